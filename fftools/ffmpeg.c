@@ -127,6 +127,7 @@ typedef struct BenchmarkTimeStamps {
 } BenchmarkTimeStamps;
 
 static void do_video_stats(OutputStream *ost, int frame_size);
+static void do_video_stats_locked(OutputStream *ost, int frame_size);
 static BenchmarkTimeStamps get_benchmark_time_stamps(void);
 static int64_t getmaxrss(void);
 static int ifilter_has_all_input_formats(FilterGraph *fg);
@@ -166,6 +167,8 @@ static int restore_tty;
 
 #if HAVE_THREADS
 static void free_input_threads(void);
+static void free_output_threads(void);
+static void free_encoder_threads(void);
 #endif
 
 /* sub2video hack:
@@ -538,6 +541,11 @@ static void ffmpeg_cleanup(int ret)
 
     av_freep(&subtitle_out);
 
+#if HAVE_THREADS
+    free_encoder_threads();
+    free_output_threads();
+#endif
+
     /* close files */
     for (i = 0; i < nb_output_files; i++) {
         OutputFile *of = output_files[i];
@@ -695,6 +703,164 @@ static void close_all_output_streams(OutputStream *ost, OSTFinished this_stream,
     }
 }
 
+#if HAVE_THREADS
+/* Serializes the muxing code, i.e. output_packet() and what it touches in the
+ * output files and streams, between the main thread and the encoder threads. */
+static pthread_mutex_t mux_lock = PTHREAD_MUTEX_INITIALIZER;
+/* set while the main thread holds mux_lock */
+static int mux_locked_by_main;
+/* set while an encoder thread runs the muxing code: it must then neither exit
+ * nor touch other streams, and reports fatal errors in encoder_mux_error */
+static int muxing_in_encoder;
+static int encoder_mux_error;
+
+static void mux_lock_main(void)
+{
+    pthread_mutex_lock(&mux_lock);
+    mux_locked_by_main = 1;
+}
+
+static void mux_unlock_main(void)
+{
+    mux_locked_by_main = 0;
+    pthread_mutex_unlock(&mux_lock);
+}
+
+static void *output_thread(void *arg)
+{
+    OutputFile *of = arg;
+    AVPacket pkt;
+    int ret, i;
+
+    while ((ret = av_thread_message_queue_recv(of->out_thread_queue, &pkt, 0)) >= 0) {
+        ret = av_interleaved_write_frame(of->ctx, &pkt);
+        if (of->ctx->pb)
+            atomic_store(&of->written_size, avio_tell(of->ctx->pb));
+        /* the interleaver may have written packets of any stream */
+        for (i = 0; i < of->ctx->nb_streams; i++)
+            atomic_store(&output_streams[of->ost_index + i]->end_pts,
+                         av_stream_get_end_pts(of->ctx->streams[i]));
+        if (ret < 0) {
+            print_error("av_interleaved_write_frame()", ret);
+            break;
+        }
+    }
+    if (ret != AVERROR_EOF)
+        av_thread_message_queue_set_err_send(of->out_thread_queue, ret);
+
+    return NULL;
+}
+
+static void free_output_thread(int i)
+{
+    OutputFile *of = output_files[i];
+    AVPacket pkt;
+
+    if (!of || !of->out_thread_queue)
+        return;
+    /* the thread drains the queued packets before seeing EOF */
+    av_thread_message_queue_set_err_recv(of->out_thread_queue, AVERROR_EOF);
+    pthread_join(of->thread, NULL);
+    while (av_thread_message_queue_recv(of->out_thread_queue, &pkt,
+                                        AV_THREAD_MESSAGE_NONBLOCK) >= 0)
+        av_packet_unref(&pkt);
+    av_thread_message_queue_free(&of->out_thread_queue);
+}
+
+static void free_output_threads(void)
+{
+    int i;
+
+    for (i = 0; i < nb_output_files; i++)
+        free_output_thread(i);
+}
+
+static int init_output_thread(OutputFile *of)
+{
+    int ret, i;
+
+    if (nb_output_files == 1)
+        return 0;
+
+    atomic_init(&of->written_size, 0);
+    for (i = 0; i < of->ctx->nb_streams; i++)
+        atomic_init(&output_streams[of->ost_index + i]->end_pts, AV_NOPTS_VALUE);
+    ret = av_thread_message_queue_alloc(&of->out_thread_queue,
+                                        of->thread_queue_size, sizeof(AVPacket));
+    if (ret < 0)
+        return ret;
+
+    if ((ret = pthread_create(&of->thread, NULL, output_thread, of))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        av_thread_message_queue_free(&of->out_thread_queue);
+        return AVERROR(ret);
+    }
+
+    return 0;
+}
+#endif
+
+/* current write position in the output file */
+static int64_t output_file_tell(OutputFile *of)
+{
+#if HAVE_THREADS
+    /* the muxer thread owns the AVIOContext */
+    if (of->out_thread_queue)
+        return atomic_load(&of->written_size);
+#endif
+    return avio_tell(of->ctx->pb);
+}
+
+/* pts of the end of the last packet muxed for ost */
+static int64_t output_stream_end_pts(OutputStream *ost)
+{
+#if HAVE_THREADS
+    /* the muxer thread updates the stream */
+    if (output_files[ost->file_index]->out_thread_queue)
+        return atomic_load(&ost->end_pts);
+#endif
+    return av_stream_get_end_pts(ost->st);
+}
+
+/* whether ost is encoded by its own thread, which then owns enc_ctx */
+static int encoder_threaded(OutputStream *ost)
+{
+#if HAVE_THREADS
+    return !!ost->enc_queue;
+#else
+    return 0;
+#endif
+}
+
+/* exit on a fatal error of the muxing code, or make the encoder thread
+ * running it stop with err */
+static void mux_fatal(int err)
+{
+#if HAVE_THREADS
+    if (muxing_in_encoder) {
+        if (!encoder_mux_error)
+            encoder_mux_error = err;
+        return;
+    }
+#endif
+    exit_program(1);
+}
+
+/* close the streams after a muxing error, or make the encoder thread running
+ * the muxing code stop with err */
+static void mux_failed(OutputStream *ost, int err)
+{
+#if HAVE_THREADS
+    if (muxing_in_encoder) {
+        if (!encoder_mux_error)
+            encoder_mux_error = err;
+        return;
+    }
+#endif
+    main_return_code = 1;
+    close_all_output_streams(ost, MUXER_FINISHED | ENCODER_FINISHED, ENCODER_FINISHED);
+}
+
 static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int unqueue)
 {
     AVFormatContext *s = of->ctx;
@@ -727,15 +893,16 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
                 av_log(NULL, AV_LOG_ERROR,
                        "Too many packets buffered for output stream %d:%d.\n",
                        ost->file_index, ost->st->index);
-                exit_program(1);
+                ret = AVERROR(ENOSPC);
+            } else {
+                ret = av_fifo_realloc2(ost->muxing_queue, new_size);
             }
-            ret = av_fifo_realloc2(ost->muxing_queue, new_size);
             if (ret < 0)
-                exit_program(1);
+                goto fail;
         }
         ret = av_packet_make_refcounted(pkt);
         if (ret < 0)
-            exit_program(1);
+            goto fail;
         av_packet_move_ref(&tmp_pkt, pkt);
         av_fifo_generic_write(ost->muxing_queue, &tmp_pkt, sizeof(tmp_pkt), NULL);
         return;
@@ -793,7 +960,8 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
                        ost->file_index, ost->st->index, ost->last_mux_dts, pkt->dts);
                 if (exit_on_error) {
                     av_log(NULL, AV_LOG_FATAL, "aborting.\n");
-                    exit_program(1);
+                    ret = AVERROR(EINVAL);
+                    goto fail;
                 }
                 av_log(s, loglevel, "changing to %"PRId64". This may result "
                        "in incorrect timestamps in the output file.\n",
@@ -821,13 +989,34 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
               );
     }
 
+#if HAVE_THREADS
+    if (of->out_thread_queue) {
+        AVPacket tmp_pkt;
+
+        ret = av_packet_make_refcounted(pkt);
+        if (ret < 0)
+            goto fail;
+        av_packet_move_ref(&tmp_pkt, pkt);
+        ret = av_thread_message_queue_send(of->out_thread_queue, &tmp_pkt, 0);
+        if (ret < 0) {
+            av_packet_unref(&tmp_pkt);
+            /* the muxer thread has already reported the error */
+            mux_failed(ost, ret);
+        }
+        return;
+    }
+#endif
+
     ret = av_interleaved_write_frame(s, pkt);
     if (ret < 0) {
         print_error("av_interleaved_write_frame()", ret);
-        main_return_code = 1;
-        close_all_output_streams(ost, MUXER_FINISHED | ENCODER_FINISHED, ENCODER_FINISHED);
+        mux_failed(ost, ret);
     }
     av_packet_unref(pkt);
+    return;
+fail:
+    av_packet_unref(pkt);
+    mux_fatal(ret);
 }
 
 static void close_output_stream(OutputStream *ost)
@@ -852,8 +1041,8 @@ static void close_output_stream(OutputStream *ost)
  * therefore flush any delayed packets to the output.  A blank packet
  * must be supplied in this case.
  */
-static void output_packet(OutputFile *of, AVPacket *pkt,
-                          OutputStream *ost, int eof)
+static void output_packet_locked(OutputFile *of, AVPacket *pkt,
+                                 OutputStream *ost, int eof)
 {
     int ret = 0;
 
@@ -899,10 +1088,22 @@ finish:
         av_log(NULL, AV_LOG_ERROR, "Error applying bitstream filters to an output "
                "packet for stream #%d:%d.\n", ost->file_index, ost->index);
         if(exit_on_error)
-            exit_program(1);
+            mux_fatal(ret);
     }
 }
 
+static void output_packet(OutputFile *of, AVPacket *pkt,
+                          OutputStream *ost, int eof)
+{
+#if HAVE_THREADS
+    mux_lock_main();
+#endif
+    output_packet_locked(of, pkt, ost, eof);
+#if HAVE_THREADS
+    mux_unlock_main();
+#endif
+}
+
 static int check_recording_time(OutputStream *ost)
 {
     OutputFile *of = output_files[ost->file_index];
@@ -916,6 +1117,194 @@ static int check_recording_time(OutputStream *ost)
     return 1;
 }
 
+#if HAVE_THREADS
+/* hand a packet returned by the encoder of ost to the muxing code, from the
+ * encoder thread */
+static int encoder_thread_output(OutputFile *of, OutputStream *ost, AVPacket *pkt)
+{
+    AVCodecContext *enc = ost->enc_ctx;
+    int pkt_size = pkt->size;
+    int ret;
+
+    if (debug_ts) {
+        av_log(NULL, AV_LOG_INFO, "encoder -> type:%s "
+               "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
+               av_get_media_type_string(enc->codec_type),
+               av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
+               av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base));
+    }
+
+    pthread_mutex_lock(&mux_lock);
+    muxing_in_encoder = 1;
+    if (ost->enc_discard) {
+        av_packet_unref(pkt);
+    } else {
+        av_packet_rescale_ts(pkt, enc->time_base, ost->mux_timebase);
+        output_packet_locked(of, pkt, ost, 0);
+
+        if (enc->codec_type == AVMEDIA_TYPE_VIDEO && vstats_filename && pkt_size)
+            do_video_stats_locked(ost, pkt_size);
+    }
+    muxing_in_encoder = 0;
+    ret = encoder_mux_error;
+    encoder_mux_error = 0;
+    pthread_mutex_unlock(&mux_lock);
+
+    return ret;
+}
+
+static void *encoder_thread(void *arg)
+{
+    OutputStream *ost = arg;
+    OutputFile *of = output_files[ost->file_index];
+    AVCodecContext *enc = ost->enc_ctx;
+    AVFrame *frame;
+    AVPacket pkt;
+    int64_t pts;
+    int ret;
+
+    while ((ret = av_thread_message_queue_recv(ost->enc_queue, &frame, 0)) >= 0) {
+        pts = AV_NOPTS_VALUE;
+        if (frame) {
+            pts = frame->pts;
+            if (enc->codec_type == AVMEDIA_TYPE_VIDEO && !ost->frame_aspect_ratio.num)
+                enc->sample_aspect_ratio = frame->sample_aspect_ratio;
+        }
+
+        ret = avcodec_send_frame(enc, frame);
+        av_frame_free(&frame);
+
+        while (ret >= 0) {
+            av_init_packet(&pkt);
+            pkt.data = NULL;
+            pkt.size = 0;
+
+            ret = avcodec_receive_packet(enc, &pkt);
+            /* if two pass, output log */
+            if ((ret >= 0 || ret == AVERROR_EOF) && ost->logfile && enc->stats_out)
+                fprintf(ost->logfile, "%s", enc->stats_out);
+            if (ret < 0)
+                break;
+
+            if (enc->codec_type == AVMEDIA_TYPE_VIDEO && pkt.pts == AV_NOPTS_VALUE &&
+                !(enc->codec->capabilities & AV_CODEC_CAP_DELAY))
+                pkt.pts = pts;
+
+            ret = encoder_thread_output(of, ost, &pkt);
+        }
+        if (ret != AVERROR(EAGAIN))
+            break;
+    }
+
+    /* read by the main thread after joining */
+    ost->enc_ret = ret == AVERROR_EOF ? 0 : ret;
+    av_thread_message_queue_set_err_send(ost->enc_queue, ret);
+
+    return NULL;
+}
+
+static void free_encoder_thread(OutputStream *ost)
+{
+    AVFrame *frame;
+
+    if (!ost->enc_queue)
+        return;
+    /* the thread encodes the queued frames before seeing EOF */
+    av_thread_message_queue_set_err_recv(ost->enc_queue, AVERROR_EOF);
+    pthread_join(ost->enc_thread, NULL);
+    while (av_thread_message_queue_recv(ost->enc_queue, &frame,
+                                        AV_THREAD_MESSAGE_NONBLOCK) >= 0)
+        av_frame_free(&frame);
+    av_thread_message_queue_free(&ost->enc_queue);
+}
+
+static void free_encoder_threads(void)
+{
+    int i;
+
+    /* an exit_program() from the muxing code may have left the lock held */
+    if (mux_locked_by_main)
+        mux_unlock_main();
+
+    for (i = 0; i < nb_output_streams; i++)
+        if (output_streams[i])
+            free_encoder_thread(output_streams[i]);
+}
+
+/* encoders get their own thread as soon as more than one stream is encoded,
+ * so that they run in parallel with each other and with decoding and
+ * filtering */
+static int want_encoder_threads(void)
+{
+    int i, nb_encoded = 0;
+
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+        enum AVMediaType type = ost->enc_ctx->codec_type;
+
+        if (ost->encoding_needed &&
+            (type == AVMEDIA_TYPE_VIDEO || type == AVMEDIA_TYPE_AUDIO))
+            nb_encoded++;
+    }
+
+    return nb_encoded > 1;
+}
+
+static int init_encoder_thread(OutputStream *ost)
+{
+    OutputFile *of = output_files[ost->file_index];
+    AVCodecContext *enc = ost->enc_ctx;
+    int ret;
+
+    if (!want_encoder_threads())
+        return 0;
+    if (enc->codec_type != AVMEDIA_TYPE_VIDEO &&
+        (enc->codec_type != AVMEDIA_TYPE_AUDIO || enc->frame_size <= 1))
+        return 0;
+
+    ret = av_thread_message_queue_alloc(&ost->enc_queue,
+                                        of->thread_queue_size, sizeof(AVFrame *));
+    if (ret < 0)
+        return ret;
+
+    if ((ret = pthread_create(&ost->enc_thread, NULL, encoder_thread, ost))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        av_thread_message_queue_free(&ost->enc_queue);
+        return AVERROR(ret);
+    }
+
+    return 0;
+}
+
+/* queue a reference to frame for the encoder thread */
+static int encoder_thread_send(OutputStream *ost, AVFrame *frame)
+{
+    AVFrame *tmp;
+    int ret;
+
+    if (!(tmp = av_frame_clone(frame)))
+        return AVERROR(ENOMEM);
+    ret = av_thread_message_queue_send(ost->enc_queue, &tmp, 0);
+    if (ret < 0)
+        av_frame_free(&tmp);
+    return ret;
+}
+
+/* drain the encoder and wait for its thread to output the last packets */
+static int encoder_thread_flush(OutputStream *ost)
+{
+    AVFrame *frame = NULL;
+    int ret;
+
+    /* the thread sees this before the flush through the queue */
+    ost->enc_discard = !!(ost->finished & MUXER_FINISHED);
+    ret = av_thread_message_queue_send(ost->enc_queue, &frame, 0);
+    free_encoder_thread(ost);
+
+    return ost->enc_ret < 0 ? ost->enc_ret : ret;
+}
+#endif
+
 static void do_audio_out(OutputFile *of, OutputStream *ost,
                          AVFrame *frame)
 {
@@ -945,6 +1334,15 @@ static void do_audio_out(OutputFile *of, OutputStream *ost,
                enc->time_base.num, enc->time_base.den);
     }
 
+#if HAVE_THREADS
+    if (ost->enc_queue) {
+        ret = encoder_thread_send(ost, frame);
+        if (ret < 0)
+            goto error;
+        return;
+    }
+#endif
+
     ret = avcodec_send_frame(enc, frame);
     if (ret < 0)
         goto error;
@@ -1294,6 +1692,19 @@ static void do_video_out(OutputFile *of,
 
         ost->frames_encoded++;
 
+#if HAVE_THREADS
+        if (ost->enc_queue) {
+            ret = encoder_thread_send(ost, in_picture);
+            if (ret < 0)
+                goto error;
+            // Make sure Closed Captions will not be duplicated
+            av_frame_remove_side_data(in_picture, AV_FRAME_DATA_A53_CC);
+            ost->sync_opts++;
+            ost->frame_number++;
+            continue;
+        }
+#endif
+
         ret = avcodec_send_frame(enc, in_picture);
         if (ret < 0)
             goto error;
@@ -1366,7 +1777,7 @@ static double psnr(double d)
     return -10.0 * log10(d);
 }
 
-static void do_video_stats(OutputStream *ost, int frame_size)
+static void do_video_stats_locked(OutputStream *ost, int frame_size)
 {
     AVCodecContext *enc;
     int frame_number;
@@ -1376,14 +1787,21 @@ static void do_video_stats(OutputStream *ost, int frame_size)
     if (!vstats_file) {
         vstats_file = fopen(vstats_filename, "w");
         if (!vstats_file) {
+            int err = AVERROR(errno);
             perror("fopen");
-            exit_program(1);
+            mux_fatal(err);
+            return;
         }
     }
 
     enc = ost->enc_ctx;
     if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
         frame_number = ost->st->nb_frames;
+#if HAVE_THREADS
+        /* the muxer thread updates the stream */
+        if (output_files[ost->file_index]->out_thread_queue)
+            frame_number = ost->packets_written;
+#endif
         if (vstats_version <= 1) {
             fprintf(vstats_file, "frame= %5d q= %2.1f ", frame_number,
                     ost->quality / (float)FF_QP2LAMBDA);
@@ -1397,7 +1815,7 @@ static void do_video_stats(OutputStream *ost, int frame_size)
 
         fprintf(vstats_file,"f_size= %6d ", frame_size);
         /* compute pts value */
-        ti1 = av_stream_get_end_pts(ost->st) * av_q2d(ost->st->time_base);
+        ti1 = output_stream_end_pts(ost) * av_q2d(ost->st->time_base);
         if (ti1 < 0.01)
             ti1 = 0.01;
 
@@ -1409,6 +1827,18 @@ static void do_video_stats(OutputStream *ost, int frame_size)
     }
 }
 
+static void do_video_stats(OutputStream *ost, int frame_size)
+{
+#if HAVE_THREADS
+    /* vstats_file is shared with the encoder threads */
+    mux_lock_main();
+#endif
+    do_video_stats_locked(ost, frame_size);
+#if HAVE_THREADS
+    mux_unlock_main();
+#endif
+}
+
 static int init_output_stream(OutputStream *ost, char *error, int error_len);
 
 static void finish_output_stream(OutputStream *ost)
@@ -1501,7 +1931,8 @@ static int reap_filters(int flush)
 
             switch (av_buffersink_get_type(filter)) {
             case AVMEDIA_TYPE_VIDEO:
-                if (!ost->frame_aspect_ratio.num)
+                /* the encoder thread, if any, sets it from the frame */
+                if (!ost->frame_aspect_ratio.num && !encoder_threaded(ost))
                     enc->sample_aspect_ratio = filtered_frame->sample_aspect_ratio;
 
                 if (debug_ts) {
@@ -1661,7 +2092,7 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
     int frame_number, vid, i;
     double bitrate;
     double speed;
-    int64_t pts = INT64_MIN + 1;
+    int64_t pts = INT64_MIN + 1, end_pts;
     static int64_t last_time = -1;
     static int qp_histogram[52];
     int hours, mins, secs, us;
@@ -1687,9 +2118,18 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
 
     oc = output_files[0]->ctx;
 
-    total_size = avio_size(oc->pb);
-    if (total_size <= 0) // FIXME improve avio_size() so it works with non seekable output too
-        total_size = avio_tell(oc->pb);
+#if HAVE_THREADS
+    /* snapshot what the encoder threads update while muxing */
+    mux_lock_main();
+    if (output_files[0]->out_thread_queue)
+        total_size = output_file_tell(output_files[0]);
+    else
+#endif
+    {
+        total_size = avio_size(oc->pb);
+        if (total_size <= 0) // FIXME improve avio_size() so it works with non seekable output too
+            total_size = avio_tell(oc->pb);
+    }
 
     vid = 0;
     av_bprint_init(&buf, 0, AV_BPRINT_SIZE_AUTOMATIC);
@@ -1760,12 +2200,15 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
             vid = 1;
         }
         /* compute min output value */
-        if (av_stream_get_end_pts(ost->st) != AV_NOPTS_VALUE)
-            pts = FFMAX(pts, av_rescale_q(av_stream_get_end_pts(ost->st),
-                                          ost->st->time_base, AV_TIME_BASE_Q));
+        end_pts = output_stream_end_pts(ost);
+        if (end_pts != AV_NOPTS_VALUE)
+            pts = FFMAX(pts, av_rescale_q(end_pts, ost->st->time_base, AV_TIME_BASE_Q));
         if (is_last_report)
             nb_frames_drop += ost->last_dropped;
     }
+#if HAVE_THREADS
+    mux_unlock_main();
+#endif
 
     secs = FFABS(pts) / AV_TIME_BASE;
     us = FFABS(pts) % AV_TIME_BASE;
@@ -1919,6 +2362,22 @@ static void flush_encoders(void)
         if (enc->codec_type != AVMEDIA_TYPE_VIDEO && enc->codec_type != AVMEDIA_TYPE_AUDIO)
             continue;
 
+#if HAVE_THREADS
+        if (ost->enc_queue) {
+            AVPacket pkt = { 0 };
+
+            ret = encoder_thread_flush(ost);
+            if (ret < 0) {
+                av_log(NULL, AV_LOG_FATAL, "%s encoding failed: %s\n",
+                       av_get_media_type_string(enc->codec_type),
+                       av_err2str(ret));
+                exit_program(1);
+            }
+            output_packet(of, &pkt, ost, 1);
+            continue;
+        }
+#endif
+
         for (;;) {
             const char *desc = NULL;
             AVPacket pkt;
@@ -2980,17 +3439,27 @@ static int check_init_output_file(OutputFile *of, int file_index)
 
     of->ctx->interrupt_callback = int_cb;
 
+#if HAVE_THREADS
+    /* the encoder threads of the other streams may already be muxing */
+    mux_lock_main();
+#endif
     ret = avformat_write_header(of->ctx, &of->opts);
     if (ret < 0) {
         av_log(NULL, AV_LOG_ERROR,
                "Could not write header for output file #%d "
                "(incorrect codec parameters ?): %s\n",
                file_index, av_err2str(ret));
-        return ret;
+        goto end;
     }
     //assert_avoptions(of->opts);
     of->header_written = 1;
 
+#if HAVE_THREADS
+    ret = init_output_thread(of);
+    if (ret < 0)
+        goto end;
+#endif
+
     av_dump_format(of->ctx, file_index, of->ctx->url, 1);
 
     if (sdp_filename || want_sdp)
@@ -3011,7 +3480,12 @@ static int check_init_output_file(OutputFile *of, int file_index)
         }
     }
 
-    return 0;
+    ret = 0;
+end:
+#if HAVE_THREADS
+    mux_unlock_main();
+#endif
+    return ret;
 }
 
 static int init_output_bsfs(OutputStream *ost)
@@ -3634,6 +4108,14 @@ static int init_output_stream(OutputStream *ost, char *error, int error_len)
     if (ret < 0)
         return ret;
 
+#if HAVE_THREADS
+    if (ost->encoding_needed) {
+        ret = init_encoder_thread(ost);
+        if (ret < 0)
+            return ret;
+    }
+#endif
+
     ost->initialized = 1;
 
     ret = check_init_output_file(output_files[ost->file_index], ost->file_index);
@@ -3833,15 +4315,19 @@ static int transcode_init(void)
 /* Return 1 if there remain streams where more output is wanted, 0 otherwise. */
 static int need_output(void)
 {
-    int i;
+    int i, ret = 0;
 
+#if HAVE_THREADS
+    /* the encoder threads update the output files and audio frame counts */
+    mux_lock_main();
+#endif
     for (i = 0; i < nb_output_streams; i++) {
         OutputStream *ost    = output_streams[i];
         OutputFile *of       = output_files[ost->file_index];
         AVFormatContext *os  = output_files[ost->file_index]->ctx;
 
         if (ost->finished ||
-            (os->pb && avio_tell(os->pb) >= of->limit_filesize))
+            (os->pb && output_file_tell(of) >= of->limit_filesize))
             continue;
         if (ost->frame_number >= ost->max_frames) {
             int j;
@@ -3850,10 +4336,14 @@ static int need_output(void)
             continue;
         }
 
-        return 1;
+        ret = 1;
+        break;
     }
+#if HAVE_THREADS
+    mux_unlock_main();
+#endif
 
-    return 0;
+    return ret;
 }
 
 /**
@@ -3867,24 +4357,46 @@ static OutputStream *choose_output(void)
     int64_t opts_min = INT64_MAX;
     OutputStream *ost_min = NULL;
 
+#if HAVE_THREADS
+    /* the encoder threads may be muxing */
+    mux_lock_main();
+#endif
     for (i = 0; i < nb_output_streams; i++) {
         OutputStream *ost = output_streams[i];
-        int64_t opts = ost->st->cur_dts == AV_NOPTS_VALUE ? INT64_MIN :
-                       av_rescale_q(ost->st->cur_dts, ost->st->time_base,
-                                    AV_TIME_BASE_Q);
-        if (ost->st->cur_dts == AV_NOPTS_VALUE)
+        int64_t cur_dts = ost->st->cur_dts;
+        int64_t opts;
+
+#if HAVE_THREADS
+        /* st->cur_dts belongs to the muxer thread */
+        if (output_files[ost->file_index]->out_thread_queue)
+            cur_dts = ost->last_mux_dts;
+#endif
+        opts = cur_dts == AV_NOPTS_VALUE ? INT64_MIN :
+               av_rescale_q(cur_dts, ost->st->time_base, AV_TIME_BASE_Q);
+        /* the packets of a threaded encoder are muxed whenever they are
+         * ready, so use what has been sent to it to keep the choice
+         * independent of the timing of the encoder thread */
+        if (encoder_threaded(ost))
+            opts = !ost->frames_encoded ? INT64_MIN :
+                   av_rescale_q(ost->sync_opts, ost->enc_ctx->time_base, AV_TIME_BASE_Q);
+        if (cur_dts == AV_NOPTS_VALUE)
             av_log(NULL, AV_LOG_DEBUG,
                 "cur_dts is invalid st:%d (%d) [init:%d i_done:%d finish:%d] (this is harmless if it occurs once at the start per stream)\n",
                 ost->st->index, ost->st->id, ost->initialized, ost->inputs_done, ost->finished);
 
-        if (!ost->initialized && !ost->inputs_done)
-            return ost;
+        if (!ost->initialized && !ost->inputs_done) {
+            ost_min = ost;
+            break;
+        }
 
         if (!ost->finished && opts < opts_min) {
             opts_min = opts;
             ost_min  = ost->unavailable ? NULL : ost;
         }
     }
+#if HAVE_THREADS
+    mux_unlock_main();
+#endif
     return ost_min;
 }
 
@@ -4712,6 +5224,10 @@ static int transcode(void)
 
     term_exit();
 
+#if HAVE_THREADS
+    free_output_threads();
+#endif
+
     /* write the trailer if needed and close file */
     for (i = 0; i < nb_output_files; i++) {
         os = output_files[i]->ctx;
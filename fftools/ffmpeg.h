@@ -21,6 +21,7 @@
 
 #include "config.h"
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <signal.h>
@@ -455,6 +456,17 @@ typedef struct OutputStream {
     int64_t first_pts;
     /* dts of the last packet sent to the muxer */
     int64_t last_mux_dts;
+#if HAVE_THREADS
+    /* av_stream_get_end_pts() as seen by the muxer thread of the file */
+    atomic_int_least64_t end_pts;
+
+    /* encoding is done in a separate thread when several streams are encoded;
+     * the thread then also hands the packets to the muxing code */
+    AVThreadMessageQueue *enc_queue; /* frames to encode, NULL to flush */
+    pthread_t enc_thread;
+    int enc_discard;            /* drop the packets of the flush, set before it */
+    int enc_ret;                /* error returned by the thread, read after joining */
+#endif
     // the timebase of the packets sent to the muxer
     AVRational mux_timebase;
     AVRational enc_timebase;
@@ -562,6 +574,13 @@ typedef struct OutputFile {
     int shortest;
 
     int header_written;
+
+#if HAVE_THREADS
+    AVThreadMessageQueue *out_thread_queue;
+    pthread_t thread;           /* thread writing packets to this file */
+    int thread_queue_size;      /* maximum number of queued packets */
+    atomic_int_least64_t written_size; /* bytes written so far, updated by the thread */
+#endif
 } OutputFile;
 
 extern InputStream **input_streams;
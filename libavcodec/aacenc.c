@@ -553,6 +553,125 @@ static void copy_input_samples(AACEncContext *s, const AVFrame *frame)
     }
 }
 
+#define ELEM_MODE_TNS  1
+#define ELEM_MODE_IS   2
+#define ELEM_MODE_PRED 4
+
+typedef struct ElementSearchData {
+    FFPsyWindowInfo *windows;
+    int start_ch[AAC_MAX_CHANNELS];     ///< first channel of each channel element
+    int bitres_alloc[AAC_MAX_CHANNELS]; ///< psy bit reservoir allocation of each channel element
+} ElementSearchData;
+
+/**
+ * Run the quantizer and tool searches of one channel element.
+ * The psy model must already have analyzed the element.
+ * @return ELEM_MODE_* flags for the tools which modified the coefficients
+ */
+static int search_channel_element(AVCodecContext *avctx, AACEncContext *s,
+                                  FFPsyWindowInfo *wi, int elem, int start_ch,
+                                  int bitres_alloc)
+{
+    int tag   = s->chan_map[elem+1];
+    int chans = tag == TYPE_CPE ? 2 : 1;
+    ChannelElement *cpe = &s->cpe[elem];
+    SingleChannelElement *sce;
+    int ch, w, modes = 0;
+
+    s->psy.bitres.alloc = bitres_alloc;
+    s->cur_type = tag;
+    for (ch = 0; ch < chans; ch++) {
+        s->cur_channel = start_ch + ch;
+        if (s->options.pns && s->coder->mark_pns)
+            s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
+        s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
+    }
+    if (chans > 1
+        && wi[0].window_type[0] == wi[1].window_type[0]
+        && wi[0].window_shape   == wi[1].window_shape) {
+
+        cpe->common_window = 1;
+        for (w = 0; w < wi[0].num_windows; w++) {
+            if (wi[0].grouping[w] != wi[1].grouping[w]) {
+                cpe->common_window = 0;
+                break;
+            }
+        }
+    }
+    for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
+        sce = &cpe->ch[ch];
+        s->cur_channel = start_ch + ch;
+        if (s->options.tns && s->coder->search_for_tns)
+            s->coder->search_for_tns(s, sce);
+        if (s->options.tns && s->coder->apply_tns_filt)
+            s->coder->apply_tns_filt(s, sce);
+        if (sce->tns.present)
+            modes |= ELEM_MODE_TNS;
+        if (s->options.pns && s->coder->search_for_pns)
+            s->coder->search_for_pns(s, avctx, sce);
+    }
+    s->cur_channel = start_ch;
+    if (s->options.intensity_stereo) { /* Intensity Stereo */
+        if (s->coder->search_for_is)
+            s->coder->search_for_is(s, avctx, cpe);
+        if (cpe->is_mode) modes |= ELEM_MODE_IS;
+        apply_intensity_stereo(cpe);
+    }
+    if (s->options.pred) { /* Prediction */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->search_for_pred)
+                s->coder->search_for_pred(s, sce);
+            if (cpe->ch[ch].ics.predictor_present) modes |= ELEM_MODE_PRED;
+        }
+        if (s->coder->adjust_common_pred)
+            s->coder->adjust_common_pred(s, cpe);
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->apply_main_pred)
+                s->coder->apply_main_pred(s, sce);
+        }
+        s->cur_channel = start_ch;
+    }
+    if (s->options.mid_side) { /* Mid/Side stereo */
+        if (s->options.mid_side == -1 && s->coder->search_for_ms)
+            s->coder->search_for_ms(s, cpe);
+        else if (cpe->common_window)
+            memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
+        apply_mid_side_stereo(cpe);
+    }
+    adjust_frame_information(cpe, chans);
+    if (s->options.ltp) { /* LTP */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->coder->search_for_ltp)
+                s->coder->search_for_ltp(s, sce, cpe->common_window);
+            if (sce->ics.ltp.present) modes |= ELEM_MODE_PRED;
+        }
+        s->cur_channel = start_ch;
+        if (s->coder->adjust_common_ltp)
+            s->coder->adjust_common_ltp(s, cpe);
+    }
+
+    return modes;
+}
+
+static int search_channel_element_job(AVCodecContext *avctx, void *arg,
+                                      int jobnr, int threadnr)
+{
+    AACEncContext *s  = avctx->priv_data;
+    AACEncContext *es = &s->slice_ctx[jobnr];
+    ElementSearchData *td = arg;
+
+    es->lambda = s->lambda;
+    return search_channel_element(avctx, es, td->windows + td->start_ch[jobnr],
+                                  jobnr, td->start_ch[jobnr],
+                                  td->bitres_alloc[jobnr]);
+}
+
 static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                             const AVFrame *frame, int *got_packet_ptr)
 {
@@ -565,7 +684,9 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     int target_bits, rate_bits, too_many_bits, too_few_bits;
     int ms_mode = 0, is_mode = 0, tns_mode = 0, pred_mode = 0;
     int chan_el_counter[4];
+    int elem_modes[AAC_MAX_CHANNELS];
     FFPsyWindowInfo windows[AAC_MAX_CHANNELS];
+    ElementSearchData td = { windows };
 
     /* add current frame to queue */
     if (frame) {
@@ -688,7 +809,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
             put_bitstream_info(s, LIBAVCODEC_IDENT);
         start_ch = 0;
         target_bits = 0;
-        memset(chan_el_counter, 0, sizeof(chan_el_counter));
         for (i = 0; i < s->chan_map[0]; i++) {
             FFPsyWindowInfo* wi = windows + start_ch;
             const float *coeffs[2];
@@ -698,8 +818,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
             cpe->common_window = 0;
             memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
             memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
-            put_bits(&s->pb, 3, tag);
-            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             for (ch = 0; ch < chans; ch++) {
                 sce = &cpe->ch[ch];
                 coeffs[ch] = sce->coeffs;
@@ -721,82 +839,36 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                     * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
                 s->psy.bitres.alloc /= chans;
             }
-            s->cur_type = tag;
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                if (s->options.pns && s->coder->mark_pns)
-                    s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
-                s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
-            }
-            if (chans > 1
-                && wi[0].window_type[0] == wi[1].window_type[0]
-                && wi[0].window_shape   == wi[1].window_shape) {
-
-                cpe->common_window = 1;
-                for (w = 0; w < wi[0].num_windows; w++) {
-                    if (wi[0].grouping[w] != wi[1].grouping[w]) {
-                        cpe->common_window = 0;
-                        break;
-                    }
-                }
-            }
-            for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
-                sce = &cpe->ch[ch];
-                s->cur_channel = start_ch + ch;
-                if (s->options.tns && s->coder->search_for_tns)
-                    s->coder->search_for_tns(s, sce);
-                if (s->options.tns && s->coder->apply_tns_filt)
-                    s->coder->apply_tns_filt(s, sce);
-                if (sce->tns.present)
-                    tns_mode = 1;
-                if (s->options.pns && s->coder->search_for_pns)
-                    s->coder->search_for_pns(s, avctx, sce);
-            }
-            s->cur_channel = start_ch;
-            if (s->options.intensity_stereo) { /* Intensity Stereo */
-                if (s->coder->search_for_is)
-                    s->coder->search_for_is(s, avctx, cpe);
-                if (cpe->is_mode) is_mode = 1;
-                apply_intensity_stereo(cpe);
-            }
-            if (s->options.pred) { /* Prediction */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->search_for_pred)
-                        s->coder->search_for_pred(s, sce);
-                    if (cpe->ch[ch].ics.predictor_present) pred_mode = 1;
-                }
-                if (s->coder->adjust_common_pred)
-                    s->coder->adjust_common_pred(s, cpe);
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->apply_main_pred)
-                        s->coder->apply_main_pred(s, sce);
-                }
-                s->cur_channel = start_ch;
-            }
-            if (s->options.mid_side) { /* Mid/Side stereo */
-                if (s->options.mid_side == -1 && s->coder->search_for_ms)
-                    s->coder->search_for_ms(s, cpe);
-                else if (cpe->common_window)
-                    memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
-                apply_mid_side_stereo(cpe);
-            }
-            adjust_frame_information(cpe, chans);
-            if (s->options.ltp) { /* LTP */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->coder->search_for_ltp)
-                        s->coder->search_for_ltp(s, sce, cpe->common_window);
-                    if (sce->ics.ltp.present) pred_mode = 1;
-                }
-                s->cur_channel = start_ch;
-                if (s->coder->adjust_common_ltp)
-                    s->coder->adjust_common_ltp(s, cpe);
-            }
+            td.start_ch[i]     = start_ch;
+            td.bitres_alloc[i] = s->psy.bitres.alloc;
+            start_ch += chans;
+        }
+
+        if (s->slice_ctx) {
+            avctx->execute2(avctx, search_channel_element_job, &td, elem_modes,
+                            s->chan_map[0]);
+            /* The quantizer search may update the psy cutoff from the frame
+             * bitrate. It is the same for every element, so take it from
+             * the last one for the psy model, which analyzes with s->psy. */
+            s->psy.cutoff = s->slice_ctx[s->chan_map[0] - 1].psy.cutoff;
+        } else
+            elem_modes[0] = search_channel_element(avctx, s, windows, 0, 0,
+                                                   td.bitres_alloc[0]);
+
+        memset(chan_el_counter, 0, sizeof(chan_el_counter));
+        for (i = 0; i < s->chan_map[0]; i++) {
+            tag      = s->chan_map[i+1];
+            chans    = tag == TYPE_CPE ? 2 : 1;
+            cpe      = &s->cpe[i];
+            start_ch = td.start_ch[i];
+            put_bits(&s->pb, 3, tag);
+            put_bits(&s->pb, 4, chan_el_counter[tag]++);
+            if (elem_modes[i] & ELEM_MODE_TNS)
+                tns_mode = 1;
+            if (elem_modes[i] & ELEM_MODE_IS)
+                is_mode = 1;
+            if (elem_modes[i] & ELEM_MODE_PRED)
+                pred_mode = 1;
             if (chans == 2) {
                 put_bits(&s->pb, 1, cpe->common_window);
                 if (cpe->common_window) {
@@ -813,7 +885,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                 s->cur_channel = start_ch + ch;
                 encode_individual_channel(avctx, s, &cpe->ch[ch], cpe->common_window);
             }
-            start_ch += chans;
         }
 
         if (avctx->flags & AV_CODEC_FLAG_QSCALE) {
@@ -906,6 +977,12 @@ static av_cold int aac_encode_end(AVCodecContext *avctx)
     ff_mdct_end(&s->mdct128);
     ff_psy_end(&s->psy);
     ff_lpc_end(&s->lpc);
+    if (s->slice_ctx) {
+        int i;
+        for (i = 0; i < s->chan_map[0]; i++)
+            ff_lpc_end(&s->slice_ctx[i].lpc);
+        av_freep(&s->slice_ctx);
+    }
     if (s->psypp)
         ff_psy_preprocess_end(s->psypp);
     av_freep(&s->buffer.samples);
@@ -1110,6 +1187,32 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
     if ((ret = ff_thread_once(&aac_table_init, &aac_encode_init_tables)) != 0)
         return AVERROR_UNKNOWN;
 
+    /* Each channel element is searched in its own job, using a private copy
+     * of the context for the scratch buffers, the quantization cost cache,
+     * TNS LPC state and PNS noise generator. The elements are also kept
+     * separate without slice threads, so that the output does not depend
+     * on the thread count. */
+    if (s->chan_map[0] > 1) {
+        s->slice_ctx = av_malloc_array(s->chan_map[0], sizeof(*s->slice_ctx));
+        if (!s->slice_ctx) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        for (i = 0; i < s->chan_map[0]; i++) {
+            AACEncContext *es = &s->slice_ctx[i];
+            *es = *s;
+            es->slice_ctx     = NULL;
+            es->random_state += i;
+            if ((ret = ff_lpc_init(&es->lpc, 2*avctx->frame_size, TNS_MAX_ORDER,
+                                   FF_LPC_TYPE_LEVINSON)) < 0) {
+                while (i--)
+                    ff_lpc_end(&s->slice_ctx[i].lpc);
+                av_freep(&s->slice_ctx);
+                goto fail;
+            }
+        }
+    }
+
     ff_af_queue_init(avctx, &s->afq);
 
     return 0;
@@ -1158,7 +1261,8 @@ AVCodec ff_aac_encoder = {
     .defaults       = aac_encode_defaults,
     .supported_samplerates = mpeg4audio_sample_rates,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_FLTP,
                                                      AV_SAMPLE_FMT_NONE },
     .priv_class     = &aacenc_class,
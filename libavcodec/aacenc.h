@@ -418,6 +418,8 @@ typedef struct AACEncContext {
     struct {
         float *samples;
     } buffer;
+
+    struct AACEncContext *slice_ctx;             ///< per channel element contexts for slice threading
 } AACEncContext;
 
 void ff_aac_dsp_init_x86(AACEncContext *s);
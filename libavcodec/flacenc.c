@@ -92,12 +92,16 @@ typedef struct FlacSubframe {
 } FlacSubframe;
 
 typedef struct FlacFrame {
-    FlacSubframe subframes[FLAC_MAX_CHANNELS];
+    FlacSubframe *subframes;
     int blocksize;
     int bs_code[2];
     uint8_t crc8;
     int ch_mode;
     int verbatim_only;
+
+    uint32_t frame_number;
+    int64_t pts;
+    int frame_bytes;
 } FlacFrame;
 
 typedef struct FlacEncodeContext {
@@ -114,16 +118,25 @@ typedef struct FlacEncodeContext {
     uint32_t frame_count;
     uint64_t sample_count;
     uint8_t md5sum[16];
-    FlacFrame frame;
     CompressionOptions options;
     AVCodecContext *avctx;
-    LPCContext lpc_ctx;
     struct AVMD5 *md5ctx;
     uint8_t *md5_buffer;
     unsigned int md5_buffer_size;
     BswapDSPContext bdsp;
     FLACDSPContext flac_dsp;
 
+    /**
+     * Frames are queued and analysed nb_frames at a time, one per thread,
+     * then written out in order.
+     */
+    FlacFrame *frames;
+    LPCContext *lpc_ctx;
+    int nb_frames;
+    int first_frame;
+    int nb_ready;
+    int nb_pending;
+
     int flushed;
     int64_t next_pts;
 } FlacEncodeContext;
@@ -454,8 +467,20 @@ FF_ENABLE_DEPRECATION_WARNINGS
         }
     }
 
-    ret = ff_lpc_init(&s->lpc_ctx, avctx->frame_size,
-                      s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+    s->nb_frames = avctx->active_thread_type & FF_THREAD_SLICE ? avctx->thread_count : 1;
+    s->frames    = av_calloc(s->nb_frames, sizeof(*s->frames));
+    s->lpc_ctx   = av_calloc(s->nb_frames, sizeof(*s->lpc_ctx));
+    if (!s->frames || !s->lpc_ctx)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_frames; i++) {
+        s->frames[i].subframes = av_calloc(channels, sizeof(*s->frames[i].subframes));
+        if (!s->frames[i].subframes)
+            return AVERROR(ENOMEM);
+        ret = ff_lpc_init(&s->lpc_ctx[i], avctx->frame_size,
+                          s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+        if (ret < 0)
+            return ret;
+    }
 
     ff_bswapdsp_init(&s->bdsp);
     ff_flacdsp_init(&s->flac_dsp, avctx->sample_fmt, channels,
@@ -467,12 +492,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
 }
 
 
-static void init_frame(FlacEncodeContext *s, int nb_samples)
+static void init_frame(FlacEncodeContext *s, FlacFrame *frame, int nb_samples)
 {
     int i, ch;
-    FlacFrame *frame;
-
-    frame = &s->frame;
 
     for (i = 0; i < 16; i++) {
         if (nb_samples == ff_flac_blocksize_table[i]) {
@@ -512,16 +534,15 @@ static void init_frame(FlacEncodeContext *s, int nb_samples)
 /**
  * Copy channel-interleaved input samples into separate subframes.
  */
-static void copy_samples(FlacEncodeContext *s, const void *samples)
+static void copy_samples(FlacEncodeContext *s, FlacFrame *frame,
+                         const void *samples)
 {
     int i, j, ch;
-    FlacFrame *frame;
     int shift = av_get_bytes_per_sample(s->avctx->sample_fmt) * 8 -
                 s->avctx->bits_per_raw_sample;
 
 #define COPY_SAMPLES(bits) do {                                     \
     const int ## bits ## _t *samples0 = samples;                    \
-    frame = &s->frame;                                              \
     for (i = 0, j = 0; i < frame->blocksize; i++)                   \
         for (ch = 0; ch < s->channels; ch++, j++)                   \
             frame->subframes[ch].samples[i] = samples0[j] >> shift; \
@@ -548,8 +569,8 @@ static uint64_t rice_count_exact(const int32_t *res, int n, int k)
 }
 
 
-static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
-                                     int pred_order)
+static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacFrame *frame,
+                                     FlacSubframe *sub, int pred_order)
 {
     int p, porder, psize;
     int i, part_end;
@@ -565,7 +586,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
     if (sub->type == FLAC_SUBFRAME_CONSTANT) {
         count += sub->obits;
     } else if (sub->type == FLAC_SUBFRAME_VERBATIM) {
-        count += s->frame.blocksize * sub->obits;
+        count += frame->blocksize * sub->obits;
     } else {
         /* warm-up samples */
         count += pred_order * sub->obits;
@@ -579,7 +600,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
 
         /* partition order */
         porder = sub->rc.porder;
-        psize  = s->frame.blocksize >> porder;
+        psize  = frame->blocksize >> porder;
         count += 4;
 
         /* residual */
@@ -590,7 +611,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
             count += sub->rc.coding_mode;
             count += rice_count_exact(&sub->residual[i], part_end - i, k);
             i = part_end;
-            part_end = FFMIN(s->frame.blocksize, part_end + psize);
+            part_end = FFMIN(frame->blocksize, part_end + psize);
         }
     }
 
@@ -751,19 +772,19 @@ static int get_max_p_order(int max_porder, int n, int order)
 }
 
 
-static uint64_t find_subframe_rice_params(FlacEncodeContext *s,
+static uint64_t find_subframe_rice_params(FlacEncodeContext *s, FlacFrame *frame,
                                           FlacSubframe *sub, int pred_order)
 {
     int pmin = get_max_p_order(s->options.min_partition_order,
-                               s->frame.blocksize, pred_order);
+                               frame->blocksize, pred_order);
     int pmax = get_max_p_order(s->options.max_partition_order,
-                               s->frame.blocksize, pred_order);
+                               frame->blocksize, pred_order);
 
     uint64_t bits = 8 + pred_order * sub->obits + 2 + sub->rc.coding_mode;
     if (sub->type == FLAC_SUBFRAME_LPC)
         bits += 4 + 5 + pred_order * s->options.lpc_coeff_precision;
     bits += calc_rice_params(&sub->rc, sub->rc_udata, sub->rc_sums, pmin, pmax, sub->residual,
-                             s->frame.blocksize, pred_order, s->options.exact_rice_parameters);
+                             frame->blocksize, pred_order, s->options.exact_rice_parameters);
     return bits;
 }
 
@@ -819,17 +840,16 @@ static void encode_residual_fixed(int32_t *res, const int32_t *smp, int n,
 }
 
 
-static int encode_residual_ch(FlacEncodeContext *s, int ch)
+static int encode_residual_ch(FlacEncodeContext *s, FlacFrame *frame,
+                              LPCContext *lpc, int ch)
 {
     int i, n;
     int min_order, max_order, opt_order, omethod;
-    FlacFrame *frame;
     FlacSubframe *sub;
     int32_t coefs[MAX_LPC_ORDER][MAX_LPC_ORDER];
     int shift[MAX_LPC_ORDER];
     int32_t *res, *smp;
 
-    frame = &s->frame;
     sub   = &frame->subframes[ch];
     res   = sub->residual;
     smp   = sub->samples;
@@ -842,14 +862,14 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
     if (i == n) {
         sub->type = sub->type_code = FLAC_SUBFRAME_CONSTANT;
         res[0] = smp[0];
-        return subframe_count_exact(s, sub, 0);
+        return subframe_count_exact(s, frame, sub, 0);
     }
 
     /* VERBATIM */
     if (frame->verbatim_only || n < 5) {
         sub->type = sub->type_code = FLAC_SUBFRAME_VERBATIM;
         memcpy(res, smp, n * sizeof(int32_t));
-        return subframe_count_exact(s, sub, 0);
+        return subframe_count_exact(s, frame, sub, 0);
     }
 
     min_order  = s->options.min_prediction_order;
@@ -867,7 +887,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         bits[0]   = UINT32_MAX;
         for (i = min_order; i <= max_order; i++) {
             encode_residual_fixed(res, smp, n, i);
-            bits[i] = find_subframe_rice_params(s, sub, i);
+            bits[i] = find_subframe_rice_params(s, frame, sub, i);
             if (bits[i] < bits[opt_order])
                 opt_order = i;
         }
@@ -875,14 +895,14 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         sub->type_code = sub->type | sub->order;
         if (sub->order != max_order) {
             encode_residual_fixed(res, smp, n, sub->order);
-            find_subframe_rice_params(s, sub, sub->order);
+            find_subframe_rice_params(s, frame, sub, sub->order);
         }
-        return subframe_count_exact(s, sub, sub->order);
+        return subframe_count_exact(s, frame, sub, sub->order);
     }
 
     /* LPC */
     sub->type = FLAC_SUBFRAME_LPC;
-    opt_order = ff_lpc_calc_coefs(&s->lpc_ctx, smp, n, min_order, max_order,
+    opt_order = ff_lpc_calc_coefs(lpc, smp, n, min_order, max_order,
                                   s->options.lpc_coeff_precision, coefs, shift, s->options.lpc_type,
                                   s->options.lpc_passes, omethod,
                                   MIN_LPC_SHIFT, MAX_LPC_SHIFT, 0);
@@ -909,7 +929,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
                 s->flac_dsp.lpc32_encode(res, smp, n, order+1, coefs[order],
                                          shift[order]);
             }
-            bits[i] = find_subframe_rice_params(s, sub, order+1);
+            bits[i] = find_subframe_rice_params(s, frame, sub, order+1);
             if (bits[i] < bits[opt_index]) {
                 opt_index = i;
                 opt_order = order;
@@ -927,7 +947,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
             } else {
                 s->flac_dsp.lpc32_encode(res, smp, n, i+1, coefs[i], shift[i]);
             }
-            bits[i] = find_subframe_rice_params(s, sub, i+1);
+            bits[i] = find_subframe_rice_params(s, frame, sub, i+1);
             if (bits[i] < bits[opt_order])
                 opt_order = i;
         }
@@ -949,7 +969,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
                 } else {
                     s->flac_dsp.lpc16_encode(res, smp, n, i+1, coefs[i], shift[i]);
                 }
-                bits[i] = find_subframe_rice_params(s, sub, i+1);
+                bits[i] = find_subframe_rice_params(s, frame, sub, i+1);
                 if (bits[i] < bits[opt_order])
                     opt_order = i;
             }
@@ -990,7 +1010,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
                 } else {
                     s->flac_dsp.lpc32_encode(res, smp, n, opt_order, lpc_try, shift[opt_order-1]);
                 }
-                score = find_subframe_rice_params(s, sub, opt_order);
+                score = find_subframe_rice_params(s, frame, sub, opt_order);
                 if (score < best_score) {
                     best_score = score;
                     memcpy(coefs[opt_order-1], lpc_try, sizeof(*coefs));
@@ -1012,13 +1032,13 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         s->flac_dsp.lpc32_encode(res, smp, n, sub->order, sub->coefs, sub->shift);
     }
 
-    find_subframe_rice_params(s, sub, sub->order);
+    find_subframe_rice_params(s, frame, sub, sub->order);
 
-    return subframe_count_exact(s, sub, sub->order);
+    return subframe_count_exact(s, frame, sub, sub->order);
 }
 
 
-static int count_frame_header(FlacEncodeContext *s)
+static int count_frame_header(FlacEncodeContext *s, FlacFrame *frame)
 {
     uint8_t av_unused tmp;
     int count;
@@ -1036,12 +1056,12 @@ static int count_frame_header(FlacEncodeContext *s)
     count = 32;
 
     /* coded frame number */
-    PUT_UTF8(s->frame_count, tmp, count += 8;)
+    PUT_UTF8(frame->frame_number, tmp, count += 8;)
 
     /* explicit block size */
-    if (s->frame.bs_code[0] == 6)
+    if (frame->bs_code[0] == 6)
         count += 8;
-    else if (s->frame.bs_code[0] == 7)
+    else if (frame->bs_code[0] == 7)
         count += 16;
 
     /* explicit sample rate */
@@ -1054,15 +1074,15 @@ static int count_frame_header(FlacEncodeContext *s)
 }
 
 
-static int encode_frame(FlacEncodeContext *s)
+static int encode_frame(FlacEncodeContext *s, FlacFrame *frame, LPCContext *lpc)
 {
     int ch;
     uint64_t count;
 
-    count = count_frame_header(s);
+    count = count_frame_header(s, frame);
 
     for (ch = 0; ch < s->channels; ch++)
-        count += encode_residual_ch(s, ch);
+        count += encode_residual_ch(s, frame, lpc, ch);
 
     count += (8 - (count & 7)) & 7; // byte alignment
     count += 16;                    // CRC-16
@@ -1074,15 +1094,15 @@ static int encode_frame(FlacEncodeContext *s)
 }
 
 
-static void remove_wasted_bits(FlacEncodeContext *s)
+static void remove_wasted_bits(FlacEncodeContext *s, FlacFrame *frame)
 {
     int ch, i;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &frame->subframes[ch];
         int32_t v         = 0;
 
-        for (i = 0; i < s->frame.blocksize; i++) {
+        for (i = 0; i < frame->blocksize; i++) {
             v |= sub->samples[i];
             if (v & 1)
                 break;
@@ -1091,7 +1111,7 @@ static void remove_wasted_bits(FlacEncodeContext *s)
         if (v && !(v & 1)) {
             v = ff_ctz(v);
 
-            for (i = 0; i < s->frame.blocksize; i++)
+            for (i = 0; i < frame->blocksize; i++)
                 sub->samples[i] >>= v;
 
             sub->wasted = v;
@@ -1150,13 +1170,11 @@ static int estimate_stereo_mode(const int32_t *left_ch, const int32_t *right_ch,
 /**
  * Perform stereo channel decorrelation.
  */
-static void channel_decorrelation(FlacEncodeContext *s)
+static void channel_decorrelation(FlacEncodeContext *s, FlacFrame *frame)
 {
-    FlacFrame *frame;
     int32_t *left, *right;
     int i, n;
 
-    frame = &s->frame;
     n     = frame->blocksize;
     left  = frame->subframes[0].samples;
     right = frame->subframes[1].samples;
@@ -1202,13 +1220,10 @@ static void write_utf8(PutBitContext *pb, uint32_t val)
 }
 
 
-static void write_frame_header(FlacEncodeContext *s)
+static void write_frame_header(FlacEncodeContext *s, FlacFrame *frame)
 {
-    FlacFrame *frame;
     int crc;
 
-    frame = &s->frame;
-
     put_bits(&s->pb, 16, 0xFFF8);
     put_bits(&s->pb, 4, frame->bs_code[0]);
     put_bits(&s->pb, 4, s->sr_code[0]);
@@ -1220,7 +1235,7 @@ static void write_frame_header(FlacEncodeContext *s)
 
     put_bits(&s->pb, 3, s->bps_code);
     put_bits(&s->pb, 1, 0);
-    write_utf8(&s->pb, s->frame_count);
+    write_utf8(&s->pb, frame->frame_number);
 
     if (frame->bs_code[0] == 6)
         put_bits(&s->pb, 8, frame->bs_code[1]);
@@ -1239,16 +1254,16 @@ static void write_frame_header(FlacEncodeContext *s)
 }
 
 
-static void write_subframes(FlacEncodeContext *s)
+static void write_subframes(FlacEncodeContext *s, FlacFrame *frame)
 {
     int ch;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &frame->subframes[ch];
         int i, p, porder, psize;
         int32_t *part_end;
         int32_t *res       =  sub->residual;
-        int32_t *frame_end = &sub->residual[s->frame.blocksize];
+        int32_t *frame_end = &sub->residual[frame->blocksize];
 
         /* subframe header */
         put_bits(&s->pb, 1, 0);
@@ -1282,7 +1297,7 @@ static void write_subframes(FlacEncodeContext *s)
 
             /* partition order */
             porder  = sub->rc.porder;
-            psize   = s->frame.blocksize >> porder;
+            psize   = frame->blocksize >> porder;
             put_bits(&s->pb, 4, porder);
 
             /* residual */
@@ -1310,20 +1325,21 @@ static void write_frame_footer(FlacEncodeContext *s)
 }
 
 
-static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
+static int write_frame(FlacEncodeContext *s, FlacFrame *frame, AVPacket *avpkt)
 {
     init_put_bits(&s->pb, avpkt->data, avpkt->size);
-    write_frame_header(s);
-    write_subframes(s);
+    write_frame_header(s, frame);
+    write_subframes(s, frame);
     write_frame_footer(s);
     return put_bits_count(&s->pb) >> 3;
 }
 
 
-static int update_md5_sum(FlacEncodeContext *s, const void *samples)
+static int update_md5_sum(FlacEncodeContext *s, const void *samples,
+                          int nb_samples)
 {
     const uint8_t *buf;
-    int buf_size = s->frame.blocksize * s->channels *
+    int buf_size = nb_samples * s->channels *
                    ((s->avctx->bits_per_raw_sample + 7) / 8);
 
     if (s->avctx->bits_per_raw_sample > 16 || HAVE_BIGENDIAN) {
@@ -1344,7 +1360,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++) {
+        for (i = 0; i < nb_samples * s->channels; i++) {
             int32_t v = samples0[i] >> 8;
             AV_WL24(tmp + 3*i, v);
         }
@@ -1356,16 +1372,76 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 }
 
 
+static int encode_frame_thread(AVCodecContext *avctx, void *arg,
+                               int jobnr, int threadnr)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacFrame *frame = &s->frames[(s->first_frame + s->nb_ready + jobnr) % s->nb_frames];
+    LPCContext *lpc  = &s->lpc_ctx[jobnr];
+    int max_framesize = s->max_framesize;
+
+    /* change max_framesize for small final frame */
+    if (frame->blocksize < s->max_blocksize)
+        max_framesize = ff_flac_get_max_frame_size(frame->blocksize, s->channels,
+                                                   avctx->bits_per_raw_sample);
+
+    channel_decorrelation(s, frame);
+
+    remove_wasted_bits(s, frame);
+
+    frame->frame_bytes = encode_frame(s, frame, lpc);
+
+    /* Fall back on verbatim mode if the compressed frame is larger than it
+       would be if encoded uncompressed. */
+    if (frame->frame_bytes < 0 || frame->frame_bytes > max_framesize) {
+        frame->verbatim_only = 1;
+        frame->frame_bytes = encode_frame(s, frame, lpc);
+    }
+
+    return 0;
+}
+
+
 static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                              const AVFrame *frame, int *got_packet_ptr)
 {
     FlacEncodeContext *s;
-    int frame_bytes, out_bytes, ret;
+    FlacFrame *f;
+    int out_bytes, ret;
 
     s = avctx->priv_data;
 
+    if (frame) {
+        f = &s->frames[(s->first_frame + s->nb_ready + s->nb_pending) % s->nb_frames];
+
+        init_frame(s, f, frame->nb_samples);
+
+        copy_samples(s, f, frame->data[0]);
+
+        f->frame_number = s->frame_count++;
+        f->pts          = frame->pts;
+
+        s->sample_count += frame->nb_samples;
+        if ((ret = update_md5_sum(s, frame->data[0], frame->nb_samples)) < 0) {
+            av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+            return ret;
+        }
+
+        s->nb_pending++;
+    }
+
+    /* analyse the queued frames once there is one for each thread */
+    if (s->nb_pending == s->nb_frames || (!frame && s->nb_pending)) {
+        avctx->execute2(avctx, encode_frame_thread, NULL, NULL, s->nb_pending);
+        s->nb_ready  += s->nb_pending;
+        s->nb_pending = 0;
+    }
+
+    if (frame && !s->nb_ready)
+        return 0;
+
     /* when the last block is reached, update the header in extradata */
-    if (!frame) {
+    if (!s->nb_ready) {
         s->max_framesize = s->max_encoded_framesize;
         av_md5_final(s->md5ctx, s->md5sum);
         write_streaminfo(s, avctx->extradata);
@@ -1392,52 +1468,27 @@ FF_ENABLE_DEPRECATION_WARNINGS
         return 0;
     }
 
-    /* change max_framesize for small final frame */
-    if (frame->nb_samples < s->frame.blocksize) {
-        s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
-                                                      s->channels,
-                                                      avctx->bits_per_raw_sample);
-    }
-
-    init_frame(s, frame->nb_samples);
-
-    copy_samples(s, frame->data[0]);
-
-    channel_decorrelation(s);
-
-    remove_wasted_bits(s);
-
-    frame_bytes = encode_frame(s);
+    f = &s->frames[s->first_frame];
+    s->first_frame = (s->first_frame + 1) % s->nb_frames;
+    s->nb_ready--;
 
-    /* Fall back on verbatim mode if the compressed frame is larger than it
-       would be if encoded uncompressed. */
-    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
-        s->frame.verbatim_only = 1;
-        frame_bytes = encode_frame(s);
-        if (frame_bytes < 0) {
-            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
-            return frame_bytes;
-        }
+    if (f->frame_bytes < 0) {
+        av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
+        return f->frame_bytes;
     }
 
-    if ((ret = ff_alloc_packet2(avctx, avpkt, frame_bytes, 0)) < 0)
+    if ((ret = ff_alloc_packet2(avctx, avpkt, f->frame_bytes, 0)) < 0)
         return ret;
 
-    out_bytes = write_frame(s, avpkt);
+    out_bytes = write_frame(s, f, avpkt);
 
-    s->frame_count++;
-    s->sample_count += frame->nb_samples;
-    if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
-        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
-        return ret;
-    }
     if (out_bytes > s->max_encoded_framesize)
         s->max_encoded_framesize = out_bytes;
     if (out_bytes < s->min_framesize)
         s->min_framesize = out_bytes;
 
-    avpkt->pts      = frame->pts;
-    avpkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
+    avpkt->pts      = f->pts;
+    avpkt->duration = ff_samples_to_time_base(avctx, f->blocksize);
     avpkt->size     = out_bytes;
 
     s->next_pts = avpkt->pts + avpkt->duration;
@@ -1453,7 +1504,14 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
         FlacEncodeContext *s = avctx->priv_data;
         av_freep(&s->md5ctx);
         av_freep(&s->md5_buffer);
-        ff_lpc_end(&s->lpc_ctx);
+        for (int i = 0; i < s->nb_frames; i++) {
+            if (s->frames)
+                av_freep(&s->frames[i].subframes);
+            if (s->lpc_ctx)
+                ff_lpc_end(&s->lpc_ctx[i]);
+        }
+        av_freep(&s->frames);
+        av_freep(&s->lpc_ctx);
     }
     av_freep(&avctx->extradata);
     avctx->extradata_size = 0;
@@ -1508,7 +1566,9 @@ AVCodec ff_flac_encoder = {
     .init           = flac_encode_init,
     .encode2        = flac_encode_frame,
     .close          = flac_encode_close,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_LOSSLESS,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_LOSSLESS |
+                      AV_CODEC_CAP_SLICE_THREADS,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_S16,
                                                      AV_SAMPLE_FMT_S32,
                                                      AV_SAMPLE_FMT_NONE },
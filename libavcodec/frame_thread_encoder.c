@@ -26,9 +26,11 @@
 #include "libavutil/avassert.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
 #include "libavutil/thread.h"
 #include "avcodec.h"
 #include "internal.h"
+#include "png.h"
 #include "thread.h"
 
 #define MAX_THREADS 64
@@ -114,13 +116,28 @@ end:
     return NULL;
 }
 
+static int is_intra_only(AVCodecContext *avctx)
+{
+    int64_t image = 0;
+
+    if (avctx->codec->capabilities & AV_CODEC_CAP_INTRA_ONLY)
+        return 1;
+
+    // the GIF encoder only references previous frames for animations
+    if (avctx->codec_id == AV_CODEC_ID_GIF &&
+        av_opt_get_int(avctx->priv_data, "gifimage", 0, &image) >= 0)
+        return image;
+
+    return 0;
+}
+
 int ff_frame_thread_encoder_init(AVCodecContext *avctx, AVDictionary *options){
     int i=0;
     ThreadContext *c;
 
 
     if(   !(avctx->thread_type & FF_THREAD_FRAME)
-       || !(avctx->codec->capabilities & AV_CODEC_CAP_INTRA_ONLY))
+       || !is_intra_only(avctx))
         return 0;
 
     if(   !avctx->thread_count
@@ -170,6 +187,20 @@ int ff_frame_thread_encoder_init(AVCodecContext *avctx, AVDictionary *options){
     if(avctx->thread_count <= 1)
         return 0;
 
+    /* The PNG encoder deflates bands of a picture in parallel with slice
+     * threading; keep frame threading for pictures too small to be split. */
+    if (CONFIG_PNG_ENCODER && avctx->codec_id == AV_CODEC_ID_PNG &&
+        avctx->thread_type & FF_THREAD_SLICE &&
+        !(avctx->flags & AV_CODEC_FLAG_INTERLACED_DCT)) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(avctx->pix_fmt);
+
+        if (desc && ff_png_max_bands(avctx->width, avctx->height,
+                                     av_get_bits_per_pixel(desc)) > 1) {
+            avctx->thread_type &= ~FF_THREAD_FRAME;
+            return 0;
+        }
+    }
+
     if(avctx->thread_count > MAX_THREADS)
         return AVERROR(EINVAL);
 
@@ -330,7 +330,8 @@ static int gif_image_write_image(AVCodecContext *avctx,
     bytestream_put_le16(bytestream, width);
     bytestream_put_le16(bytestream, height);
 
-    if (!palette) {
+    /* in image mode the global palette is always the one of the frame */
+    if (!palette || s->image) {
         bytestream_put_byte(bytestream, 0x00); /* flags */
     } else {
         unsigned i;
@@ -426,7 +427,7 @@ static int gif_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
             memcpy(s->palette, palette, AVPALETTE_SIZE);
             s->transparent_index = get_palette_transparency_index(palette);
             s->palette_loaded = 1;
-        } else if (!memcmp(s->palette, palette, AVPALETTE_SIZE)) {
+        } else if (!s->image && !memcmp(s->palette, palette, AVPALETTE_SIZE)) {
             palette = NULL;
         }
     }
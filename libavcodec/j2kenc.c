@@ -81,6 +81,8 @@
 #define CODEC_JP2 1
 #define CODEC_J2K 0
 
+#define CBLKS_PER_JOB 16 ///< codeblocks coded by one slice thread job
+
 static int lut_nmsedec_ref [1<<NMSEDEC_BITS],
            lut_nmsedec_ref0[1<<NMSEDEC_BITS],
            lut_nmsedec_sig [1<<NMSEDEC_BITS],
@@ -102,6 +104,14 @@ typedef struct {
    Jpeg2000Component *comp;
 } Jpeg2000Tile;
 
+typedef struct {
+    Jpeg2000Component *comp;
+    Jpeg2000Band *band;
+    Jpeg2000Cblk *cblk;
+    int x0, x1, y0, y1; ///< codeblock area in the transformed tile-component
+    int bandpos, lev;
+} Jpeg2000CblkJob;
+
 typedef struct {
     AVClass *class;
     AVCodecContext *avctx;
@@ -127,6 +137,10 @@ typedef struct {
 
     Jpeg2000Tile *tile;
 
+    Jpeg2000CblkJob *cblk_jobs; ///< all codeblocks of the image, in any order
+    int nb_cblk_jobs;
+    int *job_ret;
+
     int format;
     int pred;
 } Jpeg2000EncoderContext;
@@ -447,42 +461,111 @@ static int init_tiles(Jpeg2000EncoderContext *s)
     return 0;
 }
 
-static void copy_frame(Jpeg2000EncoderContext *s)
+/**
+ * list the codeblocks of all tiles, so that they can be coded in parallel
+ */
+static int init_cblk_jobs(Jpeg2000EncoderContext *s)
 {
-    int tileno, compno, i, y, x;
-    uint8_t *line;
+    int tileno, compno, reslevelno, bandno, ret;
+    Jpeg2000CodingStyle *codsty = &s->codsty;
+
     for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++){
-        Jpeg2000Tile *tile = s->tile + tileno;
-        if (s->planar){
-            for (compno = 0; compno < s->ncomponents; compno++){
-                Jpeg2000Component *comp = tile->comp + compno;
-                int *dst = comp->i_data;
-                line = s->picture->data[compno]
-                       + comp->coord[1][0] * s->picture->linesize[compno]
-                       + comp->coord[0][0];
-                for (y = comp->coord[1][0]; y < comp->coord[1][1]; y++){
-                    uint8_t *ptr = line;
-                    for (x = comp->coord[0][0]; x < comp->coord[0][1]; x++)
-                        *dst++ = *ptr++ - (1 << 7);
-                    line += s->picture->linesize[compno];
-                }
-            }
-        } else{
-            line = s->picture->data[0] + tile->comp[0].coord[1][0] * s->picture->linesize[0]
-                   + tile->comp[0].coord[0][0] * s->ncomponents;
-
-            i = 0;
-            for (y = tile->comp[0].coord[1][0]; y < tile->comp[0].coord[1][1]; y++){
-                uint8_t *ptr = line;
-                for (x = tile->comp[0].coord[0][0]; x < tile->comp[0].coord[0][1]; x++, i++){
-                    for (compno = 0; compno < s->ncomponents; compno++){
-                        tile->comp[compno].i_data[i] = *ptr++  - (1 << 7);
+        for (compno = 0; compno < s->ncomponents; compno++){
+            Jpeg2000Component *comp = s->tile[tileno].comp + compno;
+
+            for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++){
+                Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+
+                for (bandno = 0; bandno < reslevel->nbands ; bandno++){
+                    Jpeg2000Band *band = reslevel->band + bandno;
+                    Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
+                    int cblkx, cblky, cblkno=0, xx0, x0, xx1, y0, yy0, yy1, bandpos;
+                    yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
+                    y0 = yy0;
+                    yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
+                                band->coord[1][1]) - band->coord[1][0] + yy0;
+
+                    if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
+                        continue;
+
+                    bandpos = bandno + (reslevelno > 0);
+
+                    if ((ret = av_reallocp_array(&s->cblk_jobs, s->nb_cblk_jobs +
+                                                 prec->nb_codeblocks_width * prec->nb_codeblocks_height,
+                                                 sizeof(*s->cblk_jobs))) < 0) {
+                        s->nb_cblk_jobs = 0;
+                        return ret;
+                    }
+
+                    for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++){
+                        if (reslevelno == 0 || bandno == 1)
+                            xx0 = 0;
+                        else
+                            xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
+                        x0 = xx0;
+                        xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
+                                    band->coord[0][1]) - band->coord[0][0] + xx0;
+
+                        for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
+                            Jpeg2000CblkJob *job = &s->cblk_jobs[s->nb_cblk_jobs++];
+                            Jpeg2000Cblk *cblk = prec->cblk + cblkno;
+
+                            cblk->data   = av_malloc(1 + 8192);
+                            cblk->passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof(*cblk->passes));
+                            if (!cblk->data || !cblk->passes)
+                                return AVERROR(ENOMEM);
+
+                            job->comp    = comp;
+                            job->band    = band;
+                            job->cblk    = cblk;
+                            job->x0      = xx0;
+                            job->x1      = xx1;
+                            job->y0      = yy0;
+                            job->y1      = yy1;
+                            job->bandpos = bandpos;
+                            job->lev     = codsty->nreslevels - reslevelno - 1;
+
+                            xx0 = xx1;
+                            xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
+                        }
+                        yy0 = yy1;
+                        yy1 = FFMIN(yy1 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
                     }
                 }
-                line += s->picture->linesize[0];
             }
         }
     }
+    return 0;
+}
+
+static void copy_tile_comp(Jpeg2000EncoderContext *s, Jpeg2000Component *comp, int compno)
+{
+    int *dst = comp->i_data;
+    int y, x;
+    uint8_t *line;
+
+    if (s->planar){
+        line = s->picture->data[compno]
+               + comp->coord[1][0] * s->picture->linesize[compno]
+               + comp->coord[0][0];
+        for (y = comp->coord[1][0]; y < comp->coord[1][1]; y++){
+            uint8_t *ptr = line;
+            for (x = comp->coord[0][0]; x < comp->coord[0][1]; x++)
+                *dst++ = *ptr++ - (1 << 7);
+            line += s->picture->linesize[compno];
+        }
+    } else{
+        line = s->picture->data[0] + comp->coord[1][0] * s->picture->linesize[0]
+               + comp->coord[0][0] * s->ncomponents + compno;
+        for (y = comp->coord[1][0]; y < comp->coord[1][1]; y++){
+            uint8_t *ptr = line;
+            for (x = comp->coord[0][0]; x < comp->coord[0][1]; x++){
+                *dst++ = *ptr - (1 << 7);
+                ptr += s->ncomponents;
+            }
+            line += s->picture->linesize[0];
+        }
+    }
 }
 
 static void init_quantization(Jpeg2000EncoderContext *s)
@@ -638,7 +721,7 @@ static void encode_clnpass(Jpeg2000T1Context *t1, int width, int height, int ban
         }
 }
 
-static void encode_cblk(Jpeg2000EncoderContext *s, Jpeg2000T1Context *t1, Jpeg2000Cblk *cblk, Jpeg2000Tile *tile,
+static void encode_cblk(Jpeg2000EncoderContext *s, Jpeg2000T1Context *t1, Jpeg2000Cblk *cblk,
                         int width, int height, int bandpos, int lev)
 {
     int pass_t = 2, passno, x, y, max=0, nmsedec, bpno;
@@ -851,119 +934,80 @@ static int getcut(Jpeg2000Cblk *cblk, int64_t lambda, int dwt_norm)
     return res;
 }
 
-static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
+static int dwt_tile_comp(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
 {
-    int precno, compno, reslevelno, bandno, cblkno, lev;
-    Jpeg2000CodingStyle *codsty = &s->codsty;
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+    const int compno = jobnr % s->ncomponents;
+    Jpeg2000Component *comp = s->tile[jobnr / s->ncomponents].comp + compno;
 
-    for (compno = 0; compno < s->ncomponents; compno++){
-        Jpeg2000Component *comp = tile->comp + compno;
+    copy_tile_comp(s, comp, compno);
+    return ff_dwt_encode(&comp->dwt, comp->i_data);
+}
 
-        for (reslevelno = 0, lev = codsty->nreslevels-1; reslevelno < codsty->nreslevels; reslevelno++, lev--){
-            Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+static int encode_cblks(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+    Jpeg2000CodingStyle *codsty = &s->codsty;
+    const int start = jobnr * CBLKS_PER_JOB,
+              end   = FFMIN(start + CBLKS_PER_JOB, s->nb_cblk_jobs);
+    Jpeg2000T1Context t1;
+    int i;
 
-            for (precno = 0; precno < reslevel->num_precincts_x * reslevel->num_precincts_y; precno++){
-                for (bandno = 0; bandno < reslevel->nbands ; bandno++){
-                    int bandpos = bandno + (reslevelno > 0);
-                    Jpeg2000Band *band = reslevel->band + bandno;
-                    Jpeg2000Prec *prec = band->prec + precno;
+    t1.stride = (1<<codsty->log2_cblk_width) + 2;
 
-                    for (cblkno = 0; cblkno < prec->nb_codeblocks_height * prec->nb_codeblocks_width; cblkno++){
-                        Jpeg2000Cblk *cblk = prec->cblk + cblkno;
+    for (i = start; i < end; i++) {
+        const Jpeg2000CblkJob *job = &s->cblk_jobs[i];
+        Jpeg2000Component *comp = job->comp;
+        Jpeg2000Band *band = job->band;
+        int y, x;
 
-                        cblk->ninclpasses = getcut(cblk, s->lambda,
-                                (int64_t)dwt_norms[codsty->transform == FF_DWT53][bandpos][lev] * (int64_t)band->i_stepsize >> 15);
-                    }
+        if (codsty->transform == FF_DWT53){
+            for (y = job->y0; y < job->y1; y++){
+                int *ptr = t1.data + (y-job->y0)*t1.stride;
+                for (x = job->x0; x < job->x1; x++){
+                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
+                }
+            }
+        } else{
+            for (y = job->y0; y < job->y1; y++){
+                int *ptr = t1.data + (y-job->y0)*t1.stride;
+                for (x = job->x0; x < job->x1; x++){
+                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
+                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
+                    ptr++;
                 }
             }
         }
+        encode_cblk(s, &t1, job->cblk, job->x1 - job->x0, job->y1 - job->y0,
+                    job->bandpos, job->lev);
+
+        // rate control
+        job->cblk->ninclpasses = getcut(job->cblk, s->lambda,
+                (int64_t)dwt_norms[codsty->transform == FF_DWT53][job->bandpos][job->lev] * (int64_t)band->i_stepsize >> 15);
     }
+    return 0;
 }
 
-static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+/**
+ * tier-1 coding of the whole image: the tile-components are transformed and
+ * then the codeblocks coded, both in parallel when slice threading is on
+ */
+static int encode_tier1(Jpeg2000EncoderContext *s)
 {
-    int compno, reslevelno, bandno, ret;
-    Jpeg2000T1Context t1;
-    Jpeg2000CodingStyle *codsty = &s->codsty;
-    for (compno = 0; compno < s->ncomponents; compno++){
-        Jpeg2000Component *comp = s->tile[tileno].comp + compno;
-
-        t1.stride = (1<<codsty->log2_cblk_width) + 2;
-
-        av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
-        if ((ret = ff_dwt_encode(&comp->dwt, comp->i_data)) < 0)
-            return ret;
-        av_log(s->avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
+    AVCodecContext *avctx = s->avctx;
+    const int nb_tile_comps = s->numXtiles * s->numYtiles * s->ncomponents;
+    int i;
 
-        for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++){
-            Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
-
-            for (bandno = 0; bandno < reslevel->nbands ; bandno++){
-                Jpeg2000Band *band = reslevel->band + bandno;
-                Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
-                int cblkx, cblky, cblkno=0, xx0, x0, xx1, y0, yy0, yy1, bandpos;
-                yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
-                y0 = yy0;
-                yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
-                            band->coord[1][1]) - band->coord[1][0] + yy0;
-
-                if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
-                    continue;
+    av_log(s->avctx, AV_LOG_DEBUG, "dwt\n");
+    avctx->execute2(avctx, dwt_tile_comp, NULL, s->job_ret, nb_tile_comps);
+    for (i = 0; i < nb_tile_comps; i++)
+        if (s->job_ret[i] < 0)
+            return s->job_ret[i];
 
-                bandpos = bandno + (reslevelno > 0);
-
-                for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++){
-                    if (reslevelno == 0 || bandno == 1)
-                        xx0 = 0;
-                    else
-                        xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
-                    x0 = xx0;
-                    xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
-                                band->coord[0][1]) - band->coord[0][0] + xx0;
-
-                    for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
-                        int y, x;
-                        if (codsty->transform == FF_DWT53){
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
-                                }
-                            }
-                        } else{
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
-                                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
-                                    ptr++;
-                                }
-                            }
-                        }
-                        if (!prec->cblk[cblkno].data)
-                            prec->cblk[cblkno].data = av_malloc(1 + 8192);
-                        if (!prec->cblk[cblkno].passes)
-                            prec->cblk[cblkno].passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof (*prec->cblk[cblkno].passes));
-                        if (!prec->cblk[cblkno].data || !prec->cblk[cblkno].passes)
-                            return AVERROR(ENOMEM);
-                        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
-                                    bandpos, codsty->nreslevels - reslevelno - 1);
-                        xx0 = xx1;
-                        xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
-                    }
-                    yy0 = yy1;
-                    yy1 = FFMIN(yy1 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
-                }
-            }
-        }
-        av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
-    }
-
-    av_log(s->avctx, AV_LOG_DEBUG, "rate control\n");
-    truncpasses(s, tile);
-    if ((ret = encode_packets(s, tile, tileno)) < 0)
-        return ret;
-    av_log(s->avctx, AV_LOG_DEBUG, "after rate control\n");
+    av_log(s->avctx, AV_LOG_DEBUG, "tier1\n");
+    avctx->execute2(avctx, encode_cblks, NULL, NULL,
+                    (s->nb_cblk_jobs + CBLKS_PER_JOB - 1) / CBLKS_PER_JOB);
+    av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
     return 0;
 }
 
@@ -980,6 +1024,8 @@ static void cleanup(Jpeg2000EncoderContext *s)
         av_freep(&s->tile[tileno].comp);
     }
     av_freep(&s->tile);
+    av_freep(&s->cblk_jobs);
+    av_freep(&s->job_ret);
 }
 
 static void reinit(Jpeg2000EncoderContext *s)
@@ -1015,8 +1061,9 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
 
     s->lambda = s->picture->quality * LAMBDA_SCALE;
 
-    copy_frame(s);
     reinit(s);
+    if ((ret = encode_tier1(s)) < 0)
+        return ret;
 
     if (s->format == CODEC_JP2) {
         av_assert0(s->buf == pkt->data);
@@ -1113,7 +1160,7 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         if (s->buf_end - s->buf < 2)
             return -1;
         bytestream_put_be16(&s->buf, JPEG2000_SOD);
-        if ((ret = encode_tile(s, s->tile + tileno, tileno)) < 0)
+        if ((ret = encode_packets(s, s->tile + tileno, tileno)) < 0)
             return ret;
         bytestream_put_be32(&psotptr, s->buf - psotptr + 6);
     }
@@ -1203,6 +1250,12 @@ FF_ENABLE_DEPRECATION_WARNINGS
     init_quantization(s);
     if ((ret=init_tiles(s)) < 0)
         return ret;
+    if ((ret = init_cblk_jobs(s)) < 0)
+        return ret;
+
+    s->job_ret = av_malloc_array(s->numXtiles * s->numYtiles, s->ncomponents * sizeof(*s->job_ret));
+    if (!s->job_ret)
+        return AVERROR(ENOMEM);
 
     av_log(s->avctx, AV_LOG_DEBUG, "after init\n");
 
@@ -1250,6 +1303,7 @@ AVCodec ff_jpeg2000_encoder = {
     .init           = j2kenc_init,
     .encode2        = encode_frame,
     .close          = j2kenc_destroy,
+    .capabilities   = AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_YUV444P, AV_PIX_FMT_GRAY8,
         AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P,
@@ -27,6 +27,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/common.h"
+#include "libavutil/internal.h"
 #include "libavutil/mem.h"
 #include "jpeg2000dwt.h"
 #include "internal.h"
@@ -76,6 +77,43 @@ static inline void extend97_int(int32_t *p, int i0, int i1)
     }
 }
 
+static void sd53_hi_c(int32_t *dst, const int32_t *a, const int32_t *b, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[i] -= (a[i] + b[i]) >> 1;
+}
+
+static void sd53_lo_c(int32_t *dst, const int32_t *a, const int32_t *b, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[i] += (a[i] + b[i] + 2) >> 2;
+}
+
+static void sd97_int_sub_c(int32_t *dst, const int32_t *a, const int32_t *b,
+                           int n, int coef)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[i] -= (coef * (int64_t)(a[i] + b[i]) + (1 << 15)) >> 16;
+}
+
+static void sd97_int_add_c(int32_t *dst, const int32_t *a, const int32_t *b,
+                           int n, int coef)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        dst[i] += (coef * (int64_t)(a[i] + b[i]) + (1 << 15)) >> 16;
+}
+
+/* Row r of the column block, rows hold FF_DWT_COLS neighbouring columns */
+#define ROW(r) (line + (r) * FF_DWT_COLS)
+
 static void sd_1d53(int *p, int i0, int i1)
 {
     int i;
@@ -94,6 +132,44 @@ static void sd_1d53(int *p, int i0, int i1)
         p[2*i] += (p[2*i-1] + p[2*i+1] + 2) >> 2;
 }
 
+/* Same as sd_1d53() on every column of a block, one row at a time */
+static void sd_ver53(DWTContext *s, int *t, int w, int lh, int lv, int mv)
+{
+    int32_t *line = s->i_colbuf + 3 * FF_DWT_COLS;
+    int x, i, j;
+
+    for (x = 0; x < lh; x += FF_DWT_COLS) {
+        const int n = FFMIN(FF_DWT_COLS, lh - x), size = n * sizeof(*t);
+        const int i0 = mv, i1 = mv + lv;
+
+        for (i = 0; i < lv; i++)
+            memcpy(ROW(mv + i), t + w * i + x, size);
+
+        if (i1 <= i0 + 1) {
+            if (i0 == 1)
+                for (i = 0; i < n; i++)
+                    ROW(1)[i] *= 2;
+        } else {
+            memcpy(ROW(i0 - 1), ROW(i0 + 1), size);
+            memcpy(ROW(i1),     ROW(i1 - 2), size);
+            memcpy(ROW(i0 - 2), ROW(i0 + 2), size);
+            memcpy(ROW(i1 + 1), ROW(i1 - 3), size);
+
+            for (i = ((i0+1)>>1) - 1; i < (i1+1)>>1; i++)
+                s->sd53_hi(ROW(2*i+1), ROW(2*i), ROW(2*i+2), n);
+            for (i = ((i0+1)>>1); i < (i1+1)>>1; i++)
+                s->sd53_lo(ROW(2*i), ROW(2*i-1), ROW(2*i+1), n);
+        }
+
+        // copy back and deinterleave
+        j = 0;
+        for (i =   mv; i < lv; i+=2, j++)
+            memcpy(t + w * j + x, ROW(mv + i), size);
+        for (i = 1-mv; i < lv; i+=2, j++)
+            memcpy(t + w * j + x, ROW(mv + i), size);
+    }
+}
+
 static void dwt_encode53(DWTContext *s, int *t)
 {
     int lev,
@@ -110,21 +186,7 @@ static void dwt_encode53(DWTContext *s, int *t)
         int *l;
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
-
-            for (i = 0; i < lv; i++)
-                l[i] = t[w*i + lp];
-
-            sd_1d53(line, mv, mv + lv);
-
-            // copy back and deinterleave
-            for (i =   mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
-            for (i = 1-mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
-        }
+        sd_ver53(s, t, w, lh, lv, mv);
 
         // HOR_SD
         l = line + mh;
@@ -245,6 +307,54 @@ static void sd_1d97_int(int *p, int i0, int i1)
         p[2 * i]     += (I_LFTG_DELTA * (p[2 * i - 1] + p[2 * i + 1]) + (1 << 15)) >> 16;
 }
 
+/* Same as sd_1d97_int() on every column of a block, followed by the scaling
+ * of the low band, one row at a time */
+static void sd_ver97_int(DWTContext *s, int *t, int w, int lh, int lv, int mv)
+{
+    int32_t *line = s->i_colbuf + 5 * FF_DWT_COLS;
+    int x, i, j, k;
+
+    for (x = 0; x < lh; x += FF_DWT_COLS) {
+        const int n = FFMIN(FF_DWT_COLS, lh - x), size = n * sizeof(*t);
+        int i0 = mv, i1 = mv + lv;
+
+        for (i = 0; i < lv; i++)
+            memcpy(ROW(mv + i), t + w * i + x, size);
+
+        if (i1 <= i0 + 1) {
+            if (i0 == 1)
+                for (k = 0; k < n; k++)
+                    ROW(1)[k] = (ROW(1)[k] * I_LFTG_X + (1<<14)) >> 15;
+            else
+                for (k = 0; k < n; k++)
+                    ROW(0)[k] = (ROW(0)[k] * I_LFTG_K + (1<<15)) >> 16;
+        } else {
+            for (i = 1; i <= 4; i++) {
+                memcpy(ROW(i0 - i),     ROW(i0 + i),     size);
+                memcpy(ROW(i1 + i - 1), ROW(i1 - i - 1), size);
+            }
+            i0++; i1++;
+
+            for (i = (i0>>1) - 2; i < (i1>>1) + 1; i++)
+                s->sd97_int_sub(ROW(2 * i + 1), ROW(2 * i),     ROW(2 * i + 2), n, I_LFTG_ALPHA);
+            for (i = (i0>>1) - 1; i < (i1>>1) + 1; i++)
+                s->sd97_int_sub(ROW(2 * i),     ROW(2 * i - 1), ROW(2 * i + 1), n, I_LFTG_BETA);
+            for (i = (i0>>1) - 1; i < (i1>>1); i++)
+                s->sd97_int_add(ROW(2 * i + 1), ROW(2 * i),     ROW(2 * i + 2), n, I_LFTG_GAMMA);
+            for (i = (i0>>1); i < (i1>>1); i++)
+                s->sd97_int_add(ROW(2 * i),     ROW(2 * i - 1), ROW(2 * i + 1), n, I_LFTG_DELTA);
+        }
+
+        // copy back and deinterleave
+        j = 0;
+        for (i =   mv; i < lv; i+=2, j++)
+            for (k = 0; k < n; k++)
+                t[w*j + x + k] = ((ROW(mv + i)[k] * I_LFTG_X) + (1 << 15)) >> 16;
+        for (i = 1-mv; i < lv; i+=2, j++)
+            memcpy(t + w * j + x, ROW(mv + i), size);
+    }
+}
+
 static void dwt_encode97_int(DWTContext *s, int *t)
 {
     int lev;
@@ -266,21 +376,7 @@ static void dwt_encode97_int(DWTContext *s, int *t)
         int *l;
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
-
-            for (i = 0; i < lv; i++)
-                l[i] = t[w*i + lp];
-
-            sd_1d97_int(line, mv, mv + lv);
-
-            // copy back and deinterleave
-            for (i =   mv; i < lv; i+=2, j++)
-                t[w*j + lp] = ((l[i] * I_LFTG_X) + (1 << 15)) >> 16;
-            for (i = 1-mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
-        }
+        sd_ver97_int(s, t, w, lh, lv, mv);
 
         // HOR_SD
         l = line + mh;
@@ -575,6 +671,14 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
     default:
         return -1;
     }
+
+    s->sd53_hi      = sd53_hi_c;
+    s->sd53_lo      = sd53_lo_c;
+    s->sd97_int_sub = sd97_int_sub_c;
+    s->sd97_int_add = sd97_int_add_c;
+    if (ARCH_X86)
+        ff_jpeg2000dwt_init_x86(s);
+
     return 0;
 }
 
@@ -583,6 +687,13 @@ int ff_dwt_encode(DWTContext *s, void *t)
     if (s->ndeclevels == 0)
         return 0;
 
+    if (s->type != FF_DWT97 && !s->i_colbuf) {
+        s->i_colbuf = av_mallocz_array((s->linelen[s->ndeclevels-1][1] + 12) * FF_DWT_COLS,
+                                       sizeof(*s->i_colbuf));
+        if (!s->i_colbuf)
+            return AVERROR(ENOMEM);
+    }
+
     switch(s->type){
         case FF_DWT97:
             dwt_encode97_float(s, t); break;
@@ -621,4 +732,5 @@ void ff_dwt_destroy(DWTContext *s)
 {
     av_freep(&s->f_linebuf);
     av_freep(&s->i_linebuf);
+    av_freep(&s->i_colbuf);
 }
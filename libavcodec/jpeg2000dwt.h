@@ -30,6 +30,7 @@
 #include <stdint.h>
 
 #define FF_DWT_MAX_DECLVLS 32 ///< max number of decomposition levels
+#define FF_DWT_COLS        16 ///< columns lifted at once by the forward vertical transform
 #define F_LFTG_K      1.230174104914001f
 #define F_LFTG_X      0.812893066115961f
 
@@ -48,6 +49,21 @@ typedef struct DWTContext {
     uint8_t type;                        ///< 0 for 9/7; 1 for 5/3
     int32_t *i_linebuf;                  ///< int buffer used by transform
     float   *f_linebuf;                  ///< float buffer used by transform
+    int32_t *i_colbuf;                   ///< FF_DWT_COLS wide column block used by the forward transform
+
+    /**
+     * Lifting steps of the forward transform, applied to n neighbouring
+     * columns at once. a and b are the rows above and below dst.
+     * n may be rounded up to FF_DWT_COLS, the rows must have room for that.
+     */
+    /// dst[i] -= (a[i] + b[i]) >> 1
+    void (*sd53_hi)(int32_t *dst, const int32_t *a, const int32_t *b, int n);
+    /// dst[i] += (a[i] + b[i] + 2) >> 2
+    void (*sd53_lo)(int32_t *dst, const int32_t *a, const int32_t *b, int n);
+    /// dst[i] -= (coef * (a[i] + b[i]) + (1 << 15)) >> 16, with 64 bit product
+    void (*sd97_int_sub)(int32_t *dst, const int32_t *a, const int32_t *b, int n, int coef);
+    /// dst[i] += (coef * (a[i] + b[i]) + (1 << 15)) >> 16, with 64 bit product
+    void (*sd97_int_add)(int32_t *dst, const int32_t *a, const int32_t *b, int n, int coef);
 } DWTContext;
 
 /**
@@ -65,4 +81,6 @@ int ff_dwt_decode(DWTContext *s, void *t);
 
 void ff_dwt_destroy(DWTContext *s);
 
+void ff_jpeg2000dwt_init_x86(DWTContext *s);
+
 #endif /* AVCODEC_JPEG2000DWT_H */
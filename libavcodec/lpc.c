@@ -304,11 +304,11 @@ av_cold int ff_lpc_init(LPCContext *s, int blocksize, int max_order,
     s->max_order = max_order;
     s->lpc_type  = lpc_type;
 
-    s->windowed_buffer = av_mallocz((blocksize + 2 + FFALIGN(max_order, 4)) *
+    s->windowed_buffer = av_mallocz((blocksize + 2 + FFALIGN(max_order + 1, 8)) *
                                     sizeof(*s->windowed_samples));
     if (!s->windowed_buffer)
         return AVERROR(ENOMEM);
-    s->windowed_samples = s->windowed_buffer + FFALIGN(max_order, 4);
+    s->windowed_samples = s->windowed_buffer + FFALIGN(max_order + 1, 8);
 
     s->lpc_apply_welch_window = lpc_apply_welch_window_c;
     s->lpc_compute_autocorr   = lpc_compute_autocorr_c;
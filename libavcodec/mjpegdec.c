@@ -770,10 +770,11 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     return 0;
 }
 
-static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
+static inline int mjpeg_decode_dc(MJpegDecodeContext *s, GetBitContext *gb,
+                                  int dc_index)
 {
     int code;
-    code = get_vlc2(&s->gb, s->vlcs[0][dc_index].table, 9, 2);
+    code = get_vlc2(gb, s->vlcs[0][dc_index].table, 9, 2);
     if (code < 0 || code > 16) {
         av_log(s->avctx, AV_LOG_WARNING,
                "mjpeg_decode_dc: bad vlc: %d:%d (%p)\n",
@@ -782,47 +783,48 @@ static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
     }
 
     if (code)
-        return get_xbits(&s->gb, code);
+        return get_xbits(gb, code);
     else
         return 0;
 }
 
 /* decode block and dequantize */
-static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
+static int decode_block(MJpegDecodeContext *s, GetBitContext *gb, int *last_dc,
+                        int16_t *block, int component,
                         int dc_index, int ac_index, uint16_t *quant_matrix)
 {
     int code, i, j, level, val;
 
     /* DC coef */
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
     }
-    val = val * (unsigned)quant_matrix[0] + s->last_dc[component];
+    val = val * (unsigned)quant_matrix[0] + last_dc[component];
     val = av_clip_int16(val);
-    s->last_dc[component] = val;
+    last_dc[component] = val;
     block[0] = val;
     /* AC coefs */
     i = 0;
-    {OPEN_READER(re, &s->gb);
+    {OPEN_READER(re, gb);
     do {
-        UPDATE_CACHE(re, &s->gb);
-        GET_VLC(code, re, &s->gb, s->vlcs[1][ac_index].table, 9, 2);
+        UPDATE_CACHE(re, gb);
+        GET_VLC(code, re, gb, s->vlcs[1][ac_index].table, 9, 2);
 
         i += ((unsigned)code) >> 4;
             code &= 0xf;
         if (code) {
             if (code > MIN_CACHE_BITS - 16)
-                UPDATE_CACHE(re, &s->gb);
+                UPDATE_CACHE(re, gb);
 
             {
-                int cache = GET_CACHE(re, &s->gb);
+                int cache = GET_CACHE(re, gb);
                 int sign  = (~cache) >> 31;
                 level     = (NEG_USR32(sign ^ cache,code) ^ sign) - sign;
             }
 
-            LAST_SKIP_BITS(re, &s->gb, code);
+            LAST_SKIP_BITS(re, gb, code);
 
             if (i > 63) {
                 av_log(s->avctx, AV_LOG_ERROR, "error count: %d\n", i);
@@ -832,7 +834,7 @@ static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
             block[j] = level * quant_matrix[i];
         }
     } while (i < 63);
-    CLOSE_READER(re, &s->gb);}
+    CLOSE_READER(re, gb);}
 
     return 0;
 }
@@ -843,7 +845,7 @@ static int decode_dc_progressive(MJpegDecodeContext *s, int16_t *block,
 {
     unsigned val;
     s->bdsp.clear_block(block);
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, &s->gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
@@ -1133,7 +1135,7 @@ static int ljpeg_decode_rgb_scan(MJpegDecodeContext *s, int nb_components, int p
                 topleft[i] = top[i];
                 top[i]     = buffer[mb_x][i];
 
-                dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                 if(dc == 0xFFFFF)
                     return -1;
 
@@ -1265,7 +1267,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for(j=0; j<n; j++) {
                         int pred, dc;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1336,7 +1338,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for (j = 0; j < n; j++) {
                         int pred;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1405,6 +1407,158 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
+typedef struct ScanSliceContext {
+    int nb_components;
+    int nb_slices;
+    uint8_t *data[MAX_COMPONENTS];
+    int linesize[MAX_COMPONENTS];
+    int chroma_width, chroma_height;
+    int first_rst;      ///< index in rst_offsets of the marker ending slice 0
+    int end_bits;       ///< bit position in s->gb after the last slice
+} ScanSliceContext;
+
+/**
+ * Decode the MCUs of one restart interval of a baseline scan.
+ * Each interval starts with DC predictors reset and can be decoded
+ * independently of the others.
+ */
+static int decode_scan_slice(AVCodecContext *avctx, void *arg,
+                             int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    ScanSliceContext *td  = arg;
+    LOCAL_ALIGNED_32(int16_t, block, [64]);
+    int bytes_per_pixel   = 1 + (s->bits > 8);
+    int nb_mcus           = s->mb_width * s->mb_height;
+    int mcu               = jobnr * s->restart_interval;
+    int mcu_end           = FFMIN(mcu + s->restart_interval, nb_mcus);
+    const uint8_t *start, *end;
+    int last_dc[MAX_COMPONENTS];
+    GetBitContext gb;
+    int i, ret;
+
+    start = jobnr ? s->buffer + s->rst_offsets[td->first_rst + jobnr - 1].data
+                  : s->buffer;
+    end   = jobnr < td->nb_slices - 1 ?
+            s->buffer + s->rst_offsets[td->first_rst + jobnr].marker :
+            s->gb.buffer_end;
+    ret = init_get_bits8(&gb, start, end - start);
+    if (ret < 0)
+        return ret;
+    if (!jobnr)
+        skip_bits_long(&gb, get_bits_count(&s->gb));
+
+    for (i = 0; i < td->nb_components; i++)
+        last_dc[i] = 4 << s->bits;
+
+    for (; mcu < mcu_end; mcu++) {
+        int mb_x = mcu % s->mb_width;
+        int mb_y = mcu / s->mb_width;
+
+        if (get_bits_left(&gb) < 0) {
+            av_log(avctx, AV_LOG_ERROR, "overread %d\n", -get_bits_left(&gb));
+            return AVERROR_INVALIDDATA;
+        }
+        for (i = 0; i < td->nb_components; i++) {
+            int n = s->nb_blocks[i];
+            int c = s->comp_index[i];
+            int h = s->h_scount[i];
+            int v = s->v_scount[i];
+            int x = 0, y = 0, j;
+
+            for (j = 0; j < n; j++) {
+                int block_offset = (((td->linesize[c] * (v * mb_y + y) * 8) +
+                                     (h * mb_x + x) * 8 * bytes_per_pixel) >> avctx->lowres);
+
+                if (s->interlaced && s->bottom_field)
+                    block_offset += td->linesize[c] >> 1;
+
+                s->bdsp.clear_block(block);
+                if (decode_block(s, &gb, last_dc, block, i,
+                                 s->dc_index[i], s->ac_index[i],
+                                 s->quant_matrixes[s->quant_sindex[i]]) < 0) {
+                    av_log(avctx, AV_LOG_ERROR,
+                           "error y=%d x=%d\n", mb_y, mb_x);
+                    return AVERROR_INVALIDDATA;
+                }
+                if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? td->chroma_width  : s->width)
+                    && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? td->chroma_height : s->height)) {
+                    uint8_t *ptr = td->data[c] + block_offset;
+                    s->idsp.idct_put(ptr, td->linesize[c], block);
+                    if (s->bits & 7)
+                        shift_output(s, ptr, td->linesize[c]);
+                }
+                if (++x == h) {
+                    x = 0;
+                    y++;
+                }
+            }
+        }
+    }
+
+    if (jobnr == td->nb_slices - 1)
+        td->end_bits = (start - s->buffer) * 8 + get_bits_count(&gb);
+
+    return 0;
+}
+
+/**
+ * Decode a baseline scan with one job per restart interval.
+ * @return 1 if the scan was decoded, 0 if it is not suitable for slice
+ *         threading and must be decoded serially, <0 on error
+ */
+static int mjpeg_decode_scan_threaded(MJpegDecodeContext *s, int nb_components,
+                                      uint8_t **data, int *linesize,
+                                      int chroma_width, int chroma_height)
+{
+    ScanSliceContext td = { 0 };
+    int nb_mcus = s->mb_width * s->mb_height;
+    int start   = get_bits_count(&s->gb) >> 3;
+    int *rets, i, ret = 0;
+
+    if (!(s->avctx->active_thread_type & FF_THREAD_SLICE) ||
+        s->avctx->thread_count <= 1 ||
+        s->restart_interval <= 0 || s->restart_interval >= nb_mcus ||
+        s->gb.buffer != s->buffer || get_bits_count(&s->gb) & 7)
+        return 0;
+
+    td.nb_slices = (nb_mcus + s->restart_interval - 1) / s->restart_interval;
+
+    /* Skip markers belonging to a previous field and require one RST marker
+     * per interval boundary, otherwise the intervals cannot be located. */
+    while (td.first_rst < s->nb_rst && s->rst_offsets[td.first_rst].data <= start)
+        td.first_rst++;
+    if (s->nb_rst - td.first_rst < td.nb_slices - 1)
+        return 0;
+
+    td.nb_components = nb_components;
+    td.chroma_width  = chroma_width;
+    td.chroma_height = chroma_height;
+    for (i = 0; i < MAX_COMPONENTS; i++) {
+        td.data[i]     = data[i];
+        td.linesize[i] = linesize[i];
+    }
+
+    rets = av_malloc_array(td.nb_slices, sizeof(*rets));
+    if (!rets)
+        return AVERROR(ENOMEM);
+
+    s->avctx->execute2(s->avctx, decode_scan_slice, &td, rets, td.nb_slices);
+
+    for (i = 0; i < td.nb_slices; i++) {
+        if (rets[i] < 0) {
+            ret = rets[i];
+            break;
+        }
+    }
+    av_free(rets);
+    if (ret < 0)
+        return ret;
+
+    skip_bits_long(&s->gb, td.end_bits - get_bits_count(&s->gb));
+    return 1;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
                              int mb_bitmask_size,
@@ -1440,6 +1594,13 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
         s->coefs_finished[c] |= 1;
     }
 
+    if (!mb_bitmask && !s->progressive) {
+        int ret = mjpeg_decode_scan_threaded(s, nb_components, data, linesize,
+                                             chroma_width, chroma_height);
+        if (ret)
+            return FFMIN(ret, 0);
+    }
+
     for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
         for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
             const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
@@ -1481,7 +1642,7 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
 
                         } else {
                             s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
+                            if (decode_block(s, &s->gb, s->last_dc, s->block, i,
                                              s->dc_index[i], s->ac_index[i],
                                              s->quant_matrixes[s->quant_sindex[i]]) < 0) {
                                 av_log(s->avctx, AV_LOG_ERROR,
@@ -2197,6 +2358,8 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
     if (!s->buffer)
         return AVERROR(ENOMEM);
 
+    s->nb_rst = 0;
+
     /* unescape buffer of SOS, use special treatment for JPEG-LS */
     if (start_code == SOS && !s->ls) {
         const uint8_t *src = *buf_ptr;
@@ -2220,6 +2383,9 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                 uint8_t x = *(ptr++);
 
                 if (x == 0xff) {
+                    /* where this 0xFF lands once the pending data is copied,
+                     * any fill bytes following it are dropped below */
+                    int marker = (dst - s->buffer) + (ptr - 1 - src);
                     ptrdiff_t skip = 0;
                     while (ptr < buf_end && x == 0xff) {
                         x = *(ptr++);
@@ -2240,6 +2406,16 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                         copy_data_segment(1);
                         if (x)
                             break;
+                    } else {
+                        /* remember where each restart interval starts */
+                        void *tmp = av_fast_realloc(s->rst_offsets, &s->rst_offsets_size,
+                                                    (s->nb_rst + 1) * sizeof(*s->rst_offsets));
+                        if (!tmp)
+                            return AVERROR(ENOMEM);
+                        s->rst_offsets = tmp;
+                        s->rst_offsets[s->nb_rst].marker = marker;
+                        s->rst_offsets[s->nb_rst].data   = (dst - s->buffer) + (ptr - src);
+                        s->nb_rst++;
                     }
                 }
             }
@@ -2814,6 +2990,7 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
         av_frame_unref(s->picture_ptr);
 
     av_freep(&s->buffer);
+    av_freep(&s->rst_offsets);
     av_freep(&s->stereo3d);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
@@ -2867,7 +3044,7 @@ AVCodec ff_mjpeg_decoder = {
     .close          = ff_mjpeg_decode_end,
     .decode         = ff_mjpeg_decode_frame,
     .flush          = decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_SLICE_THREADS,
     .max_lowres     = 3,
     .priv_class     = &mjpegdec_class,
     .profiles       = NULL_IF_CONFIG_SMALL(ff_mjpeg_profiles),
@@ -114,6 +114,12 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    struct {
+        int marker;              ///< offset in buffer of the first 0xFF of the RSTn marker
+        int data;                ///< offset in buffer of the data following the marker
+    } *rst_offsets;              ///< restart markers of the current scan
+    unsigned int rst_offsets_size;
+    int nb_rst;
 
     int buggy_avid;
     int cs_itu601;
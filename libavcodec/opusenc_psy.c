@@ -379,6 +379,24 @@ static int bands_dist(OpusPsyContext *s, CeltFrame *f, float *total_dist)
     return 0;
 }
 
+/* Rates a single stereo candidate on a private copy of the frame, so the
+ * candidates do not depend on each other or on the order they ran in */
+static int bands_dist_job(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    OpusPsyContext *s = arg;
+    CeltFrame *f = &s->search_frames[threadnr];
+
+    memcpy(f, s->search_src, sizeof(*f));
+    f->pvq = s->search_pvq[threadnr];
+
+    if (s->search_dual)
+        f->dual_stereo = jobnr;
+    else
+        f->intensity_stereo = f->end_band - jobnr;
+
+    return bands_dist(s, f, &s->search_dist[jobnr]);
+}
+
 static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
 {
     float td1, td2;
@@ -387,9 +405,11 @@ static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
     if (s->avctx->channels < 2)
         return;
 
-    bands_dist(s, f, &td1);
-    f->dual_stereo = 1;
-    bands_dist(s, f, &td2);
+    s->search_src  = f;
+    s->search_dual = 1;
+    s->avctx->execute2(s->avctx, bands_dist_job, s, NULL, 2);
+    td1 = s->search_dist[0];
+    td2 = s->search_dist[1];
 
     f->dual_stereo = td2 < td1;
     s->dual_stereo_used += td2 < td1;
@@ -405,9 +425,13 @@ static void celt_search_for_intensity(OpusPsyContext *s, CeltFrame *f)
     if (s->avctx->channels < 2)
         return;
 
+    s->search_src  = f;
+    s->search_dual = 0;
+    s->avctx->execute2(s->avctx, bands_dist_job, s, NULL,
+                       f->end_band - (int)end_band + 1);
+
     for (i = f->end_band; i >= end_band; i--) {
-        f->intensity_stereo = i;
-        bands_dist(s, f, &dist);
+        dist = s->search_dist[f->end_band - i];
         if (best_dist > dist) {
             best_dist = dist;
             best_band = i;
@@ -568,12 +592,28 @@ av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
             goto fail;
     }
 
+    s->nb_search_threads = avctx->active_thread_type & FF_THREAD_SLICE ? avctx->thread_count : 1;
+    s->search_frames = av_malloc_array(s->nb_search_threads, sizeof(*s->search_frames));
+    s->search_pvq    = av_mallocz_array(s->nb_search_threads, sizeof(*s->search_pvq));
+    if (!s->search_frames || !s->search_pvq) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    for (i = 0; i < s->nb_search_threads; i++)
+        if ((ret = ff_celt_pvq_init(&s->search_pvq[i], 1)) < 0)
+            goto fail;
+
     return 0;
 
 fail:
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    for (i = 0; s->search_pvq && i < s->nb_search_threads; i++)
+        ff_celt_pvq_uninit(&s->search_pvq[i]);
+    av_freep(&s->search_pvq);
+    av_freep(&s->search_frames);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         ff_mdct15_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
@@ -597,6 +637,11 @@ av_cold int ff_opus_psy_end(OpusPsyContext *s)
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    for (i = 0; s->search_pvq && i < s->nb_search_threads; i++)
+        ff_celt_pvq_uninit(&s->search_pvq[i]);
+    av_freep(&s->search_pvq);
+    av_freep(&s->search_frames);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         ff_mdct15_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
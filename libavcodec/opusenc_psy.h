@@ -73,6 +73,14 @@ typedef struct OpusPsyContext {
 
     DECLARE_ALIGNED(32, float, scratch)[2048];
 
+    /* Stereo decision search, one candidate per job */
+    CeltFrame *search_frames;         /* Per thread copy of the frame */
+    struct CeltPVQ **search_pvq;      /* Per thread PVQ scratch */
+    int nb_search_threads;
+    const CeltFrame *search_src;
+    int search_dual;                  /* Searching dual stereo, not intensity */
+    float search_dist[CELT_MAX_BANDS + 1];
+
     /* Stats */
     float rc_waste;
     float avg_is_band;
@@ -70,3 +70,10 @@ int ff_png_pass_row_size(int pass, int bits_per_pixel, int width)
     pass_width = (width - xmin + (1 << shift) - 1) >> shift;
     return (pass_width * bits_per_pixel + 7) >> 3;
 }
+
+int ff_png_max_bands(int width, int height, int bits_per_pixel)
+{
+    int64_t row_size = ((int64_t)width * bits_per_pixel + 7) >> 3;
+
+    return FFMAX(FFMIN(height * (row_size + 1) / PNG_MIN_BAND_SIZE, INT_MAX), 1);
+}
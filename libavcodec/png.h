@@ -44,6 +44,9 @@
 
 #define NB_PASSES 7
 
+/* minimum amount of filtered data deflated by one slice job of the encoder */
+#define PNG_MIN_BAND_SIZE (1 << 16)
+
 #define PNGSIG 0x89504e470d0a1a0a
 #define MNGSIG 0x8a4d4e470d0a1a0a
 
@@ -59,6 +62,10 @@ int ff_png_get_nb_channels(int color_type);
 /* compute the row size of an interleaved pass */
 int ff_png_pass_row_size(int pass, int bits_per_pixel, int width);
 
+/* maximum number of bands a non-interlaced picture is split into by the
+ * slice-threaded encoder, 1 if it is encoded as a whole */
+int ff_png_max_bands(int width, int height, int bits_per_pixel);
+
 void ff_add_png_paeth_prediction(uint8_t *dst, uint8_t *src, uint8_t *top, int w, int bpp);
 
 #endif /* AVCODEC_PNG_H */
@@ -45,6 +45,14 @@ typedef struct APNGFctlChunk {
     uint8_t dispose_op, blend_op;
 } APNGFctlChunk;
 
+typedef struct PNGBand {
+    int start, end;              ///< first and last + 1 row of the band
+    uint8_t *out;                ///< compressed data of the band
+    size_t out_size;             ///< space available at out
+    size_t len;                  ///< number of compressed bytes
+    uLong adler;                 ///< Adler-32 of the uncompressed band
+} PNGBand;
+
 typedef struct PNGEncContext {
     AVClass *class;
     LLVidEncDSPContext llvidencdsp;
@@ -65,6 +73,21 @@ typedef struct PNGEncContext {
     int color_type;
     int bits_per_pixel;
 
+    // slice threading
+    z_stream *band_zstream;      ///< one raw deflate stream per slice thread
+    int nb_band_zstreams;
+    PNGBand *bands;
+    int *band_ret;
+    uint16_t zlib_header;        ///< header matching the streams in band_zstream
+    const AVFrame *band_pict;    ///< picture being encoded by the band jobs
+    int band_row_size;
+    uint8_t *filtered;           ///< filtered rows of the whole picture
+    unsigned int filtered_size;
+    uint8_t *band_buf;           ///< zlib header, compressed bands and Adler-32
+    unsigned int band_buf_size;
+    uint8_t *crow_bufs;          ///< filter scratch buffer of each slice thread
+    unsigned int crow_bufs_size;
+
     // APNG
     uint32_t palette_checksum;   // Used to ensure a single unique palette
     uint32_t sequence_number;
@@ -428,6 +451,150 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static uint16_t png_zlib_header(int level)
+{
+    /* same as the header written by deflate() with a 32K window */
+    int level_flags = level < 0 || level == 6 ? 2 : level < 2 ? 0 : level < 6 ? 1 : 3;
+    int header      = (Z_DEFLATED + (7 << 4)) << 8 | level_flags << 6;
+
+    return header + 31 - header % 31;
+}
+
+static int png_filter_band(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s     = avctx->priv_data;
+    const AVFrame *pict  = s->band_pict;
+    const PNGBand *band  = &s->bands[jobnr];
+    const int row_size   = s->band_row_size;
+    const int crow_size  = FFALIGN((row_size + 32) << 1, 32);
+    // pixel data should be aligned, but there's a control byte before it
+    uint8_t *crow_buf    = s->crow_bufs + threadnr * crow_size + 15;
+    uint8_t *ptr, *top, *crow;
+    int y;
+
+    for (y = band->start; y < band->end; y++) {
+        ptr  = pict->data[0] + y * pict->linesize[0];
+        top  = y ? ptr - pict->linesize[0] : NULL;
+        crow = png_choose_filter(s, crow_buf, ptr, top,
+                                 row_size, s->bits_per_pixel >> 3);
+        memcpy(s->filtered + (size_t)y * (row_size + 1), crow, row_size + 1);
+    }
+
+    return 0;
+}
+
+static int png_deflate_band(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s    = avctx->priv_data;
+    PNGBand *band       = &s->bands[jobnr];
+    z_stream *zstream   = &s->band_zstream[threadnr];
+    const size_t stride = s->band_row_size + 1;
+    const int last      = band->end == s->band_pict->height;
+    uint8_t *in         = s->filtered + band->start * stride;
+    const size_t len    = (band->end - band->start) * stride;
+    int ret;
+
+    if (deflateReset(zstream) != Z_OK)
+        return AVERROR_EXTERNAL;
+
+    /* prime the window with the end of the previous band so that the
+     * compression ratio stays close to the one of a single stream */
+    if (band->start) {
+        const size_t dict_len = FFMIN(band->start * stride, 32768);
+        if (deflateSetDictionary(zstream, in - dict_len, dict_len) != Z_OK)
+            return AVERROR_EXTERNAL;
+    }
+
+    zstream->next_in   = in;
+    zstream->avail_in  = len;
+    zstream->next_out  = band->out;
+    zstream->avail_out = band->out_size;
+
+    /* all bands but the last end on a byte boundary with a non-final block,
+     * so their outputs can simply be concatenated */
+    ret = deflate(zstream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (zstream->avail_in ||
+        (last ? ret != Z_STREAM_END : ret != Z_OK || !zstream->avail_out))
+        return AVERROR_EXTERNAL;
+
+    band->len   = band->out_size - zstream->avail_out;
+    band->adler = adler32(adler32(0L, Z_NULL, 0), in, len);
+
+    return 0;
+}
+
+/**
+ * Filter and deflate horizontal bands of the picture in parallel and join
+ * them into one zlib stream.
+ */
+static int encode_frame_bands(AVCodecContext *avctx, const AVFrame *pict,
+                              int row_size, int nb_bands)
+{
+    PNGEncContext *s    = avctx->priv_data;
+    const size_t stride = row_size + 1;
+    const int crow_size = FFALIGN((row_size + 32) << 1, 32);
+    size_t buf_size     = 2 + 4;
+    uint8_t *ptr, *end;
+    uLong adler;
+    int i, len;
+
+    av_fast_malloc(&s->filtered, &s->filtered_size, pict->height * stride);
+    av_fast_malloc(&s->crow_bufs, &s->crow_bufs_size, crow_size * s->nb_band_zstreams);
+    if (!s->filtered || !s->crow_bufs)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_bands; i++) {
+        PNGBand *band = &s->bands[i];
+
+        band->start    = (int64_t)pict->height *  i      / nb_bands;
+        band->end      = (int64_t)pict->height * (i + 1) / nb_bands;
+        band->out_size = deflateBound(&s->band_zstream[0], (band->end - band->start) * stride) + 16;
+        buf_size      += band->out_size;
+    }
+
+    av_fast_malloc(&s->band_buf, &s->band_buf_size, buf_size);
+    if (!s->band_buf)
+        return AVERROR(ENOMEM);
+
+    ptr = s->band_buf + 2;
+    for (i = 0; i < nb_bands; i++) {
+        s->bands[i].out = ptr;
+        ptr += s->bands[i].out_size;
+    }
+
+    s->band_pict     = pict;
+    s->band_row_size = row_size;
+
+    avctx->execute2(avctx, png_filter_band, NULL, NULL, nb_bands);
+    avctx->execute2(avctx, png_deflate_band, NULL, s->band_ret, nb_bands);
+    for (i = 0; i < nb_bands; i++)
+        if (s->band_ret[i] < 0)
+            return s->band_ret[i];
+
+    /* zlib header, concatenated bands and the combined Adler-32 */
+    ptr = s->band_buf;
+    bytestream_put_be16(&ptr, s->zlib_header);
+    adler = adler32(0L, Z_NULL, 0);
+    for (i = 0; i < nb_bands; i++) {
+        const PNGBand *band = &s->bands[i];
+
+        memmove(ptr, band->out, band->len);
+        ptr  += band->len;
+        adler = adler32_combine(adler, band->adler, (band->end - band->start) * stride);
+    }
+    bytestream_put_be32(&ptr, adler);
+
+    end = ptr;
+    for (ptr = s->band_buf; ptr < end; ptr += len) {
+        len = FFMIN(IOBUF_SIZE, end - ptr);
+        if (s->bytestream_end - s->bytestream <= len + 100)
+            return AVERROR_BUFFER_TOO_SMALL;
+        png_write_image_data(avctx, ptr, len);
+    }
+
+    return 0;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -441,6 +608,13 @@ static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 
     row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
 
+    if (!s->is_progressive && s->nb_band_zstreams > 1) {
+        int nb_bands = FFMIN(s->nb_band_zstreams,
+                             ff_png_max_bands(pict->width, pict->height, s->bits_per_pixel));
+        if (nb_bands > 1)
+            return encode_frame_bands(avctx, pict, row_size, nb_bands);
+    }
+
     crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
     if (!crow_base) {
         ret = AVERROR(ENOMEM);
@@ -1092,14 +1266,47 @@ FF_ENABLE_DEPRECATION_WARNINGS
     if (deflateInit2(&s->zstream, compression_level, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
         return -1;
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE && avctx->thread_count > 1) {
+        int i;
+
+        s->band_zstream = av_calloc(avctx->thread_count, sizeof(*s->band_zstream));
+        s->bands        = av_calloc(avctx->thread_count, sizeof(*s->bands));
+        s->band_ret     = av_calloc(avctx->thread_count, sizeof(*s->band_ret));
+        if (!s->band_zstream || !s->bands || !s->band_ret)
+            return AVERROR(ENOMEM);
+
+        for (i = 0; i < avctx->thread_count; i++) {
+            z_stream *zstream = &s->band_zstream[i];
+
+            zstream->zalloc = ff_png_zalloc;
+            zstream->zfree  = ff_png_zfree;
+            zstream->opaque = NULL;
+            /* raw deflate, the zlib header and trailer are written once per picture */
+            if (deflateInit2(zstream, compression_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return -1;
+            s->nb_band_zstreams++;
+        }
+        s->zlib_header = png_zlib_header(compression_level);
+    }
+
     return 0;
 }
 
 static av_cold int png_enc_close(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
+    int i;
 
     deflateEnd(&s->zstream);
+    for (i = 0; i < s->nb_band_zstreams; i++)
+        deflateEnd(&s->band_zstream[i]);
+    s->nb_band_zstreams = 0;
+    av_freep(&s->band_zstream);
+    av_freep(&s->bands);
+    av_freep(&s->band_ret);
+    av_freep(&s->filtered);
+    av_freep(&s->band_buf);
+    av_freep(&s->crow_bufs);
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_freep(&s->last_frame_packet);
@@ -1146,7 +1353,8 @@ AVCodec ff_png_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_png,
-    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_INTRA_ONLY,
+    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS |
+                      AV_CODEC_CAP_INTRA_ONLY,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
@@ -1167,7 +1375,7 @@ AVCodec ff_apng_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_apng,
-    .capabilities   = AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_DELAY | AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
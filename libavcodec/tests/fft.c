@@ -42,6 +42,7 @@
 #include "libavutil/log.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/time.h"
+#include "libavutil/tx.h"
 
 #if AVFFT
 #include "libavcodec/avfft.h"
@@ -351,13 +352,14 @@ static inline void dct_end(DCTContext *d)
 static void help(void)
 {
     av_log(NULL, AV_LOG_INFO,
-           "usage: fft-test [-h] [-s] [-i] [-n b]\n"
+           "usage: fft-test [-h] [-s] [-i] [-t] [-n b]\n"
            "-h     print this help\n"
            "-s     speed test\n"
            "-m     (I)MDCT test\n"
            "-d     (I)DCT test\n"
            "-r     (I)RDFT test\n"
            "-i     inverse transform test\n"
+           "-t     use the libavutil/tx FFT instead of FFTContext\n"
            "-n b   set the transform size to 2^b\n"
            "-f x   set scale factor for output data of (I)MDCT to x\n");
 }
@@ -382,6 +384,9 @@ int main(int argc, char **argv)
 #if FFT_FLOAT
     RDFTContext *r;
     DCTContext *d;
+    AVTXContext *tx = NULL;
+    av_tx_fn tx_fn;
+    int do_tx = 0;
 #endif /* FFT_FLOAT */
     int it, i, err = 1;
     int do_speed = 0, do_inverse = 0;
@@ -402,7 +407,7 @@ int main(int argc, char **argv)
     av_lfg_init(&prng, 1);
 
     for (;;) {
-        int c = getopt(argc, argv, "hsimrdn:f:c:");
+        int c = getopt(argc, argv, "hsimrdtn:f:c:");
         if (c == -1)
             break;
         switch (c) {
@@ -424,6 +429,11 @@ int main(int argc, char **argv)
         case 'd':
             transform = TRANSFORM_DCT;
             break;
+#if FFT_FLOAT
+        case 't':
+            do_tx = 1;
+            break;
+#endif /* FFT_FLOAT */
         case 'n':
             fft_nbits = atoi(optarg);
             break;
@@ -468,6 +478,15 @@ int main(int argc, char **argv)
             av_log(NULL, AV_LOG_INFO, "IFFT");
         else
             av_log(NULL, AV_LOG_INFO, "FFT");
+#if FFT_FLOAT
+        if (do_tx) {
+            const float tx_scale = 1.0f;
+            av_log(NULL, AV_LOG_INFO, " (tx)");
+            if ((err = av_tx_init(&tx, &tx_fn, AV_TX_FLOAT_FFT, do_inverse,
+                                  fft_size, &tx_scale, 0)) < 0)
+                goto cleanup;
+        } else
+#endif /* FFT_FLOAT */
         fft_init(&s, fft_nbits, do_inverse);
         if ((err = fft_ref_init(fft_nbits, do_inverse)) < 0)
             goto cleanup;
@@ -525,9 +544,16 @@ int main(int argc, char **argv)
         break;
 #endif /* CONFIG_MDCT */
     case TRANSFORM_FFT:
-        memcpy(tab, tab1, fft_size * sizeof(FFTComplex));
-        fft_permute(s, tab);
-        fft_calc(s, tab);
+#if FFT_FLOAT
+        if (tx) {
+            tx_fn(tx, tab, tab1, sizeof(*tab));
+        } else
+#endif /* FFT_FLOAT */
+        {
+            memcpy(tab, tab1, fft_size * sizeof(FFTComplex));
+            fft_permute(s, tab);
+            fft_calc(s, tab);
+        }
 
         fft_ref(tab_ref, tab1, fft_nbits);
         err = check_diff(&tab_ref->re, &tab->re, fft_size * 2, 1.0);
@@ -602,6 +628,13 @@ int main(int argc, char **argv)
                         mdct_calc(m, &tab->re, &tab1->re);
                     break;
                 case TRANSFORM_FFT:
+#if FFT_FLOAT
+                    /* out of place, so no copy is needed */
+                    if (tx) {
+                        tx_fn(tx, tab, tab1, sizeof(*tab));
+                        break;
+                    }
+#endif /* FFT_FLOAT */
                     memcpy(tab, tab1, fft_size * sizeof(FFTComplex));
                     fft_calc(s, tab);
                     break;
@@ -636,6 +669,12 @@ int main(int argc, char **argv)
         break;
 #endif /* CONFIG_MDCT */
     case TRANSFORM_FFT:
+#if FFT_FLOAT
+        if (tx) {
+            av_tx_uninit(&tx);
+            break;
+        }
+#endif /* FFT_FLOAT */
         fft_end(s);
         break;
 #if FFT_FLOAT
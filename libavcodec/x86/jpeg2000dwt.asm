@@ -0,0 +1,119 @@
+;******************************************************************************
+;* SIMD optimized JPEG 2000 forward DWT
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_2:         times 8 dd 2
+pq_round_16:  times 4 dq 0x8000
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_jpeg2000_sd53_<hi|lo>_<opt>(int32_t *dst, const int32_t *a,
+;                                     const int32_t *b, int n)
+;------------------------------------------------------------------------------
+%macro SD53 0
+cglobal jpeg2000_sd53_hi, 4, 4, 2, dst, a, b, n
+.loop:
+    mova      m0, [aq]
+    paddd     m0, [bq]
+    psrad     m0, 1
+    mova      m1, [dstq]
+    psubd     m1, m0
+    mova  [dstq], m1
+    add       aq, mmsize
+    add       bq, mmsize
+    add     dstq, mmsize
+    sub       nd, mmsize/4
+    jg .loop
+    RET
+
+cglobal jpeg2000_sd53_lo, 4, 4, 3, dst, a, b, n
+    mova      m2, [pd_2]
+.loop:
+    mova      m0, [aq]
+    paddd     m0, [bq]
+    paddd     m0, m2
+    psrad     m0, 2
+    mova      m1, [dstq]
+    paddd     m1, m0
+    mova  [dstq], m1
+    add       aq, mmsize
+    add       bq, mmsize
+    add     dstq, mmsize
+    sub       nd, mmsize/4
+    jg .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+SD53
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SD53
+%endif
+
+;------------------------------------------------------------------------------
+; void ff_jpeg2000_sd97_int_<sub|add>_<opt>(int32_t *dst, const int32_t *a,
+;                                           const int32_t *b, int n, int coef)
+;------------------------------------------------------------------------------
+; The products need up to 48 bits, so even and odd lanes are multiplied
+; separately with pmuldq. Bits 16-47 of the rounded products are the result.
+%macro SD97_INT 1 ; sub/add
+cglobal jpeg2000_sd97_int_%1, 5, 5, 6, dst, a, b, n, coef
+    movd     xm4, coefd
+%if cpuflag(avx2)
+    vpbroadcastd m4, xm4
+%else
+    pshufd    m4, m4, 0
+%endif
+    mova      m5, [pq_round_16]
+.loop:
+    mova      m0, [aq]
+    paddd     m0, [bq]
+    psrlq     m1, m0, 32
+    pmuldq    m0, m4
+    pmuldq    m1, m4
+    paddq     m0, m5
+    paddq     m1, m5
+    psrlq     m0, 16
+    psllq     m1, 16
+    pblendw   m0, m1, 0xCC
+    mova      m2, [dstq]
+    p%1d      m2, m0
+    mova  [dstq], m2
+    add       aq, mmsize
+    add       bq, mmsize
+    add     dstq, mmsize
+    sub       nd, mmsize/4
+    jg .loop
+    RET
+%endmacro
+
+INIT_XMM sse4
+SD97_INT sub
+SD97_INT add
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SD97_INT sub
+SD97_INT add
+%endif
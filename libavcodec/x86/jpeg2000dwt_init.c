@@ -0,0 +1,55 @@
+/*
+ * SIMD optimized JPEG 2000 forward DWT
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/jpeg2000dwt.h"
+
+void ff_jpeg2000_sd53_hi_sse2(int32_t *dst, const int32_t *a, const int32_t *b, int n);
+void ff_jpeg2000_sd53_lo_sse2(int32_t *dst, const int32_t *a, const int32_t *b, int n);
+void ff_jpeg2000_sd53_hi_avx2(int32_t *dst, const int32_t *a, const int32_t *b, int n);
+void ff_jpeg2000_sd53_lo_avx2(int32_t *dst, const int32_t *a, const int32_t *b, int n);
+void ff_jpeg2000_sd97_int_sub_sse4(int32_t *dst, const int32_t *a, const int32_t *b, int n, int coef);
+void ff_jpeg2000_sd97_int_add_sse4(int32_t *dst, const int32_t *a, const int32_t *b, int n, int coef);
+void ff_jpeg2000_sd97_int_sub_avx2(int32_t *dst, const int32_t *a, const int32_t *b, int n, int coef);
+void ff_jpeg2000_sd97_int_add_avx2(int32_t *dst, const int32_t *a, const int32_t *b, int n, int coef);
+
+av_cold void ff_jpeg2000dwt_init_x86(DWTContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        s->sd53_hi = ff_jpeg2000_sd53_hi_sse2;
+        s->sd53_lo = ff_jpeg2000_sd53_lo_sse2;
+    }
+
+    if (EXTERNAL_SSE4(cpu_flags)) {
+        s->sd97_int_sub = ff_jpeg2000_sd97_int_sub_sse4;
+        s->sd97_int_add = ff_jpeg2000_sd97_int_add_sse4;
+    }
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        s->sd53_hi      = ff_jpeg2000_sd53_hi_avx2;
+        s->sd53_lo      = ff_jpeg2000_sd53_lo_avx2;
+        s->sd97_int_sub = ff_jpeg2000_sd97_int_sub_avx2;
+        s->sd97_int_add = ff_jpeg2000_sd97_int_add_avx2;
+    }
+}
@@ -0,0 +1,120 @@
+;******************************************************************************
+;* SIMD-optimized LPC functions
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_1: times 4 dq 1.0
+
+SECTION .text
+
+; m%1 += m%2 * m%3, clobbers m%3
+%macro MACPD 3
+%if cpuflag(fma3)
+    fmaddpd    m%1, m%2, m%3, m%1
+%else
+    mulpd      m%3, m%3, m%2
+    addpd      m%1, m%1, m%3
+%endif
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_lpc_compute_autocorr(const double *data, int len, int lag,
+;                              double *autoc)
+;
+; Computes 8 lags per pass over the data, two samples per iteration.
+; Lags past the requested ones are read from the padding preceding data
+; and discarded.
+;------------------------------------------------------------------------------
+
+%macro LPC_COMPUTE_AUTOCORR 0
+cglobal lpc_compute_autocorr, 4, 6, 8, data, len, lag, autoc, i, k
+    movsxdifnidn lenq, lend
+    movsxdifnidn lagq, lagd
+    shl        lenq, 3
+    add       dataq, lenq
+    neg        lenq
+    inc        lagq
+    mov          kq, dataq
+.group:
+    movapd       m0, [pd_1]
+    movapd       m1, m0
+    xorpd        m2, m2, m2
+    xorpd        m3, m3, m3
+    mov          iq, lenq
+.loop:
+    vbroadcastsd m4, [dataq + iq]
+    movupd       m6, [kq + iq - 3*8]
+    movupd       m7, [kq + iq - 7*8]
+    MACPD         0, 4, 6
+    MACPD         1, 4, 7
+    vbroadcastsd m5, [dataq + iq + 8]
+    movupd       m6, [kq + iq - 2*8]
+    movupd       m7, [kq + iq - 6*8]
+    MACPD         2, 5, 6
+    MACPD         3, 5, 7
+    add          iq, 16
+    jl .loop
+
+    addpd        m0, m0, m2
+    addpd        m1, m1, m3
+    ; the lanes hold the lags in decreasing order
+    vperm2f128   m0, m0, m0, 1
+    vperm2f128   m1, m1, m1, 1
+    vpermilpd    m0, m0, 5
+    vpermilpd    m1, m1, 5
+
+    sub        lagq, 8
+    jl .tail
+    movupd [autocq], m0
+    movupd [autocq + mmsize], m1
+    add      autocq, 2*mmsize
+    sub          kq, 8*8
+    test       lagq, lagq
+    jnz .group
+    RET
+
+.tail:
+    add        lagq, 8
+    cmp        lagq, 4
+    jl .tail_xmm
+    movupd [autocq], m0
+    add      autocq, mmsize
+    sub        lagq, 4
+    jz .end
+    mova         m0, m1
+.tail_xmm:
+    movsd   [autocq], xm0
+    cmp        lagq, 2
+    jl .end
+    movhpd  [autocq + 8], xm0
+    cmp        lagq, 3
+    jl .end
+    vextractf128 xm0, m0, 1
+    movsd   [autocq + 16], xm0
+.end:
+    RET
+%endmacro
+
+INIT_YMM avx
+LPC_COMPUTE_AUTOCORR
+INIT_YMM fma3
+LPC_COMPUTE_AUTOCORR
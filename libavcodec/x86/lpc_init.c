@@ -26,6 +26,11 @@
 #include "libavutil/x86/cpu.h"
 #include "libavcodec/lpc.h"
 
+void ff_lpc_compute_autocorr_avx(const double *data, int len, int lag,
+                                 double *autoc);
+void ff_lpc_compute_autocorr_fma3(const double *data, int len, int lag,
+                                  double *autoc);
+
 DECLARE_ASM_CONST(16, double, pd_1)[2] = { 1.0, 1.0 };
 DECLARE_ASM_CONST(16, double, pd_2)[2] = { 2.0, 2.0 };
 
@@ -151,12 +156,17 @@ static void lpc_compute_autocorr_sse2(const double *data, int len, int lag,
 
 av_cold void ff_lpc_init_x86(LPCContext *c)
 {
-#if HAVE_SSE2_INLINE
     int cpu_flags = av_get_cpu_flags();
 
+#if HAVE_SSE2_INLINE
     if (INLINE_SSE2(cpu_flags) || INLINE_SSE2_SLOW(cpu_flags)) {
         c->lpc_apply_welch_window = lpc_apply_welch_window_sse2;
         c->lpc_compute_autocorr   = lpc_compute_autocorr_sse2;
     }
 #endif /* HAVE_SSE2_INLINE */
+
+    if (EXTERNAL_AVX_FAST(cpu_flags))
+        c->lpc_compute_autocorr = ff_lpc_compute_autocorr_avx;
+    if (EXTERNAL_FMA3_FAST(cpu_flags))
+        c->lpc_compute_autocorr = ff_lpc_compute_autocorr_fma3;
 }
@@ -23,7 +23,7 @@
 #include "libavfilter/internal.h"
 #include "libavutil/common.h"
 #include "libavutil/opt.h"
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 #include "libavutil/eval.h"
 #include "audio.h"
 #include "filters.h"
@@ -36,9 +36,11 @@ typedef struct AFFTFiltContext {
     int fft_size;
     int fft_bits;
 
-    FFTContext *fft, *ifft;
-    FFTComplex **fft_data;
-    FFTComplex **fft_temp;
+    AVTXContext *fft, *ifft;
+    av_tx_fn tx_fn, itx_fn;
+    AVComplexFloat **fft_data;
+    AVComplexFloat **fft_temp;
+    AVComplexFloat *fft_out;
     int nb_exprs;
     int channels;
     int window_size;
@@ -129,17 +131,20 @@ static int config_input(AVFilterLink *inlink)
     float overlap;
     char *args;
     const char *last_expr = "1";
+    const float scale = 1.f;
 
     s->channels = inlink->channels;
     s->pts  = AV_NOPTS_VALUE;
     s->fft_bits = av_log2(s->fft_size);
-    s->fft  = av_fft_init(s->fft_bits, 0);
-    s->ifft = av_fft_init(s->fft_bits, 1);
-    if (!s->fft || !s->ifft)
-        return AVERROR(ENOMEM);
-
     s->window_size = 1 << s->fft_bits;
 
+    ret = av_tx_init(&s->fft, &s->tx_fn, AV_TX_FLOAT_FFT, 0, s->window_size, &scale, 0);
+    if (ret < 0)
+        return ret;
+    ret = av_tx_init(&s->ifft, &s->itx_fn, AV_TX_FLOAT_FFT, 1, s->window_size, &scale, 0);
+    if (ret < 0)
+        return ret;
+
     s->fft_data = av_calloc(inlink->channels, sizeof(*s->fft_data));
     if (!s->fft_data)
         return AVERROR(ENOMEM);
@@ -160,6 +165,10 @@ static int config_input(AVFilterLink *inlink)
             return AVERROR(ENOMEM);
     }
 
+    s->fft_out = av_calloc(s->window_size, sizeof(*s->fft_out));
+    if (!s->fft_out)
+        return AVERROR(ENOMEM);
+
     s->real = av_calloc(inlink->channels, sizeof(*s->real));
     if (!s->real)
         return AVERROR(ENOMEM);
@@ -254,16 +263,16 @@ static int filter_frame(AVFilterLink *inlink)
 
     for (ch = 0; ch < inlink->channels; ch++) {
         const float *src = (float *)in->extended_data[ch];
-        FFTComplex *fft_data = s->fft_data[ch];
+        AVComplexFloat *fft_temp = s->fft_temp[ch];
 
         for (n = 0; n < in->nb_samples; n++) {
-            fft_data[n].re = src[n] * s->window_func_lut[n];
-            fft_data[n].im = 0;
+            fft_temp[n].re = src[n] * s->window_func_lut[n];
+            fft_temp[n].im = 0;
         }
 
         for (; n < window_size; n++) {
-            fft_data[n].re = 0;
-            fft_data[n].im = 0;
+            fft_temp[n].re = 0;
+            fft_temp[n].im = 0;
         }
     }
 
@@ -272,16 +281,12 @@ static int filter_frame(AVFilterLink *inlink)
     values[VAR_NBBINS]      = window_size / 2;
     values[VAR_CHANNELS]    = inlink->channels;
 
-    for (ch = 0; ch < inlink->channels; ch++) {
-        FFTComplex *fft_data = s->fft_data[ch];
-
-        av_fft_permute(s->fft, fft_data);
-        av_fft_calc(s->fft, fft_data);
-    }
+    for (ch = 0; ch < inlink->channels; ch++)
+        s->tx_fn(s->fft, s->fft_data[ch], s->fft_temp[ch], sizeof(AVComplexFloat));
 
     for (ch = 0; ch < inlink->channels; ch++) {
-        FFTComplex *fft_data = s->fft_data[ch];
-        FFTComplex *fft_temp = s->fft_temp[ch];
+        AVComplexFloat *fft_data = s->fft_data[ch];
+        AVComplexFloat *fft_temp = s->fft_temp[ch];
         float *buf = (float *)s->buffer->extended_data[ch];
         int x;
         values[VAR_CHANNEL] = ch;
@@ -305,11 +310,10 @@ static int filter_frame(AVFilterLink *inlink)
             fft_temp[n].im = -fft_temp[x].im;
         }
 
-        av_fft_permute(s->ifft, fft_temp);
-        av_fft_calc(s->ifft, fft_temp);
+        s->itx_fn(s->ifft, s->fft_out, fft_temp, sizeof(AVComplexFloat));
 
         for (i = 0; i < window_size; i++) {
-            buf[i] += s->fft_temp[ch][i].re * f;
+            buf[i] += s->fft_out[i].re * f;
         }
     }
 
@@ -434,8 +438,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     AFFTFiltContext *s = ctx->priv;
     int i;
 
-    av_fft_end(s->fft);
-    av_fft_end(s->ifft);
+    av_tx_uninit(&s->fft);
+    av_tx_uninit(&s->ifft);
 
     for (i = 0; i < s->channels; i++) {
         if (s->fft_data)
@@ -445,6 +449,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     }
     av_freep(&s->fft_data);
     av_freep(&s->fft_temp);
+    av_freep(&s->fft_out);
 
     for (i = 0; i < s->nb_exprs; i++) {
         av_expr_free(s->real[i]);
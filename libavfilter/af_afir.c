@@ -57,6 +57,18 @@ static void fcmul_add_c(float *sum, const float *t, const float *c, ptrdiff_t le
     sum[2 * n] += t[2 * n] * c[2 * n];
 }
 
+static void fir_direct_c(float *dst, const float *src, const float *ir,
+                         ptrdiff_t ir_len, ptrdiff_t len)
+{
+    for (int n = 0; n < len; n++) {
+        float sum = 0.f;
+
+        for (int j = 0; j < ir_len; j++)
+            sum += src[n + j] * ir[j];
+        dst[n] = sum;
+    }
+}
+
 static void direct(const float *in, const FFTComplex *ir, int len, float *out)
 {
     for (int n = 0; n < len; n++)
@@ -64,10 +76,70 @@ static void direct(const float *in, const FFTComplex *ir, int len, float *out)
             out[n] += ir[m].re * in[n - m];
 }
 
-static int fir_quantum(AVFilterContext *ctx, AVFrame *out, int ch, int offset)
+static void fcmul_partitions(AudioFIRContext *s, AudioFIRSegment *seg, int ch,
+                             float *sum, int start, int end)
+{
+    int j = seg->part_index[ch] - start;
+
+    if (j < 0)
+        j += seg->nb_partitions;
+
+    for (int i = start; i < end; i++) {
+        const int coffset = j * seg->coeff_size;
+        const float *block = (const float *)seg->block->extended_data[ch] + i * seg->block_size;
+        const FFTComplex *coeff = (const FFTComplex *)seg->coeff->extended_data[ch * !s->one2many] + coffset;
+
+        s->afirdsp.fcmul_add(sum, block, (const float *)coeff, seg->part_size);
+
+        if (j == 0)
+            j = seg->nb_partitions;
+        j--;
+    }
+}
+
+/*
+ * Sum the products of all partitions but the one of the block due next, which
+ * only depend on past input, for the segments flagged in fir_frame(). Every
+ * job handles a range of partitions of one channel.
+ */
+static int fir_part_sums(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFIRContext *s = ctx->priv;
+    AVFrame *out = arg;
+    const int nb_splits = nb_jobs / out->channels;
+    const int ch = jobnr / nb_splits;
+    const int split = jobnr % nb_splits;
+
+    for (int segment = 0; segment < s->nb_segments; segment++) {
+        AudioFIRSegment *seg = &s->seg[segment];
+        const int cur = seg->part_index[ch];
+        int start, end;
+        float *sum;
+
+        if (split >= seg->nb_part_jobs)
+            continue;
+
+        start = (seg->nb_partitions * split) / seg->nb_part_jobs;
+        end   = (seg->nb_partitions * (split+1)) / seg->nb_part_jobs;
+        sum   = seg->part_sum + (ch * seg->max_part_jobs + split) * seg->block_size;
+        memset(sum, 0, sizeof(*sum) * seg->fft_length);
+
+        if (cur >= start && cur < end) {
+            fcmul_partitions(s, seg, ch, sum, start, cur);
+            fcmul_partitions(s, seg, ch, sum, cur + 1, end);
+        } else {
+            fcmul_partitions(s, seg, ch, sum, start, end);
+        }
+    }
+
+    return 0;
+}
+
+static int fir_quantum(AVFilterContext *ctx, AVFrame *in_frame, AVFrame *out,
+                       int ch, int offset)
 {
     AudioFIRContext *s = ctx->priv;
-    const float *in = (const float *)s->in->extended_data[ch] + offset;
+    const float *in = (const float *)in_frame->extended_data[ch] + offset;
     float *block, *buf, *ptr = (float *)out->extended_data[ch] + offset;
     const int nb_samples = FFMIN(s->min_part_size, out->nb_samples - offset);
     int n, i, j;
@@ -135,18 +207,18 @@ static int fir_quantum(AVFilterContext *ctx, AVFrame *out, int ch, int offset)
         block[2 * seg->part_size] = block[1];
         block[1] = 0;
 
-        j = seg->part_index[ch];
+        if (seg->nb_part_jobs) {
+            const int cur = seg->part_index[ch];
 
-        for (i = 0; i < seg->nb_partitions; i++) {
-            const int coffset = j * seg->coeff_size;
-            const float *block = (const float *)seg->block->extended_data[ch] + i * seg->block_size;
-            const FFTComplex *coeff = (const FFTComplex *)seg->coeff->extended_data[ch * !s->one2many] + coffset;
+            fcmul_partitions(s, seg, ch, sum, cur, cur + 1);
+            for (i = 0; i < seg->nb_part_jobs; i++) {
+                const float *part_sum = seg->part_sum + (ch * seg->max_part_jobs + i) * seg->block_size;
 
-            s->afirdsp.fcmul_add(sum, block, (const float *)coeff, seg->part_size);
-
-            if (j == 0)
-                j = seg->nb_partitions;
-            j--;
+                for (n = 0; n < seg->fft_length; n++)
+                    sum[n] += part_sum[n];
+            }
+        } else {
+            fcmul_partitions(s, seg, ch, sum, 0, seg->nb_partitions);
         }
 
         sum[1] = sum[2 * seg->part_size];
@@ -187,7 +259,52 @@ static int fir_channel(AVFilterContext *ctx, AVFrame *out, int ch)
     AudioFIRContext *s = ctx->priv;
 
     for (int offset = 0; offset < out->nb_samples; offset += s->min_part_size) {
-        fir_quantum(ctx, out, ch, offset);
+        fir_quantum(ctx, s->in, out, ch, offset);
+    }
+
+    return 0;
+}
+
+/*
+ * Zero-latency mode: the first min_part_size taps are convolved directly, the
+ * rest of the IR by the partitioned convolution run on the previous complete
+ * block of min_part_size input samples, whose output is due exactly one block
+ * later.
+ */
+static int fir_channel_zl(AVFilterContext *ctx, AVFrame *out, int ch)
+{
+    AudioFIRContext *s = ctx->priv;
+    const int part_size = s->min_part_size;
+    const int head_size = s->head_size;
+    const float *in = (const float *)s->in->extended_data[ch];
+    const float *head = (const float *)s->head->extended_data[ch * !s->one2many];
+    float *hist = (float *)s->head_buf->extended_data[ch];
+    float *tail_in = (float *)s->tail_in->extended_data[ch];
+    float *tail_out = (float *)s->tail_out->extended_data[ch];
+    float *dst = (float *)out->extended_data[ch];
+    int pos = s->tail_pos;
+
+    for (int offset = 0; offset < out->nb_samples;) {
+        const int nb_samples = FFMIN(part_size - pos, out->nb_samples - offset);
+
+        for (int n = 0; n < nb_samples; n++)
+            hist[head_size - 1 + n] = in[offset + n] * s->dry_gain;
+        memcpy(tail_in + pos, in + offset, nb_samples * sizeof(*tail_in));
+
+        s->afirdsp.fir_direct(dst + offset, hist, head, head_size, nb_samples);
+        for (int n = 0; n < nb_samples; n++)
+            dst[offset + n] = dst[offset + n] * s->wet_gain + tail_out[pos + n];
+
+        memmove(hist, hist + nb_samples, (head_size - 1) * sizeof(*hist));
+
+        offset += nb_samples;
+        pos    += nb_samples;
+        if (pos == part_size) {
+            memset(tail_out, 0, part_size * sizeof(*tail_out));
+            if (s->nb_segments)
+                fir_quantum(ctx, s->tail_in, s->tail_out, ch, 0);
+            pos = 0;
+        }
     }
 
     return 0;
@@ -206,9 +323,23 @@ static int fir_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
+static int fir_channels_zl(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AVFrame *out = arg;
+    const int start = (out->channels * jobnr) / nb_jobs;
+    const int end = (out->channels * (jobnr+1)) / nb_jobs;
+
+    for (int ch = start; ch < end; ch++) {
+        fir_channel_zl(ctx, out, ch);
+    }
+
+    return 0;
+}
+
 static int fir_frame(AudioFIRContext *s, AVFrame *in, AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
     AVFrame *out = NULL;
 
     out = ff_get_audio_buffer(outlink, in->nb_samples);
@@ -220,8 +351,34 @@ static int fir_frame(AudioFIRContext *s, AVFrame *in, AVFilterLink *outlink)
     if (s->pts == AV_NOPTS_VALUE)
         s->pts = in->pts;
     s->in = in;
-    ctx->internal->execute(ctx, fir_channels, out, NULL, FFMIN(outlink->channels,
-                                                               ff_filter_get_nb_threads(ctx)));
+    if (s->zero_latency) {
+        ctx->internal->execute(ctx, fir_channels_zl, out, NULL, FFMIN(outlink->channels,
+                                                                      nb_threads));
+        s->tail_pos = (s->tail_pos + out->nb_samples) % s->min_part_size;
+    } else {
+        const int nb_quanta = (out->nb_samples + s->min_part_size - 1) / s->min_part_size;
+        int nb_splits = 0;
+
+        /* with threads to spare, the past partitions of the large segments
+         * stepping exactly once in this frame are summed ahead of the
+         * channel jobs */
+        for (int segment = 0; segment < s->nb_segments; segment++) {
+            AudioFIRSegment *seg = &s->seg[segment];
+            const int period = seg->part_size / s->min_part_size;
+            const int due = (seg->part_size - seg->output_offset[0]) / s->min_part_size;
+
+            seg->nb_part_jobs = 0;
+            if (seg->max_part_jobs && due <= nb_quanta && due + period > nb_quanta) {
+                seg->nb_part_jobs = seg->max_part_jobs;
+                nb_splits = FFMAX(nb_splits, seg->nb_part_jobs);
+            }
+        }
+        if (nb_splits)
+            ctx->internal->execute(ctx, fir_part_sums, out, NULL, outlink->channels * nb_splits);
+
+        ctx->internal->execute(ctx, fir_channels, out, NULL, FFMIN(outlink->channels,
+                                                                   nb_threads));
+    }
 
     out->pts = s->pts;
     if (s->pts != AV_NOPTS_VALUE)
@@ -410,6 +567,17 @@ static int init_segment(AVFilterContext *ctx, AudioFIRSegment *seg,
     if (!seg->buffer || !seg->sum || !seg->block || !seg->coeff || !seg->input || !seg->output)
         return AVERROR(ENOMEM);
 
+    seg->max_part_jobs = FFMIN(ff_filter_get_nb_threads(ctx) / ctx->inputs[0]->channels,
+                               nb_partitions);
+    if (part_size >= 8 && part_size > s->min_part_size && seg->max_part_jobs > 1) {
+        seg->part_sum = av_calloc(ctx->inputs[0]->channels * seg->max_part_jobs * seg->block_size,
+                                  sizeof(*seg->part_sum));
+        if (!seg->part_sum)
+            return AVERROR(ENOMEM);
+    } else {
+        seg->max_part_jobs = 0;
+    }
+
     return 0;
 }
 
@@ -433,6 +601,7 @@ static void uninit_segment(AVFilterContext *ctx, AudioFIRSegment *seg)
 
     av_freep(&seg->output_offset);
     av_freep(&seg->part_index);
+    av_freep(&seg->part_sum);
 
     av_frame_free(&seg->block);
     av_frame_free(&seg->sum);
@@ -467,6 +636,24 @@ static int convert_coeffs(AVFilterContext *ctx)
 
         s->min_part_size = part_size;
 
+        if (s->zero_latency) {
+            /* the head of the IR is not part of any segment */
+            left -= part_size;
+
+            s->head_size = FFALIGN(part_size, 16);
+            s->head     = ff_get_audio_buffer(ctx->inputs[1 + s->selir], s->head_size);
+            s->head_buf = ff_get_audio_buffer(ctx->inputs[0], s->head_size + part_size);
+            s->tail_in  = ff_get_audio_buffer(ctx->inputs[0], part_size);
+            s->tail_out = ff_get_audio_buffer(ctx->inputs[0], part_size);
+            if (!s->head || !s->head_buf || !s->tail_in || !s->tail_out)
+                return AVERROR(ENOMEM);
+            av_samples_set_silence(s->head_buf->extended_data, 0, s->head_buf->nb_samples,
+                                   s->head_buf->channels, s->head_buf->format);
+            av_samples_set_silence(s->tail_out->extended_data, 0, s->tail_out->nb_samples,
+                                   s->tail_out->channels, s->tail_out->format);
+            s->tail_pos = 0;
+        }
+
         for (i = 0; left > 0; i++) {
             int step = part_size == max_part_size ? INT_MAX : 1 + (i == 0);
             int nb_partitions = FFMIN(step, (left + part_size - 1) / part_size);
@@ -549,6 +736,16 @@ static int convert_coeffs(AVFilterContext *ctx)
         for (i = FFMAX(1, s->length * s->nb_taps); i < s->nb_taps; i++)
             time[i] = 0;
 
+        if (s->zero_latency) {
+            float *head = (float *)s->head->extended_data[ch];
+            const int head_taps = FFMIN(s->min_part_size, cur_nb_taps);
+
+            /* reversed, for the direct convolution */
+            for (i = 0; i < s->head_size; i++)
+                head[s->head_size - 1 - i] = i < head_taps ? time[i] : 0.f;
+            toffset = s->min_part_size;
+        }
+
         av_log(ctx, AV_LOG_DEBUG, "channel: %d\n", ch);
 
         for (int segment = 0; segment < s->nb_segments; segment++) {
@@ -656,9 +853,13 @@ static int activate(AVFilterContext *ctx)
             return ret;
     }
 
-    available = ff_inlink_queued_samples(ctx->inputs[0]);
-    wanted = FFMAX(s->min_part_size, (available / s->min_part_size) * s->min_part_size);
-    ret = ff_inlink_consume_samples(ctx->inputs[0], wanted, wanted, &in);
+    if (s->zero_latency) {
+        ret = ff_inlink_consume_frame(ctx->inputs[0], &in);
+    } else {
+        available = ff_inlink_queued_samples(ctx->inputs[0]);
+        wanted = FFMAX(s->min_part_size, (available / s->min_part_size) * s->min_part_size);
+        ret = ff_inlink_consume_samples(ctx->inputs[0], wanted, wanted, &in);
+    }
     if (ret > 0)
         ret = fir_frame(s, in, outlink);
 
@@ -679,7 +880,8 @@ static int activate(AVFilterContext *ctx)
         }
     }
 
-    if (ff_inlink_queued_samples(ctx->inputs[0]) >= s->min_part_size) {
+    if (s->zero_latency ? ff_inlink_queued_frames(ctx->inputs[0]) > 0 :
+        ff_inlink_queued_samples(ctx->inputs[0]) >= s->min_part_size) {
         ff_filter_set_ready(ctx, 10);
         return 0;
     }
@@ -792,6 +994,11 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_freep(&s->fdsp);
 
+    av_frame_free(&s->head);
+    av_frame_free(&s->head_buf);
+    av_frame_free(&s->tail_in);
+    av_frame_free(&s->tail_out);
+
     for (int i = 0; i < s->nb_irs; i++) {
         av_frame_free(&s->ir[i]);
     }
@@ -825,7 +1032,8 @@ static int config_video(AVFilterLink *outlink)
 
 void ff_afir_init(AudioFIRDSPContext *dsp)
 {
-    dsp->fcmul_add = fcmul_add_c;
+    dsp->fcmul_add  = fcmul_add_c;
+    dsp->fir_direct = fir_direct_c;
 
     if (ARCH_X86)
         ff_afir_init_x86(dsp);
@@ -959,6 +1167,7 @@ static const AVOption afir_options[] = {
     { "maxp",   "set max partition size", OFFSET(maxp),  AV_OPT_TYPE_INT,   {.i64=8192}, 8, 32768, AF },
     { "nbirs",  "set number of input IRs",OFFSET(nb_irs),AV_OPT_TYPE_INT,   {.i64=1},    1,    32, AF },
     { "ir",     "select IR",              OFFSET(selir), AV_OPT_TYPE_INT,   {.i64=0},    0,    31, AFR },
+    { "zl",     "set zero-latency mode",  OFFSET(zero_latency), AV_OPT_TYPE_BOOL, {.i64=0}, 0,     1, AF },
     { NULL }
 };
 
@@ -50,12 +50,25 @@ typedef struct AudioFIRSegment {
     AVFrame *input;
     AVFrame *output;
 
+    float *part_sum;
+    int max_part_jobs;
+    int nb_part_jobs;
+
     RDFTContext **rdft, **irdft;
 } AudioFIRSegment;
 
 typedef struct AudioFIRDSPContext {
     void (*fcmul_add)(float *sum, const float *t, const float *c,
                       ptrdiff_t len);
+
+    /**
+     * dst[n] = sum of src[n + j] * ir[j] for j in [0, ir_len)
+     *
+     * @param ir     32-byte aligned
+     * @param ir_len multiple of 16
+     */
+    void (*fir_direct)(float *dst, const float *src, const float *ir,
+                       ptrdiff_t ir_len, ptrdiff_t len);
 } AudioFIRDSPContext;
 
 typedef struct AudioFIRContext {
@@ -76,6 +89,7 @@ typedef struct AudioFIRContext {
     int maxp;
     int nb_irs;
     int selir;
+    int zero_latency;
 
     float gain;
 
@@ -95,6 +109,13 @@ typedef struct AudioFIRContext {
     int min_part_size;
     int64_t pts;
 
+    AVFrame *head;
+    AVFrame *head_buf;
+    AVFrame *tail_in;
+    AVFrame *tail_out;
+    int head_size;
+    int tail_pos;
+
     AudioFIRDSPContext afirdsp;
     AVFloatDSPContext *fdsp;
 
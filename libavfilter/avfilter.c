@@ -42,6 +42,7 @@
 #include "filters.h"
 #include "formats.h"
 #include "internal.h"
+#include "video.h"
 
 #include "libavutil/ffversion.h"
 const char av_filter_ffversion[] = "FFmpeg version " FFMPEG_VERSION;
@@ -609,8 +610,9 @@ static const AVClass *filter_child_class_next(const AVClass *prev)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption avfilter_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
-        { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, "thread_type" },
+        { .i64 = AVFILTER_THREAD_SLICE | AVFILTER_THREAD_FRAME }, 0, INT_MAX, FLAGS, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
+        { "frame", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_FRAME }, .flags = FLAGS, .unit = "thread_type" },
     { "enable", "set enable expression", OFFSET(enable_str), AV_OPT_TYPE_STRING, {.str=NULL}, .flags = FLAGS },
     { "threads", "Allowed number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, FLAGS },
@@ -889,7 +891,14 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
         return ret;
     }
 
-    if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
+    /* frame threading takes precedence: the graph thread pool cannot be
+     * used for slices from inside a frame job */
+    if (ctx->nb_inputs == 1 && ctx->nb_outputs == 1 &&
+        ctx->input_pads[0].process_frame &&
+        ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_FRAME &&
+        ctx->graph->internal->thread_execute) {
+        ctx->thread_type = AVFILTER_THREAD_FRAME;
+    } else if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
         ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_SLICE &&
         ctx->graph->internal->thread_execute) {
         ctx->thread_type       = AVFILTER_THREAD_SLICE;
@@ -1041,6 +1050,17 @@ static int default_filter_frame(AVFilterLink *link, AVFrame *frame)
     return ff_filter_frame(link->dst->outputs[0], frame);
 }
 
+static int default_process_frame(AVFilterLink *link, AVFrame *frame)
+{
+    AVFrame *out = NULL;
+    int ret;
+
+    ret = link->dstpad->process_frame(link, frame, &out);
+    if (ret < 0 || !out)
+        return ret;
+    return ff_filter_frame(link->dst->outputs[0], out);
+}
+
 static int ff_filter_frame_framed(AVFilterLink *link, AVFrame *frame)
 {
     int (*filter_frame)(AVFilterLink *, AVFrame *);
@@ -1049,7 +1069,8 @@ static int ff_filter_frame_framed(AVFilterLink *link, AVFrame *frame)
     int ret;
 
     if (!(filter_frame = dst->filter_frame))
-        filter_frame = default_filter_frame;
+        filter_frame = dst->process_frame ? default_process_frame :
+                                            default_filter_frame;
 
     if (dst->needs_writable) {
         ret = ff_inlink_make_frame_writable(link, &frame);
@@ -1222,6 +1243,98 @@ static int ff_filter_frame_to_filter(AVFilterLink *link)
     return ret;
 }
 
+typedef struct FrameThreadData {
+    AVFilterLink *link;
+    AVFrame **frames; ///< input frames, replaced by the output frames
+} FrameThreadData;
+
+static int process_frame_job(AVFilterContext *ctx, void *arg,
+                             int jobnr, int nb_jobs)
+{
+    FrameThreadData *td = arg;
+    AVFrame *in = td->frames[jobnr];
+
+    td->frames[jobnr] = NULL;
+    return td->link->dstpad->process_frame(td->link, in, &td->frames[jobnr]);
+}
+
+/* Frame threading: filter several queued frames concurrently, then send
+ * the results in order. */
+static int ff_filter_frames_to_filter(AVFilterLink *link)
+{
+    AVFilterContext *dst = link->dst;
+    AVFilterLink *outlink = dst->outputs[0];
+    FrameThreadData td = { .link = link };
+    int nb_frames = FFMIN(ff_framequeue_queued_frames(&link->fifo),
+                          ff_filter_get_nb_threads(dst));
+    int *rets = NULL;
+    int i, ret = 0;
+
+    /* the timeline, commands and custom allocators of the next filter need
+     * to run in order, on the calling thread */
+    if (nb_frames < 2 || link->type != AVMEDIA_TYPE_VIDEO ||
+        outlink->type != AVMEDIA_TYPE_VIDEO || dst->enable_str ||
+        dst->command_queue || outlink->dstpad->get_video_buffer)
+        return ff_filter_frame_to_filter(link);
+
+    /* make sure the output frame pool exists before the jobs use it */
+    if (!outlink->frame_pool && !outlink->hw_frames_ctx) {
+        AVFrame *frame = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!frame)
+            return AVERROR(ENOMEM);
+        av_frame_free(&frame);
+    }
+
+    td.frames = av_mallocz_array(nb_frames, sizeof(*td.frames));
+    rets      = av_mallocz_array(nb_frames, sizeof(*rets));
+    if (!td.frames || !rets) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (i = 0; i < nb_frames; i++) {
+        ret = ff_inlink_consume_frame(link, &td.frames[i]);
+        av_assert1(ret);
+        if (ret < 0)
+            goto end;
+        if (link->dstpad->needs_writable) {
+            ret = ff_inlink_make_frame_writable(link, &td.frames[i]);
+            if (ret < 0)
+                goto end;
+        }
+    }
+    filter_unblock(dst);
+
+    dst->graph->internal->thread_execute(dst, process_frame_job, &td,
+                                         rets, nb_frames);
+
+    for (i = 0; i < nb_frames; i++) {
+        ret = rets[i];
+        if (ret >= 0 && td.frames[i]) {
+            ret = ff_filter_frame(outlink, td.frames[i]);
+            td.frames[i] = NULL;
+        }
+        if (ret < 0)
+            break;
+    }
+
+end:
+    if (td.frames) {
+        for (i = 0; i < nb_frames; i++)
+            av_frame_free(&td.frames[i]);
+    }
+    av_freep(&td.frames);
+    av_freep(&rets);
+
+    if (ret < 0 && ret != link->status_out) {
+        ff_avfilter_link_set_out_status(link, ret, AV_NOPTS_VALUE);
+    } else {
+        /* Run once again, to process the frames that are still queued. */
+        ff_filter_set_ready(dst, 300);
+    }
+    return ret;
+}
+
 static int forward_status_change(AVFilterContext *filter, AVFilterLink *in)
 {
     unsigned out = 0, progress = 0;
@@ -1259,8 +1372,17 @@ static int ff_filter_activate_default(AVFilterContext *filter)
     unsigned i;
 
     for (i = 0; i < filter->nb_inputs; i++) {
-        if (samples_ready(filter->inputs[i], filter->inputs[i]->min_samples)) {
-            return ff_filter_frame_to_filter(filter->inputs[i]);
+        AVFilterLink *in = filter->inputs[i];
+
+        if (samples_ready(in, in->min_samples)) {
+            if (filter->thread_type & AVFILTER_THREAD_FRAME) {
+                /* wait until there is a frame for each thread */
+                if (ff_framequeue_queued_frames(&in->fifo) <
+                    ff_filter_get_nb_threads(filter) && !in->status_in)
+                    continue;
+                return ff_filter_frames_to_filter(in);
+            }
+            return ff_filter_frame_to_filter(in);
         }
     }
     for (i = 0; i < filter->nb_inputs; i++) {
@@ -332,6 +332,12 @@ typedef struct AVFilter {
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Process multiple consecutive frames concurrently. This delays the output
+ * of the filter by up to as many frames as there are threads.
+ */
+#define AVFILTER_THREAD_FRAME (1 << 1)
+
 typedef struct AVFilterInternal AVFilterInternal;
 
 /** An instance of a filter */
@@ -852,7 +858,8 @@ typedef struct AVFilterGraph {
      * of AVFILTER_THREAD_* flags.
      *
      * May be set by the caller at any point, the setting will apply to all
-     * filters initialized after that. The default is allowing everything.
+     * filters initialized after that. The default is allowing everything
+     * except AVFILTER_THREAD_FRAME, which adds latency.
      *
      * When a filter in this graph is initialized, this field is combined using
      * bit AND with AVFilterContext.thread_type to get the final mask used for
@@ -0,0 +1,380 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * DNN asynchronous request queue.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "dnn_async.h"
+
+typedef enum {
+    REQUEST_QUEUED,
+    REQUEST_RUNNING,
+    REQUEST_DONE,
+} DNNRequestState;
+
+typedef struct DNNRequest {
+    void *input;
+    void *output;
+    unsigned int output_size;
+    DNNData result;
+    DNNReturnType ret;
+    DNNRequestState state;
+    void *opaque;
+    struct DNNRequest *next;
+} DNNRequest;
+
+typedef struct DNNAsyncContext {
+    DNNModel *model;
+    DNNExecuteFunc execute;
+    DNNData model_input;
+    size_t input_size;
+    int batch_size;
+
+    /* requests in submission order, todo is the first one still queued */
+    DNNRequest *first, *last, *todo;
+    int nb_todo;
+    DNNRequest *free_list;
+    /* last request handed out by get_result, recycled on the next call */
+    DNNRequest *returned;
+
+#if HAVE_THREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_cond_t done_cond;
+    int thread_started;
+    int exiting;
+#endif
+} DNNAsyncContext;
+
+static size_t data_size(const DNNData *data)
+{
+    return (size_t)data->width * data->height * data->channels *
+           (data->dt == DNN_FLOAT ? sizeof(float) : 1);
+}
+
+static void lock(DNNAsyncContext *ctx)
+{
+#if HAVE_THREADS
+    pthread_mutex_lock(&ctx->lock);
+#endif
+}
+
+static void unlock(DNNAsyncContext *ctx)
+{
+#if HAVE_THREADS
+    pthread_mutex_unlock(&ctx->lock);
+#endif
+}
+
+static void run_request(DNNAsyncContext *ctx, DNNRequest *req)
+{
+    DNNData output;
+
+    memcpy(ctx->model_input.data, req->input, ctx->input_size);
+    req->ret = ctx->execute(ctx->model, &output, 1);
+    if (req->ret != DNN_SUCCESS)
+        return;
+
+    av_fast_malloc(&req->output, &req->output_size, data_size(&output));
+    if (!req->output) {
+        req->ret = DNN_ERROR;
+        return;
+    }
+    memcpy(req->output, output.data, data_size(&output));
+    req->result      = output;
+    req->result.data = req->output;
+}
+
+/**
+ * Take the next batch off the todo list, must be called with the lock held.
+ * A batch is made of what is queued, up to batch_size requests; waiting
+ * for more would only add latency.
+ * Returns the first request of the batch and its size in nb.
+ */
+static DNNRequest *take_batch(DNNAsyncContext *ctx, int *nb)
+{
+    DNNRequest *batch = ctx->todo;
+
+    *nb = FFMIN(ctx->nb_todo, ctx->batch_size);
+    for (int i = 0; i < *nb; i++) {
+        ctx->todo->state = REQUEST_RUNNING;
+        ctx->todo = ctx->todo->next;
+    }
+    ctx->nb_todo -= *nb;
+    return batch;
+}
+
+#if HAVE_THREADS
+static void *async_worker(void *arg)
+{
+    DNNAsyncContext *ctx = arg;
+
+    pthread_mutex_lock(&ctx->lock);
+    while (1) {
+        DNNRequest *req;
+        int nb;
+
+        while (!ctx->exiting && !ctx->nb_todo)
+            pthread_cond_wait(&ctx->cond, &ctx->lock);
+        if (ctx->exiting)
+            break;
+
+        req = take_batch(ctx, &nb);
+        pthread_mutex_unlock(&ctx->lock);
+
+        /* Every result is published as soon as it is ready. The next
+         * pointer of the last one may be written by a submit, and a done
+         * request may be recycled by its owner, so read it beforehand. */
+        for (int i = 0; i < nb; i++) {
+            DNNRequest *next = i + 1 < nb ? req->next : NULL;
+            run_request(ctx, req);
+            pthread_mutex_lock(&ctx->lock);
+            req->state = REQUEST_DONE;
+            pthread_cond_broadcast(&ctx->done_cond);
+            pthread_mutex_unlock(&ctx->lock);
+            req = next;
+        }
+
+        pthread_mutex_lock(&ctx->lock);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    return NULL;
+}
+#else
+static void run_pending(DNNAsyncContext *ctx)
+{
+    while (ctx->nb_todo) {
+        int nb;
+        DNNRequest *req = take_batch(ctx, &nb);
+        for (int i = 0; i < nb; i++, req = req->next) {
+            run_request(ctx, req);
+            req->state = REQUEST_DONE;
+        }
+    }
+}
+#endif
+
+static void free_request_list(DNNRequest *req)
+{
+    while (req) {
+        DNNRequest *next = req->next;
+        av_freep(&req->input);
+        av_freep(&req->output);
+        av_freep(&req);
+        req = next;
+    }
+}
+
+DNNReturnType ff_dnn_async_start(DNNModel *model, DNNExecuteFunc execute,
+                                 const DNNData *model_input, int batch_size)
+{
+    DNNAsyncContext *ctx;
+
+    if (batch_size <= 0 || !model_input->data)
+        return DNN_ERROR;
+
+    /* restart with the new input, e.g. when the filter is reconfigured */
+    ff_dnn_async_uninit(model);
+
+    ctx = av_mallocz(sizeof(*ctx));
+    if (!ctx)
+        return DNN_ERROR;
+
+    ctx->model       = model;
+    ctx->execute     = execute;
+    ctx->model_input = *model_input;
+    ctx->input_size  = data_size(model_input);
+    ctx->batch_size  = batch_size;
+
+#if HAVE_THREADS
+    if (pthread_mutex_init(&ctx->lock, NULL)) {
+        av_freep(&ctx);
+        return DNN_ERROR;
+    }
+    if (pthread_cond_init(&ctx->cond, NULL)) {
+        pthread_mutex_destroy(&ctx->lock);
+        av_freep(&ctx);
+        return DNN_ERROR;
+    }
+    if (pthread_cond_init(&ctx->done_cond, NULL)) {
+        pthread_cond_destroy(&ctx->cond);
+        pthread_mutex_destroy(&ctx->lock);
+        av_freep(&ctx);
+        return DNN_ERROR;
+    }
+    model->async = ctx;
+    if (pthread_create(&ctx->thread, NULL, async_worker, ctx)) {
+        ff_dnn_async_uninit(model);
+        return DNN_ERROR;
+    }
+    ctx->thread_started = 1;
+#else
+    model->async = ctx;
+#endif
+
+    return DNN_SUCCESS;
+}
+
+DNNReturnType ff_dnn_async_execute(DNNModel *model, const DNNData *input, void *opaque)
+{
+    DNNAsyncContext *ctx = model->async;
+    DNNRequest *req;
+
+    if (!ctx || data_size(input) != ctx->input_size)
+        return DNN_ERROR;
+
+    lock(ctx);
+    req = ctx->free_list;
+    if (req)
+        ctx->free_list = req->next;
+    unlock(ctx);
+
+    if (!req) {
+        req = av_mallocz(sizeof(*req));
+        if (!req)
+            return DNN_ERROR;
+        req->input = av_malloc(ctx->input_size);
+        if (!req->input) {
+            av_freep(&req);
+            return DNN_ERROR;
+        }
+    }
+    memcpy(req->input, input->data, ctx->input_size);
+    req->opaque = opaque;
+    req->state  = REQUEST_QUEUED;
+    req->next   = NULL;
+
+    lock(ctx);
+    if (ctx->last)
+        ctx->last->next = req;
+    else
+        ctx->first = req;
+    ctx->last = req;
+    if (!ctx->todo)
+        ctx->todo = req;
+    ctx->nb_todo++;
+#if HAVE_THREADS
+    pthread_cond_signal(&ctx->cond);
+#else
+    run_pending(ctx);
+#endif
+    unlock(ctx);
+
+    return DNN_SUCCESS;
+}
+
+DNNAsyncStatusType ff_dnn_async_get_result(DNNModel *model, DNNData *output, void **opaque, int wait)
+{
+    DNNAsyncContext *ctx = model->async;
+    DNNRequest *req;
+
+    if (!ctx)
+        return DAST_FAIL;
+
+    lock(ctx);
+    if (ctx->returned) {
+        ctx->returned->next = ctx->free_list;
+        ctx->free_list = ctx->returned;
+        ctx->returned = NULL;
+    }
+
+    req = ctx->first;
+    if (!req) {
+        unlock(ctx);
+        return DAST_EMPTY_QUEUE;
+    }
+    if (req->state != REQUEST_DONE) {
+        if (!wait) {
+            unlock(ctx);
+            return DAST_NOT_READY;
+        }
+#if HAVE_THREADS
+        while (req->state != REQUEST_DONE)
+            pthread_cond_wait(&ctx->done_cond, &ctx->lock);
+#else
+        run_pending(ctx);
+#endif
+    }
+
+    ctx->first = req->next;
+    if (!ctx->first)
+        ctx->last = NULL;
+    req->next = NULL;
+    ctx->returned = req;
+    unlock(ctx);
+
+    *opaque = req->opaque;
+    if (req->ret != DNN_SUCCESS)
+        return DAST_FAIL;
+    *output = req->result;
+    return DAST_SUCCESS;
+}
+
+DNNReturnType ff_dnn_async_flush(DNNModel *model)
+{
+    DNNAsyncContext *ctx = model->async;
+
+    if (!ctx)
+        return DNN_ERROR;
+
+#if HAVE_THREADS
+    pthread_mutex_lock(&ctx->lock);
+    while (ctx->last && ctx->last->state != REQUEST_DONE)
+        pthread_cond_wait(&ctx->done_cond, &ctx->lock);
+    pthread_mutex_unlock(&ctx->lock);
+#else
+    run_pending(ctx);
+#endif
+
+    return DNN_SUCCESS;
+}
+
+void ff_dnn_async_uninit(DNNModel *model)
+{
+    DNNAsyncContext *ctx = model->async;
+
+    if (!ctx)
+        return;
+
+#if HAVE_THREADS
+    if (ctx->thread_started) {
+        pthread_mutex_lock(&ctx->lock);
+        ctx->exiting = 1;
+        pthread_cond_signal(&ctx->cond);
+        pthread_mutex_unlock(&ctx->lock);
+        pthread_join(ctx->thread, NULL);
+    }
+    pthread_cond_destroy(&ctx->done_cond);
+    pthread_cond_destroy(&ctx->cond);
+    pthread_mutex_destroy(&ctx->lock);
+#endif
+
+    free_request_list(ctx->first);
+    free_request_list(ctx->free_list);
+    free_request_list(ctx->returned);
+    av_freep(&model->async);
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Asynchronous request queue shared by the DNN backends.
+ *
+ * Requests are executed in submission order by a worker thread, which
+ * takes up to batch_size of the queued ones at a time and runs them back
+ * to back on the backend's synchronous execute function. It never waits
+ * for a batch to fill up, and every result is available as soon as its
+ * request has run.
+ */
+
+#ifndef AVFILTER_DNN_DNN_ASYNC_H
+#define AVFILTER_DNN_DNN_ASYNC_H
+
+#include "../dnn_interface.h"
+
+typedef DNNReturnType (*DNNExecuteFunc)(const DNNModel *model, DNNData *outputs, uint32_t nb_output);
+
+/**
+ * Start the request queue. If it is already running, it is restarted and
+ * the requests not retrieved yet are dropped.
+ */
+DNNReturnType ff_dnn_async_start(DNNModel *model, DNNExecuteFunc execute,
+                                 const DNNData *model_input, int batch_size);
+
+DNNReturnType ff_dnn_async_execute(DNNModel *model, const DNNData *input, void *opaque);
+
+DNNAsyncStatusType ff_dnn_async_get_result(DNNModel *model, DNNData *output, void **opaque, int wait);
+
+DNNReturnType ff_dnn_async_flush(DNNModel *model);
+
+/**
+ * Stop the worker and free the queue, requests not retrieved yet are
+ * dropped without notifying their owner.
+ */
+void ff_dnn_async_uninit(DNNModel *model);
+
+#endif
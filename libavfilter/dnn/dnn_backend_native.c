@@ -24,10 +24,80 @@
  */
 
 #include "dnn_backend_native.h"
+#include "dnn_async.h"
 #include "libavutil/avassert.h"
 #include "dnn_backend_native_layer_conv2d.h"
 #include "dnn_backend_native_layers.h"
 
+#define OFFSET(x) offsetof(NativeContext, x)
+#define FLAGS AV_OPT_FLAG_FILTERING_PARAM
+static const AVOption dnn_native_options[] = {
+    { "conv2d_threads", "threads for conv2d layer, 0 for the number of CPUs", OFFSET(options.conv2d_threads), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { NULL },
+};
+
+static const AVClass dnn_native_class = {
+    .class_name = "dnn_native",
+    .item_name  = av_default_item_name,
+    .option     = dnn_native_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+    .category   = AV_CLASS_CATEGORY_FILTER,
+};
+
+static void native_slice_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    NativeContext *ctx = priv;
+    ctx->slice_func(ctx->slice_priv, jobnr);
+}
+
+void dnn_native_execute_jobs(NativeContext *ctx, void (*func)(void *priv, int jobnr),
+                             void *priv, int nb_jobs)
+{
+    if (!ctx || !ctx->slicethread || nb_jobs == 1) {
+        for (int i = 0; i < nb_jobs; i++)
+            func(priv, i);
+        return;
+    }
+    ctx->slice_func = func;
+    ctx->slice_priv = priv;
+    avpriv_slicethread_execute(ctx->slicethread, nb_jobs, 0);
+}
+
+static int init_native_context(NativeContext *ctx, const char *options)
+{
+    int ret;
+
+    ctx->class = &dnn_native_class;
+    av_opt_set_defaults(ctx);
+    if (options && (ret = av_opt_set_from_string(ctx, options, NULL, "=", "&")) < 0) {
+        av_log(ctx, AV_LOG_ERROR, "Failed to parse options \"%s\"\n", options);
+        return ret;
+    }
+    return 0;
+}
+
+/**
+ * Create the worker pool on the first execution, so that loading a model
+ * only to read its layers (as the tensorflow backend does) starts no threads.
+ */
+static void init_native_threads(NativeContext *ctx)
+{
+    int ret;
+
+    ctx->nb_threads = 1;
+    if (ctx->options.conv2d_threads != 1) {
+        ret = avpriv_slicethread_create(&ctx->slicethread, ctx, native_slice_worker,
+                                        NULL, ctx->options.conv2d_threads);
+        if (ret > 1) {
+            ctx->nb_threads = ret;
+        } else {
+            if (ret < 0)
+                av_log(ctx, AV_LOG_WARNING, "Failed to create conv2d threads, running single-threaded\n");
+            avpriv_slicethread_free(&ctx->slicethread);
+        }
+    }
+}
+
 static DNNReturnType get_input_native(void *model, DNNData *input, const char *input_name)
 {
     ConvolutionalNetwork *network = (ConvolutionalNetwork *)model;
@@ -113,7 +183,7 @@ static DNNReturnType set_input_output_native(void *model, DNNData *input, const
 // layers_num,layer_type,layer_parameterss,layer_type,layer_parameters...
 // For CONV layer: activation_function, input_num, output_num, kernel_size, kernel, biases
 // For DEPTH_TO_SPACE layer: block_size
-DNNModel *ff_dnn_load_model_native(const char *model_filename)
+DNNModel *ff_dnn_load_model_native(const char *model_filename, const char *options)
 {
     DNNModel *model = NULL;
     char header_expected[] = "FFMPEGDNNNATIVE";
@@ -126,7 +196,7 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
     int32_t layer;
     DNNLayerType layer_type;
 
-    model = av_malloc(sizeof(DNNModel));
+    model = av_mallocz(sizeof(DNNModel));
     if (!model){
         return NULL;
     }
@@ -180,6 +250,12 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
     }
     model->model = (void *)network;
 
+    if (init_native_context(&network->ctx, options) < 0) {
+        avio_closep(&model_file_context);
+        ff_dnn_free_model_native(&model);
+        return NULL;
+    }
+
     avio_seek(model_file_context, file_size - 8, SEEK_SET);
     network->layers_num = (int32_t)avio_rl32(model_file_context);
     network->operands_num = (int32_t)avio_rl32(model_file_context);
@@ -270,13 +346,17 @@ DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, DNNData *output
         return DNN_ERROR;
     if (!network->operands[0].data)
         return DNN_ERROR;
+    if (!network->ctx.nb_threads)
+        init_native_threads(&network->ctx);
 
     for (layer = 0; layer < network->layers_num; ++layer){
         DNNLayerType layer_type = network->layers[layer].type;
-        layer_funcs[layer_type].pf_exec(network->operands,
+        if (layer_funcs[layer_type].pf_exec(network->operands,
                                   network->layers[layer].input_operand_indexes,
                                   network->layers[layer].output_operand_index,
-                                  network->layers[layer].params);
+                                  network->layers[layer].params,
+                                  &network->ctx))
+            return DNN_ERROR;
     }
 
     for (uint32_t i = 0; i < nb; ++i) {
@@ -291,6 +371,11 @@ DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, DNNData *output
     return DNN_SUCCESS;
 }
 
+DNNReturnType ff_dnn_start_async_native(DNNModel *model, const DNNData *model_input, int batch_size)
+{
+    return ff_dnn_async_start(model, ff_dnn_execute_model_native, model_input, batch_size);
+}
+
 int32_t calculate_operand_dims_count(const DnnOperand *oprd)
 {
     int32_t result = 1;
@@ -314,6 +399,7 @@ void ff_dnn_free_model_native(DNNModel **model)
 
     if (*model)
     {
+        ff_dnn_async_uninit(*model);
         network = (ConvolutionalNetwork *)(*model)->model;
         for (layer = 0; layer < network->layers_num; ++layer){
             if (network->layers[layer].type == DLT_CONV2D){
@@ -330,6 +416,7 @@ void ff_dnn_free_model_native(DNNModel **model)
         av_freep(&network->operands);
 
         av_freep(&network->output_indexes);
+        avpriv_slicethread_free(&network->ctx.slicethread);
         av_freep(&network);
         av_freep(model);
     }
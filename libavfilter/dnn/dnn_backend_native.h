@@ -29,6 +29,8 @@
 
 #include "../dnn_interface.h"
 #include "libavformat/avio.h"
+#include "libavutil/opt.h"
+#include "libavutil/slicethread.h"
 
 /**
  * the enum value of DNNLayerType should not be changed,
@@ -102,8 +104,28 @@ typedef struct InputParams{
     int height, width, channels;
 } InputParams;
 
+typedef struct NativeOptions{
+    int conv2d_threads;
+} NativeOptions;
+
+typedef struct NativeContext{
+    const AVClass *class;
+    NativeOptions options;
+
+    /**
+     * worker pool kept for the lifetime of the model, NULL when the
+     * layers run single-threaded; nb_threads is its actual size, 0 until
+     * the model is first executed.
+     */
+    AVSliceThread *slicethread;
+    int nb_threads;
+    void (*slice_func)(void *priv, int jobnr);
+    void *slice_priv;
+} NativeContext;
+
 // Represents simple feed-forward convolutional network.
 typedef struct ConvolutionalNetwork{
+    NativeContext ctx;
     Layer *layers;
     int32_t layers_num;
     DnnOperand *operands;
@@ -112,12 +134,21 @@ typedef struct ConvolutionalNetwork{
     uint32_t nb_output;
 } ConvolutionalNetwork;
 
-DNNModel *ff_dnn_load_model_native(const char *model_filename);
+DNNModel *ff_dnn_load_model_native(const char *model_filename, const char *options);
 
 DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, DNNData *outputs, uint32_t nb_output);
 
+DNNReturnType ff_dnn_start_async_native(DNNModel *model, const DNNData *model_input, int batch_size);
+
 void ff_dnn_free_model_native(DNNModel **model);
 
+/**
+ * Run func(priv, jobnr) for jobnr in [0, nb_jobs) on the worker pool of ctx,
+ * or sequentially in the calling thread when ctx has no pool.
+ */
+void dnn_native_execute_jobs(NativeContext *ctx, void (*func)(void *priv, int jobnr),
+                             void *priv, int nb_jobs);
+
 int32_t calculate_operand_data_length(const DnnOperand *oprd);
 int32_t calculate_operand_dims_count(const DnnOperand *oprd);
 #endif
@@ -18,6 +18,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "libavutil/attributes.h"
 #include "libavutil/avassert.h"
 #include "dnn_backend_native_layer_conv2d.h"
 
@@ -75,6 +76,7 @@ int dnn_load_layer_conv2d(Layer *layer, AVIOContext *model_file_context, int fil
         }
     }
 
+    ff_dnn_conv2d_init_dsp(&conv_params->dsp);
     layer->params = conv_params;
 
     layer->input_operand_indexes[0] = (int32_t)avio_rl32(model_file_context);
@@ -83,27 +85,217 @@ int dnn_load_layer_conv2d(Layer *layer, AVIOContext *model_file_context, int fil
     return dnn_size;
 }
 
+/* number of output pixels of a row handled per im2col/GEMM tile */
+#define TILE_WIDTH 64
+
+typedef struct ThreadCommonParam {
+    const ConvolutionalParams *conv_params;
+    const float *input;
+    float *output;
+    int height, width;
+    int pad_size;
+} ThreadCommonParam;
+
+typedef struct ThreadParam {
+    const ThreadCommonParam *common;
+    int thread_start, thread_end;
+    int ret;
+} ThreadParam;
+
+/**
+ * Gather the receptive fields of the output pixels [x0, x0 + w) of row y
+ * into col, one line of stride values per (kernel_y, kernel_x, channel) tap,
+ * which is the order the kernel coefficients are stored in. The values past
+ * w in each line are left untouched.
+ */
+static void im2col_row(float *col, const float *input, const ConvolutionalParams *conv_params,
+                       int height, int width, int y, int x0, int w, int stride)
+{
+    int radius = conv_params->kernel_size >> 1;
+    int src_linesize = width * conv_params->input_num;
+
+    for (int kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y) {
+        int y_pos = y + (kernel_y - radius) * conv_params->dilation;
+        int y_outside = y_pos < 0 || y_pos >= height;
+        const float *src;
+
+        if (conv_params->padding_method == SAME_CLAMP_TO_EDGE) {
+            y_pos = CLAMP_TO_EDGE(y_pos, height);
+            y_outside = 0;
+        }
+        src = input + y_pos * src_linesize;
+
+        for (int kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x) {
+            int x_off = (kernel_x - radius) * conv_params->dilation;
+
+            for (int ch = 0; ch < conv_params->input_num; ++ch) {
+                if (y_outside) {
+                    memset(col, 0, w * sizeof(*col));
+                } else if (x0 + x_off >= 0 && x0 + w - 1 + x_off < width) {
+                    const float *s = src + (x0 + x_off) * conv_params->input_num + ch;
+                    for (int x = 0; x < w; ++x)
+                        col[x] = s[x * conv_params->input_num];
+                } else {
+                    for (int x = 0; x < w; ++x) {
+                        int x_pos = x0 + x + x_off;
+                        if (conv_params->padding_method == SAME_CLAMP_TO_EDGE)
+                            col[x] = src[CLAMP_TO_EDGE(x_pos, width) * conv_params->input_num + ch];
+                        else
+                            col[x] = (x_pos < 0 || x_pos >= width) ? 0.0f :
+                                     src[x_pos * conv_params->input_num + ch];
+                    }
+                }
+                col += stride;
+            }
+        }
+    }
+}
+
+static void gemm4_c(float *acc, const float *col, const float *kernel,
+                    int filter_size, int w)
+{
+    const float *k0 = kernel;
+    const float *k1 = kernel + filter_size;
+    const float *k2 = kernel + filter_size * 2;
+    const float *k3 = kernel + filter_size * 3;
+    float *a0 = acc;
+    float *a1 = acc + w;
+    float *a2 = acc + w * 2;
+    float *a3 = acc + w * 3;
+
+    for (int k = 0; k < filter_size; ++k) {
+        const float *c = col + k * w;
+        float w0 = k0[k], w1 = k1[k], w2 = k2[k], w3 = k3[k];
+        for (int x = 0; x < w; ++x) {
+            float v = c[x];
+            a0[x] += w0 * v;
+            a1[x] += w1 * v;
+            a2[x] += w2 * v;
+            a3[x] += w3 * v;
+        }
+    }
+}
+
+av_cold void ff_dnn_conv2d_init_dsp(Conv2DDSPContext *dsp)
+{
+    dsp->gemm4 = gemm4_c;
+
+    if (ARCH_X86)
+        ff_dnn_conv2d_init_dsp_x86(dsp);
+}
+
+/**
+ * acc[o][x] = bias[o] + sum_k kernel[o][k] * col[k][x], four output
+ * channels at a time so that every line of col is loaded once per block.
+ * Lines of col and acc are w values apart, w being a multiple of 8.
+ */
+static void gemm_tile(const Conv2DDSPContext *dsp, float *acc, const float *col,
+                      const ConvolutionalParams *conv_params, int filter_size, int w)
+{
+    int o = 0;
+
+    for (; o < conv_params->output_num; o++) {
+        float bias = conv_params->has_bias ? conv_params->biases[o] : 0.f;
+        for (int x = 0; x < w; ++x)
+            acc[o * w + x] = bias;
+    }
+
+    for (o = 0; o + 3 < conv_params->output_num; o += 4)
+        dsp->gemm4(acc + o * w, col, conv_params->kernel + o * filter_size,
+                   filter_size, w);
+    for (; o < conv_params->output_num; o++) {
+        const float *k0 = conv_params->kernel + o * filter_size;
+        float *a0 = acc + o * w;
+
+        for (int k = 0; k < filter_size; ++k) {
+            const float *c = col + k * w;
+            float w0 = k0[k];
+            for (int x = 0; x < w; ++x)
+                a0[x] += w0 * c[x];
+        }
+    }
+}
+
+static float activate(DNNActivationFunc activation, float v)
+{
+    switch (activation){
+    case RELU:
+        return FFMAX(v, 0.0);
+    case TANH:
+        return 2.0f  / (1.0f + exp(-2.0f * v)) - 1.0f;
+    case SIGMOID:
+        return 1.0f / (1.0f + exp(-v));
+    case LEAKY_RELU:
+        return FFMAX(v, 0.0) + 0.2 * FFMIN(v, 0.0);
+    case NONE:
+    default:
+        return v;
+    }
+}
+
+static void dnn_execute_layer_conv2d_thread(void *priv, int jobnr)
+{
+    ThreadParam *thread_param = (ThreadParam *)priv + jobnr;
+    const ThreadCommonParam *common = thread_param->common;
+    const ConvolutionalParams *conv_params = common->conv_params;
+    int filter_size = conv_params->kernel_size * conv_params->kernel_size * conv_params->input_num;
+    int out_width = common->width - common->pad_size * 2;
+    int tile_width = FFMIN(TILE_WIDTH, out_width);
+    /* lines of col and acc are padded to a multiple of 8 for the GEMM;
+     * in a narrower last tile the padding holds stale values from the
+     * previous tile, which only reach the acc columns past w, never output */
+    int stride = FFALIGN(tile_width, 8);
+    float *col = av_mallocz_array(filter_size, stride * sizeof(*col));
+    float *acc = av_malloc_array(conv_params->output_num, stride * sizeof(*acc));
+
+    if (!col || !acc) {
+        thread_param->ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (int y = thread_param->thread_start; y < thread_param->thread_end; ++y) {
+        float *output = common->output + (y - common->pad_size) * out_width * conv_params->output_num;
+
+        for (int x0 = common->pad_size; x0 < common->width - common->pad_size; x0 += tile_width) {
+            int w = FFMIN(tile_width, common->width - common->pad_size - x0);
+
+            im2col_row(col, common->input, conv_params, common->height, common->width,
+                       y, x0, w, stride);
+            gemm_tile(&conv_params->dsp, acc, col, conv_params, filter_size, stride);
+
+            for (int x = 0; x < w; ++x) {
+                for (int n_filter = 0; n_filter < conv_params->output_num; ++n_filter)
+                    output[n_filter] = activate(conv_params->activation, acc[n_filter * stride + x]);
+                output += conv_params->output_num;
+            }
+        }
+    }
+    thread_param->ret = 0;
+
+end:
+    av_free(col);
+    av_free(acc);
+}
+
 int dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_operand_indexes,
-                             int32_t output_operand_index, const void *parameters)
+                             int32_t output_operand_index, const void *parameters,
+                             NativeContext *ctx)
 {
-    float *output;
     int32_t input_operand_index = input_operand_indexes[0];
     int number = operands[input_operand_index].dims[0];
     int height = operands[input_operand_index].dims[1];
     int width = operands[input_operand_index].dims[2];
     int channel = operands[input_operand_index].dims[3];
-    const float *input = operands[input_operand_index].data;
     const ConvolutionalParams *conv_params = (const ConvolutionalParams *)parameters;
-
-    int radius = conv_params->kernel_size >> 1;
-    int src_linesize = width * conv_params->input_num;
-    int filter_linesize = conv_params->kernel_size * conv_params->input_num;
-    int filter_size = conv_params->kernel_size * filter_linesize;
     int pad_size = (conv_params->padding_method == VALID) ? (conv_params->kernel_size - 1) / 2 * conv_params->dilation : 0;
+    int out_height = height - pad_size * 2;
+    ThreadCommonParam thread_common_param;
+    ThreadParam *thread_param;
+    int thread_num, ret = 0;
 
     DnnOperand *output_operand = &operands[output_operand_index];
     output_operand->dims[0] = number;
-    output_operand->dims[1] = height - pad_size * 2;
+    output_operand->dims[1] = out_height;
     output_operand->dims[2] = width - pad_size * 2;
     output_operand->dims[3] = conv_params->output_num;
     output_operand->data_type = operands[input_operand_index].data_type;
@@ -111,57 +303,37 @@ int dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_operand_
     output_operand->data = av_realloc(output_operand->data, output_operand->length);
     if (!output_operand->data)
         return -1;
-    output = output_operand->data;
 
     av_assert0(channel == conv_params->input_num);
 
-    for (int y = pad_size; y < height - pad_size; ++y) {
-        for (int x = pad_size; x < width - pad_size; ++x) {
-            for (int n_filter = 0; n_filter < conv_params->output_num; ++n_filter) {
-                if (conv_params->has_bias)
-                    output[n_filter] = conv_params->biases[n_filter];
-                else
-                    output[n_filter] = 0.f;
-
-                for (int ch = 0; ch < conv_params->input_num; ++ch) {
-                    for (int kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y) {
-                        for (int kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x) {
-                            float input_pel;
-                            if (conv_params->padding_method == SAME_CLAMP_TO_EDGE) {
-                                int y_pos = CLAMP_TO_EDGE(y + (kernel_y - radius) * conv_params->dilation, height);
-                                int x_pos = CLAMP_TO_EDGE(x + (kernel_x - radius) * conv_params->dilation, width);
-                                input_pel = input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
-                            } else {
-                                int y_pos = y + (kernel_y - radius) * conv_params->dilation;
-                                int x_pos = x + (kernel_x - radius) * conv_params->dilation;
-                                input_pel = (x_pos < 0 || x_pos >= width || y_pos < 0 || y_pos >= height) ? 0.0 :
-                                                   input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
-                            }
-
-
-                            output[n_filter] += input_pel * conv_params->kernel[n_filter * filter_size + kernel_y * filter_linesize +
-                                                                                kernel_x * conv_params->input_num + ch];
-                        }
-                    }
-                }
-                switch (conv_params->activation){
-                case RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0);
-                    break;
-                case TANH:
-                    output[n_filter] = 2.0f  / (1.0f + exp(-2.0f * output[n_filter])) - 1.0f;
-                    break;
-                case SIGMOID:
-                    output[n_filter] = 1.0f / (1.0f + exp(-output[n_filter]));
-                    break;
-                case NONE:
-                    break;
-                case LEAKY_RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0) + 0.2 * FFMIN(output[n_filter], 0.0);
-                }
-            }
-            output += conv_params->output_num;
-        }
+    if (out_height <= 0 || width - pad_size * 2 <= 0)
+        return 0;
+
+    thread_num = ctx ? FFMIN(ctx->nb_threads, out_height) : 1;
+
+    thread_common_param.conv_params = conv_params;
+    thread_common_param.input       = operands[input_operand_index].data;
+    thread_common_param.output      = output_operand->data;
+    thread_common_param.height      = height;
+    thread_common_param.width       = width;
+    thread_common_param.pad_size    = pad_size;
+
+    thread_param = av_malloc_array(thread_num, sizeof(*thread_param));
+    if (!thread_param)
+        return -1;
+    for (int i = 0; i < thread_num; i++) {
+        thread_param[i].common       = &thread_common_param;
+        thread_param[i].thread_start = pad_size + out_height *  i      / thread_num;
+        thread_param[i].thread_end   = pad_size + out_height * (i + 1) / thread_num;
+        thread_param[i].ret          = AVERROR(EINVAL);
     }
-    return 0;
+
+    dnn_native_execute_jobs(ctx, dnn_execute_layer_conv2d_thread, thread_param, thread_num);
+
+    /* report the first failure */
+    for (int i = 0; i < thread_num && !ret; i++)
+        ret = thread_param[i].ret;
+    av_free(thread_param);
+
+    return ret;
 }
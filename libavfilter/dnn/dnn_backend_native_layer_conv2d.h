@@ -26,6 +26,17 @@
 typedef enum {RELU, TANH, SIGMOID, NONE, LEAKY_RELU} DNNActivationFunc;
 typedef enum {VALID, SAME, SAME_CLAMP_TO_EDGE} DNNConvPaddingParam;
 
+typedef struct Conv2DDSPContext {
+    /**
+     * Accumulate four output channels of a GEMM tile:
+     * acc[i * w + x] += sum(kernel[i * filter_size + k] * col[k * w + x],
+     * k = 0..filter_size-1) for i < 4 and x < w.
+     * w must be a multiple of 8.
+     */
+    void (*gemm4)(float *acc, const float *col, const float *kernel,
+                  int filter_size, int w);
+} Conv2DDSPContext;
+
 typedef struct ConvolutionalParams{
     int32_t input_num, output_num, kernel_size;
     DNNActivationFunc activation;
@@ -34,9 +45,14 @@ typedef struct ConvolutionalParams{
     int32_t has_bias;
     float *kernel;
     float *biases;
+    Conv2DDSPContext dsp;
 } ConvolutionalParams;
 
+void ff_dnn_conv2d_init_dsp(Conv2DDSPContext *dsp);
+void ff_dnn_conv2d_init_dsp_x86(Conv2DDSPContext *dsp);
+
 int dnn_load_layer_conv2d(Layer *layer, AVIOContext *model_file_context, int file_size);
 int dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_operand_indexes,
-                             int32_t output_operand_index, const void *parameters);
+                             int32_t output_operand_index, const void *parameters,
+                             NativeContext *ctx);
 #endif
@@ -25,6 +25,7 @@
 
 #include "dnn_backend_tf.h"
 #include "dnn_backend_native.h"
+#include "dnn_async.h"
 #include "dnn_backend_native_layer_conv2d.h"
 #include "dnn_backend_native_layer_depth2space.h"
 #include "libavformat/avio.h"
@@ -490,7 +491,7 @@ static DNNReturnType load_native_model(TFModel *tf_model, const char *model_file
     DNNModel *native_model = NULL;
     ConvolutionalNetwork *conv_network;
 
-    native_model = ff_dnn_load_model_native(model_filename);
+    native_model = ff_dnn_load_model_native(model_filename, NULL);
     if (!native_model){
         return DNN_ERROR;
     }
@@ -572,12 +573,17 @@ static DNNReturnType load_native_model(TFModel *tf_model, const char *model_file
     return DNN_SUCCESS;
 }
 
-DNNModel *ff_dnn_load_model_tf(const char *model_filename)
+DNNModel *ff_dnn_load_model_tf(const char *model_filename, const char *options)
 {
     DNNModel *model = NULL;
     TFModel *tf_model = NULL;
 
-    model = av_malloc(sizeof(DNNModel));
+    if (options && *options) {
+        av_log(NULL, AV_LOG_ERROR, "The tensorflow backend accepts no options, got \"%s\"\n", options);
+        return NULL;
+    }
+
+    model = av_mallocz(sizeof(DNNModel));
     if (!model){
         return NULL;
     }
@@ -641,11 +647,17 @@ DNNReturnType ff_dnn_execute_model_tf(const DNNModel *model, DNNData *outputs, u
     return DNN_SUCCESS;
 }
 
+DNNReturnType ff_dnn_start_async_tf(DNNModel *model, const DNNData *model_input, int batch_size)
+{
+    return ff_dnn_async_start(model, ff_dnn_execute_model_tf, model_input, batch_size);
+}
+
 void ff_dnn_free_model_tf(DNNModel **model)
 {
     TFModel *tf_model;
 
     if (*model){
+        ff_dnn_async_uninit(*model);
         tf_model = (TFModel *)(*model)->model;
         if (tf_model->graph){
             TF_DeleteGraph(tf_model->graph);
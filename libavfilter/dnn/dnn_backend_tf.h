@@ -29,10 +29,12 @@
 
 #include "../dnn_interface.h"
 
-DNNModel *ff_dnn_load_model_tf(const char *model_filename);
+DNNModel *ff_dnn_load_model_tf(const char *model_filename, const char *options);
 
 DNNReturnType ff_dnn_execute_model_tf(const DNNModel *model, DNNData *outputs, uint32_t nb_output);
 
+DNNReturnType ff_dnn_start_async_tf(DNNModel *model, const DNNData *model_input, int batch_size);
+
 void ff_dnn_free_model_tf(DNNModel **model);
 
 #endif
@@ -26,6 +26,7 @@
 #include "../dnn_interface.h"
 #include "dnn_backend_native.h"
 #include "dnn_backend_tf.h"
+#include "dnn_async.h"
 #include "libavutil/mem.h"
 
 DNNModule *ff_get_dnn_module(DNNBackendType backend_type)
@@ -42,12 +43,14 @@ DNNModule *ff_get_dnn_module(DNNBackendType backend_type)
         dnn_module->load_model = &ff_dnn_load_model_native;
         dnn_module->execute_model = &ff_dnn_execute_model_native;
         dnn_module->free_model = &ff_dnn_free_model_native;
+        dnn_module->start_async = &ff_dnn_start_async_native;
         break;
     case DNN_TF:
     #if (CONFIG_LIBTENSORFLOW == 1)
         dnn_module->load_model = &ff_dnn_load_model_tf;
         dnn_module->execute_model = &ff_dnn_execute_model_tf;
         dnn_module->free_model = &ff_dnn_free_model_tf;
+        dnn_module->start_async = &ff_dnn_start_async_tf;
     #else
         av_freep(&dnn_module);
         return NULL;
@@ -59,5 +62,9 @@ DNNModule *ff_get_dnn_module(DNNBackendType backend_type)
         return NULL;
     }
 
+    dnn_module->execute_model_async = &ff_dnn_async_execute;
+    dnn_module->get_result = &ff_dnn_async_get_result;
+    dnn_module->flush = &ff_dnn_async_flush;
+
     return dnn_module;
 }
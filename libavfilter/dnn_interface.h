@@ -30,6 +30,8 @@
 
 typedef enum {DNN_SUCCESS, DNN_ERROR} DNNReturnType;
 
+typedef enum {DAST_FAIL, DAST_EMPTY_QUEUE, DAST_NOT_READY, DAST_SUCCESS} DNNAsyncStatusType;
+
 typedef enum {DNN_NATIVE, DNN_TF} DNNBackendType;
 
 typedef enum {DNN_FLOAT = 1, DNN_UINT8 = 4} DNNDataType;
@@ -49,16 +51,32 @@ typedef struct DNNModel{
     // Sets model input and output.
     // Should be called at least once before model execution.
     DNNReturnType (*set_input_output)(void *model, DNNData *input, const char *input_name, const char **output_names, uint32_t nb_output);
+    // State of the asynchronous request queue, NULL until start_async is called.
+    struct DNNAsyncContext *async;
 } DNNModel;
 
 // Stores pointers to functions for loading, executing, freeing DNN models for one of the backends.
 typedef struct DNNModule{
-    // Loads model and parameters from given file. Returns NULL if it is not possible.
-    DNNModel *(*load_model)(const char *model_filename);
+    // Loads model and parameters from given file, options is a backend specific
+    // "key=value&key=value" string, may be NULL. Returns NULL if it is not possible.
+    DNNModel *(*load_model)(const char *model_filename, const char *options);
     // Executes model with specified input and output. Returns DNN_ERROR otherwise.
     DNNReturnType (*execute_model)(const DNNModel *model, DNNData *outputs, uint32_t nb_output);
     // Frees memory allocated for model.
     void (*free_model)(DNNModel **model);
+    // Starts the asynchronous request queue of the model, model_input is the input
+    // given to set_input_output, the queued requests are executed up to batch_size
+    // at a time. Restarts the queue, dropping pending requests, if already started.
+    DNNReturnType (*start_async)(DNNModel *model, const DNNData *model_input, int batch_size);
+    // Queues an execution of the model on a copy of input->data, which must have the
+    // layout of model_input; opaque is handed back with the result by get_result.
+    DNNReturnType (*execute_model_async)(DNNModel *model, const DNNData *input, void *opaque);
+    // Retrieves the oldest request, in submission order. Returns DAST_NOT_READY if it
+    // is still being processed and wait is 0, DAST_EMPTY_QUEUE if nothing is queued.
+    // The output data stays valid until the next call to an asynchronous function.
+    DNNAsyncStatusType (*get_result)(DNNModel *model, DNNData *output, void **opaque, int wait);
+    // Waits until all the queued requests have been executed.
+    DNNReturnType (*flush)(DNNModel *model);
 } DNNModule;
 
 // Initializes DNNModule depending on chosen backend.
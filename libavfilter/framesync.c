@@ -95,7 +95,9 @@ static void framesync_eof(FFFrameSync *fs)
 {
     fs->eof = 1;
     fs->frame_ready = 0;
-    ff_outlink_set_status(fs->parent->outputs[0], AVERROR_EOF, AV_NOPTS_VALUE);
+    /* with on_eof, ff_framesync_activate() sets it after the callback */
+    if (!fs->on_eof)
+        ff_outlink_set_status(fs->parent->outputs[0], AVERROR_EOF, AV_NOPTS_VALUE);
 }
 
 static void framesync_sync_level_update(FFFrameSync *fs)
@@ -348,6 +350,11 @@ int ff_framesync_activate(FFFrameSync *fs)
     ret = framesync_advance(fs);
     if (ret < 0)
         return ret;
+    if (fs->eof && fs->on_eof && !ff_outlink_get_status(fs->parent->outputs[0])) {
+        ret = fs->on_eof(fs);
+        ff_outlink_set_status(fs->parent->outputs[0], AVERROR_EOF, AV_NOPTS_VALUE);
+        return ret;
+    }
     if (fs->eof || !fs->frame_ready)
         return 0;
     ret = fs->on_event(fs);
@@ -171,6 +171,13 @@ typedef struct FFFrameSync {
      */
     int (*on_event)(struct FFFrameSync *fs);
 
+    /**
+     * Callback called once when the output reaches EOF, before the EOF is
+     * set on it, so that frames held back by the filter can still be sent.
+     * Optional.
+     */
+    int (*on_eof)(struct FFFrameSync *fs);
+
     /**
      * Opaque pointer, not used by the API
      */
@@ -92,6 +92,26 @@ struct AVFilterPad {
      */
     int (*filter_frame)(AVFilterLink *link, AVFrame *frame);
 
+    /**
+     * Filtering callback for filters whose output only depends on the
+     * current input frame. Like filter_frame, but the output frame is
+     * returned in *out instead of being sent with ff_filter_frame(); *out
+     * may be left NULL to drop the frame.
+     *
+     * With frame threading, it is called concurrently for consecutive
+     * frames, so it must not modify the filter private context, and must
+     * allocate output frames with ff_get_video_buffer() on the output link
+     * using the link dimensions. If filter_frame is not set, the framework
+     * implements it using this callback.
+     *
+     * Only allowed on the input pad of filters with exactly one input and
+     * one output.
+     *
+     * @return >= 0 on success, a negative AVERROR on error. The input frame
+     * is always freed.
+     */
+    int (*process_frame)(AVFilterLink *link, AVFrame *in, AVFrame **out);
+
     /**
      * Frame request callback. A call to this should result in some progress
      * towards producing output over the given link. This should return zero
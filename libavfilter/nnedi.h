@@ -0,0 +1,46 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_NNEDI_H
+#define AVFILTER_NNEDI_H
+
+#include <stdint.h>
+
+typedef struct NNEDIDSPContext {
+    /**
+     * Evaluate the first layer of a network:
+     * vals[i] = sum(data[j] * weights[i * len + j], j = 0..len-1) for i < n.
+     * n must be a multiple of 4, len a multiple of 16, data and weights
+     * must be 16-byte aligned.
+     */
+    void (*dot_prods_float)(const float *data, const float *weights,
+                            float *vals, int n, int len);
+    void (*dot_prods_int16)(const int16_t *data, const int16_t *weights,
+                            int32_t *vals, int n, int len);
+
+    /**
+     * s[i] = exp(s[i]), with s[i] clipped to [-80, 80] first.
+     * n must be a multiple of 16.
+     */
+    void (*exp)(float *s, int n);
+} NNEDIDSPContext;
+
+void ff_nnedi_init(NNEDIDSPContext *dsp);
+void ff_nnedi_init_x86(NNEDIDSPContext *dsp);
+
+#endif /* AVFILTER_NNEDI_H */
@@ -0,0 +1,42 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_PALETTEUSE_H
+#define AVFILTER_PALETTEUSE_H
+
+#include <stdint.h>
+
+typedef struct PaletteUseDSPContext {
+    /**
+     * Compute the squared euclidean distances between a color and a set of
+     * palette entries, over all 4 components.
+     *
+     * @param dist   output distances, n elements, 32-byte aligned
+     * @param pal    palette entries, 4 int16_t {r, g, b, 0} per entry,
+     *               32-byte aligned; every component must be in [0, 1023]
+     * @param target the color to match, 4 int16_t {r, g, b, 0}
+     * @param n      number of entries, a multiple of 8
+     */
+    void (*color_dist)(int32_t *dist, const int16_t *pal,
+                       const int16_t *target, int n);
+} PaletteUseDSPContext;
+
+void ff_paletteuse_init(PaletteUseDSPContext *dsp);
+void ff_paletteuse_init_x86(PaletteUseDSPContext *dsp);
+
+#endif /* AVFILTER_PALETTEUSE_H */
@@ -25,12 +25,23 @@
 #include <stdint.h>
 
 typedef struct SSIMDSPContext {
+    /**
+     * Sums of the 4x4 blocks of a line, 8 bits per sample, or 9 to 12 bits
+     * in 16-bit samples.
+     */
     void (*ssim_4x4_line)(const uint8_t *buf, ptrdiff_t buf_stride,
                           const uint8_t *ref, ptrdiff_t ref_stride,
                           int (*sums)[4], int w);
     double (*ssim_end_line)(const int (*sum0)[4], const int (*sum1)[4], int w);
+    /**
+     * ssim_end_line for 9 to 12 bits per sample, c1 and c2 being the SSIM
+     * constants of the depth.
+     */
+    double (*ssim_end_line_12bit)(const int (*sum0)[4], const int (*sum1)[4], int w,
+                                  int c1, int c2);
 } SSIMDSPContext;
 
-void ff_ssim_init_x86(SSIMDSPContext *dsp);
+void ff_ssim_init(SSIMDSPContext *dsp, int bpp);
+void ff_ssim_init_x86(SSIMDSPContext *dsp, int bpp);
 
 #endif /* AVFILTER_SSIM_H */
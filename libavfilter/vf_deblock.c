@@ -306,7 +306,7 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+static int process_frame(AVFilterLink *inlink, AVFrame *in, AVFrame **pout)
 {
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = ctx->outputs[0];
@@ -364,7 +364,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     if (in != out)
         av_frame_free(&in);
-    return ff_filter_frame(outlink, out);
+    *pout = out;
+    return 0;
 }
 
 #define OFFSET(x) offsetof(DeblockContext, x)
@@ -387,7 +388,7 @@ static const AVFilterPad inputs[] = {
     {
         .name           = "default",
         .type           = AVMEDIA_TYPE_VIDEO,
-        .filter_frame   = filter_frame,
+        .process_frame  = process_frame,
     },
     { NULL }
 };
@@ -30,6 +30,7 @@
 #include "libavutil/imgutils.h"
 #include "avfilter.h"
 #include "dnn_interface.h"
+#include "filters.h"
 #include "formats.h"
 #include "internal.h"
 #include "libswscale/swscale.h"
@@ -41,6 +42,9 @@ typedef struct DnnProcessingContext {
     DNNBackendType backend_type;
     char *model_inputname;
     char *model_outputname;
+    char *backend_options;
+    int async;
+    int batch_size;
 
     DNNModule *dnn_module;
     DNNModel *model;
@@ -49,6 +53,10 @@ typedef struct DnnProcessingContext {
     DNNData input;
     DNNData output;
 
+    // frame data handed to the asynchronous interface, and requests not retrieved yet
+    DNNData async_input;
+    int nb_in_flight;
+
     struct SwsContext *sws_gray8_to_grayf32;
     struct SwsContext *sws_grayf32_to_gray8;
     struct SwsContext *sws_uv_scale;
@@ -66,6 +74,9 @@ static const AVOption dnn_processing_options[] = {
     { "model",       "path to model file",         OFFSET(model_filename),   AV_OPT_TYPE_STRING,    { .str = NULL }, 0, 0, FLAGS },
     { "input",       "input name of the model",    OFFSET(model_inputname),  AV_OPT_TYPE_STRING,    { .str = NULL }, 0, 0, FLAGS },
     { "output",      "output name of the model",   OFFSET(model_outputname), AV_OPT_TYPE_STRING,    { .str = NULL }, 0, 0, FLAGS },
+    { "options",     "backend options",            OFFSET(backend_options),  AV_OPT_TYPE_STRING,    { .str = NULL }, 0, 0, FLAGS },
+    { "async",       "run the model asynchronously", OFFSET(async),          AV_OPT_TYPE_BOOL,      { .i64 = 0 },    0, 1, FLAGS },
+    { "batch_size",  "number of frames executed as one batch", OFFSET(batch_size), AV_OPT_TYPE_INT, { .i64 = 1 },    1, 1024, FLAGS },
     { NULL }
 };
 
@@ -98,7 +109,7 @@ static av_cold int init(AVFilterContext *context)
         return AVERROR(EINVAL);
     }
 
-    ctx->model = (ctx->dnn_module->load_model)(ctx->model_filename);
+    ctx->model = (ctx->dnn_module->load_model)(ctx->model_filename, ctx->backend_options);
     if (!ctx->model) {
         av_log(ctx, AV_LOG_ERROR, "could not load DNN model\n");
         return AVERROR(EINVAL);
@@ -297,6 +308,18 @@ static int prepare_sws_context(AVFilterLink *outlink)
     return 0;
 }
 
+static void drop_in_flight(DnnProcessingContext *ctx)
+{
+    void *in;
+    DNNData output;
+
+    if (!ctx->model->async)
+        return;
+    while ((ctx->dnn_module->get_result)(ctx->model, &output, &in, 1) != DAST_EMPTY_QUEUE)
+        av_frame_free((AVFrame **)&in);
+    ctx->nb_in_flight = 0;
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     AVFilterContext *context = outlink->src;
@@ -315,13 +338,29 @@ static int config_output(AVFilterLink *outlink)
 
     prepare_sws_context(outlink);
 
+    if (ctx->async) {
+        /* the frames queued with the previous configuration are dropped
+         * by start_async, the queue is restarted for the new input */
+        drop_in_flight(ctx);
+        av_freep(&ctx->async_input.data);
+        ctx->async_input = ctx->input;
+        ctx->async_input.data = av_malloc_array(ctx->input.width * ctx->input.height,
+                                                ctx->input.channels * sizeof(float));
+        if (!ctx->async_input.data)
+            return AVERROR(ENOMEM);
+        result = (ctx->dnn_module->start_async)(ctx->model, &ctx->input, ctx->batch_size);
+        if (result != DNN_SUCCESS) {
+            av_log(ctx, AV_LOG_ERROR, "failed to start asynchronous execution\n");
+            return AVERROR(EIO);
+        }
+    }
+
     return 0;
 }
 
-static int copy_from_frame_to_dnn(DnnProcessingContext *ctx, const AVFrame *frame)
+static int copy_from_frame_to_dnn(DnnProcessingContext *ctx, const AVFrame *frame, DNNData *dnn_input)
 {
     int bytewidth = av_image_get_linesize(frame->format, frame->width, 0);
-    DNNData *dnn_input = &ctx->input;
 
     switch (frame->format) {
     case AV_PIX_FMT_RGB24:
@@ -359,10 +398,9 @@ static int copy_from_frame_to_dnn(DnnProcessingContext *ctx, const AVFrame *fram
     return 0;
 }
 
-static int copy_from_dnn_to_frame(DnnProcessingContext *ctx, AVFrame *frame)
+static int copy_from_dnn_to_frame(DnnProcessingContext *ctx, AVFrame *frame, const DNNData *dnn_output)
 {
     int bytewidth = av_image_get_linesize(frame->format, frame->width, 0);
-    DNNData *dnn_output = &ctx->output;
 
     switch (frame->format) {
     case AV_PIX_FMT_RGB24:
@@ -441,15 +479,48 @@ static int copy_uv_planes(DnnProcessingContext *ctx, AVFrame *out, const AVFrame
     return 0;
 }
 
+static int output_frame(AVFilterLink *outlink, AVFrame *in, const DNNData *dnn_output)
+{
+    AVFilterContext *context  = outlink->src;
+    DnnProcessingContext *ctx = context->priv;
+    AVFrame *out;
+
+    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+    if (!out) {
+        av_frame_free(&in);
+        return AVERROR(ENOMEM);
+    }
+
+    av_frame_copy_props(out, in);
+    copy_from_dnn_to_frame(ctx, out, dnn_output);
+
+    if (isPlanarYUV(in->format))
+        copy_uv_planes(ctx, out, in);
+
+    av_frame_free(&in);
+    return ff_filter_frame(outlink, out);
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *context  = inlink->dst;
     AVFilterLink *outlink = context->outputs[0];
     DnnProcessingContext *ctx = context->priv;
     DNNReturnType dnn_result;
-    AVFrame *out;
 
-    copy_from_frame_to_dnn(ctx, in);
+    if (ctx->async) {
+        copy_from_frame_to_dnn(ctx, in, &ctx->async_input);
+        dnn_result = (ctx->dnn_module->execute_model_async)(ctx->model, &ctx->async_input, in);
+        if (dnn_result != DNN_SUCCESS) {
+            av_log(ctx, AV_LOG_ERROR, "failed to queue frame for the model\n");
+            av_frame_free(&in);
+            return AVERROR(EIO);
+        }
+        ctx->nb_in_flight++;
+        return 0;
+    }
+
+    copy_from_frame_to_dnn(ctx, in, &ctx->input);
 
     dnn_result = (ctx->dnn_module->execute_model)(ctx->model, &ctx->output, 1);
     if (dnn_result != DNN_SUCCESS){
@@ -458,20 +529,103 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         return AVERROR(EIO);
     }
 
-    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
-    if (!out) {
-        av_frame_free(&in);
-        return AVERROR(ENOMEM);
+    return output_frame(outlink, in, &ctx->output);
+}
+
+/**
+ * Send the finished requests downstream, waiting for them while more
+ * than max_in_flight are pending.
+ * Returns the number of frames output or a negative error code.
+ */
+static int drain_results(AVFilterContext *context, int max_in_flight)
+{
+    DnnProcessingContext *ctx = context->priv;
+    int nb_out = 0;
+
+    while (ctx->nb_in_flight) {
+        DNNAsyncStatusType status;
+        DNNData output;
+        void *in = NULL;
+        int ret;
+
+        status = (ctx->dnn_module->get_result)(ctx->model, &output, &in,
+                                               ctx->nb_in_flight > max_in_flight);
+        if (status == DAST_NOT_READY || status == DAST_EMPTY_QUEUE)
+            break;
+        ctx->nb_in_flight--;
+        if (status != DAST_SUCCESS) {
+            av_log(ctx, AV_LOG_ERROR, "failed to execute model\n");
+            av_frame_free((AVFrame **)&in);
+            return AVERROR(EIO);
+        }
+        ret = output_frame(context->outputs[0], in, &output);
+        if (ret < 0)
+            return ret;
+        nb_out++;
     }
 
-    av_frame_copy_props(out, in);
-    copy_from_dnn_to_frame(ctx, out);
+    return nb_out;
+}
 
-    if (isPlanarYUV(in->format))
-        copy_uv_planes(ctx, out, in);
+static int activate(AVFilterContext *context)
+{
+    AVFilterLink *inlink  = context->inputs[0];
+    AVFilterLink *outlink = context->outputs[0];
+    DnnProcessingContext *ctx = context->priv;
+    AVFrame *in;
+    int64_t pts;
+    int ret, status;
+
+    FF_FILTER_FORWARD_STATUS_BACK(outlink, inlink);
+
+    if (!ctx->async) {
+        ret = ff_inlink_consume_frame(inlink, &in);
+        if (ret < 0)
+            return ret;
+        if (ret > 0)
+            return filter_frame(inlink, in);
+        FF_FILTER_FORWARD_STATUS(inlink, outlink);
+        FF_FILTER_FORWARD_WANTED(outlink, inlink);
+        return FFERROR_NOT_READY;
+    }
 
-    av_frame_free(&in);
-    return ff_filter_frame(outlink, out);
+    /* keep up to two batches in flight so the worker always has a full one */
+    while (ctx->nb_in_flight < 2 * ctx->batch_size) {
+        ret = ff_inlink_consume_frame(inlink, &in);
+        if (ret < 0)
+            return ret;
+        if (!ret)
+            break;
+        ret = filter_frame(inlink, in);
+        if (ret < 0)
+            return ret;
+    }
+
+    /* Only keep frames in flight while more input is at hand to overlap
+     * with them; otherwise wait for the oldest one, so that no finished
+     * frame has to wait for the next input to be delivered. */
+    ret = drain_results(context, ff_inlink_queued_frames(inlink) ?
+                                 2 * ctx->batch_size - 1 : 0);
+    if (ret < 0)
+        return ret;
+    if (ret > 0) {
+        if (ff_inlink_queued_frames(inlink))
+            ff_filter_set_ready(context, 100);
+        return 0;
+    }
+
+    if (ff_inlink_acknowledge_status(inlink, &status, &pts)) {
+        (ctx->dnn_module->flush)(ctx->model);
+        ret = drain_results(context, 0);
+        if (ret < 0)
+            return ret;
+        ff_outlink_set_status(outlink, status, pts);
+        return 0;
+    }
+
+    FF_FILTER_FORWARD_WANTED(outlink, inlink);
+
+    return FFERROR_NOT_READY;
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -482,8 +636,11 @@ static av_cold void uninit(AVFilterContext *ctx)
     sws_freeContext(context->sws_grayf32_to_gray8);
     sws_freeContext(context->sws_uv_scale);
 
-    if (context->dnn_module)
+    if (context->dnn_module && context->model) {
+        drop_in_flight(context);
         (context->dnn_module->free_model)(&context->model);
+    }
+    av_freep(&context->async_input.data);
 
     av_freep(&context->dnn_module);
 }
@@ -493,7 +650,6 @@ static const AVFilterPad dnn_processing_inputs[] = {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
         .config_props = config_input,
-        .filter_frame = filter_frame,
     },
     { NULL }
 };
@@ -517,4 +673,5 @@ AVFilter ff_vf_dnn_processing = {
     .inputs        = dnn_processing_inputs,
     .outputs       = dnn_processing_outputs,
     .priv_class    = &dnn_processing_class,
+    .activate      = activate,
 };
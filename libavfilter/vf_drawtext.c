@@ -134,6 +134,9 @@ enum var_name {
     VAR_VARS_NB
 };
 
+#define MAX_THREADS      32
+#define MIN_SLICE_HEIGHT 16
+
 enum expansion_mode {
     EXP_NONE,
     EXP_NORMAL,
@@ -1211,7 +1214,7 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
+static int draw_glyphs(DrawTextContext *s, uint8_t *dst[4], int dst_linesize[4],
                        int width, int height,
                        FFDrawColor *color,
                        int x, int y, int borderw)
@@ -1246,7 +1249,7 @@ continue_on_invalid:
         y1 = s->positions[i].y+s->y+y - borderw;
 
         ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
+                      dst, dst_linesize, width, height,
                       bitmap.buffer, bitmap.pitch,
                       bitmap.width, bitmap.rows,
                       bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
@@ -1257,6 +1260,70 @@ continue_on_invalid:
 }
 
 
+typedef struct ThreadData {
+    AVFrame *frame;
+    int width, height;
+    int box_w, box_h;
+    int top, bottom;            ///< vertical extent of the drawn text, split among the jobs
+    FFDrawColor *fontcolor;
+    FFDrawColor *shadowcolor;
+    FFDrawColor *bordercolor;
+    FFDrawColor *boxcolor;
+} ThreadData;
+
+/**
+ * Blend box, shadow, border and text into one horizontal band of the frame.
+ * Band boundaries are aligned to the chroma subsampling, so every chroma
+ * row is computed from the same luma rows as in a single pass.
+ */
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int align = 1 << s->dc.vsub_max;
+    const int span  = td->bottom - td->top;
+    const int slice_start = jobnr ? FFMIN(FFALIGN(td->top + span *  jobnr      / nb_jobs, align), td->height) : 0;
+    const int slice_end   = jobnr < nb_jobs - 1 ?
+                            FFMIN(FFALIGN(td->top + span * (jobnr + 1) / nb_jobs, align), td->height) : td->height;
+    const int h = slice_end - slice_start;
+    uint8_t *dst[4] = { NULL };
+    int dst_linesize[4] = { 0 };
+    int plane, ret;
+
+    if (h <= 0)
+        return 0;
+
+    for (plane = 0; plane < s->dc.nb_planes; plane++) {
+        dst[plane]          = td->frame->data[plane] +
+                              (slice_start >> s->dc.vsub[plane]) * td->frame->linesize[plane];
+        dst_linesize[plane] = td->frame->linesize[plane];
+    }
+
+    /* draw box */
+    if (s->draw_box)
+        ff_blend_rectangle(&s->dc, td->boxcolor,
+                           dst, dst_linesize, td->width, h,
+                           s->x - s->boxborderw, s->y - s->boxborderw - slice_start,
+                           td->box_w + s->boxborderw * 2, td->box_h + s->boxborderw * 2);
+
+    if (s->shadowx || s->shadowy) {
+        if ((ret = draw_glyphs(s, dst, dst_linesize, td->width, h,
+                               td->shadowcolor, s->shadowx, s->shadowy - slice_start, 0)) < 0)
+            return ret;
+    }
+
+    if (s->borderw) {
+        if ((ret = draw_glyphs(s, dst, dst_linesize, td->width, h,
+                               td->bordercolor, 0, -slice_start, s->borderw)) < 0)
+            return ret;
+    }
+    if ((ret = draw_glyphs(s, dst, dst_linesize, td->width, h,
+                           td->fontcolor, 0, -slice_start, 0)) < 0)
+        return ret;
+
+    return 0;
+}
+
 static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
 {
     *color = incolor;
@@ -1306,6 +1373,10 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     FFDrawColor bordercolor;
     FFDrawColor boxcolor;
 
+    ThreadData td;
+    int jobs_ret[MAX_THREADS];
+    int nb_jobs, margin_top, margin_bottom;
+
     av_bprint_clear(bp);
 
     if(s->basetime != AV_NOPTS_VALUE)
@@ -1476,27 +1547,29 @@ continue_on_invalid2:
             s->y = FFMAX(height - box_h - offsetbottom, 0);
     }
 
-    /* draw box */
-    if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
-
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
-    }
-
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
-    }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    /* split the rows covered by the text and its effects among the jobs;
+     * the first and last jobs also own everything above and below */
+    margin_top    = FFMAX3(s->draw_box ? s->boxborderw : 0, s->borderw, -s->shadowy);
+    margin_bottom = FFMAX3(s->draw_box ? s->boxborderw : 0, s->borderw,  s->shadowy);
+
+    td.frame       = frame;
+    td.width       = width;
+    td.height      = height;
+    td.box_w       = box_w;
+    td.box_h       = box_h;
+    td.top         = av_clip(s->y - margin_top, 0, height);
+    td.bottom      = av_clip(s->y + box_h + margin_bottom, td.top, height);
+    td.fontcolor   = &fontcolor;
+    td.shadowcolor = &shadowcolor;
+    td.bordercolor = &bordercolor;
+    td.boxcolor    = &boxcolor;
+
+    nb_jobs = av_clip((td.bottom - td.top) / MIN_SLICE_HEIGHT, 1,
+                      FFMIN(ff_filter_get_nb_threads(ctx), MAX_THREADS));
+    ctx->internal->execute(ctx, draw_text_slice, &td, jobs_ret, nb_jobs);
+    for (i = 0; i < nb_jobs; i++)
+        if (jobs_ret[i] < 0)
+            return jobs_ret[i];
 
     return 0;
 }
@@ -1572,5 +1645,5 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -269,13 +269,14 @@ static void fixed_borders16(FillBordersContext *s, AVFrame *frame)
     }
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+static int process_frame(AVFilterLink *inlink, AVFrame *frame, AVFrame **out)
 {
     FillBordersContext *s = inlink->dst->priv;
 
     s->fillborders(s, frame);
 
-    return ff_filter_frame(inlink->dst->outputs[0], frame);
+    *out = frame;
+    return 0;
 }
 
 static int config_input(AVFilterLink *inlink)
@@ -381,7 +382,7 @@ static const AVFilterPad fillborders_inputs[] = {
         .name           = "default",
         .type           = AVMEDIA_TYPE_VIDEO,
         .config_props   = config_input,
-        .filter_frame   = filter_frame,
+        .process_frame  = process_frame,
         .needs_writable = 1,
     },
     { NULL }
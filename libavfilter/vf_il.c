@@ -145,7 +145,8 @@ static void interleave(uint8_t *dst, uint8_t *src, int w, int h,
     }
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *inpicref)
+static int process_frame(AVFilterLink *inlink, AVFrame *inpicref,
+                         AVFrame **pout)
 {
     IlContext *s = inlink->dst->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
@@ -180,15 +181,16 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *inpicref)
     }
 
     av_frame_free(&inpicref);
-    return ff_filter_frame(outlink, out);
+    *pout = out;
+    return 0;
 }
 
 static const AVFilterPad inputs[] = {
     {
-        .name         = "default",
-        .type         = AVMEDIA_TYPE_VIDEO,
-        .filter_frame = filter_frame,
-        .config_props = config_input,
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .process_frame = process_frame,
+        .config_props  = config_input,
     },
     { NULL }
 };
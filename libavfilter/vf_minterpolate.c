@@ -26,6 +26,7 @@
 #include "libavutil/motion_vector.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
@@ -195,8 +196,23 @@ typedef struct MIContext {
     int log2_chroma_w;
     int log2_chroma_h;
     int nb_planes;
+
+    int nb_threads;
+    int me_wavefront;
+    int *me_progress;
+#if HAVE_THREADS
+    pthread_mutex_t me_lock;
+    pthread_cond_t me_cond;
+#endif
 } MIContext;
 
+typedef struct ThreadData {
+    Block *blocks;
+    int dir;
+    int alpha;
+    AVFrame *out;
+} ThreadData;
+
 #define OFFSET(x) offsetof(MIContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 #define CONST(name, help, val, unit) { name, help, 0, AV_OPT_TYPE_CONST, {.i64=val}, 0, 0, FLAGS, unit }
@@ -262,8 +278,8 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     int linesize = me_ctx->linesize;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, me_ctx->x_min, me_ctx->x_max);
     y = av_clip(y, me_ctx->y_min, me_ctx->y_max);
@@ -273,9 +289,7 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     data_cur += (y + mv_y) * linesize;
     data_next += (y - mv_y) * linesize;
 
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + j * linesize] - data_next[x - mv_x + i + j * linesize]);
+    sbad = ff_me_block_sad(me_ctx, data_cur + x + mv_x, data_next + x - mv_x, me_ctx->mb_size);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -291,17 +305,19 @@ static uint64_t get_sbad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv,
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - x_min, x_max - x), FFMIN(x - x_min, x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - y_min, y_max - y), FFMIN(y - y_min, y_max - y));
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + (y + mv_y + j) * linesize] - data_next[x - mv_x + i + (y - mv_y + j) * linesize]);
+    x -= me_ctx->mb_size / 2;
+    y -= me_ctx->mb_size / 2;
+    sbad = ff_me_block_sad(me_ctx, data_cur  + x + mv_x + (y + mv_y) * linesize,
+                                   data_next + x - mv_x + (y - mv_y) * linesize,
+                           me_ctx->mb_size * 3 / 2 + me_ctx->mb_size / 2);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -317,21 +333,34 @@ static uint64_t get_sad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, i
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x = x_mv - x;
     int mv_y = y_mv - y;
-    int i, j;
-    uint64_t sad = 0;
+    uint64_t sad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     x_mv = av_clip(x_mv, x_min, x_max);
     y_mv = av_clip(y_mv, y_min, y_max);
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sad += FFABS(data_ref[x_mv + i + (y_mv + j) * linesize] - data_cur[x + i + (y + j) * linesize]);
+    sad = ff_me_block_sad(me_ctx, data_ref + x_mv - me_ctx->mb_size / 2 + (y_mv - me_ctx->mb_size / 2) * linesize,
+                                  data_cur + x    - me_ctx->mb_size / 2 + (y    - me_ctx->mb_size / 2) * linesize,
+                          me_ctx->mb_size * 3 / 2 + me_ctx->mb_size / 2);
 
     return sad + (FFABS(mv_x - me_ctx->pred_x) + FFABS(mv_y - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
 
+static av_cold int init(AVFilterContext *ctx)
+{
+#if HAVE_THREADS
+    MIContext *mi_ctx = ctx->priv;
+    int ret;
+
+    if ((ret = pthread_mutex_init(&mi_ctx->me_lock, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&mi_ctx->me_cond, NULL)))
+        return AVERROR(ret);
+#endif
+    return 0;
+}
+
 static int config_input(AVFilterLink *inlink)
 {
     MIContext *mi_ctx = inlink->dst->priv;
@@ -353,6 +382,14 @@ static int config_input(AVFilterLink *inlink)
     mi_ctx->b_height = height >> mi_ctx->log2_mb_size;
     mi_ctx->b_count = mi_ctx->b_width * mi_ctx->b_height;
 
+    mi_ctx->nb_threads = ff_filter_get_nb_threads(inlink->dst);
+    mi_ctx->me_wavefront = mi_ctx->nb_threads > 1 &&
+                           (mi_ctx->me_method == AV_ME_METHOD_EPZS ||
+                            mi_ctx->me_method == AV_ME_METHOD_UMH);
+    mi_ctx->me_progress = av_calloc(mi_ctx->b_height, sizeof(*mi_ctx->me_progress));
+    if (!mi_ctx->me_progress)
+        return AVERROR(ENOMEM);
+
     for (i = 0; i < NB_FRAMES; i++) {
         Frame *frame = &mi_ctx->frames[i];
         frame->blocks = av_mallocz_array(mi_ctx->b_count, sizeof(Block));
@@ -422,9 +459,9 @@ static int config_output(AVFilterLink *outlink)
         preds.nb++;\
     } while(0)
 
-static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int dir)
+static void search_mv(MIContext *mi_ctx, AVMotionEstContext *me_ctx, Block *blocks,
+                      int mb_x, int mb_y, int dir)
 {
-    AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
     AVMotionEstPredictor *preds = me_ctx->preds;
     Block *block = &blocks[mb_x + mb_y * mi_ctx->b_width];
 
@@ -564,8 +601,74 @@ static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int
     block->mvs[dir][1] = mv[1] - y_mb;
 }
 
-static void bilateral_me(MIContext *mi_ctx)
+/* EPZS and UMH predict from the left, top and top-right blocks of the
+ * current frame, so rows are searched as a wavefront where row mb_y may only
+ * pass block mb_x once row mb_y - 1 is done up to block mb_x + 1. */
+static void me_await_progress(MIContext *mi_ctx, int mb_x, int mb_y)
 {
+#if HAVE_THREADS
+    const int needed = FFMIN(mb_x + 2, mi_ctx->b_width);
+
+    if (!mi_ctx->me_wavefront || !mb_y)
+        return;
+
+    pthread_mutex_lock(&mi_ctx->me_lock);
+    while (mi_ctx->me_progress[mb_y - 1] < needed)
+        pthread_cond_wait(&mi_ctx->me_cond, &mi_ctx->me_lock);
+    pthread_mutex_unlock(&mi_ctx->me_lock);
+#endif
+}
+
+static void me_report_progress(MIContext *mi_ctx, int mb_x, int mb_y)
+{
+#if HAVE_THREADS
+    if (!mi_ctx->me_wavefront)
+        return;
+
+    pthread_mutex_lock(&mi_ctx->me_lock);
+    mi_ctx->me_progress[mb_y] = mb_x + 1;
+    pthread_cond_broadcast(&mi_ctx->me_cond);
+    pthread_mutex_unlock(&mi_ctx->me_lock);
+#endif
+}
+
+static int search_mv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVMotionEstContext me_ctx = mi_ctx->me_ctx;
+    const int mb_y = jobnr;
+    int mb_x;
+
+    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+        me_await_progress(mi_ctx, mb_x, mb_y);
+        search_mv(mi_ctx, &me_ctx, td->blocks, mb_x, mb_y, td->dir);
+        me_report_progress(mi_ctx, mb_x, mb_y);
+    }
+
+    /* keep the predictor the last block leaves behind, later cost
+     * evaluations depend on it */
+    if (mb_y == mi_ctx->b_height - 1) {
+        mi_ctx->me_ctx.pred_x = me_ctx.pred_x;
+        mi_ctx->me_ctx.pred_y = me_ctx.pred_y;
+    }
+
+    emms_c();
+    return 0;
+}
+
+static void search_mvs(AVFilterContext *ctx, Block *blocks, int dir)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData td = { .blocks = blocks, .dir = dir };
+
+    memset(mi_ctx->me_progress, 0, mi_ctx->b_height * sizeof(*mi_ctx->me_progress));
+    ctx->internal->execute(ctx, search_mv_slice, &td, NULL, mi_ctx->b_height);
+}
+
+static void bilateral_me(AVFilterContext *ctx)
+{
+    MIContext *mi_ctx = ctx->priv;
     Block *block;
     int mb_x, mb_y;
 
@@ -580,9 +683,25 @@ static void bilateral_me(MIContext *mi_ctx)
             block->mvs[0][1] = 0;
         }
 
-    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-            search_mv(mi_ctx, mi_ctx->int_blocks, mb_x, mb_y, 0);
+    search_mvs(ctx, mi_ctx->int_blocks, 0);
+}
+
+static int block_sbad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    const int mb_y = jobnr;
+    const int y_mb = mb_y << mi_ctx->log2_mb_size;
+    int mb_x;
+
+    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+        const int x_mb = mb_x << mi_ctx->log2_mb_size;
+        Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+        block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
+    }
+
+    emms_c();
+    return 0;
 }
 
 static int var_size_bme(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n)
@@ -765,9 +884,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
                     mi_ctx->me_ctx.data_cur = mi_ctx->frames[2].avf->data[0];
                     mi_ctx->me_ctx.data_ref = mi_ctx->frames[dir ? 3 : 1].avf->data[0];
 
-                    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-                            search_mv(mi_ctx, mi_ctx->frames[2].blocks, mb_x, mb_y, dir);
+                    search_mvs(ctx, mi_ctx->frames[2].blocks, dir);
                 }
             }
 
@@ -782,19 +899,10 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
             mi_ctx->me_ctx.data_cur = mi_ctx->frames[1].avf->data[0];
             mi_ctx->me_ctx.data_ref = mi_ctx->frames[2].avf->data[0];
 
-            bilateral_me(mi_ctx);
-
-            if (mi_ctx->mc_mode == MC_MODE_AOBMC) {
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        int x_mb = mb_x << mi_ctx->log2_mb_size;
-                        int y_mb = mb_y << mi_ctx->log2_mb_size;
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+            bilateral_me(ctx);
 
-                        block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
-                    }
-            }
+            if (mi_ctx->mc_mode == MC_MODE_AOBMC)
+                ctx->internal->execute(ctx, block_sbad_slice, NULL, NULL, mi_ctx->b_height);
 
             if (mi_ctx->vsbmc) {
 
@@ -814,7 +922,9 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 
                 mi_ctx->clusters[0].nb = mi_ctx->b_count;
 
-                if (ret = cluster_mvs(mi_ctx))
+                ret = cluster_mvs(mi_ctx);
+                emms_c();
+                if (ret)
                     return ret;
             }
         }
@@ -863,17 +973,13 @@ static int detect_scene_change(MIContext *mi_ctx)
         pixel_refs->nb++;\
     } while(0)
 
-static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
+static void bidirectional_obmc(MIContext *mi_ctx, int alpha, int y0, int y1)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
     int height = mi_ctx->frames[0].avf->height;
     int mb_y, mb_x, dir;
 
-    for (y = 0; y < height; y++)
-        for (x = 0; x < width; x++)
-            mi_ctx->pixel_refs[x + y * width].nb = 0;
-
     for (dir = 0; dir < 2; dir++)
         for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
             for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
@@ -887,9 +993,9 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
                 start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2 + mv_y * a / ALPHA_MAX;
 
                 startc_x = av_clip(start_x, 0, width - 1);
-                startc_y = av_clip(start_y, 0, height - 1);
+                startc_y = av_clip(start_y, y0, y1);
                 endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-                endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
+                endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), y0, FFMIN(y1, height - 1));
 
                 if (dir) {
                     mv_x = -mv_x;
@@ -913,16 +1019,15 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
             }
 }
 
-static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
+static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out, int y0, int y1)
 {
     int x, y, plane;
 
     for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
         int width = avf_out->width;
-        int height = avf_out->height;
         int chroma = plane == 1 || plane == 2;
 
-        for (y = 0; y < height; y++)
+        for (y = y0; y < y1; y++)
             for (x = 0; x < width; x++) {
                 int x_mv, y_mv;
                 int weight_sum = 0;
@@ -971,7 +1076,8 @@ static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
     }
 }
 
-static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha)
+static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha,
+                         int y0, int y1)
 {
     int sb_x, sb_y;
     int width = mi_ctx->frames[0].avf->width;
@@ -982,7 +1088,7 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
             Block *sb = &block->subs[sb_x + sb_y * 2];
 
             if (sb->sb)
-                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha);
+                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha, y0, y1);
             else {
                 int x, y;
                 int mv_x = sb->mvs[0][0] * 2;
@@ -993,7 +1099,7 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
                 int end_x = start_x + (1 << (n - 1));
                 int end_y = start_y + (1 << (n - 1));
 
-                for (y = start_y; y < end_y; y++)  {
+                for (y = FFMAX(start_y, y0); y < FFMIN(end_y, y1); y++)  {
                     int y_min = -y;
                     int y_max = height - y - 1;
                     for (x = start_x; x < end_x; x++) {
@@ -1010,7 +1116,8 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
         }
 }
 
-static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha)
+static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha,
+                           int y0, int y1)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
@@ -1018,7 +1125,8 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
 
     Block *nb;
     int nb_x, nb_y;
-    uint64_t sbads[9];
+    uint64_t sbads[9] = { UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX,
+                          UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX };
 
     int mv_x = block->mvs[0][0] * 2;
     int mv_y = block->mvs[0][1] * 2;
@@ -1039,9 +1147,9 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
 
     startc_x = av_clip(start_x, 0, width - 1);
-    startc_y = av_clip(start_y, 0, height - 1);
+    startc_y = av_clip(start_y, y0, y1);
     endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
+    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), y0, FFMIN(y1, height - 1));
 
     for (y = startc_y; y < endc_y; y++) {
         int y_min = -y;
@@ -1074,13 +1182,100 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     }
 }
 
+/* Bands of output rows, aligned so that no chroma row is shared. */
+static void mc_band(MIContext *mi_ctx, int height, int jobnr, int nb_jobs, int *y0, int *y1)
+{
+    const int align = 1 << mi_ctx->log2_chroma_h;
+    const int rows = (height + align - 1) / align;
+
+    *y0 = FFMIN(rows *  jobnr      / nb_jobs * align, height);
+    *y1 = FFMIN(rows * (jobnr + 1) / nb_jobs * align, height);
+}
+
+static int mc_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    const int width  = td->out->width;
+    const int height = td->out->height;
+    int x, y, y0, y1;
+
+    mc_band(mi_ctx, height, jobnr, nb_jobs, &y0, &y1);
+
+    for (y = y0; y < y1; y++)
+        for (x = 0; x < width; x++)
+            mi_ctx->pixel_refs[x + y * width].nb = 0;
+
+    if (mi_ctx->me_mode == ME_MODE_BIDIR) {
+        bidirectional_obmc(mi_ctx, td->alpha, y0, y1);
+    } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
+        const int mb_size = mi_ctx->mb_size;
+        int mb_x, mb_y;
+
+        for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++) {
+            /* the OBMC window extends half a block above and below */
+            const int start_y = (mb_y << mi_ctx->log2_mb_size) - mb_size / 2;
+            if (start_y + 2 * mb_size <= y0 || start_y >= y1)
+                continue;
+
+            for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+                Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+                if (block->sb)
+                    var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size,
+                                 mi_ctx->log2_mb_size, td->alpha, y0, y1);
+
+                bilateral_obmc(mi_ctx, block, mb_x, mb_y, td->alpha, y0, y1);
+            }
+        }
+    }
+
+    set_frame_data(mi_ctx, td->alpha, td->out, y0, y1);
+
+    emms_c();
+    return 0;
+}
+
+static int blend_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *avf_out = td->out;
+    const int alpha = td->alpha;
+    int x, y, plane;
+
+    for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
+        int width = avf_out->width;
+        int height = avf_out->height;
+        int start, end;
+
+        if (plane == 1 || plane == 2) {
+            width = AV_CEIL_RSHIFT(width, mi_ctx->log2_chroma_w);
+            height = AV_CEIL_RSHIFT(height, mi_ctx->log2_chroma_h);
+        }
+
+        start = (height *  jobnr     ) / nb_jobs;
+        end   = (height * (jobnr + 1)) / nb_jobs;
+
+        for (y = start; y < end; y++) {
+            for (x = 0; x < width; x++) {
+                avf_out->data[plane][x + y * avf_out->linesize[plane]] =
+                    (alpha  * mi_ctx->frames[2].avf->data[plane][x + y * mi_ctx->frames[2].avf->linesize[plane]] +
+                     (ALPHA_MAX - alpha) * mi_ctx->frames[1].avf->data[plane][x + y * mi_ctx->frames[1].avf->linesize[plane]] + 512) >> 10;
+            }
+        }
+    }
+
+    return 0;
+}
+
 static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
 {
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = ctx->outputs[0];
     MIContext *mi_ctx = ctx->priv;
-    int x, y;
-    int plane, alpha;
+    ThreadData td;
+    int alpha;
     int64_t pts;
 
     pts = av_rescale(avf_out->pts, (int64_t) ALPHA_MAX * outlink->time_base.num * inlink->time_base.den,
@@ -1106,51 +1301,17 @@ static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
 
             break;
         case MI_MODE_BLEND:
-            for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
-                int width = avf_out->width;
-                int height = avf_out->height;
-
-                if (plane == 1 || plane == 2) {
-                    width = AV_CEIL_RSHIFT(width, mi_ctx->log2_chroma_w);
-                    height = AV_CEIL_RSHIFT(height, mi_ctx->log2_chroma_h);
-                }
-
-                for (y = 0; y < height; y++) {
-                    for (x = 0; x < width; x++) {
-                        avf_out->data[plane][x + y * avf_out->linesize[plane]] =
-                            (alpha  * mi_ctx->frames[2].avf->data[plane][x + y * mi_ctx->frames[2].avf->linesize[plane]] +
-                             (ALPHA_MAX - alpha) * mi_ctx->frames[1].avf->data[plane][x + y * mi_ctx->frames[1].avf->linesize[plane]] + 512) >> 10;
-                    }
-                }
-            }
+            td.out   = avf_out;
+            td.alpha = alpha;
+            ctx->internal->execute(ctx, blend_slice, &td, NULL,
+                                   FFMIN(AV_CEIL_RSHIFT(avf_out->height, mi_ctx->log2_chroma_h), mi_ctx->nb_threads));
 
             break;
         case MI_MODE_MCI:
-            if (mi_ctx->me_mode == ME_MODE_BIDIR) {
-                bidirectional_obmc(mi_ctx, alpha);
-                set_frame_data(mi_ctx, alpha, avf_out);
-
-            } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
-                int mb_x, mb_y;
-                Block *block;
-
-                for (y = 0; y < mi_ctx->frames[0].avf->height; y++)
-                    for (x = 0; x < mi_ctx->frames[0].avf->width; x++)
-                        mi_ctx->pixel_refs[x + y * mi_ctx->frames[0].avf->width].nb = 0;
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
-
-                        if (block->sb)
-                            var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size, mi_ctx->log2_mb_size, alpha);
-
-                        bilateral_obmc(mi_ctx, block, mb_x, mb_y, alpha);
-
-                    }
-
-                set_frame_data(mi_ctx, alpha, avf_out);
-            }
+            td.out   = avf_out;
+            td.alpha = alpha;
+            ctx->internal->execute(ctx, mc_slice, &td, NULL,
+                                   FFMIN(AV_CEIL_RSHIFT(avf_out->height, mi_ctx->log2_chroma_h), mi_ctx->nb_threads));
 
             break;
     }
@@ -1235,6 +1396,12 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     for (i = 0; i < 3; i++)
         av_freep(&mi_ctx->mv_table[i]);
+
+    av_freep(&mi_ctx->me_progress);
+#if HAVE_THREADS
+    pthread_mutex_destroy(&mi_ctx->me_lock);
+    pthread_cond_destroy(&mi_ctx->me_cond);
+#endif
 }
 
 static const AVFilterPad minterpolate_inputs[] = {
@@ -1261,8 +1428,10 @@ AVFilter ff_vf_minterpolate = {
     .description   = NULL_IF_CONFIG_SMALL("Frame rate conversion using Motion Interpolation."),
     .priv_size     = sizeof(MIContext),
     .priv_class    = &minterpolate_class,
+    .init          = init,
     .uninit        = uninit,
     .query_formats = query_formats,
     .inputs        = minterpolate_inputs,
     .outputs       = minterpolate_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
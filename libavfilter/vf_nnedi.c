@@ -29,6 +29,7 @@
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "nnedi.h"
 #include "video.h"
 
 typedef struct FrameData {
@@ -43,8 +44,9 @@ typedef struct FrameData {
     int field[3];
 
     int32_t *lcount[3];
-    float *input;
-    float *temp;
+    float *input;   /* 512 floats per slice job */
+    float *temp;    /* temp_stride floats per slice job */
+    int temp_stride;
 } FrameData;
 
 typedef struct NNEDIContext {
@@ -59,6 +61,8 @@ typedef struct NNEDIContext {
     int64_t cur_pts;
 
     AVFloatDSPContext *fdsp;
+    NNEDIDSPContext dsp;
+    int nb_threads;
     int nb_planes;
     int linesize[4];
     int planeheight[4];
@@ -84,8 +88,10 @@ typedef struct NNEDIContext {
     int max_value;
 
     void (*copy_pad)(const AVFrame *, FrameData *, struct NNEDIContext *, int);
-    void (*evalfunc_0)(struct NNEDIContext *, FrameData *);
-    void (*evalfunc_1)(struct NNEDIContext *, FrameData *);
+    void (*evalfunc_0)(struct NNEDIContext *, FrameData *, int plane,
+                       int slice_start, int slice_end, float *input, float *temp);
+    void (*evalfunc_1)(struct NNEDIContext *, FrameData *, int plane,
+                       int slice_start, int slice_end, float *input, float *temp);
 
     // Functions used in evalfunc_0
     void (*readpixels)(const uint8_t *, const int, float *);
@@ -161,6 +167,8 @@ static int config_input(AVFilterLink *inlink)
     s->planeheight[1] = s->planeheight[2] = AV_CEIL_RSHIFT(inlink->h, desc->log2_chroma_h);
     s->planeheight[0] = s->planeheight[3] = inlink->h;
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+
     return 0;
 }
 
@@ -265,10 +273,45 @@ static void elliott(float *data, const int n)
         data[i] = data[i] / (1.0f + FFABS(data[i]));
 }
 
+static void dot_prods_float_c(const float *data, const float *weights,
+                              float *vals, int n, int len)
+{
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        float sum = 0.0f;
+
+        for (j = 0; j < len; j++)
+            sum += data[j] * weights[i * len + j];
+        vals[i] = sum;
+    }
+}
+
+static void dot_prods_int16_c(const int16_t *data, const int16_t *weights,
+                              int32_t *vals, int n, int len)
+{
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        int sum = 0;
+
+        for (j = 0; j < len; j++)
+            sum += data[j] * weights[i * len + j];
+        vals[i] = sum;
+    }
+}
+
 static void dot_prod(NNEDIContext *s, const float *data, const float *weights, float *vals, const int n, const int len, const float *scale)
 {
     int i;
 
+    if (!(n & 3) && !(len & 15)) {
+        s->dsp.dot_prods_float(data, weights, vals, n, len);
+        for (i = 0; i < n; i++)
+            vals[i] = vals[i] * scale[0] + weights[n * len + i];
+        return;
+    }
+
     for (i = 0; i < n; i++) {
         float sum;
 
@@ -283,14 +326,14 @@ static void dot_prods(NNEDIContext *s, const float *dataf, const float *weightsf
     const int16_t *data = (int16_t *)dataf;
     const int16_t *weights = (int16_t *)weightsf;
     const float *wf = (float *)&weights[n * len];
-    int i, j;
+    LOCAL_ALIGNED_16(int32_t, sums, [512]);
+    int i;
 
+    s->dsp.dot_prods_int16(data, weights, sums, n, len);
     for (i = 0; i < n; i++) {
-        int sum = 0, off = ((i >> 2) << 3) + (i & 3);
-        for (j = 0; j < len; j++)
-            sum += data[j] * weights[i * len + j];
+        const int off = ((i >> 2) << 3) + (i & 3);
 
-        vals[i] = sum * wf[off] * scale[0] + wf[off + 4];
+        vals[i] = sums[i] * wf[off] * scale[0] + wf[off + 4];
     }
 }
 
@@ -385,16 +428,14 @@ static void compute_network0new(NNEDIContext *s, const float *datai, const float
     int16_t *data = (int16_t *)datai;
     int16_t *ws = (int16_t *)weights;
     float *wf = (float *)&ws[4 * 64];
+    LOCAL_ALIGNED_16(int32_t, sums, [4]);
     float vals[8];
     int mask, i, j;
 
+    s->dsp.dot_prods_int16(data, ws, sums, 4, 64);
     for (i = 0; i < 4; i++) {
-        int sum = 0;
-        float t;
+        const float t = sums[i] * wf[i] + wf[4 + i];
 
-        for (j = 0; j < 64; j++)
-            sum += data[j] * ws[(i << 3) + ((j >> 3) << 5) + (j & 7)];
-        t = sum * wf[i] + wf[4 + i];
         vals[i] = t / (1.0f + FFABS(t));
     }
 
@@ -415,71 +456,62 @@ static void compute_network0new(NNEDIContext *s, const float *datai, const float
     ((int *)d)[0] = mask;
 }
 
-static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
+static void evalfunc_0(NNEDIContext *s, FrameData *frame_data, int plane,
+                       int slice_start, int slice_end, float *input, float *temp)
 {
-    float *input = frame_data->input;
     const float *weights0 = s->weights0;
-    float *temp = frame_data->temp;
     uint8_t *tempu = (uint8_t *)temp;
-    int plane, x, y;
-
-    // And now the actual work.
-    for (plane = 0; plane < s->nb_planes; plane++) {
-        const uint8_t *srcp = (const uint8_t *)frame_data->paddedp[plane];
-        const int src_stride = frame_data->padded_stride[plane] / sizeof(uint8_t);
+    const int field = frame_data->field[plane];
+    const uint8_t *srcp = (const uint8_t *)frame_data->paddedp[plane];
+    const int src_stride = frame_data->padded_stride[plane] / sizeof(uint8_t);
 
-        const int width = frame_data->padded_width[plane];
-        const int height = frame_data->padded_height[plane];
+    const int width = frame_data->padded_width[plane];
 
-        uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
-        const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
-        const uint8_t *src3p;
-        int ystart, ystop;
-        int32_t *lcount;
+    uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
+    const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
+    const uint8_t *src3p;
+    int32_t *lcount;
+    int x, y;
 
-        if (!(s->process_plane & (1 << plane)))
-            continue;
+    /* lines of the kept field are copied, the others are interpolated */
+    for (y = slice_start + ((slice_start ^ (1 - field)) & 1); y < slice_end; y += 2) {
+        memcpy(dstp + y * dst_stride,
+               srcp + 32 + (6 + y) * src_stride,
+               (width - 64) * sizeof(uint8_t));
 
-        for (y = 1 - frame_data->field[plane]; y < height - 12; y += 2) {
-            memcpy(dstp + y * dst_stride,
-                   srcp + 32 + (6 + y) * src_stride,
-                   (width - 64) * sizeof(uint8_t));
+    }
 
-        }
+    slice_start += (slice_start ^ field) & 1;
+    srcp += (slice_start + 6) * src_stride;
+    dstp += slice_start * dst_stride - 32;
+    src3p = srcp - src_stride * 3;
+    lcount = frame_data->lcount[plane];
 
-        ystart = 6 + frame_data->field[plane];
-        ystop = height - 6;
-        srcp += ystart * src_stride;
-        dstp += (ystart - 6) * dst_stride - 32;
-        src3p = srcp - src_stride * 3;
-        lcount = frame_data->lcount[plane] - 6;
-
-        if (s->pscrn == 1) { // original
-            for (y = ystart; y < ystop; y += 2) {
-                for (x = 32; x < width - 32; x++) {
-                    s->readpixels((const uint8_t *)(src3p + x - 5), src_stride, input);
-                    s->compute_network0(s, input, weights0, tempu+x);
-                }
-                lcount[y] += s->process_line0(tempu + 32, width - 64, (uint8_t *)(dstp + 32), (const uint8_t *)(src3p + 32), src_stride, s->max_value, plane);
-                src3p += src_stride * 2;
-                dstp += dst_stride * 2;
-            }
-        } else if (s->pscrn > 1) { // new
-            for (y = ystart; y < ystop; y += 2) {
-                for (x = 32; x < width - 32; x += 4) {
-                    s->readpixels((const uint8_t *)(src3p + x - 6), src_stride, input);
-                    s->compute_network0(s, input, weights0, tempu + x);
-                }
-                lcount[y] += s->process_line0(tempu + 32, width - 64, (uint8_t *)(dstp + 32), (const uint8_t *)(src3p + 32), src_stride, s->max_value, plane);
-                src3p += src_stride * 2;
-                dstp += dst_stride * 2;
+    if (s->pscrn == 1) { // original
+        for (y = slice_start; y < slice_end; y += 2) {
+            for (x = 32; x < width - 32; x++) {
+                s->readpixels((const uint8_t *)(src3p + x - 5), src_stride, input);
+                s->compute_network0(s, input, weights0, tempu+x);
             }
-        } else { // no prescreening
-            for (y = ystart; y < ystop; y += 2) {
-                memset(dstp + 32, 255, (width - 64) * sizeof(uint8_t));
-                lcount[y] += width - 64;
-                dstp += dst_stride * 2;
+            lcount[y] += s->process_line0(tempu + 32, width - 64, (uint8_t *)(dstp + 32), (const uint8_t *)(src3p + 32), src_stride, s->max_value, plane);
+            src3p += src_stride * 2;
+            dstp += dst_stride * 2;
+        }
+    } else if (s->pscrn > 1) { // new
+        for (y = slice_start; y < slice_end; y += 2) {
+            for (x = 32; x < width - 32; x += 4) {
+                s->readpixels((const uint8_t *)(src3p + x - 6), src_stride, input);
+                s->compute_network0(s, input, weights0, tempu + x);
             }
+            lcount[y] += s->process_line0(tempu + 32, width - 64, (uint8_t *)(dstp + 32), (const uint8_t *)(src3p + 32), src_stride, s->max_value, plane);
+            src3p += src_stride * 2;
+            dstp += dst_stride * 2;
+        }
+    } else { // no prescreening
+        for (y = slice_start; y < slice_end; y += 2) {
+            memset(dstp + 32, 255, (width - 64) * sizeof(uint8_t));
+            lcount[y] += width - 64;
+            dstp += dst_stride * 2;
         }
     }
 }
@@ -575,10 +607,9 @@ static void weighted_avg_elliott_mul5_m16(const float *w, const int n, float *ms
 }
 
 
-static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
+static void evalfunc_1(NNEDIContext *s, FrameData *frame_data, int plane,
+                       int slice_start, int slice_end, float *input, float *temp)
 {
-    float *input = frame_data->input;
-    float *temp = frame_data->temp;
     float **weights1 = s->weights1;
     const int qual = s->qual;
     const int asize = s->asize;
@@ -587,48 +618,40 @@ static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
     const int xdiad2m1 = (xdia / 2) - 1;
     const int ydia = s->ydia;
     const float scale = 1.0f / (float)qual;
-    int plane, y, x, i;
+    const uint8_t *srcp = (const uint8_t *)frame_data->paddedp[plane];
+    const int src_stride = frame_data->padded_stride[plane] / sizeof(uint8_t);
 
-    for (plane = 0; plane < s->nb_planes; plane++) {
-        const uint8_t *srcp = (const uint8_t *)frame_data->paddedp[plane];
-        const int src_stride = frame_data->padded_stride[plane] / sizeof(uint8_t);
+    const int width = frame_data->padded_width[plane];
 
-        const int width = frame_data->padded_width[plane];
-        const int height = frame_data->padded_height[plane];
+    uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
+    const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
 
-        uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
-        const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
+    const int ystart = slice_start + ((slice_start ^ frame_data->field[plane]) & 1);
+    const uint8_t *srcpp;
+    int y, x, i;
 
-        const int ystart = frame_data->field[plane];
-        const int ystop = height - 12;
-        const uint8_t *srcpp;
+    srcp += (ystart + 6) * src_stride;
+    dstp += ystart * dst_stride - 32;
+    srcpp = srcp - (ydia - 1) * src_stride - xdiad2m1;
 
-        if (!(s->process_plane & (1 << plane)))
-            continue;
-
-        srcp += (ystart + 6) * src_stride;
-        dstp += ystart * dst_stride - 32;
-        srcpp = srcp - (ydia - 1) * src_stride - xdiad2m1;
+    for (y = ystart; y < slice_end; y += 2) {
+        for (x = 32; x < width - 32; x++) {
+            float mstd[4];
 
-        for (y = ystart; y < ystop; y += 2) {
-            for (x = 32; x < width - 32; x++) {
-                float mstd[4];
+            if (dstp[x] != 255)
+                continue;
 
-                if (dstp[x] != 255)
-                    continue;
-
-                s->extract((const uint8_t *)(srcpp + x), src_stride, xdia, ydia, mstd, input);
-                for (i = 0; i < qual; i++) {
-                    s->dot_prod(s, input, weights1[i], temp, nns * 2, asize, mstd + 2);
-                    s->expfunc(temp, nns);
-                    s->wae5(temp, nns, mstd);
-                }
-
-                dstp[x] = FFMIN(FFMAX((int)(mstd[3] * scale + 0.5f), 0), s->max_value);
+            s->extract((const uint8_t *)(srcpp + x), src_stride, xdia, ydia, mstd, input);
+            for (i = 0; i < qual; i++) {
+                s->dot_prod(s, input, weights1[i], temp, nns * 2, asize, mstd + 2);
+                s->expfunc(temp, nns);
+                s->wae5(temp, nns, mstd);
             }
-            srcpp += src_stride * 2;
-            dstp += dst_stride * 2;
+
+            dstp[x] = FFMIN(FFMAX((int)(mstd[3] * scale + 0.5f), 0), s->max_value);
         }
+        srcpp += src_stride * 2;
+        dstp += dst_stride * 2;
     }
 }
 
@@ -676,7 +699,43 @@ static void select_functions(NNEDIContext *s)
         s->dot_prod = dot_prod;
     }
 
-    s->expfunc = e2_m16;
+    s->expfunc = s->dsp.exp;
+}
+
+av_cold void ff_nnedi_init(NNEDIDSPContext *dsp)
+{
+    dsp->dot_prods_float = dot_prods_float_c;
+    dsp->dot_prods_int16 = dot_prods_int16_c;
+    dsp->exp             = e2_m16;
+
+    if (ARCH_X86)
+        ff_nnedi_init_x86(dsp);
+}
+
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    NNEDIContext *s = ctx->priv;
+    FrameData *frame_data = &s->frame_data;
+    float *input = frame_data->input + jobnr * 512;
+    float *temp  = frame_data->temp  + jobnr * frame_data->temp_stride;
+    int plane;
+
+    for (plane = 0; plane < s->nb_planes; plane++) {
+        const int height = s->planeheight[plane];
+        const int slice_start = (height *  jobnr     ) / nb_jobs;
+        const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+
+        if (!(s->process_plane & (1 << plane)))
+            continue;
+
+        // Handles prescreening and the cubic interpolation.
+        s->evalfunc_0(s, frame_data, plane, slice_start, slice_end, input, temp);
+
+        // The rest.
+        s->evalfunc_1(s, frame_data, plane, slice_start, slice_end, input, temp);
+    }
+
+    return 0;
 }
 
 static int modnpf(const int m, const int n)
@@ -693,7 +752,6 @@ static int get_frame(AVFilterContext *ctx, int is_second)
     AVFrame *src = s->src;
     FrameData *frame_data;
     int effective_field = s->field;
-    size_t temp_size;
     int field_n;
     int plane;
 
@@ -766,15 +824,15 @@ static int get_frame(AVFilterContext *ctx, int is_second)
     }
 
     if (!frame_data->input) {
-        frame_data->input = av_malloc(512 * sizeof(float));
+        frame_data->input = av_malloc_array(s->nb_threads, 512 * sizeof(float));
         if (!frame_data->input)
             return AVERROR(ENOMEM);
     }
     // evalfunc_0 requires at least padded_width[0] bytes.
     // evalfunc_1 requires at least 512 floats.
     if (!frame_data->temp) {
-        temp_size = FFMAX(frame_data->padded_width[0], 512 * sizeof(float));
-        frame_data->temp = av_malloc(temp_size);
+        frame_data->temp_stride = FFALIGN(FFMAX(frame_data->padded_width[0], 512 * sizeof(float)), 64) / sizeof(float);
+        frame_data->temp = av_malloc_array(s->nb_threads, frame_data->temp_stride * sizeof(float));
         if (!frame_data->temp)
             return AVERROR(ENOMEM);
     }
@@ -782,11 +840,8 @@ static int get_frame(AVFilterContext *ctx, int is_second)
     // Copy src to a padded "frame" in frame_data and mirror the edges.
     s->copy_pad(src, frame_data, s, field_n);
 
-    // Handles prescreening and the cubic interpolation.
-    s->evalfunc_0(s, frame_data);
-
-    // The rest.
-    s->evalfunc_1(s, frame_data);
+    ctx->internal->execute(ctx, filter_slice, NULL, NULL,
+                           FFMIN(s->planeheight[1], s->nb_threads));
 
     return 0;
 }
@@ -1027,7 +1082,7 @@ static av_cold int init(AVFilterContext *ctx)
                 mval = FFMAX(mval, FFABS((bdw[offt[j * 64 + k]] - mean[j]) / 127.5));
             scale = 32767.0 / mval;
             for (k = 0; k < 64; k++)
-                ws[offt[j * 64 + k]] = roundds(((bdw[offt[j * 64 + k]] - mean[j]) / 127.5) * scale);
+                ws[j * 64 + k] = roundds(((bdw[offt[j * 64 + k]] - mean[j]) / 127.5) * scale);
             wf[j] = (float)(mval / 32767.0);
         }
         memcpy(wf + 4, bdw + 4 * 64, (dims0new - 4 * 64) * sizeof(float));
@@ -1145,6 +1200,7 @@ static av_cold int init(AVFilterContext *ctx)
 
     s->max_value = 65535 >> 8;
 
+    ff_nnedi_init(&s->dsp);
     select_functions(s);
 
     s->fdsp = avpriv_float_dsp_alloc(0);
@@ -1207,5 +1263,5 @@ AVFilter ff_vf_nnedi = {
     .query_formats = query_formats,
     .inputs        = inputs,
     .outputs       = outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
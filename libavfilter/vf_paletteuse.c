@@ -25,12 +25,14 @@
 
 #include "libavutil/bprint.h"
 #include "libavutil/internal.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/qsort.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "framesync.h"
 #include "internal.h"
+#include "paletteuse.h"
 
 enum dithering_mode {
     DITHERING_NONE,
@@ -77,15 +79,26 @@ struct cache_node {
 
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
+typedef int (*set_frame_func)(struct PaletteUseContext *s, struct cache_node *cache,
+                              AVFrame *out, AVFrame *in,
                               int x_start, int y_start, int width, int height);
 
+/* distance component used for the palette entries ignored by the search */
+#define PAL16_SKIP 1023
+
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node *cache;               /* lookup caches, CACHE_SIZE nodes per slice job */
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
     uint32_t palette[AVPALETTE_COUNT];
+    DECLARE_ALIGNED(32, int16_t, pal16)[AVPALETTE_COUNT * 4]; /* {r,g,b,0} of each palette entry */
+    PaletteUseDSPContext dsp;
+    int use_lut;
+    uint8_t *lut;                           /* nearest palette entry for each opaque RGB color */
+    int lut_trans;                          /* nearest palette entry for transparent colors */
+    int nb_threads;
+    int *slice_ret;
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
     int trans_thresh;
     int palette_loaded;
@@ -120,6 +133,7 @@ static const AVOption paletteuse_options[] = {
         { "rectangle", "process smallest different rectangle", 0, AV_OPT_TYPE_CONST, {.i64=DIFF_MODE_RECTANGLE}, INT_MIN, INT_MAX, FLAGS, "diff_mode" },
     { "new", "take new palette for each output frame", OFFSET(new), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS },
     { "alpha_threshold", "set the alpha threshold for transparency", OFFSET(trans_thresh), AV_OPT_TYPE_INT, {.i64=128}, 0, 255, FLAGS },
+    { "lut", "precompute the nearest color of the whole RGB cube", OFFSET(use_lut), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS },
 
     /* following are the debug options, not part of the official API */
     { "debug_kdtree", "save Graphviz graph of the kdtree in specified file", OFFSET(dot_filename), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
@@ -206,6 +220,41 @@ static av_always_inline uint8_t colormap_nearest_bruteforce(const uint32_t *pale
     return pal_id;
 }
 
+static void color_dist_c(int32_t *dist, const int16_t *pal,
+                         const int16_t *target, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        const int dr = pal[4*i + 0] - target[0];
+        const int dg = pal[4*i + 1] - target[1];
+        const int db = pal[4*i + 2] - target[2];
+        const int dx = pal[4*i + 3] - target[3];
+        dist[i] = dr*dr + dg*dg + db*db + dx*dx;
+    }
+}
+
+/* Same result as colormap_nearest_bruteforce(), with all the distances
+ * computed at once by the DSP function. */
+static av_always_inline uint8_t colormap_nearest_bruteforce_dsp(const PaletteUseContext *s, const uint8_t *argb)
+{
+    LOCAL_ALIGNED_32(int32_t, dist, [AVPALETTE_COUNT]);
+    const int16_t target[] = { argb[1], argb[2], argb[3], 0 };
+    int i, min_dist = INT_MAX;
+
+    if (argb[0] < s->trans_thresh)
+        return colormap_nearest_bruteforce(s->palette, argb, s->trans_thresh);
+
+    s->dsp.color_dist(dist, s->pal16, target, AVPALETTE_COUNT);
+    for (i = 0; i < AVPALETTE_COUNT; i++)
+        min_dist = FFMIN(min_dist, dist[i]);
+    if (min_dist > 255*255 + 255*255 + 255*255)
+        return -1; // only ignored entries in the palette
+    for (i = 0; dist[i] != min_dist; i++)
+        ;
+    return i;
+}
+
 /* Recursive form, simpler but a bit slower. Kept for reference. */
 struct nearest_color {
     int node_pos;
@@ -327,10 +376,10 @@ end:
     return root[best_node_id].palette_id;
 }
 
-#define COLORMAP_NEAREST(search, palette, root, target, trans_thresh)                                    \
-    search == COLOR_SEARCH_NNS_ITERATIVE ? colormap_nearest_iterative(root, target, trans_thresh) :      \
-    search == COLOR_SEARCH_NNS_RECURSIVE ? colormap_nearest_recursive(root, target, trans_thresh) :      \
-                                           colormap_nearest_bruteforce(palette, target, trans_thresh)
+#define COLORMAP_NEAREST(s, search, target)                                                                  \
+    search == COLOR_SEARCH_NNS_ITERATIVE ? colormap_nearest_iterative((s)->map, target, (s)->trans_thresh) : \
+    search == COLOR_SEARCH_NNS_RECURSIVE ? colormap_nearest_recursive((s)->map, target, (s)->trans_thresh) : \
+                                           colormap_nearest_bruteforce_dsp(s, target)
 
 /**
  * Check if the requested color is in the cache already. If not, find it in the
@@ -338,7 +387,7 @@ end:
  * Note: a, r, g, and b are the components of color, but are passed as well to avoid
  * recomputing them (they are generally computed by the caller for other uses).
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache, uint32_t color,
                                       uint8_t a, uint8_t r, uint8_t g, uint8_t b,
                                       const enum color_search_method search_method)
 {
@@ -348,7 +397,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     const uint8_t ghash = g & ((1<<NBITS)-1);
     const uint8_t bhash = b & ((1<<NBITS)-1);
     const unsigned hash = rhash<<(NBITS*2) | ghash<<NBITS | bhash;
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -356,6 +405,9 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
         return s->transparency_index;
     }
 
+    if (s->lut)
+        return a < s->trans_thresh ? s->lut_trans : s->lut[r<<16 | g<<8 | b];
+
     for (i = 0; i < node->nb_entries; i++) {
         e = &node->entries[i];
         if (e->color == color)
@@ -367,12 +419,12 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     if (!e)
         return AVERROR(ENOMEM);
     e->color = color;
-    e->pal_entry = COLORMAP_NEAREST(search_method, s->palette, s->map, argb_elts, s->trans_thresh);
+    e->pal_entry = COLORMAP_NEAREST(s, search_method, argb_elts);
 
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb,
                                               const enum color_search_method search_method)
 {
@@ -381,7 +433,7 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     const uint8_t g = c >>  8 & 0xff;
     const uint8_t b = c       & 0xff;
     uint32_t dstc;
-    const int dstx = color_get(s, c, a, r, g, b, search_method);
+    const int dstx = color_get(s, cache, c, a, r, g, b, search_method);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -391,7 +443,8 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
+static av_always_inline int set_frame(PaletteUseContext *s, struct cache_node *cache,
+                                      AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
                                       enum dithering_mode dither,
                                       const enum color_search_method search_method)
@@ -418,7 +471,8 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = av_clip_uint8(r8 + d);
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
-                const int color = color_get(s, src[x], a8, r, g, b, search_method);
+                const uint32_t dithered = (uint32_t)a8 << 24 | r << 16 | g << 8 | b;
+                const int color = color_get(s, cache, dithered, a8, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -426,7 +480,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -438,7 +492,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -452,7 +506,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -471,7 +525,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -486,7 +540,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = src[x] >> 16 & 0xff;
                 const uint8_t g = src[x] >>  8 & 0xff;
                 const uint8_t b = src[x]       & 0xff;
-                const int color = color_get(s, src[x], a, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -554,16 +608,17 @@ static int disp_tree(const struct color_node *node, const char *fname)
     return 0;
 }
 
-static int debug_accuracy(const struct color_node *node, const uint32_t *palette, const int trans_thresh,
-                          const enum color_search_method search_method)
+static int debug_accuracy(const PaletteUseContext *s)
 {
+    const uint32_t *palette = s->palette;
+    const int trans_thresh = s->trans_thresh;
     int r, g, b, ret = 0;
 
     for (r = 0; r < 256; r++) {
         for (g = 0; g < 256; g++) {
             for (b = 0; b < 256; b++) {
                 const uint8_t argb[] = {0xff, r, g, b};
-                const int r1 = COLORMAP_NEAREST(search_method, palette, node, argb, trans_thresh);
+                const int r1 = COLORMAP_NEAREST(s, s->color_search_method, argb);
                 const int r2 = colormap_nearest_bruteforce(palette, argb, trans_thresh);
                 if (r1 != r2) {
                     const uint32_t c1 = palette[r1];
@@ -748,6 +803,20 @@ static void load_colormap(PaletteUseContext *s)
         }
     }
 
+    for (i = 0; i < AVPALETTE_COUNT; i++) {
+        const uint32_t c = s->palette[i];
+        int16_t *c16 = &s->pal16[4*i];
+
+        if (c >> 24 < s->trans_thresh) {
+            c16[0] = c16[1] = c16[2] = PAL16_SKIP;
+        } else {
+            c16[0] = c >> 16 & 0xff;
+            c16[1] = c >>  8 & 0xff;
+            c16[2] = c       & 0xff;
+        }
+        c16[3] = 0;
+    }
+
     for (i = 0; i < AVPALETTE_COUNT; i++) {
         const uint32_t c = s->palette[i];
         if (i != 0 && c == last_color) {
@@ -770,7 +839,7 @@ static void load_colormap(PaletteUseContext *s)
         disp_tree(s->map, s->dot_filename);
 
     if (s->debug_accuracy) {
-        if (!debug_accuracy(s->map, s->palette, s->trans_thresh, s->color_search_method))
+        if (!debug_accuracy(s))
             av_log(NULL, AV_LOG_INFO, "Accuracy check passed\n");
     }
 }
@@ -894,12 +963,29 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;
+} ThreadData;
+
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const int slice_start = td->y + (td->h *  jobnr     ) / nb_jobs;
+    const int slice_end   = td->y + (td->h * (jobnr + 1)) / nb_jobs;
+
+    return s->set_frame(s, s->cache + jobnr * CACHE_SIZE, td->out, td->in,
+                        td->x, slice_start, td->w, slice_end - slice_start);
+}
+
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
-    int x, y, w, h, ret;
+    int i, x, y, w, h, nb_jobs, ret;
     AVFilterContext *ctx = inlink->dst;
     PaletteUseContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
+    ThreadData td;
 
     AVFrame *out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -923,11 +1009,24 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
-    if (ret < 0) {
-        av_frame_free(&out);
-        *outf = NULL;
-        return ret;
+    /* error diffusion depends on the previously processed pixels, so only
+     * the other dithering modes can be split into slices */
+    nb_jobs = s->dither == DITHERING_NONE || s->dither == DITHERING_BAYER ?
+              FFMIN(h, s->nb_threads) : 1;
+    td.in = in;
+    td.out = out;
+    td.x = x;
+    td.y = y;
+    td.w = w;
+    td.h = h;
+    ctx->internal->execute(ctx, set_frame_slice, &td, s->slice_ret, nb_jobs);
+    for (i = 0; i < nb_jobs; i++) {
+        ret = s->slice_ret[i];
+        if (ret < 0) {
+            av_frame_free(&out);
+            *outf = NULL;
+            return ret;
+        }
     }
     memcpy(out->data[1], s->palette, AVPALETTE_SIZE);
     if (s->calc_mean_err)
@@ -949,6 +1048,17 @@ static int config_output(AVFilterLink *outlink)
     s->fs.in[1].before = s->fs.in[1].after = EXT_INFINITY;
     s->fs.on_event = load_apply_palette;
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->cache = av_calloc(s->nb_threads, CACHE_SIZE * sizeof(*s->cache));
+    s->slice_ret = av_calloc(s->nb_threads, sizeof(*s->slice_ret));
+    if (!s->cache || !s->slice_ret)
+        return AVERROR(ENOMEM);
+    if (s->use_lut) {
+        s->lut = av_malloc(1 << 24);
+        if (!s->lut)
+            return AVERROR(ENOMEM);
+    }
+
     outlink->w = ctx->inputs[0]->w;
     outlink->h = ctx->inputs[0]->h;
 
@@ -973,8 +1083,106 @@ static int config_input_palette(AVFilterLink *inlink)
     return 0;
 }
 
-static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
+#define LUT_CELL_BITS 3
+#define LUT_CELL      (1 << LUT_CELL_BITS)
+
+/**
+ * Fill the LUT for the colors of a cube of LUT_CELL^3 colors. Only the
+ * palette entries which can be the nearest color of some point of the cube
+ * are tested. Whenever several entries are at the same distance, the actual
+ * search method is used so that the tie is resolved the same way.
+ */
+static void build_lut_cell(PaletteUseContext *s, int r0, int g0, int b0,
+                           const enum color_search_method search_method)
+{
+    LOCAL_ALIGNED_32(int16_t, cand16, [AVPALETTE_COUNT * 4]);
+    LOCAL_ALIGNED_32(int32_t, dist,   [AVPALETTE_COUNT]);
+    uint8_t cand_id[AVPALETTE_COUNT];
+    int dmin[AVPALETTE_COUNT];
+    const int lo[] = { r0, g0, b0 };
+    const int kdtree = search_method != COLOR_SEARCH_BRUTEFORCE;
+    int i, k, r, g, b, nb_cand = 0, nb_cand_pad, max_dist = INT_MAX;
+
+    for (i = 0; i < AVPALETTE_COUNT; i++) {
+        const uint32_t c = s->palette[i];
+        const int a = c >> 24;
+        int dmax = 0;
+
+        /* entries which can not be returned by the search method */
+        if (kdtree ? a != 0xff : a < s->trans_thresh) {
+            dmin[i] = INT_MAX;
+            continue;
+        }
+        dmin[i] = 0;
+        for (k = 0; k < 3; k++) {
+            const int v  = s->pal16[4*i + k];
+            const int d0 = v - lo[k];
+            const int d1 = v - (lo[k] + LUT_CELL - 1);
+            if (d0 < 0) dmin[i] += d0 * d0;
+            if (d1 > 0) dmin[i] += d1 * d1;
+            dmax += FFMAX(d0 * d0, d1 * d1);
+        }
+        max_dist = FFMIN(max_dist, dmax);
+    }
+
+    for (i = 0; i < AVPALETTE_COUNT; i++) {
+        if (dmin[i] <= max_dist) {
+            memcpy(&cand16[4*nb_cand], &s->pal16[4*i], 4 * sizeof(*cand16));
+            cand_id[nb_cand++] = i;
+        }
+    }
+    for (nb_cand_pad = nb_cand; nb_cand_pad & 7; nb_cand_pad++) {
+        int16_t *c16 = &cand16[4*nb_cand_pad];
+        c16[0] = c16[1] = c16[2] = PAL16_SKIP;
+        c16[3] = 0;
+    }
+
+    for (r = r0; r < r0 + LUT_CELL; r++) {
+        for (g = g0; g < g0 + LUT_CELL; g++) {
+            uint8_t *lut = s->lut + (r << 16 | g << 8);
+            for (b = b0; b < b0 + LUT_CELL; b++) {
+                const uint8_t argb[] = {0xff, r, g, b};
+                const int16_t target[] = {r, g, b, 0};
+                int best = -1, nb_best = 0, best_dist = INT_MAX;
+
+                if (nb_cand) {
+                    s->dsp.color_dist(dist, cand16, target, nb_cand_pad);
+                    for (i = 0; i < nb_cand; i++) {
+                        if (dist[i] < best_dist) {
+                            best = i;
+                            best_dist = dist[i];
+                            nb_best = 1;
+                        } else if (dist[i] == best_dist) {
+                            nb_best++;
+                        }
+                    }
+                }
+                lut[b] = nb_best == 1 ? cand_id[best]
+                                      : COLORMAP_NEAREST(s, search_method, argb);
+            }
+        }
+    }
+}
+
+static int build_lut_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const int nb_cells = 256 >> LUT_CELL_BITS;
+    const int slice_start = (nb_cells *  jobnr     ) / nb_jobs;
+    const int slice_end   = (nb_cells * (jobnr + 1)) / nb_jobs;
+    int r, g, b;
+
+    for (r = slice_start; r < slice_end; r++)
+        for (g = 0; g < nb_cells; g++)
+            for (b = 0; b < nb_cells; b++)
+                build_lut_cell(s, r << LUT_CELL_BITS, g << LUT_CELL_BITS,
+                               b << LUT_CELL_BITS, s->color_search_method);
+    return 0;
+}
+
+static void load_palette(AVFilterContext *ctx, const AVFrame *palette_frame)
 {
+    PaletteUseContext *s = ctx->priv;
     int i, x, y;
     const uint32_t *p = (const uint32_t *)palette_frame->data[0];
     const int p_linesize = palette_frame->linesize[0] >> 2;
@@ -984,9 +1192,9 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
+        for (i = 0; i < s->nb_threads * CACHE_SIZE; i++)
             av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        memset(s->cache, 0, s->nb_threads * CACHE_SIZE * sizeof(*s->cache));
     }
 
     i = 0;
@@ -1003,6 +1211,13 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
 
     load_colormap(s);
 
+    if (s->lut) {
+        const uint8_t argb[] = {0, 0, 0, 0};
+        s->lut_trans = COLORMAP_NEAREST(s, s->color_search_method, argb);
+        ctx->internal->execute(ctx, build_lut_slice, NULL, NULL,
+                               FFMIN(256 >> LUT_CELL_BITS, s->nb_threads));
+    }
+
     if (!s->new)
         s->palette_loaded = 1;
 }
@@ -1024,7 +1239,7 @@ static int load_apply_palette(FFFrameSync *fs)
         return AVERROR_BUG;
     }
     if (!s->palette_loaded) {
-        load_palette(s, second);
+        load_palette(ctx, second);
     }
     ret = apply_palette(inlink, master, &out);
     av_frame_free(&master);
@@ -1034,10 +1249,12 @@ static int load_apply_palette(FFFrameSync *fs)
 }
 
 #define DEFINE_SET_FRAME(color_search, name, value)                             \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
+static int set_frame_##name(PaletteUseContext *s, struct cache_node *cache,     \
+                            AVFrame *out, AVFrame *in,                          \
                             int x_start, int y_start, int w, int h)             \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value, color_search);  \
+    return set_frame(s, cache, out, in, x_start, y_start, w, h,                 \
+                     value, color_search);                                      \
 }
 
 #define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
@@ -1075,6 +1292,14 @@ static int dither_value(int p)
            | (p & 1) << 4 | (q & 1) << 5;
 }
 
+av_cold void ff_paletteuse_init(PaletteUseDSPContext *dsp)
+{
+    dsp->color_dist = color_dist_c;
+
+    if (ARCH_X86)
+        ff_paletteuse_init_x86(dsp);
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     PaletteUseContext *s = ctx->priv;
@@ -1088,6 +1313,7 @@ static av_cold int init(AVFilterContext *ctx)
     }
 
     s->set_frame = set_frame_lut[s->color_search_method][s->dither];
+    ff_paletteuse_init(&s->dsp);
 
     if (s->dither == DITHERING_BAYER) {
         int i;
@@ -1112,8 +1338,11 @@ static av_cold void uninit(AVFilterContext *ctx)
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (i = 0; i < CACHE_SIZE; i++)
+    for (i = 0; i < s->nb_threads * CACHE_SIZE; i++)
         av_freep(&s->cache[i].entries);
+    av_freep(&s->cache);
+    av_freep(&s->slice_ret);
+    av_freep(&s->lut);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1150,4 +1379,5 @@ AVFilter ff_vf_paletteuse = {
     .inputs        = paletteuse_inputs,
     .outputs       = paletteuse_outputs,
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -596,7 +596,7 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+static int process_frame(AVFilterLink *inlink, AVFrame *in, AVFrame **pout)
 {
     AVFilterContext *ctx = inlink->dst;
     PseudoColorContext *s = ctx->priv;
@@ -625,15 +625,16 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
 
     av_frame_free(&in);
-    return ff_filter_frame(outlink, out);
+    *pout = out;
+    return 0;
 }
 
 static const AVFilterPad inputs[] = {
     {
-        .name         = "default",
-        .type         = AVMEDIA_TYPE_VIDEO,
-        .filter_frame = filter_frame,
-        .config_props = config_input,
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .process_frame = process_frame,
+        .config_props  = config_input,
     },
     { NULL }
 };
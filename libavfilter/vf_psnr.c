@@ -36,11 +36,17 @@
 #include "psnr.h"
 #include "video.h"
 
+typedef struct PSNRStats {
+    double mse, min_mse, max_mse, mse_comp[4];
+    uint64_t nb_frames;
+} PSNRStats;
+
 typedef struct PSNRContext {
     const AVClass *class;
     FFFrameSync fs;
-    double mse, min_mse, max_mse, mse_comp[4];
-    uint64_t nb_frames;
+    int nb_inputs;
+    int nb_mains;
+    PSNRStats *stats;
     FILE *stats_file;
     char *stats_file_str;
     int stats_version;
@@ -54,6 +60,7 @@ typedef struct PSNRContext {
     int planewidth[4];
     int planeheight[4];
     double planeweight[4];
+    uint64_t *score;
     PSNRDSPContext dsp;
 } PSNRContext;
 
@@ -65,6 +72,7 @@ static const AVOption psnr_options[] = {
     {"f",          "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
     {"stats_version", "Set the format version for the stats file.",               OFFSET(stats_version),  AV_OPT_TYPE_INT,    {.i64=1},    1, 2, FLAGS },
     {"output_max",  "Add raw stats (max values) to the output log.",            OFFSET(stats_add_max), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS},
+    {"inputs",     "Set number of inputs, the last one is the reference",       OFFSET(nb_inputs),      AV_OPT_TYPE_INT,    {.i64=2},    2, 17, FLAGS },
     { NULL }
 };
 
@@ -104,29 +112,55 @@ static uint64_t sse_line_16bit(const uint8_t *_main_line, const uint8_t *_ref_li
     return m2;
 }
 
-static inline
-void compute_images_mse(PSNRContext *s,
-                        const uint8_t *main_data[4], const int main_linesizes[4],
-                        const uint8_t *ref_data[4], const int ref_linesizes[4],
-                        int w, int h, double mse[4])
+void ff_psnr_init(PSNRDSPContext *dsp, int bpp)
+{
+    dsp->sse_line = bpp > 8 ? sse_line_16bit : sse_line_8bit;
+    if (ARCH_X86)
+        ff_psnr_init_x86(dsp, bpp);
+}
+
+typedef struct ThreadData {
+    AVFrame **mains;
+    const AVFrame *ref;
+} ThreadData;
+
+/**
+ * Accumulate the squared errors of a slice of rows of every plane into
+ * s->score[jobnr], each reference line is compared against all the main
+ * inputs while it is in cache.
+ */
+static int compute_images_mse(AVFilterContext *ctx, void *arg,
+                              int jobnr, int nb_jobs)
 {
-    int i, c;
+    PSNRContext *s = ctx->priv;
+    ThreadData *td = arg;
+    uint64_t *score = s->score + jobnr * s->nb_mains * 4;
+    int i, c, k;
 
     for (c = 0; c < s->nb_components; c++) {
         const int outw = s->planewidth[c];
         const int outh = s->planeheight[c];
-        const uint8_t *main_line = main_data[c];
-        const uint8_t *ref_line = ref_data[c];
-        const int ref_linesize = ref_linesizes[c];
-        const int main_linesize = main_linesizes[c];
-        uint64_t m = 0;
-        for (i = 0; i < outh; i++) {
-            m += s->dsp.sse_line(main_line, ref_line, outw);
+        const int slice_start = (outh *  jobnr     ) / nb_jobs;
+        const int slice_end   = (outh * (jobnr + 1)) / nb_jobs;
+        const int ref_linesize = td->ref->linesize[c];
+        const uint8_t *ref_line = td->ref->data[c] + slice_start * ref_linesize;
+
+        for (k = 0; k < s->nb_mains; k++)
+            score[k * 4 + c] = 0;
+
+        for (i = slice_start; i < slice_end; i++) {
+            for (k = 0; k < s->nb_mains; k++) {
+                const AVFrame *main = td->mains[k];
+                if (!main)
+                    continue;
+                score[k * 4 + c] += s->dsp.sse_line(main->data[c] + i * main->linesize[c],
+                                                    ref_line, outw);
+            }
             ref_line += ref_linesize;
-            main_line += main_linesize;
         }
-        mse[c] = m / (double)(outw * outh);
     }
+
+    return 0;
 }
 
 static void set_meta(AVDictionary **metadata, const char *key, char comp, float d)
@@ -142,48 +176,36 @@ static void set_meta(AVDictionary **metadata, const char *key, char comp, float
     }
 }
 
-static int do_psnr(FFFrameSync *fs)
+static void log_stats(PSNRContext *s, int k, AVDictionary **metadata, const double comp_mse[4], double mse)
 {
-    AVFilterContext *ctx = fs->parent;
-    PSNRContext *s = ctx->priv;
-    AVFrame *master, *ref;
-    double comp_mse[4], mse = 0;
-    int ret, j, c;
-    AVDictionary **metadata;
-
-    ret = ff_framesync_dualinput_get(fs, &master, &ref);
-    if (ret < 0)
-        return ret;
-    if (!ref)
-        return ff_filter_frame(ctx->outputs[0], master);
-    metadata = &master->metadata;
-
-    compute_images_mse(s, (const uint8_t **)master->data, master->linesize,
-                          (const uint8_t **)ref->data, ref->linesize,
-                          master->width, master->height, comp_mse);
-
-    for (j = 0; j < s->nb_components; j++)
-        mse += comp_mse[j] * s->planeweight[j];
-
-    s->min_mse = FFMIN(s->min_mse, mse);
-    s->max_mse = FFMAX(s->max_mse, mse);
-
-    s->mse += mse;
-    for (j = 0; j < s->nb_components; j++)
-        s->mse_comp[j] += comp_mse[j];
-    s->nb_frames++;
-
+    PSNRStats *st = &s->stats[k];
+    char prefix[32];
+    int j, c;
+
+    if (s->nb_mains > 1)
+        snprintf(prefix, sizeof(prefix), "lavfi.psnr.%d.", k);
+    else
+        snprintf(prefix, sizeof(prefix), "lavfi.psnr.");
+
+#define META(key, comp, val) do {                               \
+        char key2[64];                                          \
+        snprintf(key2, sizeof(key2), "%s%s", prefix, key);      \
+        set_meta(metadata, key2, comp, val);                    \
+    } while (0)
     for (j = 0; j < s->nb_components; j++) {
         c = s->is_rgb ? s->rgba_map[j] : j;
-        set_meta(metadata, "lavfi.psnr.mse.", s->comps[j], comp_mse[c]);
-        set_meta(metadata, "lavfi.psnr.psnr.", s->comps[j], get_psnr(comp_mse[c], 1, s->max[c]));
+        META("mse.", s->comps[j], comp_mse[c]);
+        META("psnr.", s->comps[j], get_psnr(comp_mse[c], 1, s->max[c]));
     }
-    set_meta(metadata, "lavfi.psnr.mse_avg", 0, mse);
-    set_meta(metadata, "lavfi.psnr.psnr_avg", 0, get_psnr(mse, 1, s->average_max));
+    META("mse_avg", 0, mse);
+    META("psnr_avg", 0, get_psnr(mse, 1, s->average_max));
+#undef META
 
     if (s->stats_file) {
         if (s->stats_version == 2 && !s->stats_header_written) {
             fprintf(s->stats_file, "psnr_log_version:2 fields:n");
+            if (s->nb_mains > 1)
+                fprintf(s->stats_file, ",input");
             fprintf(s->stats_file, ",mse_avg");
             for (j = 0; j < s->nb_components; j++) {
                 fprintf(s->stats_file, ",mse_%c", s->comps[j]);
@@ -201,7 +223,10 @@ static int do_psnr(FFFrameSync *fs)
             fprintf(s->stats_file, "\n");
             s->stats_header_written = 1;
         }
-        fprintf(s->stats_file, "n:%"PRId64" mse_avg:%0.2f ", s->nb_frames, mse);
+        fprintf(s->stats_file, "n:%"PRId64" ", st->nb_frames);
+        if (s->nb_mains > 1)
+            fprintf(s->stats_file, "input:%d ", k);
+        fprintf(s->stats_file, "mse_avg:%0.2f ", mse);
         for (j = 0; j < s->nb_components; j++) {
             c = s->is_rgb ? s->rgba_map[j] : j;
             fprintf(s->stats_file, "mse_%c:%0.2f ", s->comps[j], comp_mse[c]);
@@ -221,16 +246,109 @@ static int do_psnr(FFFrameSync *fs)
         }
         fprintf(s->stats_file, "\n");
     }
+}
+
+static int do_psnr(FFFrameSync *fs)
+{
+    AVFilterContext *ctx = fs->parent;
+    PSNRContext *s = ctx->priv;
+    AVFrame *mains[16] = { NULL }, *ref = NULL;
+    ThreadData td;
+    int ret, j, k, nb_jobs;
+    AVDictionary **metadata;
+
+    if (s->nb_mains == 1) {
+        ret = ff_framesync_dualinput_get(fs, &mains[0], &ref);
+        if (ret < 0)
+            return ret;
+    } else {
+        ret = ff_framesync_get_frame(fs, 0, &mains[0], 1);
+        if (ret < 0)
+            return ret;
+        for (k = 1; k < s->nb_inputs && ret >= 0; k++)
+            ret = ff_framesync_get_frame(fs, k, k < s->nb_mains ? &mains[k] : &ref, 0);
+        if (ret < 0) {
+            av_frame_free(&mains[0]);
+            return ret;
+        }
+        mains[0]->pts = av_rescale_q(fs->pts, fs->time_base, ctx->outputs[0]->time_base);
+        if (ctx->is_disabled)
+            ref = NULL;
+    }
+    if (!ref)
+        return ff_filter_frame(ctx->outputs[0], mains[0]);
+    metadata = &mains[0]->metadata;
+
+    td.mains = mains;
+    td.ref   = ref;
+    nb_jobs  = FFMIN(s->planeheight[0], ff_filter_get_nb_threads(ctx));
+    ctx->internal->execute(ctx, compute_images_mse, &td, NULL, nb_jobs);
 
-    return ff_filter_frame(ctx->outputs[0], master);
+    for (k = 0; k < s->nb_mains; k++) {
+        PSNRStats *st = &s->stats[k];
+        double comp_mse[4], mse = 0;
+
+        if (!mains[k])
+            continue;
+
+        for (j = 0; j < s->nb_components; j++) {
+            uint64_t m = 0;
+            for (int i = 0; i < nb_jobs; i++)
+                m += s->score[(i * s->nb_mains + k) * 4 + j];
+            comp_mse[j] = m / (double)(s->planewidth[j] * s->planeheight[j]);
+        }
+
+        for (j = 0; j < s->nb_components; j++)
+            mse += comp_mse[j] * s->planeweight[j];
+
+        st->min_mse = FFMIN(st->min_mse, mse);
+        st->max_mse = FFMAX(st->max_mse, mse);
+
+        st->mse += mse;
+        for (j = 0; j < s->nb_components; j++)
+            st->mse_comp[j] += comp_mse[j];
+        st->nb_frames++;
+
+        log_stats(s, k, metadata, comp_mse, mse);
+    }
+
+    return ff_filter_frame(ctx->outputs[0], mains[0]);
 }
 
+static int config_input_ref(AVFilterLink *inlink);
+
 static av_cold int init(AVFilterContext *ctx)
 {
     PSNRContext *s = ctx->priv;
+    int ret;
+
+    s->nb_mains = s->nb_inputs - 1;
+    s->stats = av_calloc(s->nb_mains, sizeof(*s->stats));
+    if (!s->stats)
+        return AVERROR(ENOMEM);
+    for (int k = 0; k < s->nb_mains; k++) {
+        s->stats[k].min_mse = +INFINITY;
+        s->stats[k].max_mse = -INFINITY;
+    }
+
+    for (int i = 0; i < s->nb_inputs; i++) {
+        AVFilterPad pad = { 0 };
 
-    s->min_mse = +INFINITY;
-    s->max_mse = -INFINITY;
+        pad.type = AVMEDIA_TYPE_VIDEO;
+        if (i == s->nb_mains) {
+            pad.name = av_strdup("reference");
+            pad.config_props = config_input_ref;
+        } else {
+            pad.name = i ? av_asprintf("main%d", i) : av_strdup("main");
+        }
+        if (!pad.name)
+            return AVERROR(ENOMEM);
+
+        if ((ret = ff_insert_inpad(ctx, i, &pad)) < 0) {
+            av_freep(&pad.name);
+            return ret;
+        }
+    }
 
     if (s->stats_file_str) {
         if (s->stats_version < 2 && s->stats_add_max) {
@@ -290,14 +408,16 @@ static int config_input_ref(AVFilterLink *inlink)
     int j;
 
     s->nb_components = desc->nb_components;
-    if (ctx->inputs[0]->w != ctx->inputs[1]->w ||
-        ctx->inputs[0]->h != ctx->inputs[1]->h) {
-        av_log(ctx, AV_LOG_ERROR, "Width and height of input videos must be same.\n");
-        return AVERROR(EINVAL);
-    }
-    if (ctx->inputs[0]->format != ctx->inputs[1]->format) {
-        av_log(ctx, AV_LOG_ERROR, "Inputs must be of same pixel format.\n");
-        return AVERROR(EINVAL);
+    for (j = 0; j < s->nb_mains; j++) {
+        if (ctx->inputs[j]->w != inlink->w ||
+            ctx->inputs[j]->h != inlink->h) {
+            av_log(ctx, AV_LOG_ERROR, "Width and height of input videos must be same.\n");
+            return AVERROR(EINVAL);
+        }
+        if (ctx->inputs[j]->format != inlink->format) {
+            av_log(ctx, AV_LOG_ERROR, "Inputs must be of same pixel format.\n");
+            return AVERROR(EINVAL);
+        }
     }
 
     s->max[0] = (1 << desc->comp[0].depth) - 1;
@@ -325,9 +445,11 @@ static int config_input_ref(AVFilterLink *inlink)
     }
     s->average_max = lrint(average_max);
 
-    s->dsp.sse_line = desc->comp[0].depth > 8 ? sse_line_16bit : sse_line_8bit;
-    if (ARCH_X86)
-        ff_psnr_init_x86(&s->dsp, desc->comp[0].depth);
+    s->score = av_calloc(ff_filter_get_nb_threads(ctx) * s->nb_mains * 4, sizeof(*s->score));
+    if (!s->score)
+        return AVERROR(ENOMEM);
+
+    ff_psnr_init(&s->dsp, desc->comp[0].depth);
 
     return 0;
 }
@@ -339,9 +461,21 @@ static int config_output(AVFilterLink *outlink)
     AVFilterLink *mainlink = ctx->inputs[0];
     int ret;
 
-    ret = ff_framesync_init_dualinput(&s->fs, ctx);
-    if (ret < 0)
-        return ret;
+    if (s->nb_mains == 1) {
+        ret = ff_framesync_init_dualinput(&s->fs, ctx);
+        if (ret < 0)
+            return ret;
+    } else {
+        ret = ff_framesync_init(&s->fs, ctx, s->nb_inputs);
+        if (ret < 0)
+            return ret;
+        for (int i = 0; i < s->nb_inputs; i++) {
+            s->fs.in[i].time_base = ctx->inputs[i]->time_base;
+            s->fs.in[i].sync      = i ? 1 : 2;
+            s->fs.in[i].before    = i ? EXT_NULL : EXT_STOP;
+            s->fs.in[i].after     = EXT_INFINITY;
+        }
+    }
     outlink->w = mainlink->w;
     outlink->h = mainlink->h;
     outlink->time_base = mainlink->time_base;
@@ -352,11 +486,13 @@ static int config_output(AVFilterLink *outlink)
 
     outlink->time_base = s->fs.time_base;
 
-    if (av_cmp_q(mainlink->time_base, outlink->time_base) ||
-        av_cmp_q(ctx->inputs[1]->time_base, outlink->time_base))
-        av_log(ctx, AV_LOG_WARNING, "not matching timebases found between first input: %d/%d and second input %d/%d, results may be incorrect!\n",
-               mainlink->time_base.num, mainlink->time_base.den,
-               ctx->inputs[1]->time_base.num, ctx->inputs[1]->time_base.den);
+    for (int i = 1; i < s->nb_inputs; i++) {
+        if (av_cmp_q(mainlink->time_base, outlink->time_base) ||
+            av_cmp_q(ctx->inputs[i]->time_base, outlink->time_base))
+            av_log(ctx, AV_LOG_WARNING, "not matching timebases found between first input: %d/%d and input %d: %d/%d, results may be incorrect!\n",
+                   mainlink->time_base.num, mainlink->time_base.den, i,
+                   ctx->inputs[i]->time_base.num, ctx->inputs[i]->time_base.den);
+    }
 
     return 0;
 }
@@ -371,40 +507,40 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     PSNRContext *s = ctx->priv;
 
-    if (s->nb_frames > 0) {
+    for (int k = 0; s->stats && k < s->nb_mains; k++) {
+        PSNRStats *st = &s->stats[k];
         int j;
         char buf[256];
 
+        if (!st->nb_frames)
+            continue;
+
         buf[0] = 0;
+        if (s->nb_mains > 1)
+            av_strlcatf(buf, sizeof(buf), " input:%d", k);
         for (j = 0; j < s->nb_components; j++) {
             int c = s->is_rgb ? s->rgba_map[j] : j;
             av_strlcatf(buf, sizeof(buf), " %c:%f", s->comps[j],
-                        get_psnr(s->mse_comp[c], s->nb_frames, s->max[c]));
+                        get_psnr(st->mse_comp[c], st->nb_frames, s->max[c]));
         }
         av_log(ctx, AV_LOG_INFO, "PSNR%s average:%f min:%f max:%f\n",
                buf,
-               get_psnr(s->mse, s->nb_frames, s->average_max),
-               get_psnr(s->max_mse, 1, s->average_max),
-               get_psnr(s->min_mse, 1, s->average_max));
+               get_psnr(st->mse, st->nb_frames, s->average_max),
+               get_psnr(st->max_mse, 1, s->average_max),
+               get_psnr(st->min_mse, 1, s->average_max));
     }
 
     ff_framesync_uninit(&s->fs);
 
     if (s->stats_file && s->stats_file != stdout)
         fclose(s->stats_file);
-}
 
-static const AVFilterPad psnr_inputs[] = {
-    {
-        .name         = "main",
-        .type         = AVMEDIA_TYPE_VIDEO,
-    },{
-        .name         = "reference",
-        .type         = AVMEDIA_TYPE_VIDEO,
-        .config_props = config_input_ref,
-    },
-    { NULL }
-};
+    av_freep(&s->stats);
+    av_freep(&s->score);
+
+    for (int i = 0; i < ctx->nb_inputs; i++)
+        av_freep(&ctx->input_pads[i].name);
+}
 
 static const AVFilterPad psnr_outputs[] = {
     {
@@ -425,6 +561,6 @@ AVFilter ff_vf_psnr = {
     .activate      = activate,
     .priv_size     = sizeof(PSNRContext),
     .priv_class    = &psnr_class,
-    .inputs        = psnr_inputs,
     .outputs       = psnr_outputs,
+    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -492,7 +492,8 @@ static void blur_image(int ***mask,
     }
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *inpicref)
+static int process_frame(AVFilterLink *inlink, AVFrame *inpicref,
+                         AVFrame **out)
 {
     RemovelogoContext *s = inlink->dst->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
@@ -530,7 +531,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *inpicref)
     if (!direct)
         av_frame_free(&inpicref);
 
-    return ff_filter_frame(outlink, outpicref);
+    *out = outpicref;
+    return 0;
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -557,10 +559,10 @@ static av_cold void uninit(AVFilterContext *ctx)
 
 static const AVFilterPad removelogo_inputs[] = {
     {
-        .name         = "default",
-        .type         = AVMEDIA_TYPE_VIDEO,
-        .config_props = config_props_input,
-        .filter_frame = filter_frame,
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .config_props  = config_props_input,
+        .process_frame = process_frame,
     },
     { NULL }
 };
@@ -45,27 +45,35 @@
 #include "ssim.h"
 #include "video.h"
 
+typedef struct SSIMStats {
+    uint64_t nb_frames;
+    double ssim[4], ssim_total;
+} SSIMStats;
+
 typedef struct SSIMContext {
     const AVClass *class;
     FFFrameSync fs;
     FILE *stats_file;
     char *stats_file_str;
+    int nb_inputs;
+    int nb_mains;
     int nb_components;
     int max;
-    uint64_t nb_frames;
-    double ssim[4], ssim_total;
+    SSIMStats *stats;
     char comps[4];
     double coefs[4];
     uint8_t rgba_map[4];
     int planewidth[4];
     int planeheight[4];
-    int *temp;
+    uint8_t **temp;
+    int nb_temp;
+    double *score;
     int is_rgb;
-    double (*ssim_plane)(SSIMDSPContext *dsp,
-                        uint8_t *main, int main_stride,
-                        uint8_t *ref, int ref_stride,
-                        int width, int height, void *temp,
-                        int max);
+    void (*ssim_plane)(SSIMDSPContext *dsp,
+                       uint8_t *main, int main_stride,
+                       uint8_t *ref, int ref_stride,
+                       int width, int y_start, int y_end, void *temp,
+                       int max, double *score);
     SSIMDSPContext dsp;
 } SSIMContext;
 
@@ -75,6 +83,7 @@ typedef struct SSIMContext {
 static const AVOption ssim_options[] = {
     {"stats_file", "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
     {"f",          "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    {"inputs",     "Set number of inputs, the last one is the reference",       OFFSET(nb_inputs),      AV_OPT_TYPE_INT,    {.i64=2},    2, 17, FLAGS },
     { NULL }
 };
 
@@ -129,6 +138,42 @@ static void ssim_4x4xn_16bit(const uint8_t *main8, ptrdiff_t main_stride,
     }
 }
 
+static void ssim_4x4xn_12bit(const uint8_t *main8, ptrdiff_t main_stride,
+                             const uint8_t *ref8, ptrdiff_t ref_stride,
+                             int (*sums)[4], int width)
+{
+    const uint16_t *main16 = (const uint16_t *)main8;
+    const uint16_t *ref16  = (const uint16_t *)ref8;
+    int x, y, z;
+
+    main_stride >>= 1;
+    ref_stride >>= 1;
+
+    for (z = 0; z < width; z++) {
+        uint32_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
+
+        for (y = 0; y < 4; y++) {
+            for (x = 0; x < 4; x++) {
+                unsigned a = main16[x + y * main_stride];
+                unsigned b = ref16[x + y * ref_stride];
+
+                s1  += a;
+                s2  += b;
+                ss  += a*a;
+                ss  += b*b;
+                s12 += a*b;
+            }
+        }
+
+        sums[z][0] = s1;
+        sums[z][1] = s2;
+        sums[z][2] = ss;
+        sums[z][3] = s12;
+        main16 += 4;
+        ref16 += 4;
+    }
+}
+
 static void ssim_4x4xn_8bit(const uint8_t *main, ptrdiff_t main_stride,
                             const uint8_t *ref, ptrdiff_t ref_stride,
                             int (*sums)[4], int width)
@@ -160,11 +205,12 @@ static void ssim_4x4xn_8bit(const uint8_t *main, ptrdiff_t main_stride,
     }
 }
 
-static float ssim_end1x(int64_t s1, int64_t s2, int64_t ss, int64_t s12, int max)
-{
-    int64_t ssim_c1 = (int64_t)(.01*.01*max*max*64 + .5);
-    int64_t ssim_c2 = (int64_t)(.03*.03*max*max*64*63 + .5);
+#define SSIM_C1(max) ((int64_t)(.01*.01*(max)*(max)*64 + .5))
+#define SSIM_C2(max) ((int64_t)(.03*.03*(max)*(max)*64*63 + .5))
 
+static float ssim_end1x(int64_t s1, int64_t s2, int64_t ss, int64_t s12,
+                        int64_t ssim_c1, int64_t ssim_c2)
+{
     int64_t fs1 = s1;
     int64_t fs2 = s2;
     int64_t fss = ss;
@@ -192,7 +238,8 @@ static float ssim_end1(int s1, int s2, int ss, int s12)
          / ((float)(fs1 * fs1 + fs2 * fs2 + ssim_c1) * (float)(vars + ssim_c2));
 }
 
-static float ssim_endn_16bit(const int64_t (*sum0)[4], const int64_t (*sum1)[4], int width, int max)
+static float ssim_endn_16bit(const int64_t (*sum0)[4], const int64_t (*sum1)[4], int width,
+                             int64_t c1, int64_t c2)
 {
     float ssim = 0.0;
     int i;
@@ -202,7 +249,23 @@ static float ssim_endn_16bit(const int64_t (*sum0)[4], const int64_t (*sum1)[4],
                            sum0[i][1] + sum0[i + 1][1] + sum1[i][1] + sum1[i + 1][1],
                            sum0[i][2] + sum0[i + 1][2] + sum1[i][2] + sum1[i + 1][2],
                            sum0[i][3] + sum0[i + 1][3] + sum1[i][3] + sum1[i + 1][3],
-                           max);
+                           c1, c2);
+    return ssim;
+}
+
+/* up to 12 bits, the sums of four 4x4 blocks fit in an int */
+static double ssim_endn_12bit(const int (*sum0)[4], const int (*sum1)[4], int width,
+                              int c1, int c2)
+{
+    double ssim = 0.0;
+    int i;
+
+    for (i = 0; i < width; i++)
+        ssim += ssim_end1x(sum0[i][0] + sum0[i + 1][0] + sum1[i][0] + sum1[i + 1][0],
+                           sum0[i][1] + sum0[i + 1][1] + sum1[i][1] + sum1[i + 1][1],
+                           sum0[i][2] + sum0[i + 1][2] + sum1[i][2] + sum1[i + 1][2],
+                           sum0[i][3] + sum0[i + 1][3] + sum1[i][3] + sum1[i + 1][3],
+                           c1, c2);
     return ssim;
 }
 
@@ -221,21 +284,24 @@ static double ssim_endn_8bit(const int (*sum0)[4], const int (*sum1)[4], int wid
 
 #define SUM_LEN(w) (((w) >> 2) + 3)
 
-static double ssim_plane_16bit(SSIMDSPContext *dsp,
-                              uint8_t *main, int main_stride,
-                              uint8_t *ref, int ref_stride,
-                              int width, int height, void *temp,
-                              int max)
+/**
+ * Compute the SSIM sum of each row y in [y_start, y_end) of 4x4 blocks into
+ * score[y], y_start >= 1 since each row is paired with the one above it.
+ */
+static void ssim_plane_16bit(SSIMDSPContext *dsp,
+                             uint8_t *main, int main_stride,
+                             uint8_t *ref, int ref_stride,
+                             int width, int y_start, int y_end, void *temp,
+                             int max, double *score)
 {
-    int z = 0, y;
-    double ssim = 0.0;
+    int z = y_start - 1, y;
     int64_t (*sum0)[4] = temp;
     int64_t (*sum1)[4] = sum0 + SUM_LEN(width);
+    int64_t c1 = SSIM_C1(max), c2 = SSIM_C2(max);
 
     width >>= 2;
-    height >>= 2;
 
-    for (y = 1; y < height; y++) {
+    for (y = y_start; y < y_end; y++) {
         for (; z <= y; z++) {
             FFSWAP(void*, sum0, sum1);
             ssim_4x4xn_16bit(&main[4 * z * main_stride], main_stride,
@@ -243,27 +309,49 @@ static double ssim_plane_16bit(SSIMDSPContext *dsp,
                              sum0, width);
         }
 
-        ssim += ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
+        score[y] = ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, c1, c2);
     }
+}
 
-    return ssim / ((height - 1) * (width - 1));
+static void ssim_plane_12bit(SSIMDSPContext *dsp,
+                             uint8_t *main, int main_stride,
+                             uint8_t *ref, int ref_stride,
+                             int width, int y_start, int y_end, void *temp,
+                             int max, double *score)
+{
+    int z = y_start - 1, y;
+    int (*sum0)[4] = temp;
+    int (*sum1)[4] = sum0 + SUM_LEN(width);
+    int c1 = SSIM_C1(max), c2 = SSIM_C2(max);
+
+    width >>= 2;
+
+    for (y = y_start; y < y_end; y++) {
+        for (; z <= y; z++) {
+            FFSWAP(void*, sum0, sum1);
+            dsp->ssim_4x4_line(&main[4 * z * main_stride], main_stride,
+                               &ref[4 * z * ref_stride], ref_stride,
+                               sum0, width);
+        }
+
+        score[y] = dsp->ssim_end_line_12bit((const int (*)[4])sum0, (const int (*)[4])sum1,
+                                            width - 1, c1, c2);
+    }
 }
 
-static double ssim_plane(SSIMDSPContext *dsp,
-                        uint8_t *main, int main_stride,
-                        uint8_t *ref, int ref_stride,
-                        int width, int height, void *temp,
-                        int max)
+static void ssim_plane(SSIMDSPContext *dsp,
+                       uint8_t *main, int main_stride,
+                       uint8_t *ref, int ref_stride,
+                       int width, int y_start, int y_end, void *temp,
+                       int max, double *score)
 {
-    int z = 0, y;
-    double ssim = 0.0;
+    int z = y_start - 1, y;
     int (*sum0)[4] = temp;
     int (*sum1)[4] = sum0 + SUM_LEN(width);
 
     width >>= 2;
-    height >>= 2;
 
-    for (y = 1; y < height; y++) {
+    for (y = y_start; y < y_end; y++) {
         for (; z <= y; z++) {
             FFSWAP(void*, sum0, sum1);
             dsp->ssim_4x4_line(&main[4 * z * main_stride], main_stride,
@@ -271,10 +359,17 @@ static double ssim_plane(SSIMDSPContext *dsp,
                                sum0, width);
         }
 
-        ssim += dsp->ssim_end_line((const int (*)[4])sum0, (const int (*)[4])sum1, width - 1);
+        score[y] = dsp->ssim_end_line((const int (*)[4])sum0, (const int (*)[4])sum1, width - 1);
     }
+}
 
-    return ssim / ((height - 1) * (width - 1));
+void ff_ssim_init(SSIMDSPContext *dsp, int bpp)
+{
+    dsp->ssim_4x4_line       = bpp > 8 ? ssim_4x4xn_12bit : ssim_4x4xn_8bit;
+    dsp->ssim_end_line       = ssim_endn_8bit;
+    dsp->ssim_end_line_12bit = ssim_endn_12bit;
+    if (ARCH_X86)
+        ff_ssim_init_x86(dsp, bpp);
 }
 
 static double ssim_db(double ssim, double weight)
@@ -282,43 +377,67 @@ static double ssim_db(double ssim, double weight)
     return (fabs(weight - ssim) > 1e-9) ? 10.0 * log10(weight / (weight - ssim)) : INFINITY;
 }
 
-static int do_ssim(FFFrameSync *fs)
+/* rows of 4x4 blocks compared against all main inputs before moving on */
+#define SSIM_CHUNK 8
+
+typedef struct ThreadData {
+    AVFrame **mains;
+    const AVFrame *ref;
+} ThreadData;
+
+static int ssim_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    AVFilterContext *ctx = fs->parent;
     SSIMContext *s = ctx->priv;
-    AVFrame *master, *ref;
-    AVDictionary **metadata;
-    double c[4] = { 0 }, ssimv = 0.0;
-    int ret, i;
+    ThreadData *td = arg;
+    void *temp = s->temp[jobnr];
+    const int rows = (s->planeheight[0] >> 2) + 1;
+
+    for (int c = 0; c < s->nb_components; c++) {
+        const int height = s->planeheight[c] >> 2;
+        const int slice_start = 1 + ((height - 1) *  jobnr     ) / nb_jobs;
+        const int slice_end   = 1 + ((height - 1) * (jobnr + 1)) / nb_jobs;
+        const int chunk = s->nb_mains > 1 ? SSIM_CHUNK : FFMAX(slice_end - slice_start, 1);
+
+        for (int y = slice_start; y < slice_end; y += chunk) {
+            for (int k = 0; k < s->nb_mains; k++) {
+                AVFrame *main = td->mains[k];
+                if (!main)
+                    continue;
+                s->ssim_plane(&s->dsp, main->data[c], main->linesize[c],
+                              td->ref->data[c], td->ref->linesize[c],
+                              s->planewidth[c], y, FFMIN(y + chunk, slice_end),
+                              temp, s->max, s->score + (k * 4 + c) * rows);
+            }
+        }
+    }
 
-    ret = ff_framesync_dualinput_get(fs, &master, &ref);
-    if (ret < 0)
-        return ret;
-    if (!ref)
-        return ff_filter_frame(ctx->outputs[0], master);
-    metadata = &master->metadata;
+    return 0;
+}
 
-    s->nb_frames++;
+static void log_stats(SSIMContext *s, int k, AVDictionary **metadata, const double c[4], double ssimv)
+{
+    SSIMStats *st = &s->stats[k];
+    char prefix[32], key[64];
+    int i;
+
+    if (s->nb_mains > 1)
+        snprintf(prefix, sizeof(prefix), "lavfi.ssim.%d.", k);
+    else
+        snprintf(prefix, sizeof(prefix), "lavfi.ssim.");
 
-    for (i = 0; i < s->nb_components; i++) {
-        c[i] = s->ssim_plane(&s->dsp, master->data[i], master->linesize[i],
-                             ref->data[i], ref->linesize[i],
-                             s->planewidth[i], s->planeheight[i], s->temp,
-                             s->max);
-        ssimv += s->coefs[i] * c[i];
-        s->ssim[i] += c[i];
-    }
     for (i = 0; i < s->nb_components; i++) {
         int cidx = s->is_rgb ? s->rgba_map[i] : i;
-        set_meta(metadata, "lavfi.ssim.", s->comps[i], c[cidx]);
+        set_meta(metadata, prefix, s->comps[i], c[cidx]);
     }
-    s->ssim_total += ssimv;
-
-    set_meta(metadata, "lavfi.ssim.All", 0, ssimv);
-    set_meta(metadata, "lavfi.ssim.dB", 0, ssim_db(ssimv, 1.0));
+    snprintf(key, sizeof(key), "%sAll", prefix);
+    set_meta(metadata, key, 0, ssimv);
+    snprintf(key, sizeof(key), "%sdB", prefix);
+    set_meta(metadata, key, 0, ssim_db(ssimv, 1.0));
 
     if (s->stats_file) {
-        fprintf(s->stats_file, "n:%"PRId64" ", s->nb_frames);
+        fprintf(s->stats_file, "n:%"PRId64" ", st->nb_frames);
+        if (s->nb_mains > 1)
+            fprintf(s->stats_file, "input:%d ", k);
 
         for (i = 0; i < s->nb_components; i++) {
             int cidx = s->is_rgb ? s->rgba_map[i] : i;
@@ -327,13 +446,103 @@ static int do_ssim(FFFrameSync *fs)
 
         fprintf(s->stats_file, "All:%f (%f)\n", ssimv, ssim_db(ssimv, 1.0));
     }
+}
+
+static int do_ssim(FFFrameSync *fs)
+{
+    AVFilterContext *ctx = fs->parent;
+    SSIMContext *s = ctx->priv;
+    AVFrame *mains[16] = { NULL }, *ref = NULL;
+    AVDictionary **metadata;
+    const int rows = (s->planeheight[0] >> 2) + 1;
+    ThreadData td;
+    int ret, i, k;
+
+    if (s->nb_mains == 1) {
+        ret = ff_framesync_dualinput_get(fs, &mains[0], &ref);
+        if (ret < 0)
+            return ret;
+    } else {
+        ret = ff_framesync_get_frame(fs, 0, &mains[0], 1);
+        if (ret < 0)
+            return ret;
+        for (k = 1; k < s->nb_inputs && ret >= 0; k++)
+            ret = ff_framesync_get_frame(fs, k, k < s->nb_mains ? &mains[k] : &ref, 0);
+        if (ret < 0) {
+            av_frame_free(&mains[0]);
+            return ret;
+        }
+        mains[0]->pts = av_rescale_q(fs->pts, fs->time_base, ctx->outputs[0]->time_base);
+        if (ctx->is_disabled)
+            ref = NULL;
+    }
+    if (!ref)
+        return ff_filter_frame(ctx->outputs[0], mains[0]);
+    metadata = &mains[0]->metadata;
+
+    td.mains = mains;
+    td.ref   = ref;
+    ctx->internal->execute(ctx, ssim_slice, &td, NULL,
+                           FFMAX(FFMIN((s->planeheight[0] >> 2) - 1, ff_filter_get_nb_threads(ctx)), 1));
+
+    for (k = 0; k < s->nb_mains; k++) {
+        SSIMStats *st = &s->stats[k];
+        double c[4] = { 0 }, ssimv = 0.0;
+
+        if (!mains[k])
+            continue;
+
+        st->nb_frames++;
 
-    return ff_filter_frame(ctx->outputs[0], master);
+        for (i = 0; i < s->nb_components; i++) {
+            const double *score = s->score + (k * 4 + i) * rows;
+            const int width  = s->planewidth[i]  >> 2;
+            const int height = s->planeheight[i] >> 2;
+
+            for (int y = 1; y < height; y++)
+                c[i] += score[y];
+            c[i] /= (height - 1) * (width - 1);
+            ssimv += s->coefs[i] * c[i];
+            st->ssim[i] += c[i];
+        }
+        st->ssim_total += ssimv;
+
+        log_stats(s, k, metadata, c, ssimv);
+    }
+
+    return ff_filter_frame(ctx->outputs[0], mains[0]);
 }
 
+static int config_input_ref(AVFilterLink *inlink);
+
 static av_cold int init(AVFilterContext *ctx)
 {
     SSIMContext *s = ctx->priv;
+    int ret;
+
+    s->nb_mains = s->nb_inputs - 1;
+    s->stats = av_calloc(s->nb_mains, sizeof(*s->stats));
+    if (!s->stats)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < s->nb_inputs; i++) {
+        AVFilterPad pad = { 0 };
+
+        pad.type = AVMEDIA_TYPE_VIDEO;
+        if (i == s->nb_mains) {
+            pad.name = av_strdup("reference");
+            pad.config_props = config_input_ref;
+        } else {
+            pad.name = i ? av_asprintf("main%d", i) : av_strdup("main");
+        }
+        if (!pad.name)
+            return AVERROR(ENOMEM);
+
+        if ((ret = ff_insert_inpad(ctx, i, &pad)) < 0) {
+            av_freep(&pad.name);
+            return ret;
+        }
+    }
 
     if (s->stats_file_str) {
         if (!strcmp(s->stats_file_str, "-")) {
@@ -385,14 +594,16 @@ static int config_input_ref(AVFilterLink *inlink)
 
     s->nb_components = desc->nb_components;
 
-    if (ctx->inputs[0]->w != ctx->inputs[1]->w ||
-        ctx->inputs[0]->h != ctx->inputs[1]->h) {
-        av_log(ctx, AV_LOG_ERROR, "Width and height of input videos must be same.\n");
-        return AVERROR(EINVAL);
-    }
-    if (ctx->inputs[0]->format != ctx->inputs[1]->format) {
-        av_log(ctx, AV_LOG_ERROR, "Inputs must be of same pixel format.\n");
-        return AVERROR(EINVAL);
+    for (i = 0; i < s->nb_mains; i++) {
+        if (ctx->inputs[i]->w != inlink->w ||
+            ctx->inputs[i]->h != inlink->h) {
+            av_log(ctx, AV_LOG_ERROR, "Width and height of input videos must be same.\n");
+            return AVERROR(EINVAL);
+        }
+        if (ctx->inputs[i]->format != inlink->format) {
+            av_log(ctx, AV_LOG_ERROR, "Inputs must be of same pixel format.\n");
+            return AVERROR(EINVAL);
+        }
     }
 
     s->is_rgb = ff_fill_rgba_map(s->rgba_map, inlink->format) >= 0;
@@ -410,16 +621,29 @@ static int config_input_ref(AVFilterLink *inlink)
     for (i = 0; i < s->nb_components; i++)
         s->coefs[i] = (double) s->planeheight[i] * s->planewidth[i] / sum;
 
-    s->temp = av_mallocz_array(2 * SUM_LEN(inlink->w), (desc->comp[0].depth > 8) ? sizeof(int64_t[4]) : sizeof(int[4]));
+    s->nb_temp = ff_filter_get_nb_threads(ctx);
+    s->temp = av_calloc(s->nb_temp, sizeof(*s->temp));
     if (!s->temp)
         return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_temp; i++) {
+        s->temp[i] = av_mallocz_array(2 * SUM_LEN(inlink->w), (desc->comp[0].depth > 12) ? sizeof(int64_t[4]) : sizeof(int[4]));
+        if (!s->temp[i])
+            return AVERROR(ENOMEM);
+    }
+    s->score = av_calloc(s->nb_mains * 4 * ((inlink->h >> 2) + 1), sizeof(*s->score));
+    if (!s->score)
+        return AVERROR(ENOMEM);
     s->max = (1 << desc->comp[0].depth) - 1;
 
-    s->ssim_plane = desc->comp[0].depth > 8 ? ssim_plane_16bit : ssim_plane;
-    s->dsp.ssim_4x4_line = ssim_4x4xn_8bit;
-    s->dsp.ssim_end_line = ssim_endn_8bit;
-    if (ARCH_X86)
-        ff_ssim_init_x86(&s->dsp);
+    /* Up to 12 bits, the block sums fit in 32 bits; beyond, the sums of
+     * squares need 64 bits and there is no SIMD. */
+    if (desc->comp[0].depth > 12)
+        s->ssim_plane = ssim_plane_16bit;
+    else if (desc->comp[0].depth > 8)
+        s->ssim_plane = ssim_plane_12bit;
+    else
+        s->ssim_plane = ssim_plane;
+    ff_ssim_init(&s->dsp, desc->comp[0].depth);
 
     return 0;
 }
@@ -431,9 +655,21 @@ static int config_output(AVFilterLink *outlink)
     AVFilterLink *mainlink = ctx->inputs[0];
     int ret;
 
-    ret = ff_framesync_init_dualinput(&s->fs, ctx);
-    if (ret < 0)
-        return ret;
+    if (s->nb_mains == 1) {
+        ret = ff_framesync_init_dualinput(&s->fs, ctx);
+        if (ret < 0)
+            return ret;
+    } else {
+        ret = ff_framesync_init(&s->fs, ctx, s->nb_inputs);
+        if (ret < 0)
+            return ret;
+        for (int i = 0; i < s->nb_inputs; i++) {
+            s->fs.in[i].time_base = ctx->inputs[i]->time_base;
+            s->fs.in[i].sync      = i ? 1 : 2;
+            s->fs.in[i].before    = i ? EXT_NULL : EXT_STOP;
+            s->fs.in[i].after     = EXT_INFINITY;
+        }
+    }
     outlink->w = mainlink->w;
     outlink->h = mainlink->h;
     outlink->time_base = mainlink->time_base;
@@ -445,11 +681,13 @@ static int config_output(AVFilterLink *outlink)
 
     outlink->time_base = s->fs.time_base;
 
-    if (av_cmp_q(mainlink->time_base, outlink->time_base) ||
-        av_cmp_q(ctx->inputs[1]->time_base, outlink->time_base))
-        av_log(ctx, AV_LOG_WARNING, "not matching timebases found between first input: %d/%d and second input %d/%d, results may be incorrect!\n",
-               mainlink->time_base.num, mainlink->time_base.den,
-               ctx->inputs[1]->time_base.num, ctx->inputs[1]->time_base.den);
+    for (int i = 1; i < s->nb_inputs; i++) {
+        if (av_cmp_q(mainlink->time_base, outlink->time_base) ||
+            av_cmp_q(ctx->inputs[i]->time_base, outlink->time_base))
+            av_log(ctx, AV_LOG_WARNING, "not matching timebases found between first input: %d/%d and input %d: %d/%d, results may be incorrect!\n",
+                   mainlink->time_base.num, mainlink->time_base.den, i,
+                   ctx->inputs[i]->time_base.num, ctx->inputs[i]->time_base.den);
+    }
 
     return 0;
 }
@@ -464,17 +702,24 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     SSIMContext *s = ctx->priv;
 
-    if (s->nb_frames > 0) {
+    for (int k = 0; s->stats && k < s->nb_mains; k++) {
+        SSIMStats *st = &s->stats[k];
         char buf[256];
         int i;
+
+        if (!st->nb_frames)
+            continue;
+
         buf[0] = 0;
+        if (s->nb_mains > 1)
+            av_strlcatf(buf, sizeof(buf), " input:%d", k);
         for (i = 0; i < s->nb_components; i++) {
             int c = s->is_rgb ? s->rgba_map[i] : i;
-            av_strlcatf(buf, sizeof(buf), " %c:%f (%f)", s->comps[i], s->ssim[c] / s->nb_frames,
-                        ssim_db(s->ssim[c], s->nb_frames));
+            av_strlcatf(buf, sizeof(buf), " %c:%f (%f)", s->comps[i], st->ssim[c] / st->nb_frames,
+                        ssim_db(st->ssim[c], st->nb_frames));
         }
         av_log(ctx, AV_LOG_INFO, "SSIM%s All:%f (%f)\n", buf,
-               s->ssim_total / s->nb_frames, ssim_db(s->ssim_total, s->nb_frames));
+               st->ssim_total / st->nb_frames, ssim_db(st->ssim_total, st->nb_frames));
     }
 
     ff_framesync_uninit(&s->fs);
@@ -482,20 +727,15 @@ static av_cold void uninit(AVFilterContext *ctx)
     if (s->stats_file && s->stats_file != stdout)
         fclose(s->stats_file);
 
+    for (int i = 0; s->temp && i < s->nb_temp; i++)
+        av_freep(&s->temp[i]);
     av_freep(&s->temp);
-}
+    av_freep(&s->score);
+    av_freep(&s->stats);
 
-static const AVFilterPad ssim_inputs[] = {
-    {
-        .name         = "main",
-        .type         = AVMEDIA_TYPE_VIDEO,
-    },{
-        .name         = "reference",
-        .type         = AVMEDIA_TYPE_VIDEO,
-        .config_props = config_input_ref,
-    },
-    { NULL }
-};
+    for (int i = 0; i < ctx->nb_inputs; i++)
+        av_freep(&ctx->input_pads[i].name);
+}
 
 static const AVFilterPad ssim_outputs[] = {
     {
@@ -516,6 +756,6 @@ AVFilter ff_vf_ssim = {
     .activate      = activate,
     .priv_size     = sizeof(SSIMContext),
     .priv_class    = &ssim_class,
-    .inputs        = ssim_inputs,
     .outputs       = ssim_outputs,
+    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -305,7 +305,8 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *inpicref)
+static int process_frame(AVFilterLink *inlink, AVFrame *inpicref,
+                         AVFrame **out)
 {
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *outpicref = ff_get_video_buffer(outlink, outlink->w, outlink->h);
@@ -322,15 +323,16 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *inpicref)
                inlink->w, inlink->h);
 
     av_frame_free(&inpicref);
-    return ff_filter_frame(outlink, outpicref);
+    *out = outpicref;
+    return 0;
 }
 
 static const AVFilterPad super2xsai_inputs[] = {
     {
-        .name         = "default",
-        .type         = AVMEDIA_TYPE_VIDEO,
-        .config_props = config_input,
-        .filter_frame = filter_frame,
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .config_props  = config_input,
+        .process_frame = process_frame,
     },
     { NULL }
 };
@@ -0,0 +1,1270 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Native VMAF (Video Multi-Method Assessment Fusion) filter.
+ *
+ * Computes the elementary VMAF features (VIF at four scales, ADM and
+ * motion) on the luma plane without depending on libvmaf, and optionally
+ * fuses them into a VMAF score using a libvmaf JSON model (linear feature
+ * rescaling followed by a libsvm nu-SVR with RBF kernel).
+ */
+
+#include <float.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/bprint.h"
+#include "libavutil/file.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "avfilter.h"
+#include "filters.h"
+#include "formats.h"
+#include "framesync.h"
+#include "internal.h"
+#include "vmaf.h"
+#include "vmaf_motion.h"
+#include "video.h"
+
+#define VIF_SCALES       4
+#define ADM_SCALES       4
+#define VIF_MAX_RADIUS   8
+#define VIF_SIGMA_NSQ    2.0f
+#define VIF_GAIN_LIMIT   100.0f
+#define ADM_BORDER       0.1
+#define ADM_GAIN_LIMIT   100.0f
+#define MAX_FEATURES     16
+
+enum VMAFFeature {
+    FEATURE_ADM2,
+    FEATURE_MOTION,
+    FEATURE_MOTION2,
+    FEATURE_VIF_SCALE0,
+    FEATURE_VIF_SCALE1,
+    FEATURE_VIF_SCALE2,
+    FEATURE_VIF_SCALE3,
+    NB_FEATURES
+};
+
+static const char *const feature_names[NB_FEATURES] = {
+    [FEATURE_ADM2]       = "adm2",
+    [FEATURE_MOTION]     = "motion",
+    [FEATURE_MOTION2]    = "motion2",
+    [FEATURE_VIF_SCALE0] = "vif_scale0",
+    [FEATURE_VIF_SCALE1] = "vif_scale1",
+    [FEATURE_VIF_SCALE2] = "vif_scale2",
+    [FEATURE_VIF_SCALE3] = "vif_scale3",
+};
+
+typedef struct VMAFModel {
+    int nb_features;
+    int feature[MAX_FEATURES];
+    double slope[MAX_FEATURES + 1];
+    double intercept[MAX_FEATURES + 1];
+    double score_min, score_max;
+    double gamma, rho;
+    int nb_sv;
+    double *sv_coef;
+    double *sv;
+} VMAFModel;
+
+typedef struct VMAFContext {
+    const AVClass *class;
+    FFFrameSync fs;
+    char *model_path;
+    char *log_path;
+
+    FILE *log_file;
+    int depth;
+    int width, height;
+    int nb_threads;
+    int pw;
+
+    VMAFModel model;
+    int has_model;
+    VMAFMotionData motion;
+    VMAFDSPContext dsp;
+
+    float *ref, *dis;
+    float *vif_ref[2], *vif_dis[2];
+    float vif_filter[VIF_SCALES][2 * VIF_MAX_RADIUS + 1];
+    int vif_radius[VIF_SCALES];
+    double *vif_rows;
+
+    float *adm_band[2][2][4];
+    float *adm_r[3], *adm_csf_f[3];
+    float adm_rfactor[ADM_SCALES][3];
+    double *adm_rows;
+
+    float **temp;
+
+    double features[NB_FEATURES];
+    double pending[NB_FEATURES];
+    AVFrame *pending_frame;
+    uint64_t nb_frames;
+    double feature_sum[NB_FEATURES];
+    double score_sum;
+} VMAFContext;
+
+#define OFFSET(x) offsetof(VMAFContext, x)
+#define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
+
+static const AVOption vmaf_options[] = {
+    {"model_path", "Set the libvmaf JSON model used to compute the VMAF score", OFFSET(model_path), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    {"log_path",   "Set the file where to store per-frame scores",              OFFSET(log_path),   AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    { NULL }
+};
+
+FRAMESYNC_DEFINE_CLASS(vmaf, VMAFContext, fs);
+
+/* Daubechies 2 analysis filters used by ADM. */
+static const float dwt_lo[4] = {
+    -0.12940952255092145, 0.22414386804185735, 0.836516303737469,  0.48296291314469025,
+};
+
+static const float dwt_hi[4] = {
+    -0.48296291314469025, 0.836516303737469,  -0.22414386804185735, -0.12940952255092145,
+};
+
+/* Watson et al. luma quantization model for the 9/7 wavelet. */
+static const double dwt_basis_amplitude[ADM_SCALES][4] = {
+    { 0.62171,  0.67234, 0.72709, 0.67234 },
+    { 0.34537,  0.41317, 0.49428, 0.41317 },
+    { 0.18004,  0.22727, 0.28688, 0.22727 },
+    { 0.091401, 0.11792, 0.15214, 0.11792 },
+};
+
+static double dwt_quant_step(int lambda, int theta)
+{
+    static const double g[4] = { 1.501, 1.0, 0.534, 1.0 };
+    const double a = 0.495, k = 0.466, f0 = 0.401;
+    const double r = 3.0 * 1080 * M_PI / 180.0;
+    const double t = log10(pow(2.0, lambda + 1) * f0 * g[theta] / r);
+
+    return 2.0 * a * pow(10.0, k * t * t) / dwt_basis_amplitude[lambda][theta];
+}
+
+static av_always_inline int mirror(int i, int n)
+{
+    if (i < 0)
+        return -i;
+    if (i >= n)
+        return 2 * n - i - 1;
+    return i;
+}
+
+/* Like mirror(), but without repeating the edge sample, as libvmaf does
+ * for the contrast masking neighbourhood. */
+static av_always_inline int reflect(int i, int n)
+{
+    if (i < 0)
+        return -i;
+    if (i >= n)
+        return 2 * n - i - 2;
+    return i;
+}
+
+static void vif_vfilter_c(float *dst, ptrdiff_t stride, const float *a,
+                          const float *b, const float *c, int w)
+{
+    float *mu1 = dst, *mu2 = dst + stride;
+    float *xx = mu2 + stride, *yy = xx + stride, *xy = yy + stride;
+
+    for (int j = 0; j < w; j++) {
+        const float ca = c[0] * a[j], cb = c[0] * b[j];
+
+        mu1[j] += ca;
+        mu2[j] += cb;
+        xx [j] += ca * a[j];
+        yy [j] += cb * b[j];
+        xy [j] += ca * b[j];
+    }
+}
+
+static void vif_hfilter_c(float *dst, const float *src, const float *filter,
+                          int len, int w)
+{
+    for (int j = 0; j < w; j++) {
+        float sum = 0.0f;
+
+        for (int k = 0; k < len; k++)
+            sum += filter[k] * src[j + k];
+        dst[j] = sum;
+    }
+}
+
+static void adm_dwt_v_c(float *lo, float *hi, const float *l0, const float *l1,
+                        const float *l2, const float *l3, int w)
+{
+    for (int j = 0; j < w; j++) {
+        lo[j] = dwt_lo[0] * l0[j] + dwt_lo[1] * l1[j] +
+                dwt_lo[2] * l2[j] + dwt_lo[3] * l3[j];
+        hi[j] = dwt_hi[0] * l0[j] + dwt_hi[1] * l1[j] +
+                dwt_hi[2] * l2[j] + dwt_hi[3] * l3[j];
+    }
+}
+
+av_cold void ff_vmaf_init_dsp(VMAFDSPContext *dsp)
+{
+    dsp->vif_vfilter = vif_vfilter_c;
+    dsp->vif_hfilter = vif_hfilter_c;
+    dsp->adm_dwt_v   = adm_dwt_v_c;
+
+    if (ARCH_X86)
+        ff_vmaf_init_dsp_x86(dsp);
+}
+
+typedef struct ThreadData {
+    const float *ref, *dis;
+    float *dst_ref, *dst_dis;
+    float *const *band_ref, *const *band_dis;
+    int w, h;
+    int scale;
+    int top, bottom, left, right;
+} ThreadData;
+
+static void slice_range(int n, int jobnr, int nb_jobs, int *start, int *end)
+{
+    *start = (n *  jobnr     ) / nb_jobs;
+    *end   = (n * (jobnr + 1)) / nb_jobs;
+}
+
+static int convert_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    VMAFContext *s = ctx->priv;
+    AVFrame **in = arg;
+    const int w = s->width;
+    int start, end;
+
+    slice_range(s->height, jobnr, nb_jobs, &start, &end);
+
+    for (int k = 0; k < 2; k++) {
+        const uint8_t *src = in[k]->data[0] + start * in[k]->linesize[0];
+        float *dst = (k ? s->dis : s->ref) + start * w;
+
+        for (int y = start; y < end; y++) {
+            if (s->depth == 8) {
+                for (int x = 0; x < w; x++)
+                    dst[x] = src[x] - 128.0f;
+            } else {
+                const uint16_t *src16 = (const uint16_t *)src;
+                for (int x = 0; x < w; x++)
+                    dst[x] = src16[x] * 0.25f - 128.0f;
+            }
+            src += in[k]->linesize[0];
+            dst += w;
+        }
+    }
+
+    return 0;
+}
+
+static void vif_pad_row(float *row, int w, int r)
+{
+    for (int m = 1; m <= r; m++) {
+        row[r - m]         = row[r + m];
+        row[r + w - 1 + m] = row[r + w - m];
+    }
+}
+
+static av_always_inline float filter_row(const float *row, const float *f, int len)
+{
+    float sum = 0.0f;
+
+    for (int k = 0; k < len; k++)
+        sum += f[k] * row[k];
+    return sum;
+}
+
+/* Low-pass filter the previous scale and keep every second sample. */
+static int vif_decimate_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    VMAFContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int r = s->vif_radius[td->scale];
+    const int len = 2 * r + 1;
+    const float *f = s->vif_filter[td->scale];
+    const int w = td->w, h = td->h;
+    const int dw = w / 2;
+    float *tmp = s->temp[jobnr];
+    int start, end;
+
+    slice_range(h / 2, jobnr, nb_jobs, &start, &end);
+
+    for (int k = 0; k < 2; k++) {
+        const float *src = k ? td->dis : td->ref;
+        float *dst = k ? td->dst_dis : td->dst_ref;
+
+        for (int i = start; i < end; i++) {
+            float *row = tmp + r;
+
+            memset(row, 0, w * sizeof(*row));
+            for (int t = 0; t < len; t++) {
+                const float *line = src + mirror(2 * i - r + t, h) * w;
+                const float c = f[t];
+                for (int j = 0; j < w; j++)
+                    row[j] += c * line[j];
+            }
+            vif_pad_row(tmp, w, r);
+            for (int j = 0; j < dw; j++)
+                dst[i * dw + j] = filter_row(tmp + 2 * j, f, len);
+        }
+    }
+
+    return 0;
+}
+
+static int vif_statistic_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    VMAFContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int r = s->vif_radius[td->scale];
+    const int len = 2 * r + 1;
+    const int pw = s->pw;
+    const float *f = s->vif_filter[td->scale];
+    const float sigma_max_inv = 4.0f / (255.0f * 255.0f);
+    const float eps = 1.0e-10f;
+    const int w = td->w, h = td->h;
+    const int aw = FFALIGN(w, 8);
+    float *mu1 = s->temp[jobnr];
+    float *mu2 = mu1 + pw;
+    float *xx  = mu2 + pw;
+    float *yy  = xx  + pw;
+    float *xy  = yy  + pw;
+    float *fm1 = xy  + pw;
+    float *fm2 = fm1 + aw;
+    float *fxx = fm2 + aw;
+    float *fyy = fxx + aw;
+    float *fxy = fyy + aw;
+    int start, end;
+
+    slice_range(h, jobnr, nb_jobs, &start, &end);
+
+    for (int i = start; i < end; i++) {
+        double num = 0.0, den = 0.0;
+
+        memset(mu1, 0, 5 * pw * sizeof(*mu1));
+        for (int t = 0; t < len; t++) {
+            const int y = mirror(i - r + t, h);
+            s->dsp.vif_vfilter(mu1 + r, pw, td->ref + y * w, td->dis + y * w,
+                               f + t, aw);
+        }
+        vif_pad_row(mu1, w, r);
+        vif_pad_row(mu2, w, r);
+        vif_pad_row(xx,  w, r);
+        vif_pad_row(yy,  w, r);
+        vif_pad_row(xy,  w, r);
+        s->dsp.vif_hfilter(fm1, mu1, f, len, aw);
+        s->dsp.vif_hfilter(fm2, mu2, f, len, aw);
+        s->dsp.vif_hfilter(fxx, xx,  f, len, aw);
+        s->dsp.vif_hfilter(fyy, yy,  f, len, aw);
+        s->dsp.vif_hfilter(fxy, xy,  f, len, aw);
+
+        for (int j = 0; j < w; j++) {
+            const float m1 = fm1[j];
+            const float m2 = fm2[j];
+            float sigma1_sq = fxx[j] - m1 * m1;
+            float sigma2_sq = fyy[j] - m2 * m2;
+            const float sigma12 = fxy[j] - m1 * m2;
+            float g, sv_sq;
+
+            sigma1_sq = FFMAX(sigma1_sq, 0.0f);
+            sigma2_sq = FFMAX(sigma2_sq, 0.0f);
+
+            if (sigma1_sq < VIF_SIGMA_NSQ) {
+                num += 1.0f - sigma2_sq * sigma_max_inv;
+                den += 1.0f;
+                continue;
+            }
+
+            g     = sigma12 / (sigma1_sq + eps);
+            sv_sq = sigma2_sq - g * sigma12;
+            if (sigma2_sq < eps) {
+                g     = 0.0f;
+                sv_sq = 0.0f;
+            }
+            if (g < 0.0f) {
+                sv_sq = sigma2_sq;
+                g     = 0.0f;
+            }
+            sv_sq = FFMAX(sv_sq, eps);
+            g     = FFMIN(g, VIF_GAIN_LIMIT);
+
+            num += log2f(1.0f + g * g * sigma1_sq / (sv_sq + VIF_SIGMA_NSQ));
+            den += log2f(1.0f + sigma1_sq / VIF_SIGMA_NSQ);
+        }
+        s->vif_rows[2 * i    ] = num;
+        s->vif_rows[2 * i + 1] = den;
+    }
+
+    return 0;
+}
+
+static void compute_vif(AVFilterContext *ctx)
+{
+    VMAFContext *s = ctx->priv;
+    ThreadData td = { .ref = s->ref, .dis = s->dis, .w = s->width, .h = s->height };
+
+    for (int scale = 0; scale < VIF_SCALES; scale++) {
+        double num = 0.0, den = 0.0;
+
+        td.scale = scale;
+        if (scale > 0) {
+            td.dst_ref = s->vif_ref[scale & 1];
+            td.dst_dis = s->vif_dis[scale & 1];
+            ctx->internal->execute(ctx, vif_decimate_slice, &td, NULL,
+                                   FFMIN(td.h / 2, s->nb_threads));
+            td.ref = td.dst_ref;
+            td.dis = td.dst_dis;
+            td.w  /= 2;
+            td.h  /= 2;
+        }
+        ctx->internal->execute(ctx, vif_statistic_slice, &td, NULL,
+                               FFMIN(td.h, s->nb_threads));
+
+        for (int i = 0; i < td.h; i++) {
+            num += s->vif_rows[2 * i    ];
+            den += s->vif_rows[2 * i + 1];
+        }
+        s->features[FEATURE_VIF_SCALE0 + scale] = den > 0.0 ? num / den : 1.0;
+    }
+}
+
+static int adm_dwt_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    VMAFContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int w = td->w, h = td->h;
+    const int w2 = (w + 1) / 2, h2 = (h + 1) / 2;
+    float *lo = s->temp[jobnr];
+    float *hi = lo + FFALIGN(w, 8);
+    int start, end;
+
+    slice_range(h2, jobnr, nb_jobs, &start, &end);
+
+    for (int k = 0; k < 2; k++) {
+        const float *src = k ? td->dis : td->ref;
+        float *const *band = k ? td->band_dis : td->band_ref;
+
+        for (int i = start; i < end; i++) {
+            const float *l0 = src + mirror(2 * i - 1, h) * w;
+            const float *l1 = src + mirror(2 * i    , h) * w;
+            const float *l2 = src + mirror(2 * i + 1, h) * w;
+            const float *l3 = src + mirror(2 * i + 2, h) * w;
+            float *a = band[0] + i * w2;
+            float *v = band[1] + i * w2;
+            float *hb = band[2] + i * w2;
+            float *d = band[3] + i * w2;
+
+            s->dsp.adm_dwt_v(lo, hi, l0, l1, l2, l3, FFALIGN(w, 8));
+            for (int j = 0; j < w2; j++) {
+                const int j0 = mirror(2 * j - 1, w), j1 = mirror(2 * j,     w);
+                const int j2 = mirror(2 * j + 1, w), j3 = mirror(2 * j + 2, w);
+
+                a[j]  = dwt_lo[0] * lo[j0] + dwt_lo[1] * lo[j1] + dwt_lo[2] * lo[j2] + dwt_lo[3] * lo[j3];
+                v[j]  = dwt_hi[0] * lo[j0] + dwt_hi[1] * lo[j1] + dwt_hi[2] * lo[j2] + dwt_hi[3] * lo[j3];
+                hb[j] = dwt_lo[0] * hi[j0] + dwt_lo[1] * hi[j1] + dwt_lo[2] * hi[j2] + dwt_lo[3] * hi[j3];
+                d[j]  = dwt_hi[0] * hi[j0] + dwt_hi[1] * hi[j1] + dwt_hi[2] * hi[j2] + dwt_hi[3] * hi[j3];
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* Split the distorted detail bands into restored detail and additive
+ * impairment, and derive the masking map from the latter. */
+static int adm_decouple_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    VMAFContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const float cos_1deg_sq = cos(M_PI / 180.0) * cos(M_PI / 180.0);
+    const float eps = 1.0e-30f;
+    const float *rf = s->adm_rfactor[td->scale];
+    const int w = td->w;
+    int start, end;
+
+    slice_range(td->h, jobnr, nb_jobs, &start, &end);
+
+    for (int i = start * w; i < end * w; i++) {
+        const float oh = td->band_ref[2][i], ov = td->band_ref[1][i], od = td->band_ref[3][i];
+        const float th = td->band_dis[2][i], tv = td->band_dis[1][i], tg = td->band_dis[3][i];
+        const float kh = av_clipf(th  / (oh + eps), 0.0f, 1.0f);
+        const float kv = av_clipf(tv  / (ov + eps), 0.0f, 1.0f);
+        const float kd = av_clipf(tg / (od + eps), 0.0f, 1.0f);
+        const float ot_dp    = oh * th + ov * tv;
+        const float o_mag_sq = oh * oh + ov * ov;
+        const float t_mag_sq = th * th + tv * tv;
+        const int angle_flag = ot_dp >= 0.0f &&
+                               ot_dp * ot_dp >= cos_1deg_sq * o_mag_sq * t_mag_sq;
+        float rh = kh * oh, rv = kv * ov, rd = kd * od;
+
+        /* Enhancement along the reference orientation counts as restored
+         * detail, up to the gain limit. */
+        if (angle_flag) {
+            if (rh > 0.0f) rh = FFMIN(rh * ADM_GAIN_LIMIT, th);
+            if (rh < 0.0f) rh = FFMAX(rh * ADM_GAIN_LIMIT, th);
+            if (rv > 0.0f) rv = FFMIN(rv * ADM_GAIN_LIMIT, tv);
+            if (rv < 0.0f) rv = FFMAX(rv * ADM_GAIN_LIMIT, tv);
+            if (rd > 0.0f) rd = FFMIN(rd * ADM_GAIN_LIMIT, tg);
+            if (rd < 0.0f) rd = FFMAX(rd * ADM_GAIN_LIMIT, tg);
+        }
+
+        s->adm_r[0][i] = rh;
+        s->adm_r[1][i] = rv;
+        s->adm_r[2][i] = rd;
+        s->adm_csf_f[0][i] = fabsf((th  - rh) * rf[0]) * (1.0f / 30.0f);
+        s->adm_csf_f[1][i] = fabsf((tv  - rv) * rf[1]) * (1.0f / 30.0f);
+        s->adm_csf_f[2][i] = fabsf((tg - rd) * rf[2]) * (1.0f / 30.0f);
+    }
+
+    return 0;
+}
+
+/* Contrast masking of the restored detail and the CSF-weighted reference
+ * energy, both cube-pooled per row over the image minus a border. */
+static int adm_masking_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    VMAFContext *s = ctx->priv;
+    ThreadData *td = arg;
+    static const int band_idx[3] = { 2, 1, 3 };
+    const float *rf = s->adm_rfactor[td->scale];
+    const int w = td->w, h = td->h;
+    int start, end;
+
+    slice_range(td->bottom - td->top, jobnr, nb_jobs, &start, &end);
+
+    for (int i = td->top + start; i < td->top + end; i++) {
+        const int rows[3] = { reflect(i - 1, h) * w, i * w, reflect(i + 1, h) * w };
+        double num[3] = { 0 }, den[3] = { 0 };
+
+        for (int j = td->left; j < td->right; j++) {
+            const int cols[3] = { reflect(j - 1, w), j, reflect(j + 1, w) };
+            float thr = 0.0f;
+
+            for (int b = 0; b < 3; b++) {
+                const float *m = s->adm_csf_f[b];
+                for (int y = 0; y < 3; y++)
+                    for (int x = 0; x < 3; x++)
+                        thr += m[rows[y] + cols[x]];
+                thr += m[i * w + j];
+            }
+
+            for (int b = 0; b < 3; b++) {
+                const float x = fabsf(s->adm_r[b][i * w + j] * rf[b]) - thr;
+                const float o = fabsf(td->band_ref[band_idx[b]][i * w + j] * rf[b]);
+
+                if (x > 0.0f)
+                    num[b] += x * x * x;
+                den[b] += o * o * o;
+            }
+        }
+        for (int b = 0; b < 3; b++) {
+            s->adm_rows[6 * i + b    ] = num[b];
+            s->adm_rows[6 * i + b + 3] = den[b];
+        }
+    }
+
+    return 0;
+}
+
+static void compute_adm(AVFilterContext *ctx)
+{
+    VMAFContext *s = ctx->priv;
+    const double limit = 1.0e-10 * s->width * s->height / (1920.0 * 1080.0);
+    ThreadData td = { .ref = s->ref, .dis = s->dis, .w = s->width, .h = s->height };
+    double num = 0.0, den = 0.0;
+
+    for (int scale = 0; scale < ADM_SCALES; scale++) {
+        float *const *band_ref = s->adm_band[scale & 1][0];
+        float *const *band_dis = s->adm_band[scale & 1][1];
+        double area, sum[6] = { 0 };
+
+        td.scale    = scale;
+        td.band_ref = band_ref;
+        td.band_dis = band_dis;
+        ctx->internal->execute(ctx, adm_dwt_slice, &td, NULL,
+                               FFMIN((td.h + 1) / 2, s->nb_threads));
+
+        td.w = (td.w + 1) / 2;
+        td.h = (td.h + 1) / 2;
+        td.left   = td.w * ADM_BORDER - 0.5;
+        td.top    = td.h * ADM_BORDER - 0.5;
+        td.left   = FFMAX(td.left, 0);
+        td.top    = FFMAX(td.top,  0);
+        td.right  = td.w - td.left;
+        td.bottom = td.h - td.top;
+
+        ctx->internal->execute(ctx, adm_decouple_slice, &td, NULL,
+                               FFMIN(td.h, s->nb_threads));
+        ctx->internal->execute(ctx, adm_masking_slice, &td, NULL,
+                               FFMIN(td.bottom - td.top, s->nb_threads));
+
+        for (int i = td.top; i < td.bottom; i++)
+            for (int k = 0; k < 6; k++)
+                sum[k] += s->adm_rows[6 * i + k];
+
+        area = cbrt((td.bottom - td.top) * (td.right - td.left) / 32.0);
+        for (int b = 0; b < 3; b++) {
+            num += cbrt(sum[b    ]) + area;
+            den += cbrt(sum[b + 3]) + area;
+        }
+
+        td.ref = band_ref[0];
+        td.dis = band_dis[0];
+    }
+
+    num = num < limit ? 0.0 : num;
+    den = den < limit ? 0.0 : den;
+    s->features[FEATURE_ADM2] = den > 0.0 ? num / den : 1.0;
+}
+
+static double predict_score(const VMAFModel *m, const double *features)
+{
+    double x[MAX_FEATURES];
+    double sum = 0.0, score;
+
+    for (int f = 0; f < m->nb_features; f++)
+        x[f] = m->slope[f + 1] * features[m->feature[f]] + m->intercept[f + 1];
+
+    for (int i = 0; i < m->nb_sv; i++) {
+        const double *sv = m->sv + i * m->nb_features;
+        double d2 = 0.0;
+
+        for (int f = 0; f < m->nb_features; f++)
+            d2 += (x[f] - sv[f]) * (x[f] - sv[f]);
+        sum += m->sv_coef[i] * exp(-m->gamma * d2);
+    }
+
+    score = (sum - m->rho - m->intercept[0]) / m->slope[0];
+    return av_clipd(score, m->score_min, m->score_max);
+}
+
+static double log_frame(AVFilterContext *ctx, const double *features, uint64_t n)
+{
+    VMAFContext *s = ctx->priv;
+    double score = 0.0;
+
+    for (int f = 0; f < NB_FEATURES; f++)
+        s->feature_sum[f] += features[f];
+
+    if (s->has_model) {
+        score = predict_score(&s->model, features);
+        s->score_sum += score;
+    }
+
+    if (s->log_file) {
+        fprintf(s->log_file, "n:%"PRIu64, n);
+        for (int f = 0; f < NB_FEATURES; f++)
+            fprintf(s->log_file, " %s:%f", feature_names[f], features[f]);
+        if (s->has_model)
+            fprintf(s->log_file, " vmaf:%f", score);
+        fprintf(s->log_file, "\n");
+    }
+
+    return score;
+}
+
+static void set_meta(AVDictionary **metadata, const char *key, double d)
+{
+    char value[128];
+    snprintf(value, sizeof(value), "%f", d);
+    av_dict_set(metadata, key, value, 0);
+}
+
+/* motion2 looks one frame ahead, so a frame is held back until the next
+ * one has been analysed, and only then gets its motion2 and score. */
+static int output_pending(AVFilterContext *ctx, double next_motion)
+{
+    VMAFContext *s = ctx->priv;
+    AVFrame *frame = s->pending_frame;
+    double score;
+
+    s->pending_frame = NULL;
+    s->pending[FEATURE_MOTION2] = FFMIN(s->pending[FEATURE_MOTION], next_motion);
+    score = log_frame(ctx, s->pending, s->nb_frames - 1);
+
+    set_meta(&frame->metadata, "lavfi.vmaf.motion2", s->pending[FEATURE_MOTION2]);
+    if (s->has_model)
+        set_meta(&frame->metadata, "lavfi.vmaf.score", score);
+
+    return ff_filter_frame(ctx->outputs[0], frame);
+}
+
+/* the last frame has no next one, its motion2 is its own motion */
+static int flush_pending(FFFrameSync *fs)
+{
+    AVFilterContext *ctx = fs->parent;
+    VMAFContext *s = ctx->priv;
+
+    if (!s->pending_frame)
+        return 0;
+    return output_pending(ctx, s->pending[FEATURE_MOTION]);
+}
+
+static int do_vmaf(FFFrameSync *fs)
+{
+    AVFilterContext *ctx = fs->parent;
+    VMAFContext *s = ctx->priv;
+    AVFrame *master, *ref, *in[2];
+    char key[64];
+    int ret;
+
+    ret = ff_framesync_dualinput_get(fs, &master, &ref);
+    if (ret < 0)
+        return ret;
+    if (ctx->is_disabled || !ref) {
+        if (s->pending_frame) {
+            ret = output_pending(ctx, s->pending[FEATURE_MOTION]);
+            if (ret < 0) {
+                av_frame_free(&master);
+                return ret;
+            }
+        }
+        return ff_filter_frame(ctx->outputs[0], master);
+    }
+
+    in[0] = ref;
+    in[1] = master;
+    ctx->internal->execute(ctx, convert_slice, in, NULL,
+                           FFMIN(s->height, s->nb_threads));
+    compute_vif(ctx);
+    compute_adm(ctx);
+    s->features[FEATURE_MOTION] = ff_vmafmotion_process(&s->motion, ref);
+
+    for (int f = 0; f < NB_FEATURES; f++) {
+        if (f == FEATURE_MOTION2)
+            continue;
+        snprintf(key, sizeof(key), "lavfi.vmaf.%s", feature_names[f]);
+        set_meta(&master->metadata, key, s->features[f]);
+    }
+
+    if (s->pending_frame) {
+        ret = output_pending(ctx, s->features[FEATURE_MOTION]);
+        if (ret < 0) {
+            av_frame_free(&master);
+            return ret;
+        }
+    } else {
+        /* nothing went out, so nothing else will wake us up */
+        ff_filter_set_ready(ctx, 100);
+    }
+    memcpy(s->pending, s->features, sizeof(s->pending));
+    s->pending_frame = master;
+    s->nb_frames++;
+
+    return 0;
+}
+
+static const char *json_skip_string(const char *p)
+{
+    for (p++; *p && *p != '"'; p++)
+        if (*p == '\\' && p[1])
+            p++;
+    return *p ? p + 1 : NULL;
+}
+
+static const char *json_find_key(const char *p, const char *key)
+{
+    const size_t len = strlen(key);
+
+    while ((p = strchr(p, '"'))) {
+        const char *next = json_skip_string(p);
+
+        if (!next)
+            break;
+        if (next - p == len + 2 && !strncmp(p + 1, key, len)) {
+            next += strspn(next, " \t\r\n");
+            if (*next == ':') {
+                next++;
+                return next + strspn(next, " \t\r\n");
+            }
+        }
+        p = next;
+    }
+    return NULL;
+}
+
+static char *json_parse_string(const char **pp)
+{
+    const char *p = *pp;
+    AVBPrint bp;
+    char *str;
+
+    if (*p != '"')
+        return NULL;
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    for (p++; *p && *p != '"'; p++) {
+        if (*p == '\\' && p[1]) {
+            p++;
+            switch (*p) {
+            case 'n': av_bprint_chars(&bp, '\n', 1); break;
+            case 't': av_bprint_chars(&bp, '\t', 1); break;
+            case 'r': av_bprint_chars(&bp, '\r', 1); break;
+            default:  av_bprint_chars(&bp, *p,   1); break;
+            }
+        } else {
+            av_bprint_chars(&bp, *p, 1);
+        }
+    }
+    if (!*p || av_bprint_finalize(&bp, &str) < 0)
+        return NULL;
+    *pp = p + 1;
+    return str;
+}
+
+static int json_parse_numbers(const char *p, double *dst, int max)
+{
+    int n = 0;
+
+    if (!p || *p != '[')
+        return AVERROR_INVALIDDATA;
+    for (p++;;) {
+        char *end;
+
+        p += strspn(p, " \t\r\n");
+        if (*p == ']')
+            return n;
+        if (n >= max)
+            return AVERROR_INVALIDDATA;
+        dst[n++] = strtod(p, &end);
+        if (end == p)
+            return AVERROR_INVALIDDATA;
+        p = end + strspn(end, " \t\r\n");
+        if (*p == ',')
+            p++;
+    }
+}
+
+static int feature_from_name(const char *name)
+{
+    static const char prefix[] = "VMAF_feature_";
+
+    if (av_strstart(name, prefix, &name)) {
+        for (int f = 0; f < NB_FEATURES; f++) {
+            const char *suffix;
+            if (av_strstart(name, feature_names[f], &suffix) &&
+                !strcmp(suffix, "_score"))
+                return f;
+        }
+    }
+    return AVERROR(EINVAL);
+}
+
+static int parse_svm(AVFilterContext *ctx, VMAFModel *m, const char *text)
+{
+    const char *p = text;
+    int sv = -1, nb_sv = 0;
+
+    m->gamma = m->rho = NAN;
+    while (*p) {
+        const char *eol = p + strcspn(p, "\n");
+        char *end;
+
+        if (sv >= 0) {
+            if (sv >= nb_sv)
+                break;
+            m->sv_coef[sv] = strtod(p, &end);
+            for (p = end; p < eol;) {
+                long idx = strtol(p, &end, 10);
+                if (end == p || *end != ':')
+                    break;
+                if (idx < 1 || idx > m->nb_features)
+                    return AVERROR_INVALIDDATA;
+                p = end + 1;
+                m->sv[sv * m->nb_features + idx - 1] = strtod(p, &end);
+                p = end;
+            }
+            sv++;
+        } else if (av_strstart(p, "svm_type ", NULL)) {
+            if (strncmp(p + 9, "nu_svr", 6) && strncmp(p + 9, "epsilon_svr", 11)) {
+                av_log(ctx, AV_LOG_ERROR, "Only SVR models are supported.\n");
+                return AVERROR_PATCHWELCOME;
+            }
+        } else if (av_strstart(p, "kernel_type ", NULL)) {
+            if (strncmp(p + 12, "rbf", 3)) {
+                av_log(ctx, AV_LOG_ERROR, "Only the RBF kernel is supported.\n");
+                return AVERROR_PATCHWELCOME;
+            }
+        } else if (av_strstart(p, "gamma ", NULL)) {
+            m->gamma = strtod(p + 6, NULL);
+        } else if (av_strstart(p, "rho ", NULL)) {
+            m->rho = strtod(p + 4, NULL);
+        } else if (av_strstart(p, "total_sv ", NULL)) {
+            nb_sv = strtol(p + 9, NULL, 10);
+        } else if (!strncmp(p, "SV", 2) && eol - p <= 3) {
+            if (nb_sv <= 0 || nb_sv > INT_MAX / MAX_FEATURES)
+                return AVERROR_INVALIDDATA;
+            m->sv_coef = av_calloc(nb_sv, sizeof(*m->sv_coef));
+            m->sv      = av_calloc(nb_sv, m->nb_features * sizeof(*m->sv));
+            if (!m->sv_coef || !m->sv)
+                return AVERROR(ENOMEM);
+            sv = 0;
+        }
+        p = *eol ? eol + 1 : eol;
+    }
+
+    if (sv != nb_sv || isnan(m->gamma) || isnan(m->rho)) {
+        av_log(ctx, AV_LOG_ERROR, "Incomplete SVM model.\n");
+        return AVERROR_INVALIDDATA;
+    }
+    m->nb_sv = nb_sv;
+    return 0;
+}
+
+static int parse_model(AVFilterContext *ctx, VMAFModel *m, char *json)
+{
+    const char *p, *dict;
+    char *str;
+    double clip[2];
+    int ret, n;
+
+    dict = json_find_key(json, "model_dict");
+    if (!dict || *dict != '{') {
+        av_log(ctx, AV_LOG_ERROR, "No model_dict found in the model.\n");
+        return AVERROR_INVALIDDATA;
+    }
+
+    p = json_find_key(dict, "feature_names");
+    if (!p || *p != '[')
+        return AVERROR_INVALIDDATA;
+    for (p++;;) {
+        p += strspn(p, " \t\r\n,");
+        if (*p == ']')
+            break;
+        if (m->nb_features >= MAX_FEATURES || !(str = json_parse_string(&p)))
+            return AVERROR_INVALIDDATA;
+        ret = feature_from_name(str);
+        if (ret < 0)
+            av_log(ctx, AV_LOG_ERROR, "Unsupported feature '%s'.\n", str);
+        av_free(str);
+        if (ret < 0)
+            return ret;
+        m->feature[m->nb_features++] = ret;
+    }
+
+    p = json_find_key(dict, "norm_type");
+    if (p && !strncmp(p, "\"none\"", 6)) {
+        for (int f = 0; f <= m->nb_features; f++) {
+            m->slope[f]     = 1.0;
+            m->intercept[f] = 0.0;
+        }
+    } else {
+        n = json_parse_numbers(json_find_key(dict, "slopes"), m->slope, MAX_FEATURES + 1);
+        if (n != m->nb_features + 1)
+            return AVERROR_INVALIDDATA;
+        n = json_parse_numbers(json_find_key(dict, "intercepts"), m->intercept, MAX_FEATURES + 1);
+        if (n != m->nb_features + 1 || m->slope[0] == 0.0)
+            return AVERROR_INVALIDDATA;
+    }
+
+    m->score_min = -DBL_MAX;
+    m->score_max =  DBL_MAX;
+    p = json_find_key(dict, "score_clip");
+    if (p && *p == '[') {
+        if (json_parse_numbers(p, clip, 2) != 2)
+            return AVERROR_INVALIDDATA;
+        m->score_min = clip[0];
+        m->score_max = clip[1];
+    }
+
+    p = json_find_key(dict, "model");
+    if (!p || !(str = json_parse_string(&p)))
+        return AVERROR_INVALIDDATA;
+    ret = parse_svm(ctx, m, str);
+    av_free(str);
+    return ret;
+}
+
+static int load_model(AVFilterContext *ctx, VMAFModel *m, const char *path)
+{
+    uint8_t *buf;
+    size_t size;
+    char *json;
+    int ret;
+
+    ret = av_file_map(path, &buf, &size, 0, ctx);
+    if (ret < 0) {
+        av_log(ctx, AV_LOG_ERROR, "Could not read model %s.\n", path);
+        return ret;
+    }
+    json = av_malloc(size + 1);
+    if (!json) {
+        av_file_unmap(buf, size);
+        return AVERROR(ENOMEM);
+    }
+    memcpy(json, buf, size);
+    json[size] = 0;
+    av_file_unmap(buf, size);
+
+    ret = parse_model(ctx, m, json);
+    av_free(json);
+    if (ret == AVERROR_INVALIDDATA)
+        av_log(ctx, AV_LOG_ERROR, "Invalid model %s.\n", path);
+    return ret;
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    VMAFContext *s = ctx->priv;
+    int ret;
+
+    if (s->model_path) {
+        ret = load_model(ctx, &s->model, s->model_path);
+        if (ret < 0)
+            return ret;
+        s->has_model = 1;
+    }
+
+    if (s->log_path) {
+        if (!strcmp(s->log_path, "-")) {
+            s->log_file = stdout;
+        } else {
+            s->log_file = fopen(s->log_path, "w");
+            if (!s->log_file) {
+                int err = AVERROR(errno);
+                char buf[128];
+                av_strerror(err, buf, sizeof(buf));
+                av_log(ctx, AV_LOG_ERROR, "Could not open log file %s: %s\n",
+                       s->log_path, buf);
+                return err;
+            }
+        }
+    }
+
+    s->fs.on_event = do_vmaf;
+    s->fs.on_eof   = flush_pending;
+    return 0;
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    static const enum AVPixelFormat pix_fmts[] = {
+        AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY10,
+        AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV444P,
+        AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_YUVJ422P, AV_PIX_FMT_YUVJ444P,
+        AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUV422P10, AV_PIX_FMT_YUV444P10,
+        AV_PIX_FMT_NONE
+    };
+
+    AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
+    if (!fmts_list)
+        return AVERROR(ENOMEM);
+    return ff_set_common_formats(ctx, fmts_list);
+}
+
+static int config_input_ref(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx  = inlink->dst;
+    VMAFContext *s = ctx->priv;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    const int w = inlink->w, h = inlink->h;
+    const int w2 = (w + 1) / 2, h2 = (h + 1) / 2;
+    int ret;
+
+    if (ctx->inputs[0]->w != w || ctx->inputs[0]->h != h) {
+        av_log(ctx, AV_LOG_ERROR, "Width and height of input videos must be same.\n");
+        return AVERROR(EINVAL);
+    }
+    if (ctx->inputs[0]->format != inlink->format) {
+        av_log(ctx, AV_LOG_ERROR, "Inputs must be of same pixel format.\n");
+        return AVERROR(EINVAL);
+    }
+    if (w < 32 || h < 32) {
+        av_log(ctx, AV_LOG_ERROR, "Inputs must be at least 32x32.\n");
+        return AVERROR(EINVAL);
+    }
+
+    s->depth  = desc->comp[0].depth;
+    s->width  = w;
+    s->height = h;
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->pw = FFALIGN(w, 8) + 2 * VIF_MAX_RADIUS;
+    ff_vmaf_init_dsp(&s->dsp);
+
+    for (int scale = 0; scale < VIF_SCALES; scale++) {
+        const int n = (1 << (VIF_SCALES - scale)) + 1;
+        const double sigma = n / 5.0;
+        double sum = 0.0, g[2 * VIF_MAX_RADIUS + 1];
+
+        s->vif_radius[scale] = n / 2;
+        for (int i = 0; i < n; i++) {
+            g[i] = exp(-(i - n / 2) * (i - n / 2) / (2.0 * sigma * sigma));
+            sum += g[i];
+        }
+        for (int i = 0; i < n; i++)
+            s->vif_filter[scale][i] = g[i] / sum;
+    }
+
+    for (int scale = 0; scale < ADM_SCALES; scale++) {
+        s->adm_rfactor[scale][0] = 1.0 / dwt_quant_step(scale, 1);
+        s->adm_rfactor[scale][1] = 1.0 / dwt_quant_step(scale, 1);
+        s->adm_rfactor[scale][2] = 1.0 / dwt_quant_step(scale, 2);
+    }
+
+    /* The DSP functions process whole multiples of 8 samples, so the
+     * planes they read rows from are padded. */
+    if (!(s->ref        = av_calloc(w * h + 8, sizeof(*s->ref))) ||
+        !(s->dis        = av_calloc(w * h + 8, sizeof(*s->dis))) ||
+        !(s->vif_ref[0] = av_calloc(w2 * h2 + 8, sizeof(float))) ||
+        !(s->vif_ref[1] = av_calloc(w2 * h2 + 8, sizeof(float))) ||
+        !(s->vif_dis[0] = av_calloc(w2 * h2 + 8, sizeof(float))) ||
+        !(s->vif_dis[1] = av_calloc(w2 * h2 + 8, sizeof(float))) ||
+        !(s->vif_rows   = av_malloc_array(h, 2 * sizeof(*s->vif_rows))) ||
+        !(s->adm_rows   = av_malloc_array(h2, 6 * sizeof(*s->adm_rows))))
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < 2; i++)
+        for (int k = 0; k < 2; k++)
+            for (int b = 0; b < 4; b++)
+                if (!(s->adm_band[i][k][b] = av_calloc(w2 * h2 + 8, sizeof(float))))
+                    return AVERROR(ENOMEM);
+    for (int b = 0; b < 3; b++)
+        if (!(s->adm_r[b]     = av_malloc_array(w2 * h2, sizeof(float))) ||
+            !(s->adm_csf_f[b] = av_malloc_array(w2 * h2, sizeof(float))))
+            return AVERROR(ENOMEM);
+
+    s->temp = av_calloc(s->nb_threads, sizeof(*s->temp));
+    if (!s->temp)
+        return AVERROR(ENOMEM);
+    for (int i = 0; i < s->nb_threads; i++)
+        if (!(s->temp[i] = av_calloc(5 * (s->pw + FFALIGN(w, 8)), sizeof(float))))
+            return AVERROR(ENOMEM);
+
+    ret = ff_vmafmotion_init(&s->motion, w, h, inlink->format);
+    if (ret < 0)
+        return ret;
+
+    return 0;
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    VMAFContext *s = ctx->priv;
+    AVFilterLink *mainlink = ctx->inputs[0];
+    int ret;
+
+    ret = ff_framesync_init_dualinput(&s->fs, ctx);
+    if (ret < 0)
+        return ret;
+    outlink->w = mainlink->w;
+    outlink->h = mainlink->h;
+    outlink->time_base = mainlink->time_base;
+    outlink->sample_aspect_ratio = mainlink->sample_aspect_ratio;
+    outlink->frame_rate = mainlink->frame_rate;
+    if ((ret = ff_framesync_configure(&s->fs)) < 0)
+        return ret;
+
+    return 0;
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    VMAFContext *s = ctx->priv;
+
+    return ff_framesync_activate(&s->fs);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    VMAFContext *s = ctx->priv;
+
+    if (s->pending_frame) {
+        s->pending[FEATURE_MOTION2] = s->pending[FEATURE_MOTION];
+        log_frame(ctx, s->pending, s->nb_frames - 1);
+        av_frame_free(&s->pending_frame);
+    }
+
+    if (s->nb_frames > 0) {
+        AVBPrint bp;
+
+        av_bprint_init(&bp, 0, AV_BPRINT_SIZE_AUTOMATIC);
+        for (int f = 0; f < NB_FEATURES; f++)
+            av_bprintf(&bp, " %s:%f", feature_names[f], s->feature_sum[f] / s->nb_frames);
+        av_log(ctx, AV_LOG_INFO, "VMAF features average:%s\n", bp.str);
+        av_bprint_finalize(&bp, NULL);
+        if (s->has_model)
+            av_log(ctx, AV_LOG_INFO, "VMAF score: %f\n", s->score_sum / s->nb_frames);
+    }
+
+    ff_framesync_uninit(&s->fs);
+    ff_vmafmotion_uninit(&s->motion);
+
+    if (s->log_file && s->log_file != stdout)
+        fclose(s->log_file);
+
+    av_freep(&s->ref);
+    av_freep(&s->dis);
+    for (int i = 0; i < 2; i++) {
+        av_freep(&s->vif_ref[i]);
+        av_freep(&s->vif_dis[i]);
+        for (int k = 0; k < 2; k++)
+            for (int b = 0; b < 4; b++)
+                av_freep(&s->adm_band[i][k][b]);
+    }
+    for (int b = 0; b < 3; b++) {
+        av_freep(&s->adm_r[b]);
+        av_freep(&s->adm_csf_f[b]);
+    }
+    av_freep(&s->vif_rows);
+    av_freep(&s->adm_rows);
+    for (int i = 0; i < s->nb_threads && s->temp; i++)
+        av_freep(&s->temp[i]);
+    av_freep(&s->temp);
+    av_freep(&s->model.sv_coef);
+    av_freep(&s->model.sv);
+}
+
+static const AVFilterPad vmaf_inputs[] = {
+    {
+        .name         = "main",
+        .type         = AVMEDIA_TYPE_VIDEO,
+    },{
+        .name         = "reference",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input_ref,
+    },
+    { NULL }
+};
+
+static const AVFilterPad vmaf_outputs[] = {
+    {
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .config_props  = config_output,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_vmaf = {
+    .name          = "vmaf",
+    .description   = NULL_IF_CONFIG_SMALL("Calculate the VMAF between two video streams natively."),
+    .preinit       = vmaf_framesync_preinit,
+    .init          = init,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+    .activate      = activate,
+    .priv_size     = sizeof(VMAFContext),
+    .priv_class    = &vmaf_class,
+    .inputs        = vmaf_inputs,
+    .outputs       = vmaf_outputs,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
+};
@@ -45,6 +45,7 @@
 #include "libavutil/avassert.h"
 
 #define ZIMG_ALIGNMENT 32
+#define MAX_THREADS 32
 
 static const char *const var_names[] = {
     "in_w",   "iw",
@@ -112,13 +113,17 @@ typedef struct ZScaleContext {
 
     int force_original_aspect_ratio;
 
-    void *tmp;
-    size_t tmp_size;
+    int nb_threads;
+    int out_slice_start[MAX_THREADS], out_slice_end[MAX_THREADS];
+    double in_slice_start[MAX_THREADS], in_slice_end[MAX_THREADS];
+
+    void *tmp[MAX_THREADS];
+    size_t tmp_size[MAX_THREADS];
 
     zimg_image_format src_format, dst_format;
     zimg_image_format alpha_src_format, alpha_dst_format;
     zimg_graph_builder_params alpha_params, params;
-    zimg_filter_graph *alpha_graph, *graph;
+    zimg_filter_graph *alpha_graph[MAX_THREADS], *graph[MAX_THREADS];
 
     enum AVColorSpace in_colorspace, out_colorspace;
     enum AVColorTransferCharacteristic in_trc, out_trc;
@@ -504,6 +509,58 @@ static int graph_build(zimg_filter_graph **graph, zimg_graph_builder_params *par
     return 0;
 }
 
+/**
+ * Split the output into nb_threads horizontal bands whose boundaries are
+ * aligned to the output chroma subsampling, and map each band back to the
+ * matching (fractional) band of the input.
+ */
+static void slice_params(ZScaleContext *s, int out_h, int in_h, int align)
+{
+    int i;
+
+    s->out_slice_start[0] = 0;
+    for (i = 1; i < s->nb_threads; i++) {
+        int slice_end = FFALIGN((int64_t)out_h * i / s->nb_threads, align);
+        s->out_slice_end[i - 1] = s->out_slice_start[i] = slice_end;
+    }
+    s->out_slice_end[s->nb_threads - 1] = out_h;
+
+    for (i = 0; i < s->nb_threads; i++) {
+        s->in_slice_start[i] = s->out_slice_start[i] * in_h / (double)out_h;
+        s->in_slice_end[i]   = s->out_slice_end[i]   * in_h / (double)out_h;
+    }
+}
+
+static int graphs_build(ZScaleContext *s, int job, int alpha)
+{
+    zimg_image_format src_format = s->src_format;
+    zimg_image_format dst_format = s->dst_format;
+    int ret;
+
+    src_format.active_region.left   = 0;
+    src_format.active_region.top    = s->in_slice_start[job];
+    src_format.active_region.width  = src_format.width;
+    src_format.active_region.height = s->in_slice_end[job] - s->in_slice_start[job];
+    dst_format.height = s->out_slice_end[job] - s->out_slice_start[job];
+
+    ret = graph_build(&s->graph[job], &s->params, &src_format, &dst_format,
+                      &s->tmp[job], &s->tmp_size[job]);
+    if (ret < 0 || !alpha)
+        return ret;
+
+    src_format = s->alpha_src_format;
+    dst_format = s->alpha_dst_format;
+
+    src_format.active_region.left   = 0;
+    src_format.active_region.top    = s->in_slice_start[job];
+    src_format.active_region.width  = src_format.width;
+    src_format.active_region.height = s->in_slice_end[job] - s->in_slice_start[job];
+    dst_format.height = s->out_slice_end[job] - s->out_slice_start[job];
+
+    return graph_build(&s->alpha_graph[job], &s->alpha_params, &src_format, &dst_format,
+                       &s->tmp[job], &s->tmp_size[job]);
+}
+
 static int realign_frame(const AVPixFmtDescriptor *desc, AVFrame **frame)
 {
     AVFrame *aligned = NULL;
@@ -542,16 +599,84 @@ fail:
     return ret;
 }
 
+typedef struct ThreadData {
+    const AVPixFmtDescriptor *desc, *odesc;
+    AVFrame *in, *out;
+} ThreadData;
+
+static int filter_slice(AVFilterContext *ctx, void *data, int job_nr, int n_jobs)
+{
+    ZScaleContext *s = ctx->priv;
+    ThreadData *td = data;
+    const AVPixFmtDescriptor *desc  = td->desc;
+    const AVPixFmtDescriptor *odesc = td->odesc;
+    const int out_slice_start = s->out_slice_start[job_nr];
+    const int out_slice_end   = s->out_slice_end[job_nr];
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    zimg_image_buffer_const src_buf = { ZIMG_API_VERSION };
+    zimg_image_buffer dst_buf = { ZIMG_API_VERSION };
+    int ret, plane;
+
+    for (plane = 0; plane < 3; plane++) {
+        const int vsub = plane ? odesc->log2_chroma_h : 0;
+        int p = desc->comp[plane].plane;
+        src_buf.plane[plane].data   = in->data[p];
+        src_buf.plane[plane].stride = in->linesize[p];
+        src_buf.plane[plane].mask   = -1;
+
+        p = odesc->comp[plane].plane;
+        dst_buf.plane[plane].data   = out->data[p] + (out_slice_start >> vsub) * out->linesize[p];
+        dst_buf.plane[plane].stride = out->linesize[p];
+        dst_buf.plane[plane].mask   = -1;
+    }
+
+    ret = zimg_filter_graph_process(s->graph[job_nr], &src_buf, &dst_buf, s->tmp[job_nr], 0, 0, 0, 0);
+    if (ret)
+        return print_zimg_error(ctx);
+
+    if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
+        src_buf.plane[0].data   = in->data[3];
+        src_buf.plane[0].stride = in->linesize[3];
+        src_buf.plane[0].mask   = -1;
+
+        dst_buf.plane[0].data   = out->data[3] + out_slice_start * out->linesize[3];
+        dst_buf.plane[0].stride = out->linesize[3];
+        dst_buf.plane[0].mask   = -1;
+
+        ret = zimg_filter_graph_process(s->alpha_graph[job_nr], &src_buf, &dst_buf, s->tmp[job_nr], 0, 0, 0, 0);
+        if (ret)
+            return print_zimg_error(ctx);
+    } else if (odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
+        int x, y;
+
+        if (odesc->flags & AV_PIX_FMT_FLAG_FLOAT) {
+            for (y = out_slice_start; y < out_slice_end; y++) {
+                for (x = 0; x < out->width; x++) {
+                    AV_WN32(out->data[3] + x * odesc->comp[3].step + y * out->linesize[3],
+                            av_float2int(1.0f));
+                }
+            }
+        } else {
+            for (y = out_slice_start; y < out_slice_end; y++)
+                memset(out->data[3] + y * out->linesize[3], 0xff, out->width);
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
-    ZScaleContext *s = link->dst->priv;
-    AVFilterLink *outlink = link->dst->outputs[0];
+    AVFilterContext *ctx = link->dst;
+    ZScaleContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     const AVPixFmtDescriptor *odesc = av_pix_fmt_desc_get(outlink->format);
-    zimg_image_buffer_const src_buf = { ZIMG_API_VERSION };
-    zimg_image_buffer dst_buf = { ZIMG_API_VERSION };
+    int jobs_ret[MAX_THREADS];
+    ThreadData td;
     char buf[32];
-    int ret = 0, plane;
+    int ret = 0, i;
     AVFrame *out = NULL;
 
     if ((ret = realign_frame(desc, &in)) < 0)
@@ -578,7 +703,11 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
        || s->out_primaries != out->color_primaries
        || s->out_range != out->color_range
        || s->in_chromal != in->chroma_location
-       || s->out_chromal != out->chroma_location) {
+       || s->out_chromal != out->chroma_location
+       || !s->graph[0]) {
+        int alpha = desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA;
+        int align;
+
         snprintf(buf, sizeof(buf)-1, "%d", outlink->w);
         av_opt_set(s, "w", buf, 0);
         snprintf(buf, sizeof(buf)-1, "%d", outlink->h);
@@ -622,11 +751,6 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         if (s->chromal != -1)
             out->chroma_location = (int)s->dst_format.chroma_location - 1;
 
-        ret = graph_build(&s->graph, &s->params, &s->src_format, &s->dst_format,
-                          &s->tmp, &s->tmp_size);
-        if (ret < 0)
-            goto fail;
-
         s->in_colorspace  = in->colorspace;
         s->in_trc         = in->color_trc;
         s->in_primaries   = in->color_primaries;
@@ -636,7 +760,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         s->out_primaries  = out->color_primaries;
         s->out_range      = out->color_range;
 
-        if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
+        if (alpha) {
             zimg_image_format_default(&s->alpha_src_format, ZIMG_API_VERSION);
             zimg_image_format_default(&s->alpha_dst_format, ZIMG_API_VERSION);
             zimg_graph_builder_params_default(&s->alpha_params, ZIMG_API_VERSION);
@@ -656,13 +780,23 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
             s->alpha_dst_format.depth = odesc->comp[0].depth;
             s->alpha_dst_format.pixel_type = (odesc->flags & AV_PIX_FMT_FLAG_FLOAT) ? ZIMG_PIXEL_FLOAT : odesc->comp[0].depth > 8 ? ZIMG_PIXEL_WORD : ZIMG_PIXEL_BYTE;
             s->alpha_dst_format.color_family = ZIMG_COLOR_GREY;
+        }
 
-            zimg_filter_graph_free(s->alpha_graph);
-            s->alpha_graph = zimg_filter_graph_build(&s->alpha_src_format, &s->alpha_dst_format, &s->alpha_params);
-            if (!s->alpha_graph) {
-                ret = print_zimg_error(link->dst);
+        align = 1 << odesc->log2_chroma_h;
+        s->nb_threads = av_clip(FFMIN(ff_filter_get_nb_threads(ctx), MAX_THREADS),
+                                1, FFMAX(out->height / align, 1));
+        /* Error diffusion carries its state from row to row and the ordered
+         * and random patterns are indexed by the row within the graph, so
+         * splitting a dithered image into bands would leave seams at the
+         * band boundaries and make the output depend on the thread count. */
+        if (s->dither != ZIMG_DITHER_NONE)
+            s->nb_threads = 1;
+        slice_params(s, out->height, in->height, align);
+
+        for (i = 0; i < s->nb_threads; i++) {
+            ret = graphs_build(s, i, alpha);
+            if (ret < 0)
                 goto fail;
-            }
         }
     }
 
@@ -683,52 +817,17 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
               (int64_t)in->sample_aspect_ratio.den * outlink->w * link->h,
               INT_MAX);
 
-    for (plane = 0; plane < 3; plane++) {
-        int p = desc->comp[plane].plane;
-        src_buf.plane[plane].data   = in->data[p];
-        src_buf.plane[plane].stride = in->linesize[p];
-        src_buf.plane[plane].mask   = -1;
+    td.desc  = desc;
+    td.odesc = odesc;
+    td.in    = in;
+    td.out   = out;
 
-        p = odesc->comp[plane].plane;
-        dst_buf.plane[plane].data   = out->data[p];
-        dst_buf.plane[plane].stride = out->linesize[p];
-        dst_buf.plane[plane].mask   = -1;
-    }
-
-    ret = zimg_filter_graph_process(s->graph, &src_buf, &dst_buf, s->tmp, 0, 0, 0, 0);
-    if (ret) {
-        ret = print_zimg_error(link->dst);
-        goto fail;
-    }
-
-    if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
-        src_buf.plane[0].data   = in->data[3];
-        src_buf.plane[0].stride = in->linesize[3];
-        src_buf.plane[0].mask   = -1;
-
-        dst_buf.plane[0].data   = out->data[3];
-        dst_buf.plane[0].stride = out->linesize[3];
-        dst_buf.plane[0].mask   = -1;
-
-        ret = zimg_filter_graph_process(s->alpha_graph, &src_buf, &dst_buf, s->tmp, 0, 0, 0, 0);
-        if (ret) {
-            ret = print_zimg_error(link->dst);
+    ctx->internal->execute(ctx, filter_slice, &td, jobs_ret, s->nb_threads);
+    for (i = 0; i < s->nb_threads; i++) {
+        if (jobs_ret[i] < 0) {
+            ret = jobs_ret[i];
             goto fail;
         }
-    } else if (odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
-        int x, y;
-
-        if (odesc->flags & AV_PIX_FMT_FLAG_FLOAT) {
-            for (y = 0; y < out->height; y++) {
-                for (x = 0; x < out->width; x++) {
-                    AV_WN32(out->data[3] + x * odesc->comp[3].step + y * out->linesize[3],
-                            av_float2int(1.0f));
-                }
-            }
-        } else {
-            for (y = 0; y < outlink->h; y++)
-                memset(out->data[3] + y * out->linesize[3], 0xff, outlink->w);
-        }
     }
 
 fail:
@@ -744,11 +843,15 @@ fail:
 static av_cold void uninit(AVFilterContext *ctx)
 {
     ZScaleContext *s = ctx->priv;
-
-    zimg_filter_graph_free(s->graph);
-    zimg_filter_graph_free(s->alpha_graph);
-    av_freep(&s->tmp);
-    s->tmp_size = 0;
+    int i;
+
+    for (i = 0; i < MAX_THREADS; i++) {
+        zimg_filter_graph_free(s->graph[i]);
+        zimg_filter_graph_free(s->alpha_graph[i]);
+        s->graph[i] = s->alpha_graph[i] = NULL;
+        av_freep(&s->tmp[i]);
+        s->tmp_size[i] = 0;
+    }
 }
 
 static int process_command(AVFilterContext *ctx, const char *cmd, const char *args,
@@ -931,4 +1034,5 @@ AVFilter ff_vf_zscale = {
     .inputs          = avfilter_vf_zscale_inputs,
     .outputs         = avfilter_vf_zscale_outputs,
     .process_command = process_command,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
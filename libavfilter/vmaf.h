@@ -0,0 +1,50 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_VMAF_H
+#define AVFILTER_VMAF_H
+
+#include <stddef.h>
+
+/**
+ * All functions process w elements, w being a multiple of 8; the buffers
+ * must be readable and writable up to that size.
+ */
+typedef struct VMAFDSPContext {
+    /**
+     * Vertical VIF filter tap: add c[0] * (a, b, a * a, b * b, a * b) to the
+     * five rows dst, dst + stride, ..., dst + 4 * stride.
+     */
+    void (*vif_vfilter)(float *dst, ptrdiff_t stride, const float *a,
+                        const float *b, const float *c, int w);
+    /**
+     * Horizontal VIF filter: dst[j] = sum of filter[k] * src[j + k], k < len.
+     */
+    void (*vif_hfilter)(float *dst, const float *src, const float *filter,
+                        int len, int w);
+    /**
+     * Vertical pass of the ADM db2 wavelet over the four source rows.
+     */
+    void (*adm_dwt_v)(float *lo, float *hi, const float *l0, const float *l1,
+                      const float *l2, const float *l3, int w);
+} VMAFDSPContext;
+
+void ff_vmaf_init_dsp(VMAFDSPContext *dsp);
+void ff_vmaf_init_dsp_x86(VMAFDSPContext *dsp);
+
+#endif /* AVFILTER_VMAF_H */
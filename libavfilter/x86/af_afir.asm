@@ -67,3 +67,56 @@ INIT_XMM sse3
 FCMUL_ADD
 INIT_YMM avx
 FCMUL_ADD
+
+;------------------------------------------------------------------------------
+; void ff_fir_direct(float *dst, const float *src, const float *ir,
+;                    ptrdiff_t ir_len, ptrdiff_t len)
+;------------------------------------------------------------------------------
+
+%macro FIR_DIRECT 0
+cglobal fir_direct, 5,6,4, dst, src, ir, ir_len, len, j
+    shl    ir_lenq, 2
+    add        irq, ir_lenq
+    add       srcq, ir_lenq
+    neg    ir_lenq
+.loop:
+    mov         jq, ir_lenq
+    xorps       m0, m0, m0
+    xorps       m1, m1, m1
+.inner:
+    movu        m2, [srcq + jq]
+    movu        m3, [srcq + jq + mmsize]
+%if cpuflag(fma3)
+    fmaddps     m0, m2, [irq + jq], m0
+    fmaddps     m1, m3, [irq + jq + mmsize], m1
+%else
+    mulps       m2, m2, [irq + jq]
+    mulps       m3, m3, [irq + jq + mmsize]
+    addps       m0, m0, m2
+    addps       m1, m1, m3
+%endif
+    add         jq, mmsize*2
+    jl .inner
+    addps       m0, m0, m1
+%if mmsize == 32
+    vextractf128 xm1, m0, 1
+    addps      xm0, xm0, xm1
+%endif
+    movhlps    xm1, xm0
+    addps      xm0, xm0, xm1
+    movshdup   xm1, xm0
+    addss      xm0, xm0, xm1
+    movss    [dstq], xm0
+    add       dstq, 4
+    add       srcq, 4
+    dec       lenq
+    jg .loop
+    RET
+%endmacro
+
+INIT_XMM sse3
+FIR_DIRECT
+INIT_YMM avx
+FIR_DIRECT
+INIT_YMM fma3
+FIR_DIRECT
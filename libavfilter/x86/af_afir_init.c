@@ -27,14 +27,26 @@ void ff_fcmul_add_sse3(float *sum, const float *t, const float *c,
 void ff_fcmul_add_avx(float *sum, const float *t, const float *c,
                       ptrdiff_t len);
 
+void ff_fir_direct_sse3(float *dst, const float *src, const float *ir,
+                        ptrdiff_t ir_len, ptrdiff_t len);
+void ff_fir_direct_avx(float *dst, const float *src, const float *ir,
+                       ptrdiff_t ir_len, ptrdiff_t len);
+void ff_fir_direct_fma3(float *dst, const float *src, const float *ir,
+                        ptrdiff_t ir_len, ptrdiff_t len);
+
 av_cold void ff_afir_init_x86(AudioFIRDSPContext *s)
 {
     int cpu_flags = av_get_cpu_flags();
 
     if (EXTERNAL_SSE3(cpu_flags)) {
-        s->fcmul_add = ff_fcmul_add_sse3;
+        s->fcmul_add  = ff_fcmul_add_sse3;
+        s->fir_direct = ff_fir_direct_sse3;
     }
     if (EXTERNAL_AVX_FAST(cpu_flags)) {
-        s->fcmul_add = ff_fcmul_add_avx;
+        s->fcmul_add  = ff_fcmul_add_avx;
+        s->fir_direct = ff_fir_direct_avx;
+    }
+    if (EXTERNAL_FMA3_FAST(cpu_flags)) {
+        s->fir_direct = ff_fir_direct_fma3;
     }
 }
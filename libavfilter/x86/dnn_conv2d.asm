@@ -0,0 +1,81 @@
+;*****************************************************************************
+;* x86-optimized functions for the conv2d layer of the native DNN backend
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_dnn_conv2d_gemm4(float *acc, const float *col, const float *kernel,
+;                          int filter_size, int w)
+;------------------------------------------------------------------------------
+%macro CONV2D_GEMM4 0
+cglobal dnn_conv2d_gemm4, 5, 11, 7, acc, col, kernel, fsize, w, w3, fs3, cnt, c, kp, k
+    movsxdifnidn fsizeq, fsized
+    movsxdifnidn     wq, wd
+    shl          fsizeq, 2
+    shl              wq, 2
+    lea            fs3q, [fsizeq + fsizeq * 2]
+    lea             w3q, [wq + wq * 2]
+    mov            cntq, wq
+.loop_x:
+    ; the four accumulator lines stay in registers along the taps
+    movu             m0, [accq]
+    movu             m1, [accq + wq]
+    movu             m2, [accq + wq * 2]
+    movu             m3, [accq + w3q]
+    mov              cq, colq
+    mov             kpq, kernelq
+    mov              kq, fsizeq
+.loop_k:
+    movu             m4, [cq]
+    VBROADCASTSS     m5, [kpq]
+    FMULADD_PS       m0, m4, m5, m0, m6
+    VBROADCASTSS     m5, [kpq + fsizeq]
+    FMULADD_PS       m1, m4, m5, m1, m6
+    VBROADCASTSS     m5, [kpq + fsizeq * 2]
+    FMULADD_PS       m2, m4, m5, m2, m6
+    VBROADCASTSS     m5, [kpq + fs3q]
+    FMULADD_PS       m3, m4, m5, m3, m6
+    add              cq, wq
+    add             kpq, 4
+    sub              kq, 4
+    jg .loop_k
+
+    movu         [accq], m0
+    movu    [accq + wq], m1
+    movu [accq + wq * 2], m2
+    movu   [accq + w3q], m3
+    add            accq, mmsize
+    add            colq, mmsize
+    sub            cntq, mmsize
+    jg .loop_x
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse
+CONV2D_GEMM4
+
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+CONV2D_GEMM4
+%endif
+%endif
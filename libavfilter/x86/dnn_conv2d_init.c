@@ -0,0 +1,39 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/dnn/dnn_backend_native_layer_conv2d.h"
+
+void ff_dnn_conv2d_gemm4_sse(float *acc, const float *col, const float *kernel,
+                             int filter_size, int w);
+void ff_dnn_conv2d_gemm4_fma3(float *acc, const float *col, const float *kernel,
+                              int filter_size, int w);
+
+av_cold void ff_dnn_conv2d_init_dsp_x86(Conv2DDSPContext *dsp)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE(cpu_flags))
+        dsp->gemm4 = ff_dnn_conv2d_gemm4_sse;
+    if (EXTERNAL_FMA3_FAST(cpu_flags))
+        dsp->gemm4 = ff_dnn_conv2d_gemm4_fma3;
+#endif
+}
@@ -0,0 +1,216 @@
+;*****************************************************************************
+;* x86-optimized functions for nnedi filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or modify
+;* it under the terms of the GNU General Public License as published by
+;* the Free Software Foundation; either version 2 of the License, or
+;* (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;* GNU General Public License for more details.
+;*
+;* You should have received a copy of the GNU General Public License along
+;* with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+;* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+ps_exp_lo: times 8 dd -80.0
+ps_exp_hi: times 8 dd  80.0
+ps_log2e:  times 8 dd 1.44269504088896341
+ps_ln2_hi: times 8 dd 0.693359375
+ps_ln2_lo: times 8 dd -2.12194440e-4
+ps_exp_p0: times 8 dd 1.9875691500e-4
+ps_exp_p1: times 8 dd 1.3981999507e-3
+ps_exp_p2: times 8 dd 8.3334519073e-3
+ps_exp_p3: times 8 dd 4.1665795894e-2
+ps_exp_p4: times 8 dd 1.6666665459e-1
+ps_exp_p5: times 8 dd 5.0000001201e-1
+ps_1:      times 8 dd 1.0
+pd_127:    times 8 dd 127
+
+SECTION .text
+
+; horizontal sums of m0-m3, result in xm0 (float)
+%macro HSUM4_PS 0
+%if mmsize == 32
+    vextractf128   xm4, m0, 1
+    vextractf128   xm5, m1, 1
+    addps          xm0, xm4
+    addps          xm1, xm5
+    vextractf128   xm4, m2, 1
+    vextractf128   xm5, m3, 1
+    addps          xm2, xm4
+    addps          xm3, xm5
+%endif
+    unpcklps       xm4, xm0, xm1    ; a0 b0 a1 b1
+    unpckhps       xm0, xm1         ; a2 b2 a3 b3
+    addps          xm0, xm4
+    unpcklps       xm4, xm2, xm3    ; c0 d0 c1 d1
+    unpckhps       xm2, xm3         ; c2 d2 c3 d3
+    addps          xm2, xm4
+    shufps         xm4, xm0, xm2, q1010
+    shufps         xm0, xm2, q3232
+    addps          xm0, xm4
+%endmacro
+
+; horizontal sums of m0-m3, result in xm0 (int32)
+%macro HSUM4_D 0
+%if mmsize == 32
+    vextracti128   xm4, m0, 1
+    vextracti128   xm5, m1, 1
+    paddd          xm0, xm4
+    paddd          xm1, xm5
+    vextracti128   xm4, m2, 1
+    vextracti128   xm5, m3, 1
+    paddd          xm2, xm4
+    paddd          xm3, xm5
+%endif
+    punpckldq      xm4, xm0, xm1    ; a0 b0 a1 b1
+    punpckhdq      xm0, xm1         ; a2 b2 a3 b3
+    paddd          xm0, xm4
+    punpckldq      xm4, xm2, xm3    ; c0 d0 c1 d1
+    punpckhdq      xm2, xm3         ; c2 d2 c3 d3
+    paddd          xm2, xm4
+    punpcklqdq     xm4, xm0, xm2
+    punpckhqdq     xm0, xm2
+    paddd          xm0, xm4
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_dot_prods_float(const float *data, const float *weights,
+;                               float *vals, int n, int len)
+;------------------------------------------------------------------------------
+%macro DOT_PRODS_FLOAT 0
+cglobal nnedi_dot_prods_float, 5, 7, 6, data, weights, vals, n, len, len3, cnt
+    movsxdifnidn  lenq, lend
+    shl           lenq, 2
+    lea          len3q, [lenq * 3]
+.loop_n:
+    mov           cntq, lenq
+    xorps           m0, m0
+    xorps           m1, m1
+    xorps           m2, m2
+    xorps           m3, m3
+.loop_j:
+    movu            m4, [dataq]
+%if cpuflag(fma3)
+    fmaddps         m0, m4, [weightsq], m0
+    fmaddps         m1, m4, [weightsq + lenq], m1
+    fmaddps         m2, m4, [weightsq + lenq * 2], m2
+    fmaddps         m3, m4, [weightsq + len3q], m3
+%else
+    mulps           m5, m4, [weightsq]
+    addps           m0, m5
+    mulps           m5, m4, [weightsq + lenq]
+    addps           m1, m5
+    mulps           m5, m4, [weightsq + lenq * 2]
+    addps           m2, m5
+    mulps           m5, m4, [weightsq + len3q]
+    addps           m3, m5
+%endif
+    add          dataq, mmsize
+    add       weightsq, mmsize
+    sub           cntq, mmsize
+    jg .loop_j
+
+    HSUM4_PS
+    movu       [valsq], xm0
+    add          valsq, 16
+    sub          dataq, lenq
+    add       weightsq, len3q
+    sub             nd, 4
+    jg .loop_n
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_dot_prods_int16(const int16_t *data, const int16_t *weights,
+;                               int32_t *vals, int n, int len)
+;------------------------------------------------------------------------------
+%macro DOT_PRODS_INT16 0
+cglobal nnedi_dot_prods_int16, 5, 7, 6, data, weights, vals, n, len, len3, cnt
+    movsxdifnidn  lenq, lend
+    add           lenq, lenq
+    lea          len3q, [lenq * 3]
+.loop_n:
+    mov           cntq, lenq
+    pxor            m0, m0
+    pxor            m1, m1
+    pxor            m2, m2
+    pxor            m3, m3
+.loop_j:
+    movu            m4, [dataq]
+    pmaddwd         m5, m4, [weightsq]
+    paddd           m0, m5
+    pmaddwd         m5, m4, [weightsq + lenq]
+    paddd           m1, m5
+    pmaddwd         m5, m4, [weightsq + lenq * 2]
+    paddd           m2, m5
+    pmaddwd         m5, m4, [weightsq + len3q]
+    paddd           m3, m5
+    add          dataq, mmsize
+    add       weightsq, mmsize
+    sub           cntq, mmsize
+    jg .loop_j
+
+    HSUM4_D
+    movu       [valsq], xm0
+    add          valsq, 16
+    sub          dataq, lenq
+    add       weightsq, len3q
+    sub             nd, 4
+    jg .loop_n
+    RET
+%endmacro
+
+INIT_XMM sse
+DOT_PRODS_FLOAT
+INIT_XMM sse2
+DOT_PRODS_INT16
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+DOT_PRODS_FLOAT
+DOT_PRODS_INT16
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_exp(float *s, int n)
+;------------------------------------------------------------------------------
+cglobal nnedi_exp, 2, 2, 4, s, n
+    movsxdifnidn    nq, nd
+    lea             sq, [sq + nq * 4]
+    neg             nq
+.loop:
+    movu            m0, [sq + nq * 4]
+    maxps           m0, [ps_exp_lo]
+    minps           m0, [ps_exp_hi]
+    mulps           m1, m0, [ps_log2e]
+    roundps         m1, m1, 0                   ; n = round(x * log2(e))
+    fnmaddps        m0, m1, [ps_ln2_hi], m0     ; r = x - n * ln(2)
+    fnmaddps        m0, m1, [ps_ln2_lo], m0
+    mova            m2, [ps_exp_p0]
+    fmaddps         m2, m2, m0, [ps_exp_p1]
+    fmaddps         m2, m2, m0, [ps_exp_p2]
+    fmaddps         m2, m2, m0, [ps_exp_p3]
+    fmaddps         m2, m2, m0, [ps_exp_p4]
+    fmaddps         m2, m2, m0, [ps_exp_p5]
+    mulps           m3, m0, m0
+    fmaddps         m2, m2, m3, m0              ; p * r^2 + r
+    addps           m2, [ps_1]
+    cvtps2dq        m1, m1                      ; 2^n
+    paddd           m1, [pd_127]
+    pslld           m1, 23
+    mulps           m2, m1
+    movu [sq + nq * 4], m2
+    add             nq, mmsize / 4
+    jl .loop
+    RET
+%endif
@@ -0,0 +1,62 @@
+;*****************************************************************************
+;* x86-optimized functions for paletteuse filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_paletteuse_color_dist(int32_t *dist, const int16_t *pal,
+;                               const int16_t *target, int n)
+;------------------------------------------------------------------------------
+%macro COLOR_DIST 0
+cglobal paletteuse_color_dist, 4, 4, 5, dist, pal, target, n
+%if cpuflag(avx2)
+    vpbroadcastq    m4, [targetq]
+%else
+    movq            m4, [targetq]
+    punpcklqdq      m4, m4
+%endif
+.loop:
+    psubw           m0, m4, [palq]
+    psubw           m1, m4, [palq + mmsize]
+    pmaddwd         m0, m0              ; r*r+g*g, b*b+x*x of each entry
+    pmaddwd         m1, m1
+    shufps          m2, m0, m1, q3131
+    shufps          m0, m1, q2020
+    paddd           m0, m2
+%if cpuflag(avx2)
+    vpermq          m0, m0, q3120
+%endif
+    mova       [distq], m0
+    add           palq, mmsize * 2
+    add          distq, mmsize
+    sub             nd, mmsize / 4
+    jg .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+COLOR_DIST
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+COLOR_DIST
+%endif
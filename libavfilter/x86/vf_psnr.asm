@@ -25,7 +25,6 @@
 SECTION .text
 
 %macro SSE_LINE_FN 2 ; 8 or 16, byte or word
-INIT_XMM sse2
 %if ARCH_X86_32
 %if %1 == 8
 cglobal sse_line_%1 %+ bit, 0, 6, 8, res, buf, w, px1, px2, ref
@@ -94,20 +93,28 @@ cglobal sse_line_%1 %+ bit, 3, 5, 8, buf, ref, w, px1, px2
 
 .end:
     add         wd, mmsize*2
-    movhlps     m0, m7
+%if mmsize == 32
+    vextracti128 xm0, m7, 1
 %if %1 == 8
-    paddd       m7, m0
-    pshufd      m0, m7, 1
-    paddd       m7, m0
-    movd       eax, m7
+    paddd      xm7, xm0
 %else
-    paddq       m7, m0
+    paddq      xm7, xm0
+%endif
+%endif
+    movhlps    xm0, xm7
+%if %1 == 8
+    paddd      xm7, xm0
+    pshufd     xm0, xm7, 1
+    paddd      xm7, xm0
+    movd       eax, xm7
+%else
+    paddq      xm7, xm0
 %if ARCH_X86_32
-    movd       eax, m7
-    psrldq      m7, 4
-    movd       edx, m7
+    movd       eax, xm7
+    psrldq     xm7, 4
+    movd       edx, xm7
 %else
-    movq       rax, m7
+    movq       rax, xm7
 %endif
 %endif
 
@@ -138,3 +145,8 @@ cglobal sse_line_%1 %+ bit, 3, 5, 8, buf, ref, w, px1, px2
 INIT_XMM sse2
 SSE_LINE_FN  8, byte
 SSE_LINE_FN 16, word
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SSE_LINE_FN  8, byte
+SSE_LINE_FN 16, word
+%endif
@@ -27,11 +27,17 @@ SECTION_RODATA
 pw_1: times 8 dw 1
 ssim_c1: times 4 dd 416 ;(.01*.01*255*255*64 + .5)
 ssim_c2: times 4 dd 235963 ;(.03*.03*255*255*64*63 + .5)
+pd_0123: dd 0, 1, 2, 3
+pd_4: times 4 dd 4
+pd_64: times 4 dq 64.0
 
 SECTION .text
 
-%macro SSIM_4X4_LINE 1
-%if ARCH_X86_64
+; %2: 8 bits per sample, or 12 for 9 to 12 bits in words
+%macro SSIM_4X4_LINE 1-2 8
+%if %2 > 8
+cglobal ssim_4x4_line_%{2}bit, 6, 8, %1, buf, buf_stride, ref, ref_stride, sums, w, buf_stride3, ref_stride3
+%elif ARCH_X86_64
 cglobal ssim_4x4_line, 6, 8, %1, buf, buf_stride, ref, ref_stride, sums, w, buf_stride3, ref_stride3
 %else
 cglobal ssim_4x4_line, 5, 7, %1, buf, buf_stride, ref, ref_stride, sums, buf_stride3, ref_stride3
@@ -73,6 +79,12 @@ cglobal ssim_4x4_line, 5, 7, %1, buf, buf_stride, ref, ref_stride, sums, buf_str
     paddw             m0, m5
     paddw             m1, m7
     vpmadcswd         m4, m7, m7, m4
+%else
+%if %2 > 8
+    movu              m0, [bufq+buf_strideq*0]  ; a1
+    movu              m1, [refq+ref_strideq*0]  ; b1
+    movu              m2, [bufq+buf_strideq*1]  ; a2
+    movu              m3, [refq+ref_strideq*1]  ; b2
 %else
     movh              m0, [bufq+buf_strideq*0]  ; a1
     movh              m1, [refq+ref_strideq*0]  ; b1
@@ -82,6 +94,7 @@ cglobal ssim_4x4_line, 5, 7, %1, buf, buf_stride, ref, ref_stride, sums, buf_str
     punpcklbw         m1, m7                    ; s2 [word]
     punpcklbw         m2, m7                    ; s1 [word]
     punpcklbw         m3, m7                    ; s2 [word]
+%endif
     pmaddwd           m4, m0, m0                ; a1 * a1
     pmaddwd           m5, m1, m1                ; b1 * b1
     pmaddwd           m8, m2, m2                ; a2 * a2
@@ -95,6 +108,12 @@ cglobal ssim_4x4_line, 5, 7, %1, buf, buf_stride, ref, ref_stride, sums, buf_str
     paddd             m6, m5                    ; s12
     paddd             m4, m8                    ; ss
 
+%if %2 > 8
+    movu              m2, [bufq+buf_strideq*2]  ; a3
+    movu              m3, [refq+ref_strideq*2]  ; b3
+    movu              m5, [bufq+buf_stride3q]   ; a4
+    movu              m8, [refq+ref_stride3q]   ; b4
+%else
     movh              m2, [bufq+buf_strideq*2]  ; a3
     movh              m3, [refq+ref_strideq*2]  ; b3
     movh              m5, [bufq+buf_stride3q]   ; a4
@@ -103,6 +122,7 @@ cglobal ssim_4x4_line, 5, 7, %1, buf, buf_stride, ref, ref_stride, sums, buf_str
     punpcklbw         m3, m7                    ; s2 [word]
     punpcklbw         m5, m7                    ; s1 [word]
     punpcklbw         m8, m7                    ; s2 [word]
+%endif
     pmaddwd           m9, m2, m2                ; a3 * a3
     pmaddwd          m10, m3, m3                ; b3 * b3
     pmaddwd          m12, m5, m5                ; a4 * a4
@@ -151,8 +171,13 @@ cglobal ssim_4x4_line, 5, 7, %1, buf, buf_stride, ref, ref_stride, sums, buf_str
     mova  [sumsq+     0], m0
     mova  [sumsq+mmsize], m1
 
+%if %2 > 8
+    add             bufq, mmsize
+    add             refq, mmsize
+%else
     add             bufq, mmsize/2
     add             refq, mmsize/2
+%endif
     add            sumsq, mmsize*2
     sub               wd, mmsize/8
     jg .loop
@@ -162,6 +187,7 @@ cglobal ssim_4x4_line, 5, 7, %1, buf, buf_stride, ref, ref_stride, sums, buf_str
 %if ARCH_X86_64
 INIT_XMM ssse3
 SSIM_4X4_LINE 16
+SSIM_4X4_LINE 16, 12
 %endif
 %if HAVE_XOP_EXTERNAL
 INIT_XMM xop
@@ -241,7 +267,7 @@ cglobal ssim_end_line, 3, 3, 7, sum0, sum1, w
     subpd             m6, m5
     jmp .end
 .skip2:
-    psrldq            m5, 8
+    psrldq            m3, 8
     subpd             m6, m5
     subpd             m0, m3
     jmp .end
@@ -258,3 +284,86 @@ cglobal ssim_end_line, 3, 3, 7, sum0, sum1, w
     fld        qword r0m
 %endif
     RET
+
+%if ARCH_X86_64 && HAVE_AVX_EXTERNAL
+; the sums of four blocks fit in dwords up to 12 bits, but their products
+; do not, so they are computed in doubles, where they are exact, and
+; rounded to float like the int64_t ones of the C version
+INIT_YMM avx
+cglobal ssim_end_line_12bit, 5, 5, 10, sum0, sum1, w, c1, c2
+    cvtsi2sd         xm8, c1d
+    cvtsi2sd         xm9, c2d
+    movddup          xm8, xm8
+    movddup          xm9, xm9
+    vinsertf128       m8, m8, xm8, 1            ; ssim_c1 [double]
+    vinsertf128       m9, m9, xm9, 1            ; ssim_c2 [double]
+    movd             xm7, wd
+    pshufd           xm7, xm7, 0                ; w [dword]
+    xorpd             m0, m0
+.loop:
+    mova             xm1, [sum0q+16*0]
+    mova             xm2, [sum0q+16*1]
+    mova             xm3, [sum0q+16*2]
+    mova             xm4, [sum0q+16*3]
+    paddd            xm1, [sum1q+16*0]
+    paddd            xm2, [sum1q+16*1]
+    paddd            xm3, [sum1q+16*2]
+    paddd            xm4, [sum1q+16*3]
+    paddd            xm1, xm2
+    paddd            xm2, xm3
+    paddd            xm3, xm4
+    paddd            xm4, [sum0q+16*4]
+    paddd            xm4, [sum1q+16*4]
+    punpckhdq        xm5, xm1, xm2
+    punpckldq        xm1, xm2
+    punpckhdq        xm6, xm3, xm4
+    punpckldq        xm3, xm4
+    punpckhqdq       xm2, xm1, xm3              ; fs2
+    punpcklqdq       xm1, xm3                   ; fs1
+    punpckhqdq       xm4, xm5, xm6              ; fs12
+    punpcklqdq       xm3, xm5, xm6              ; fss
+    pcmpgtd          xm6, xm7, [pd_0123]        ; the lanes below w
+    psubd            xm7, [pd_4]
+
+    cvtdq2pd          m1, xm1
+    cvtdq2pd          m2, xm2
+    cvtdq2pd          m3, xm3
+    cvtdq2pd          m4, xm4
+    mulpd             m5, m1, m2                ; fs1 * fs2
+    mulpd             m1, m1                    ; fs1 * fs1
+    mulpd             m2, m2                    ; fs2 * fs2
+    mulpd             m3, [pd_64]
+    mulpd             m4, [pd_64]
+    subpd             m3, m1
+    subpd             m4, m5                    ; covariance
+    subpd             m3, m2                    ; variance
+    addpd             m4, m4                    ; 2 * covariance
+    addpd             m5, m5                    ; 2 * fs1 * fs2
+    addpd             m1, m2                    ; fs1 * fs1 + fs2 * fs2
+    addpd             m3, m9                    ; variance + ssim_c2
+    addpd             m4, m9                    ; 2 * covariance + ssim_c2
+    addpd             m5, m8                    ; 2 * fs1 * fs2 + ssim_c1
+    addpd             m1, m8                    ; fs1 * fs1 + fs2 * fs2 + ssim_c1
+
+    ; convert to float
+    cvtpd2ps         xm3, m3
+    cvtpd2ps         xm4, m4
+    cvtpd2ps         xm5, m5
+    cvtpd2ps         xm1, m1
+    mulps            xm4, xm5
+    mulps            xm3, xm1
+    divps            xm4, xm3                   ; ssim_endl
+    andps            xm4, xm6
+    cvtps2pd          m4, xm4
+    addpd             m0, m4                    ; ssim
+    add            sum0q, 16*4
+    add            sum1q, 16*4
+    sub               wd, 4
+    jg .loop
+
+    vextractf128     xm1, m0, 1
+    addpd            xm0, xm1
+    movhlps          xm1, xm0
+    addsd            xm0, xm1
+    RET
+%endif
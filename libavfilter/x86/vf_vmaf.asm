@@ -0,0 +1,172 @@
+;*****************************************************************************
+;* x86-optimized functions for the vmaf filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+; Daubechies 2 analysis filters
+dwt_lo: dd -0.12940952255092145, 0.22414386804185735, 0.836516303737469,  0.48296291314469025
+dwt_hi: dd -0.48296291314469025, 0.836516303737469,  -0.22414386804185735, -0.12940952255092145
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_vmaf_vif_vfilter(float *dst, ptrdiff_t stride, const float *a,
+;                          const float *b, const float *c, int w)
+;------------------------------------------------------------------------------
+%macro VIF_VFILTER 0
+cglobal vmaf_vif_vfilter, 6, 9, 6, dst, stride, a, b, c, w, mu2, xx, yy
+    VBROADCASTSS     m0, [cq]
+    movsxdifnidn     wq, wd
+    shl         strideq, 2
+    shl              wq, 2
+    add            dstq, wq
+    add              aq, wq
+    add              bq, wq
+    lea            mu2q, [dstq + strideq]
+    lea             xxq, [dstq + strideq * 2]
+    lea             yyq, [mu2q + strideq * 2]
+    lea              cq, [xxq  + strideq * 2]   ; xy
+    neg              wq
+.loop:
+    movu             m1, [aq + wq]
+    movu             m2, [bq + wq]
+    mulps            m3, m0, m1                 ; c * a
+    mulps            m4, m0, m2                 ; c * b
+    movu             m5, [dstq + wq]
+    addps            m5, m3
+    movu  [dstq + wq], m5
+    movu             m5, [mu2q + wq]
+    addps            m5, m4
+    movu  [mu2q + wq], m5
+    mulps            m1, m3                     ; c * a * a
+    movu             m5, [xxq + wq]
+    addps            m5, m1
+    movu   [xxq + wq], m5
+    mulps            m4, m2                     ; c * b * b
+    movu             m5, [yyq + wq]
+    addps            m5, m4
+    movu   [yyq + wq], m5
+    mulps            m3, m2                     ; c * a * b
+    movu             m5, [cq + wq]
+    addps            m5, m3
+    movu    [cq + wq], m5
+    add              wq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_vmaf_vif_hfilter(float *dst, const float *src, const float *filter,
+;                          int len, int w)
+;------------------------------------------------------------------------------
+%macro VIF_HFILTER 0
+cglobal vmaf_vif_hfilter, 5, 7, 3, dst, src, filter, len, w, k, s
+    movsxdifnidn   lenq, lend
+    movsxdifnidn     wq, wd
+    shl              wq, 2
+    add            dstq, wq
+    add            srcq, wq
+    neg              wq
+.loop_x:
+    xorps            m0, m0
+    lea              sq, [srcq + wq]
+    xor              kq, kq
+.loop_k:
+    VBROADCASTSS     m1, [filterq + kq * 4]
+    movu             m2, [sq + kq * 4]
+    mulps            m2, m1
+    addps            m0, m2
+    inc              kq
+    cmp              kq, lenq
+    jl .loop_k
+
+    movu  [dstq + wq], m0
+    add              wq, mmsize
+    jl .loop_x
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_vmaf_adm_dwt_v(float *lo, float *hi, const float *l0, const float *l1,
+;                        const float *l2, const float *l3, int w)
+;------------------------------------------------------------------------------
+%macro ADM_DWT_V 0
+cglobal vmaf_adm_dwt_v, 7, 7, 14, lo, hi, l0, l1, l2, l3, w
+    VBROADCASTSS     m6, [dwt_lo]
+    VBROADCASTSS     m7, [dwt_lo + 4]
+    VBROADCASTSS     m8, [dwt_lo + 8]
+    VBROADCASTSS     m9, [dwt_lo + 12]
+    VBROADCASTSS    m10, [dwt_hi]
+    VBROADCASTSS    m11, [dwt_hi + 4]
+    VBROADCASTSS    m12, [dwt_hi + 8]
+    VBROADCASTSS    m13, [dwt_hi + 12]
+    movsxdifnidn     wq, wd
+    shl              wq, 2
+    add             loq, wq
+    add             hiq, wq
+    add             l0q, wq
+    add             l1q, wq
+    add             l2q, wq
+    add             l3q, wq
+    neg              wq
+.loop:
+    movu             m0, [l0q + wq]
+    movu             m1, [l1q + wq]
+    movu             m2, [l2q + wq]
+    movu             m3, [l3q + wq]
+
+    mulps            m4, m6, m0
+    mulps            m5, m7, m1
+    addps            m4, m5
+    mulps            m5, m8, m2
+    addps            m4, m5
+    mulps            m5, m9, m3
+    addps            m4, m5
+    movu   [loq + wq], m4
+
+    mulps            m0, m10
+    mulps            m1, m11
+    addps            m0, m1
+    mulps            m2, m12
+    addps            m0, m2
+    mulps            m3, m13
+    addps            m0, m3
+    movu   [hiq + wq], m0
+
+    add              wq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse
+VIF_VFILTER
+VIF_HFILTER
+ADM_DWT_V
+
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+VIF_VFILTER
+VIF_HFILTER
+ADM_DWT_V
+%endif
+%endif
@@ -0,0 +1,52 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/vmaf.h"
+
+#define DECLARE_FUNCS(opt)                                                         \
+void ff_vmaf_vif_vfilter_##opt(float *dst, ptrdiff_t stride, const float *a,       \
+                               const float *b, const float *c, int w);             \
+void ff_vmaf_vif_hfilter_##opt(float *dst, const float *src, const float *filter,  \
+                               int len, int w);                                    \
+void ff_vmaf_adm_dwt_v_##opt(float *lo, float *hi, const float *l0,                \
+                             const float *l1, const float *l2, const float *l3,    \
+                             int w);
+
+DECLARE_FUNCS(sse)
+DECLARE_FUNCS(avx)
+
+av_cold void ff_vmaf_init_dsp_x86(VMAFDSPContext *dsp)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE(cpu_flags)) {
+        dsp->vif_vfilter = ff_vmaf_vif_vfilter_sse;
+        dsp->vif_hfilter = ff_vmaf_vif_hfilter_sse;
+        dsp->adm_dwt_v   = ff_vmaf_adm_dwt_v_sse;
+    }
+    if (EXTERNAL_AVX_FAST(cpu_flags)) {
+        dsp->vif_vfilter = ff_vmaf_vif_vfilter_avx;
+        dsp->vif_hfilter = ff_vmaf_vif_hfilter_avx;
+        dsp->adm_dwt_v   = ff_vmaf_adm_dwt_v_avx;
+    }
+#endif
+}
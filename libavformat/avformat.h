@@ -1957,6 +1957,15 @@ typedef struct AVFormatContext {
      * - decoding: set by user
      */
     int max_probe_packets;
+
+    /**
+     * Path of a sidecar file caching the index entries and timings of the
+     * input, used to skip rebuilding them when the same input is opened
+     * again. The file is created or updated when the input is closed.
+     * - encoding: unused
+     * - decoding: set by user
+     */
+    char *index_cache;
 } AVFormatContext;
 
 #if FF_API_FORMAT_GET_SET
@@ -19,11 +19,14 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
+
 #include "libavutil/avstring.h"
 #include "libavutil/dict.h"
 #include "libavutil/opt.h"
 #include "libavutil/time.h"
 #include "libavutil/avassert.h"
+#include "libavutil/thread.h"
 #include "os_support.h"
 #include "avformat.h"
 #include "internal.h"
@@ -58,6 +61,7 @@ static const AVOption options[] = {
     {"protocol_whitelist", "List of protocols that are allowed to be used", OFFSET(protocol_whitelist), AV_OPT_TYPE_STRING, { .str = NULL },  0, 0, D },
     {"protocol_blacklist", "List of protocols that are not allowed to be used", OFFSET(protocol_blacklist), AV_OPT_TYPE_STRING, { .str = NULL },  0, 0, D },
     {"rw_timeout", "Timeout for IO operations (in microseconds)", offsetof(URLContext, rw_timeout), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, AV_OPT_FLAG_ENCODING_PARAM | AV_OPT_FLAG_DECODING_PARAM },
+    {"io_buffers", "Number of buffers for background read-ahead or write-behind", OFFSET(io_buffers), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1024, E|D },
     { NULL }
 };
 
@@ -164,6 +168,9 @@ fail:
     return err;
 }
 
+static int io_thread_start(URLContext *h);
+static void io_thread_hook_interrupt(URLContext *h);
+
 int ffurl_connect(URLContext *uc, AVDictionary **options)
 {
     int err;
@@ -203,6 +210,10 @@ int ffurl_connect(URLContext *uc, AVDictionary **options)
     if ((err = av_dict_set(options, "protocol_blacklist", uc->protocol_blacklist, 0)) < 0)
         return err;
 
+    /* Hooked before opening, so that nested protocols copy the hook. */
+    if (uc->io_buffers)
+        io_thread_hook_interrupt(uc);
+
     err =
         uc->prot->url_open2 ? uc->prot->url_open2(uc,
                                                   uc->filename,
@@ -221,6 +232,8 @@ int ffurl_connect(URLContext *uc, AVDictionary **options)
     if ((uc->flags & AVIO_FLAG_WRITE) || !strcmp(uc->prot->name, "file"))
         if (!uc->is_streamed && ffurl_seek(uc, 0, SEEK_SET) < 0)
             uc->is_streamed = 1;
+    if (uc->io_buffers && (err = io_thread_start(uc)) < 0)
+        return err;
     return 0;
 }
 
@@ -314,8 +327,11 @@ int ffurl_open_whitelist(URLContext **puc, const char *filename, int flags,
     int ret = ffurl_alloc(puc, filename, flags, int_cb);
     if (ret < 0)
         return ret;
-    if (parent)
+    if (parent) {
         av_opt_copy(*puc, parent);
+        /* background I/O is done by the outermost protocol only */
+        (*puc)->io_buffers = 0;
+    }
     if (options &&
         (ret = av_opt_set_dict(*puc, options)) < 0)
         goto fail;
@@ -403,10 +419,324 @@ static inline int retry_transfer_wrapper(URLContext *h, uint8_t *buf,
     return len;
 }
 
+#define IO_THREAD_BUFFER_SIZE 32768
+
+#if HAVE_THREADS
+/**
+ * Background I/O for a URLContext opened only for reading or only for
+ * writing. A ring of io_buffers buffers is filled ahead by the thread
+ * when reading, or drained by it when writing, so that the caller does
+ * not wait for the protocol.
+ */
+typedef struct URLIOThread {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint8_t *buffer;
+    int *fill;              ///< number of valid bytes in each buffer
+    int nb_buffers;
+    int head;               ///< index of the oldest queued buffer
+    int count;              ///< number of queued buffers
+    int head_pos;           ///< bytes already consumed from the head buffer
+    int error;              ///< sticky error or EOF of the protocol
+    int busy;               ///< the thread is inside the protocol
+    int paused;             ///< the caller needs exclusive protocol access
+    atomic_int abort;       ///< also read by interrupt_cb outside the mutex
+} URLIOThread;
+
+/**
+ * Installed as the interrupt callback of the protocol before it is opened,
+ * so that nested protocols inherit it, and stopping a reader also
+ * interrupts a blocking read wherever the callback is checked.
+ * Pending writes are still completed when a writer is stopped.
+ */
+static int io_thread_interrupt_cb(void *opaque)
+{
+    URLContext *h  = opaque;
+    URLIOThread *t = h->io_thread;
+
+    if (t && !(h->flags & AVIO_FLAG_WRITE) && atomic_load(&t->abort))
+        return 1;
+    return ff_check_interrupt(&h->io_interrupt_callback);
+}
+
+static void io_thread_hook_interrupt(URLContext *h)
+{
+    h->io_interrupt_callback = h->interrupt_callback;
+    h->interrupt_callback    = (AVIOInterruptCB){ io_thread_interrupt_cb, h };
+}
+
+static void *io_thread_worker(void *arg)
+{
+    URLContext *h   = arg;
+    URLIOThread *t  = h->io_thread;
+    int write       = h->flags & AVIO_FLAG_WRITE;
+
+    pthread_mutex_lock(&t->mutex);
+    for (;;) {
+        uint8_t *buf;
+        int slot, ret;
+
+        if (write) {
+            /* Queued data is still written out on abort. */
+            while (!t->count && !atomic_load(&t->abort))
+                pthread_cond_wait(&t->cond, &t->mutex);
+            if (!t->count)
+                break;
+            slot = t->head;
+        } else {
+            while (!atomic_load(&t->abort) &&
+                   (t->paused || t->error || t->count == t->nb_buffers))
+                pthread_cond_wait(&t->cond, &t->mutex);
+            if (atomic_load(&t->abort))
+                break;
+            slot = (t->head + t->count) % t->nb_buffers;
+        }
+        buf     = t->buffer + slot * IO_THREAD_BUFFER_SIZE;
+        t->busy = 1;
+        pthread_mutex_unlock(&t->mutex);
+
+        if (write)
+            ret = t->error ? t->error :
+                  retry_transfer_wrapper(h, buf, t->fill[slot], t->fill[slot],
+                                         (int (*)(struct URLContext *, uint8_t *, int))
+                                         h->prot->url_write);
+        else
+            ret = retry_transfer_wrapper(h, buf, IO_THREAD_BUFFER_SIZE, 1,
+                                         h->prot->url_read);
+
+        pthread_mutex_lock(&t->mutex);
+        t->busy = 0;
+        if (write) {
+            if (ret < 0)
+                t->error = ret;
+            t->head = (t->head + 1) % t->nb_buffers;
+            t->count--;
+        } else if (ret <= 0) {
+            t->error = ret ? ret : AVERROR_EOF;
+        } else {
+            t->fill[slot] = ret;
+            t->count++;
+        }
+        pthread_cond_broadcast(&t->cond);
+    }
+    pthread_mutex_unlock(&t->mutex);
+
+    return NULL;
+}
+
+static int io_thread_start(URLContext *h)
+{
+    URLIOThread *t;
+    int ret;
+
+    if ((h->flags & AVIO_FLAG_READ_WRITE) == AVIO_FLAG_READ_WRITE ||
+        h->flags & AVIO_FLAG_NONBLOCK || h->max_packet_size ||
+        h->prot->url_read_pause || h->prot->url_read_seek) {
+        av_log(h, AV_LOG_WARNING,
+               "Background I/O is not supported by this protocol or mode\n");
+        return 0;
+    }
+
+    t = av_mallocz(sizeof(*t));
+    if (!t)
+        return AVERROR(ENOMEM);
+    atomic_init(&t->abort, 0);
+    t->nb_buffers = h->io_buffers;
+    t->buffer     = av_malloc_array(t->nb_buffers, IO_THREAD_BUFFER_SIZE);
+    t->fill       = av_malloc_array(t->nb_buffers, sizeof(*t->fill));
+    if (!t->buffer || !t->fill) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    if ((ret = pthread_mutex_init(&t->mutex, NULL))) {
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    if ((ret = pthread_cond_init(&t->cond, NULL))) {
+        pthread_mutex_destroy(&t->mutex);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+
+    h->io_thread = t;
+    if ((ret = pthread_create(&t->thread, NULL, io_thread_worker, h))) {
+        h->io_thread = NULL;
+        pthread_cond_destroy(&t->cond);
+        pthread_mutex_destroy(&t->mutex);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    return 0;
+fail:
+    av_freep(&t->buffer);
+    av_freep(&t->fill);
+    av_freep(&t);
+    return ret;
+}
+
+static int io_thread_stop(URLContext *h)
+{
+    URLIOThread *t = h->io_thread;
+    int ret;
+
+    pthread_mutex_lock(&t->mutex);
+    atomic_store(&t->abort, 1);
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
+    pthread_join(t->thread, NULL);
+
+    ret = h->flags & AVIO_FLAG_WRITE ? t->error : 0;
+
+    pthread_cond_destroy(&t->cond);
+    pthread_mutex_destroy(&t->mutex);
+    av_freep(&t->buffer);
+    av_freep(&t->fill);
+    av_freep(&h->io_thread);
+    return ret;
+}
+
+static int io_thread_read(URLContext *h, uint8_t *buf, int size, int size_min)
+{
+    URLIOThread *t = h->io_thread;
+    int len = 0;
+
+    pthread_mutex_lock(&t->mutex);
+    while (len < size) {
+        const uint8_t *src;
+        int n;
+
+        if (!t->count) {
+            if (len >= size_min || t->error)
+                break;
+            pthread_cond_wait(&t->cond, &t->mutex);
+            continue;
+        }
+        src = t->buffer + t->head * IO_THREAD_BUFFER_SIZE + t->head_pos;
+        n   = FFMIN(size - len, t->fill[t->head] - t->head_pos);
+        memcpy(buf + len, src, n);
+        len         += n;
+        t->head_pos += n;
+        if (t->head_pos == t->fill[t->head]) {
+            t->head     = (t->head + 1) % t->nb_buffers;
+            t->head_pos = 0;
+            t->count--;
+            pthread_cond_broadcast(&t->cond);
+        }
+    }
+    if (!len)
+        len = t->error;
+    pthread_mutex_unlock(&t->mutex);
+
+    return len;
+}
+
+static int io_thread_write(URLContext *h, const uint8_t *buf, int size)
+{
+    URLIOThread *t = h->io_thread;
+    int len = 0;
+
+    pthread_mutex_lock(&t->mutex);
+    while (len < size && !t->error) {
+        int slot, n;
+
+        if (t->count == t->nb_buffers) {
+            pthread_cond_wait(&t->cond, &t->mutex);
+            continue;
+        }
+        slot = (t->head + t->count) % t->nb_buffers;
+        n    = FFMIN(size - len, IO_THREAD_BUFFER_SIZE);
+        memcpy(t->buffer + slot * IO_THREAD_BUFFER_SIZE, buf + len, n);
+        t->fill[slot] = n;
+        t->count++;
+        len += n;
+        pthread_cond_broadcast(&t->cond);
+    }
+    if (t->error)
+        len = t->error;
+    pthread_mutex_unlock(&t->mutex);
+
+    return len;
+}
+
+/**
+ * Wait until the thread leaves the protocol alone and lock it out.
+ * Queued writes are completed first.
+ * @return the pending write error, if any
+ */
+static int io_thread_pause(URLContext *h)
+{
+    URLIOThread *t = h->io_thread;
+
+    pthread_mutex_lock(&t->mutex);
+    t->paused = 1;
+    if (h->flags & AVIO_FLAG_WRITE) {
+        while (t->count)
+            pthread_cond_wait(&t->cond, &t->mutex);
+    } else {
+        while (t->busy)
+            pthread_cond_wait(&t->cond, &t->mutex);
+    }
+    return h->flags & AVIO_FLAG_WRITE ? t->error : 0;
+}
+
+static void io_thread_resume(URLContext *h)
+{
+    URLIOThread *t = h->io_thread;
+
+    t->paused = 0;
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
+}
+
+static int64_t io_thread_seek(URLContext *h, int64_t pos, int whence)
+{
+    URLIOThread *t = h->io_thread;
+    int64_t ret;
+
+    if ((ret = io_thread_pause(h)) < 0)
+        goto end;
+
+    if (whence == SEEK_CUR && !(h->flags & AVIO_FLAG_WRITE)) {
+        /* the protocol is ahead of the caller by the queued data */
+        int i;
+        pos += t->head_pos;
+        for (i = 0; i < t->count; i++)
+            pos -= t->fill[(t->head + i) % t->nb_buffers];
+    }
+
+    ret = h->prot->url_seek(h, pos, whence);
+    if (ret >= 0 && whence != AVSEEK_SIZE) {
+        t->head     = 0;
+        t->head_pos = 0;
+        t->count    = 0;
+        t->error    = 0;
+    }
+end:
+    io_thread_resume(h);
+    return ret;
+}
+#else
+static void io_thread_hook_interrupt(URLContext *h)
+{
+}
+
+static int io_thread_start(URLContext *h)
+{
+    av_log(h, AV_LOG_WARNING, "Background I/O requires threading support\n");
+    return 0;
+}
+#endif
+
 int ffurl_read(URLContext *h, unsigned char *buf, int size)
 {
     if (!(h->flags & AVIO_FLAG_READ))
         return AVERROR(EIO);
+#if HAVE_THREADS
+    if (h->io_thread)
+        return io_thread_read(h, buf, size, 1);
+#endif
     return retry_transfer_wrapper(h, buf, size, 1, h->prot->url_read);
 }
 
@@ -414,6 +744,10 @@ int ffurl_read_complete(URLContext *h, unsigned char *buf, int size)
 {
     if (!(h->flags & AVIO_FLAG_READ))
         return AVERROR(EIO);
+#if HAVE_THREADS
+    if (h->io_thread)
+        return io_thread_read(h, buf, size, size);
+#endif
     return retry_transfer_wrapper(h, buf, size, size, h->prot->url_read);
 }
 
@@ -425,6 +759,10 @@ int ffurl_write(URLContext *h, const unsigned char *buf, int size)
     if (h->max_packet_size && size > h->max_packet_size)
         return AVERROR(EIO);
 
+#if HAVE_THREADS
+    if (h->io_thread)
+        return io_thread_write(h, buf, size);
+#endif
     return retry_transfer_wrapper(h, (unsigned char *)buf, size, size,
                                   (int (*)(struct URLContext *, uint8_t *, int))
                                   h->prot->url_write);
@@ -436,6 +774,10 @@ int64_t ffurl_seek(URLContext *h, int64_t pos, int whence)
 
     if (!h->prot->url_seek)
         return AVERROR(ENOSYS);
+#if HAVE_THREADS
+    if (h->io_thread)
+        return io_thread_seek(h, pos, whence & ~AVSEEK_FORCE);
+#endif
     ret = h->prot->url_seek(h, pos, whence & ~AVSEEK_FORCE);
     return ret;
 }
@@ -447,8 +789,15 @@ int ffurl_closep(URLContext **hh)
     if (!h)
         return 0;     /* can happen when ffurl_open fails */
 
-    if (h->is_connected && h->prot->url_close)
-        ret = h->prot->url_close(h);
+#if HAVE_THREADS
+    if (h->io_thread)
+        ret = io_thread_stop(h);
+#endif
+    if (h->is_connected && h->prot->url_close) {
+        int err = h->prot->url_close(h);
+        if (!ret)
+            ret = err;
+    }
 #if CONFIG_NETWORK
     if (h->prot->flags & URL_PROTOCOL_FLAG_NETWORK)
         ff_network_close();
@@ -653,10 +1002,27 @@ int ffurl_get_short_seek(URLContext *h)
     return h->prot->url_get_short_seek(h);
 }
 
+int ffurl_get_buffer_ref(URLContext *h, int64_t pos, int size,
+                         AVBufferRef **buf)
+{
+    if (!h || !h->prot || !h->prot->url_get_buffer_ref)
+        return AVERROR(ENOSYS);
+    return h->prot->url_get_buffer_ref(h, pos, size, buf);
+}
+
 int ffurl_shutdown(URLContext *h, int flags)
 {
     if (!h || !h->prot || !h->prot->url_shutdown)
         return AVERROR(ENOSYS);
+#if HAVE_THREADS
+    if (h->io_thread) {
+        int ret = io_thread_pause(h);
+        if (ret >= 0)
+            ret = h->prot->url_shutdown(h, flags);
+        io_thread_resume(h);
+        return ret;
+    }
+#endif
     return h->prot->url_shutdown(h, flags);
 }
 
@@ -83,6 +83,16 @@ uint64_t ffio_read_varlen(AVIOContext *bc);
  */
 int ffio_read_size(AVIOContext *s, unsigned char *buf, int size);
 
+/**
+ * Read size bytes from AVIOContext without copying them, if the underlying
+ * protocol supports it (e.g. the file protocol with the mmap option).
+ * On success *buf is a read-only reference to the data, padded with at least
+ * AV_INPUT_BUFFER_PADDING_SIZE zeroed bytes, and the read position is
+ * advanced by size. On failure the read position is left unchanged.
+ * @return size on success, a negative AVERROR code on failure
+ */
+int ffio_read_ref(AVIOContext *s, AVBufferRef **buf, int size);
+
 /** @warning must be called before any I/O */
 int ffio_set_buf_size(AVIOContext *s, int buf_size);
 
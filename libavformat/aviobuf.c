@@ -699,6 +699,28 @@ int ffio_read_size(AVIOContext *s, unsigned char *buf, int size)
     return ret;
 }
 
+int ffio_read_ref(AVIOContext *s, AVBufferRef **buf, int size)
+{
+    URLContext *h = ffio_geturlcontext(s);
+    int64_t pos, ret;
+
+    if (!h || s->write_flag || s->update_checksum || size <= 0)
+        return AVERROR(ENOSYS);
+
+    pos = avio_tell(s);
+    if (pos < 0)
+        return pos;
+    ret = ffurl_get_buffer_ref(h, pos, size, buf);
+    if (ret < 0)
+        return ret;
+    ret = avio_skip(s, size);
+    if (ret < 0) {
+        av_buffer_unref(buf);
+        return ret;
+    }
+    return size;
+}
+
 int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsigned char **data)
 {
     if (s->buf_end - s->buf_ptr >= size && !s->write_flag) {
@@ -19,6 +19,9 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE     /* Needed for MAP_ANONYMOUS with glibc */
+
 #include "libavutil/avstring.h"
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
@@ -35,6 +38,12 @@
 #endif
 #include <sys/stat.h>
 #include <stdlib.h>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
 #include "os_support.h"
 #include "url.h"
 
@@ -74,6 +83,13 @@ typedef struct FileContext {
     int blocksize;
     int follow;
     int seekable;
+    int use_mmap;
+    int64_t map_size;
+    int64_t page_size;
+    AVBufferRef *window;
+    int64_t window_start;
+    int64_t window_data_end;
+    int64_t window_end;
 #if HAVE_DIRENT_H
     DIR *dir;
 #endif
@@ -84,6 +100,7 @@ static const AVOption file_options[] = {
     { "blocksize", "set I/O operation maximum block size", offsetof(FileContext, blocksize), AV_OPT_TYPE_INT, { .i64 = INT_MAX }, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "seekable", "Sets if the file is seekable", offsetof(FileContext, seekable), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 0, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "mmap", "map the file into memory and return packet data without copying", offsetof(FileContext, use_mmap), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -205,6 +222,143 @@ static int file_move(URLContext *h_src, URLContext *h_dst)
 
 #if CONFIG_FILE_PROTOCOL
 
+#if HAVE_MMAP
+/* amount of the file mapped at once, packets within it share the mapping */
+#define MAP_WINDOW_SIZE (64 << 20)
+
+static void file_unmap(void *opaque, uint8_t *data)
+{
+    munmap(data, (size_t)(uintptr_t)opaque);
+}
+
+static int file_map_window(FileContext *c, int64_t pos, int64_t end)
+{
+    int64_t start, data_len;
+    size_t len;
+    uint8_t *map;
+    int ret;
+
+    start    = pos & ~(c->page_size - 1);
+    data_len = FFMIN(FFALIGN(FFMAX(MAP_WINDOW_SIZE, end - start), c->page_size),
+                     c->map_size - start);
+    len      = FFALIGN(data_len + AV_INPUT_BUFFER_PADDING_SIZE, c->page_size);
+
+    /* Reserve zeroed memory for the window and the padding of its last
+     * packet, and map the file over it. */
+    map = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED)
+        return AVERROR(errno);
+    if (mmap(map, FFALIGN(data_len, c->page_size), PROT_READ,
+             MAP_PRIVATE | MAP_FIXED, c->fd, start) == MAP_FAILED) {
+        ret = AVERROR(errno);
+        munmap(map, len);
+        return ret;
+    }
+
+    c->window = av_buffer_create(map, len, file_unmap, (void *)(uintptr_t)len,
+                                 AV_BUFFER_FLAG_READONLY);
+    if (!c->window) {
+        munmap(map, len);
+        return AVERROR(ENOMEM);
+    }
+    c->window_start    = start;
+    c->window_data_end = start + data_len;
+    c->window_end      = start + len;
+    return 0;
+}
+
+/**
+ * Map the pages holding a packet on their own, for packets followed by
+ * nonzero bytes in the window.
+ */
+static int file_map_packet(FileContext *c, int64_t pos, int size,
+                           AVBufferRef **buf)
+{
+    int64_t start, end, map_end;
+    size_t len;
+    uint8_t *map;
+    int ret;
+
+    start   = pos & ~(c->page_size - 1);
+    end     = pos + size;
+    map_end = FFALIGN(end, c->page_size);
+    len     = FFALIGN(end - start + AV_INPUT_BUFFER_PADDING_SIZE, c->page_size);
+
+    /* Reserve zeroed memory for the data and its padding, and map the
+     * pages of the file holding the data over it. */
+    map = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED)
+        return AVERROR(errno);
+    if (mmap(map, map_end - start, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_FIXED, c->fd, start) == MAP_FAILED) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+    /* The end of the last page holds the next bytes of the file, clear
+     * them in a private copy of the page so that the padding is zeroed. */
+    memset(map + (end - start), 0, map_end - end);
+    if (mprotect(map, map_end - start, PROT_READ) < 0) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+
+    *buf = av_buffer_create(map, len, file_unmap, (void *)(uintptr_t)len,
+                            AV_BUFFER_FLAG_READONLY);
+    if (!*buf) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    (*buf)->data += pos - start;
+    (*buf)->size  = size;
+    return 0;
+fail:
+    munmap(map, len);
+    return ret;
+}
+#endif
+
+static int file_get_buffer_ref(URLContext *h, int64_t pos, int size,
+                               AVBufferRef **buf)
+{
+#if HAVE_MMAP
+    FileContext *c = h->priv_data;
+    const uint8_t *pad;
+    int64_t end;
+    int i, ret;
+
+    if (!c->map_size)
+        return AVERROR(ENOSYS);
+    if (pos < 0 || size <= 0 || pos > c->map_size - size ||
+        size > INT_MAX - 2 * c->page_size - AV_INPUT_BUFFER_PADDING_SIZE)
+        return AVERROR(ERANGE);
+
+    end = pos + size;
+    if (!c->window || pos < c->window_start || end > c->window_data_end ||
+        end + AV_INPUT_BUFFER_PADDING_SIZE > c->window_end) {
+        av_buffer_unref(&c->window);
+        if ((ret = file_map_window(c, pos, end)) < 0)
+            return ret;
+    }
+
+    /* A view into the window has the following bytes of the file as its
+     * padding, which is only usable if they are zero. Past the end of the
+     * file they always are. */
+    pad = c->window->data + (end - c->window_start);
+    for (i = 0; i < FFMIN(AV_INPUT_BUFFER_PADDING_SIZE, c->window_data_end - end); i++)
+        if (pad[i])
+            return file_map_packet(c, pos, size, buf);
+
+    *buf = av_buffer_ref(c->window);
+    if (!*buf)
+        return AVERROR(ENOMEM);
+    (*buf)->data += pos - c->window_start;
+    (*buf)->size  = size;
+    return 0;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
+
 static int file_open(URLContext *h, const char *filename, int flags)
 {
     FileContext *c = h->priv_data;
@@ -243,6 +397,17 @@ static int file_open(URLContext *h, const char *filename, int flags)
     if (c->seekable >= 0)
         h->is_streamed = !c->seekable;
 
+    if (c->use_mmap) {
+#if HAVE_MMAP
+        if (!h->is_streamed && !c->follow && !(flags & AVIO_FLAG_WRITE) &&
+            !fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+            c->map_size  = st.st_size;
+            c->page_size = sysconf(_SC_PAGESIZE);
+        } else
+#endif
+            av_log(h, AV_LOG_WARNING, "Memory mapping is not supported for this file\n");
+    }
+
     return 0;
 }
 
@@ -266,6 +431,7 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
+    av_buffer_unref(&c->window);
     return close(c->fd);
 }
 
@@ -369,6 +535,7 @@ const URLProtocol ff_file_protocol = {
     .url_open_dir        = file_open_dir,
     .url_read_dir        = file_read_dir,
     .url_close_dir       = file_close_dir,
+    .url_get_buffer_ref  = file_get_buffer_ref,
     .default_whitelist   = "file,crypto,data"
 };
 
@@ -41,6 +41,7 @@
 #include "libavutil/random_seed.h"
 #include "libavutil/opt.h"
 #include "libavutil/log.h"
+#include "libavutil/thread.h"
 #include "libavutil/time_internal.h"
 
 #include "avformat.h"
@@ -102,6 +103,7 @@ typedef enum HLSFlags {
     HLS_PERIODIC_REKEY = (1 << 12),
     HLS_INDEPENDENT_SEGMENTS = (1 << 13),
     HLS_I_FRAMES_ONLY = (1 << 14),
+    HLS_ASYNC_IO = (1 << 15), // finalize segments and playlists on a per variant I/O thread
 } HLSFlags;
 
 typedef enum {
@@ -109,6 +111,33 @@ typedef enum {
     SEGMENT_TYPE_FMP4,
 } SegmentType;
 
+/**
+ * Deferred I/O operation executed by a variant's I/O thread: write data to
+ * filename, rename filename to new_filename, or delete filename.
+ */
+typedef struct HLSIOJob {
+    char *filename;
+    char *new_filename;
+    AVDictionary *options;
+    uint8_t *data;
+    int size;
+    int delete;
+    struct HLSIOJob *next;
+} HLSIOJob;
+
+typedef struct HLSIOThread {
+    AVFormatContext *s;
+#if HAVE_THREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+    HLSIOJob *first;
+    HLSIOJob *last;
+    int finish;
+    int error;
+} HLSIOThread;
+
 typedef struct VariantStream {
     unsigned var_stream_idx;
     unsigned number;
@@ -167,6 +196,7 @@ typedef struct VariantStream {
     char *ccgroup; /* closed caption group name */
     char *baseurl;
     char *varname; // variant name
+    HLSIOThread *io; // I/O thread used with the async_io flag, NULL otherwise
 } VariantStream;
 
 typedef struct ClosedCaptionsStream {
@@ -285,6 +315,234 @@ static int hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename)
     return ret;
 }
 
+static void hls_io_free_job(HLSIOJob **pjob)
+{
+    HLSIOJob *job = *pjob;
+
+    if (!job)
+        return;
+    av_freep(&job->filename);
+    av_freep(&job->new_filename);
+    av_freep(&job->data);
+    av_dict_free(&job->options);
+    av_freep(pjob);
+}
+
+static HLSIOJob *hls_io_alloc_job(AVDictionary *options, int delete)
+{
+    HLSIOJob *job = av_mallocz(sizeof(*job));
+
+    if (!job)
+        return NULL;
+    job->delete = delete;
+    if (av_dict_copy(&job->options, options, 0) < 0)
+        hls_io_free_job(&job);
+    return job;
+}
+
+static int hls_io_run_job(AVFormatContext *s, HLSIOJob *job)
+{
+    AVIOContext *pb = NULL;
+    int ret;
+
+    if (job->new_filename)
+        return ff_rename(job->filename, job->new_filename, s);
+
+    if (job->delete) {
+        if (unlink(job->filename) < 0)
+            av_log(s, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
+                   job->filename, av_err2str(AVERROR(errno)));
+        return 0;
+    }
+
+    ret = s->io_open(s, &pb, job->filename, AVIO_FLAG_WRITE, &job->options);
+    if (ret < 0) {
+        av_log(s, AV_LOG_ERROR, "Failed to open file '%s'\n", job->filename);
+        return ret;
+    }
+    avio_write(pb, job->data, job->size);
+    avio_flush(pb);
+    ret = pb->error;
+    ff_format_io_close(s, &pb);
+    if (ret < 0)
+        av_log(s, AV_LOG_ERROR, "Failed to write file '%s'\n", job->filename);
+    return ret;
+}
+
+#if HAVE_THREADS
+static void *hls_io_thread(void *arg)
+{
+    HLSIOThread *io = arg;
+
+    pthread_mutex_lock(&io->lock);
+    for (;;) {
+        HLSIOJob *job;
+        int ret;
+
+        while (!io->first && !io->finish)
+            pthread_cond_wait(&io->cond, &io->lock);
+        if (!io->first)
+            break;
+        job = io->first;
+        io->first = job->next;
+        if (!io->first)
+            io->last = NULL;
+        pthread_mutex_unlock(&io->lock);
+
+        ret = hls_io_run_job(io->s, job);
+        hls_io_free_job(&job);
+
+        pthread_mutex_lock(&io->lock);
+        if (ret < 0 && !io->error)
+            io->error = ret;
+    }
+    pthread_mutex_unlock(&io->lock);
+
+    return NULL;
+}
+#endif
+
+static int hls_io_thread_start(AVFormatContext *s, VariantStream *vs)
+{
+#if HAVE_THREADS
+    HLSIOThread *io = av_mallocz(sizeof(*io));
+    int ret;
+
+    if (!io)
+        return AVERROR(ENOMEM);
+    io->s = s;
+
+    if ((ret = pthread_mutex_init(&io->lock, NULL))) {
+        av_free(io);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&io->cond, NULL))) {
+        pthread_mutex_destroy(&io->lock);
+        av_free(io);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_create(&io->thread, NULL, hls_io_thread, io))) {
+        av_log(s, AV_LOG_ERROR, "Failed to create I/O thread: %s\n",
+               av_err2str(AVERROR(ret)));
+        pthread_cond_destroy(&io->cond);
+        pthread_mutex_destroy(&io->lock);
+        av_free(io);
+        return AVERROR(ret);
+    }
+    vs->io = io;
+#else
+    av_log(s, AV_LOG_WARNING, "async_io requires thread support, "
+           "writing segments synchronously\n");
+#endif
+    return 0;
+}
+
+/* Wait for all pending operations and return the first error, if any. */
+static int hls_io_thread_stop(VariantStream *vs)
+{
+    HLSIOThread *io = vs->io;
+    int ret;
+
+    if (!io)
+        return 0;
+#if HAVE_THREADS
+    pthread_mutex_lock(&io->lock);
+    io->finish = 1;
+    pthread_cond_signal(&io->cond);
+    pthread_mutex_unlock(&io->lock);
+    pthread_join(io->thread, NULL);
+    pthread_cond_destroy(&io->cond);
+    pthread_mutex_destroy(&io->lock);
+#endif
+    ret = io->error;
+    av_freep(&vs->io);
+    return ret;
+}
+
+/* Return and clear the first error of the operations completed so far. */
+static int hls_io_check_error(VariantStream *vs)
+{
+    int ret = 0;
+
+    if (!vs->io)
+        return 0;
+#if HAVE_THREADS
+    pthread_mutex_lock(&vs->io->lock);
+    ret = vs->io->error;
+    vs->io->error = 0;
+    pthread_mutex_unlock(&vs->io->lock);
+#endif
+    return ret;
+}
+
+static int hls_io_submit(VariantStream *vs, HLSIOJob *job,
+                         const char *filename, const char *new_filename)
+{
+    if (!job)
+        return AVERROR(ENOMEM);
+    job->filename = av_strdup(filename);
+    if (new_filename)
+        job->new_filename = av_strdup(new_filename);
+    if (!job->filename || (new_filename && !job->new_filename)) {
+        hls_io_free_job(&job);
+        return AVERROR(ENOMEM);
+    }
+
+#if HAVE_THREADS
+    pthread_mutex_lock(&vs->io->lock);
+    if (vs->io->last)
+        vs->io->last->next = job;
+    else
+        vs->io->first = job;
+    vs->io->last = job;
+    pthread_cond_signal(&vs->io->cond);
+    pthread_mutex_unlock(&vs->io->lock);
+#else
+    hls_io_free_job(&job);
+#endif
+    return 0;
+}
+
+/**
+ * Open an output for a segment or playlist. With an I/O thread the data is
+ * collected in memory and written out by hls_out_close().
+ */
+static int hls_out_open(AVFormatContext *s, VariantStream *vs, AVIOContext **pb,
+                        char *filename, AVDictionary **options)
+{
+    if (vs->io)
+        return avio_open_dyn_buf(pb);
+    return hlsenc_io_open(s, pb, filename, options);
+}
+
+static int hls_out_close(AVFormatContext *s, VariantStream *vs, AVIOContext **pb,
+                         char *filename, AVDictionary *options)
+{
+    HLSIOJob *job;
+
+    if (!vs->io)
+        return hlsenc_io_close(s, pb, filename);
+    if (!*pb)
+        return 0;
+
+    job = hls_io_alloc_job(options, 0);
+    if (!job) {
+        ffio_free_dyn_buf(pb);
+        return AVERROR(ENOMEM);
+    }
+    job->size = avio_close_dyn_buf(*pb, &job->data);
+    *pb = NULL;
+    return hls_io_submit(vs, job, filename, NULL);
+}
+
+static int hls_rename(AVFormatContext *s, VariantStream *vs,
+                      const char *url_src, const char *url_dst)
+{
+    if (!vs->io)
+        return ff_rename(url_src, url_dst, s);
+    return hls_io_submit(vs, hls_io_alloc_job(NULL, 0), url_src, url_dst);
+}
+
 static void set_http_options(AVFormatContext *s, AVDictionary **options, HLSContext *c)
 {
     int http_base_proto = ff_is_http_proto(s->url);
@@ -567,12 +825,18 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
         proto = avio_find_protocol_name(s->url);
         if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
             av_dict_set(&options, "method", "DELETE", 0);
-            if ((ret = vs->avf->io_open(vs->avf, &out, path, AVIO_FLAG_WRITE, &options)) < 0) {
+            if (vs->io) {
+                if ((ret = hls_io_submit(vs, hls_io_alloc_job(options, 0), path, NULL)) < 0)
+                    goto fail;
+            } else if ((ret = vs->avf->io_open(vs->avf, &out, path, AVIO_FLAG_WRITE, &options)) < 0) {
                 if (hls->ignore_io_errors)
                     ret = 0;
                 goto fail;
             }
             ff_format_io_close(vs->avf, &out);
+        } else if (vs->io) {
+            if ((ret = hls_io_submit(vs, hls_io_alloc_job(NULL, 1), path, NULL)) < 0)
+                goto fail;
         } else if (unlink(path) < 0) {
             av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                    path, strerror(errno));
@@ -594,13 +858,23 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
 
             if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
                 av_dict_set(&options, "method", "DELETE", 0);
-                if ((ret = vs->vtt_avf->io_open(vs->vtt_avf, &out, sub_path, AVIO_FLAG_WRITE, &options)) < 0) {
+                if (vs->io) {
+                    if ((ret = hls_io_submit(vs, hls_io_alloc_job(options, 0), sub_path, NULL)) < 0) {
+                        av_freep(&sub_path);
+                        goto fail;
+                    }
+                } else if ((ret = vs->vtt_avf->io_open(vs->vtt_avf, &out, sub_path, AVIO_FLAG_WRITE, &options)) < 0) {
                     if (hls->ignore_io_errors)
                         ret = 0;
                     av_freep(&sub_path);
                     goto fail;
                 }
                 ff_format_io_close(vs->vtt_avf, &out);
+            } else if (vs->io) {
+                if ((ret = hls_io_submit(vs, hls_io_alloc_job(NULL, 1), sub_path, NULL)) < 0) {
+                    av_freep(&sub_path);
+                    goto fail;
+                }
             } else if (unlink(sub_path) < 0) {
                 av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                        sub_path, strerror(errno));
@@ -982,10 +1256,10 @@ static int sls_flag_check_duration_size(HLSContext *hls, VariantStream *vs)
     return ret;
 }
 
-static void sls_flag_file_rename(HLSContext *hls, VariantStream *vs, char *old_filename) {
+static void sls_flag_file_rename(AVFormatContext *s, HLSContext *hls, VariantStream *vs, char *old_filename) {
     if ((hls->flags & (HLS_SECOND_LEVEL_SEGMENT_SIZE | HLS_SECOND_LEVEL_SEGMENT_DURATION)) &&
         strlen(vs->current_segment_final_filename_fmt)) {
-        ff_rename(old_filename, vs->avf->url, hls);
+        hls_rename(s, vs, old_filename, vs->avf->url);
     }
 }
 
@@ -1230,7 +1504,7 @@ static void hls_free_segments(HLSSegment *p)
     }
 }
 
-static int hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
+static int hls_rename_temp_file(AVFormatContext *s, VariantStream *vs, AVFormatContext *oc)
 {
     size_t len = strlen(oc->url);
     char *final_filename = av_strdup(oc->url);
@@ -1239,7 +1513,7 @@ static int hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
     if (!final_filename)
         return AVERROR(ENOMEM);
     final_filename[len-4] = '\0';
-    ret = ff_rename(oc->url, final_filename, s);
+    ret = hls_rename(s, vs, oc->url, final_filename);
     oc->url[len-4] = '\0';
     av_freep(&final_filename);
     return ret;
@@ -1439,7 +1713,7 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     int target_duration = 0;
     int ret = 0;
     char temp_filename[MAX_URL_SIZE];
-    char temp_vtt_filename[MAX_URL_SIZE];
+    char temp_vtt_filename[MAX_URL_SIZE] = "";
     int64_t sequence = FFMAX(hls->start_sequence, vs->sequence - vs->nb_entries);
     const char *proto = avio_find_protocol_name(vs->m3u8_name);
     int is_file_proto = proto && !strcmp(proto, "file");
@@ -1471,7 +1745,7 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 
     set_http_options(s, &options, hls);
     snprintf(temp_filename, sizeof(temp_filename), use_temp_file ? "%s.tmp" : "%s", vs->m3u8_name);
-    if ((ret = hlsenc_io_open(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename, &options)) < 0) {
+    if ((ret = hls_out_open(s, vs, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename, &options)) < 0) {
         if (hls->ignore_io_errors)
             ret = 0;
         goto fail;
@@ -1523,7 +1797,7 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 
     if (vs->vtt_m3u8_name) {
         snprintf(temp_vtt_filename, sizeof(temp_vtt_filename), use_temp_file ? "%s.tmp" : "%s", vs->vtt_m3u8_name);
-        if ((ret = hlsenc_io_open(s, &hls->sub_m3u8_out, temp_vtt_filename, &options)) < 0) {
+        if ((ret = hls_out_open(s, vs, &hls->sub_m3u8_out, temp_vtt_filename, &options)) < 0) {
             if (hls->ignore_io_errors)
                 ret = 0;
             goto fail;
@@ -1545,16 +1819,17 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     }
 
 fail:
-    av_dict_free(&options);
-    ret = hlsenc_io_close(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename);
+    ret = hls_out_close(s, vs, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename, options);
     if (ret < 0) {
+        av_dict_free(&options);
         return ret;
     }
-    hlsenc_io_close(s, &hls->sub_m3u8_out, vs->vtt_m3u8_name);
+    hls_out_close(s, vs, &hls->sub_m3u8_out, temp_vtt_filename, options);
+    av_dict_free(&options);
     if (use_temp_file) {
-        ff_rename(temp_filename, vs->m3u8_name, s);
+        hls_rename(s, vs, temp_filename, vs->m3u8_name);
         if (vs->vtt_m3u8_name)
-            ff_rename(temp_vtt_filename, vs->vtt_m3u8_name, s);
+            hls_rename(s, vs, temp_vtt_filename, vs->vtt_m3u8_name);
     }
     if (ret >= 0 && hls->master_pl_name)
         if (create_master_playlist(s, vs) < 0)
@@ -2326,6 +2601,12 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         int64_t new_start_pos;
         int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
 
+        /* Report failures of the previous segment's background I/O. */
+        ret = hls_io_check_error(vs);
+        if (ret < 0 && !hls->ignore_io_errors)
+            return ret;
+        ret = 0;
+
         av_write_frame(oc, NULL); /* Flush any buffered data */
         new_start_pos = avio_tell(oc->pb);
         vs->size = new_start_pos - vs->start_pos;
@@ -2384,7 +2665,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
 
                 set_http_options(s, &options, hls);
 
-                ret = hlsenc_io_open(s, &vs->out, filename, &options);
+                ret = hls_out_open(s, vs, &vs->out, filename, &options);
                 if (ret < 0) {
                     av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
                            "Failed to open file '%s'\n", filename);
@@ -2399,8 +2680,8 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                     av_dict_free(&options);
                     return ret;
                 }
-                ret = hlsenc_io_close(s, &vs->out, filename);
-                if (ret < 0) {
+                ret = hls_out_close(s, vs, &vs->out, filename, options);
+                if (ret < 0 && !vs->io) {
                     av_log(s, AV_LOG_WARNING, "upload segment failed,"
                            " will retry with a new http session.\n");
                     ff_format_io_close(s, &vs->out);
@@ -2415,7 +2696,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         }
 
         if (use_temp_file && !(hls->flags & HLS_SINGLE_FILE)) {
-            hls_rename_temp_file(s, oc);
+            hls_rename_temp_file(s, vs, oc);
         }
 
         old_filename = av_strdup(oc->url);
@@ -2453,7 +2734,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
             vs->start_pos = new_start_pos;
             if (vs->size >= hls->max_seg_size) {
                 vs->sequence++;
-                sls_flag_file_rename(hls, vs, old_filename);
+                sls_flag_file_rename(s, hls, vs, old_filename);
                 ret = hls_start(s, vs);
                 vs->start_pos = 0;
                 /* When split segment by byte, the duration is short than hls_time,
@@ -2463,7 +2744,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
             vs->number++;
         } else {
             vs->start_pos = new_start_pos;
-            sls_flag_file_rename(hls, vs, old_filename);
+            sls_flag_file_rename(s, hls, vs, old_filename);
             ret = hls_start(s, vs);
         }
         av_freep(&old_filename);
@@ -2532,11 +2813,23 @@ static int hls_write_trailer(struct AVFormatContext *s)
     const char *proto = NULL;
     int use_temp_file = 0;
     int i;
-    int ret = 0;
+    int ret = 0, err = 0;
     VariantStream *vs = NULL;
     AVDictionary *options = NULL;
     int range_length, byterange_mode;
 
+    /* Finish the pending background I/O, the last segment and playlist
+     * are written synchronously. */
+    for (i = 0; i < hls->nb_varstreams; i++) {
+        ret = hls_io_thread_stop(&hls->var_streams[i]);
+        if (ret < 0) {
+            av_log(s, AV_LOG_ERROR, "Background I/O failed: %s\n", av_err2str(ret));
+            if (!err && !hls->ignore_io_errors)
+                err = ret;
+        }
+    }
+    ret = 0;
+
     for (i = 0; i < hls->nb_varstreams; i++) {
         char *filename = NULL;
         vs = &hls->var_streams[i];
@@ -2622,7 +2915,7 @@ failed:
 
         // rename that segment from .tmp to the real one
         if (use_temp_file && !(hls->flags & HLS_SINGLE_FILE)) {
-            hls_rename_temp_file(s, oc);
+            hls_rename_temp_file(s, vs, oc);
             av_freep(&old_filename);
             old_filename = av_strdup(oc->url);
 
@@ -2634,7 +2927,7 @@ failed:
         /* after av_write_trailer, then duration + 1 duration per packet */
         hls_append_segment(s, hls, vs, vs->duration + vs->dpp, vs->start_pos, vs->size);
 
-        sls_flag_file_rename(hls, vs, old_filename);
+        sls_flag_file_rename(s, hls, vs, old_filename);
 
         if (vtt_oc) {
             if (vtt_oc->pb)
@@ -2668,9 +2961,20 @@ failed:
     av_freep(&hls->var_streams);
     av_freep(&hls->cc_streams);
     av_freep(&hls->master_m3u8_url);
-    return 0;
+    return err;
 }
 
+static void hls_deinit(AVFormatContext *s)
+{
+    HLSContext *hls = s->priv_data;
+    int i;
+
+    /* Only reached with live I/O threads if the trailer was not written. */
+    if (!hls->var_streams)
+        return;
+    for (i = 0; i < hls->nb_varstreams; i++)
+        hls_io_thread_stop(&hls->var_streams[i]);
+}
 
 static int hls_init(AVFormatContext *s)
 {
@@ -2961,12 +3265,29 @@ static int hls_init(AVFormatContext *s)
             }
         }
 
+        if (hls->flags & HLS_ASYNC_IO) {
+            if ((hls->flags & HLS_SINGLE_FILE) || hls->max_seg_size > 0 || hls->http_persistent) {
+                av_log(s, AV_LOG_WARNING, "async_io cannot be used with single_file, "
+                       "hls_segment_size or http_persistent, ignoring\n");
+                hls->flags &= ~HLS_ASYNC_IO;
+            } else if (!ff_format_io_is_default(s)) {
+                /* custom I/O callbacks are not required to be thread-safe */
+                av_log(s, AV_LOG_WARNING, "async_io cannot be used with custom "
+                       "I/O callbacks, writing segments synchronously\n");
+                hls->flags &= ~HLS_ASYNC_IO;
+            } else if ((ret = hls_io_thread_start(s, vs)) < 0) {
+                goto fail;
+            }
+        }
+
         if ((ret = hls_start(s, vs)) < 0)
             goto fail;
     }
 
 fail:
     if (ret < 0) {
+        for (i = 0; i < hls->nb_varstreams; i++)
+            hls_io_thread_stop(&hls->var_streams[i]);
         hls_free_variant_streams(hls);
         for (i = 0; i < hls->nb_ccstreams; i++) {
             ClosedCaptionsStream *ccs = &hls->cc_streams[i];
@@ -3026,6 +3347,7 @@ static const AVOption options[] = {
     {"periodic_rekey", "reload keyinfo file periodically for re-keying", 0, AV_OPT_TYPE_CONST, {.i64 = HLS_PERIODIC_REKEY }, 0, UINT_MAX,   E, "flags"},
     {"independent_segments", "add EXT-X-INDEPENDENT-SEGMENTS, whenever applicable", 0, AV_OPT_TYPE_CONST, { .i64 = HLS_INDEPENDENT_SEGMENTS }, 0, UINT_MAX, E, "flags"},
     {"iframes_only", "add EXT-X-I-FRAMES-ONLY, whenever applicable", 0, AV_OPT_TYPE_CONST, { .i64 = HLS_I_FRAMES_ONLY }, 0, UINT_MAX, E, "flags"},
+    {"async_io", "write segments and playlists and rename files on per variant I/O threads", 0, AV_OPT_TYPE_CONST, { .i64 = HLS_ASYNC_IO }, 0, UINT_MAX, E, "flags"},
 #if FF_API_HLS_USE_LOCALTIME
     {"use_localtime", "set filename expansion with strftime at segment creation(will be deprecated )", OFFSET(use_localtime), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
 #endif
@@ -3075,5 +3397,6 @@ AVOutputFormat ff_hls_muxer = {
     .write_header   = hls_write_header,
     .write_packet   = hls_write_packet,
     .write_trailer  = hls_write_trailer,
+    .deinit         = hls_deinit,
     .priv_class     = &hls_class,
 };
@@ -0,0 +1,426 @@
+/*
+ * Persistent demuxer index cache
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Sidecar file holding the index entries and timings of an input, so that
+ * they do not have to be rebuilt every time the same input is opened.
+ *
+ * Layout, all values big-endian:
+ *   tag 'FFIC', version
+ *   url, demuxer name (32-bit length + bytes)
+ *   file size (64), CRC-32 of the first KEY_SIZE bytes (32)
+ *   has timings (8), start time, duration, bit rate (64), estimation method (8)
+ *   number of streams (32), then for every stream:
+ *     id (32), time base (32 + 32), start time, duration (64),
+ *     number of index entries (32), then for every entry:
+ *       pos, timestamp (64), size << 2 | flags (32), min_distance (32)
+ */
+
+#include "libavutil/crc.h"
+#include "libavutil/mem.h"
+#include "avformat.h"
+#include "avio_internal.h"
+#include "indexcache.h"
+#include "internal.h"
+
+#define CACHE_TAG     MKBETAG('F', 'F', 'I', 'C')
+#define CACHE_VERSION 1
+#define KEY_SIZE      65536 ///< bytes at the start of the input covered by the key
+#define MAX_STRING    4096
+#define ENTRY_SIZE    24    ///< size of one index entry in the file
+
+typedef struct IndexCacheStream {
+    int id;
+    AVRational time_base;
+    int64_t start_time;
+    int64_t duration;
+    AVIndexEntry *entries;
+    int nb_entries;
+    int restored;                   ///< entries were installed in the stream
+} IndexCacheStream;
+
+typedef struct IndexCache {
+    int64_t  file_size;
+    uint32_t crc;
+    int valid;                      ///< the cache file matches the input
+    int estimated;                  ///< the timings of this session are known
+    int has_timings;                ///< the cache file holds timings
+    int64_t start_time;
+    int64_t duration;
+    int64_t bit_rate;
+    int duration_estimation_method;
+    IndexCacheStream *streams;
+    int nb_streams;
+} IndexCache;
+
+static void free_streams(IndexCache *c)
+{
+    int i;
+
+    for (i = 0; i < c->nb_streams; i++)
+        av_freep(&c->streams[i].entries);
+    av_freep(&c->streams);
+    c->nb_streams = 0;
+}
+
+void ff_index_cache_free(AVFormatContext *s)
+{
+    IndexCache *c = s->internal->index_cache;
+
+    if (!c)
+        return;
+    free_streams(c);
+    av_freep(&s->internal->index_cache);
+}
+
+static int compute_key(AVFormatContext *s, IndexCache *c)
+{
+    AVIOContext *pb = s->pb;
+    int64_t pos     = avio_tell(pb);
+    uint8_t *buf;
+    int len, ret;
+
+    c->file_size = avio_size(pb);
+    if (c->file_size < 0)
+        return c->file_size;
+
+    buf = av_malloc(KEY_SIZE);
+    if (!buf)
+        return AVERROR(ENOMEM);
+
+    ret = avio_seek(pb, 0, SEEK_SET);
+    if (ret >= 0) {
+        len = avio_read(pb, buf, FFMIN(KEY_SIZE, c->file_size));
+        if (len < 0)
+            ret = len;
+        else
+            c->crc = av_crc(av_crc_get_table(AV_CRC_32_IEEE_LE), UINT32_MAX, buf, len);
+    }
+    av_free(buf);
+
+    if (avio_seek(pb, pos, SEEK_SET) < 0)
+        return AVERROR(EIO);
+    return ret < 0 ? ret : 0;
+}
+
+static int match_string(AVIOContext *pb, const char *str)
+{
+    unsigned len = avio_rb32(pb);
+    char buf[MAX_STRING];
+
+    if (len >= MAX_STRING || avio_read(pb, buf, len) != len)
+        return 0;
+    buf[len] = 0;
+    return !strcmp(buf, str);
+}
+
+static void write_string(AVIOContext *pb, const char *str)
+{
+    avio_wb32(pb, strlen(str));
+    avio_write(pb, str, strlen(str));
+}
+
+/**
+ * @return 1 if the cache matches the input, 0 if it is stale,
+ *         a negative error code if it is damaged
+ */
+static int read_cache(AVFormatContext *s, IndexCache *c, AVIOContext *pb)
+{
+    int64_t size = avio_size(pb);
+    int i, j;
+
+    if (avio_rb32(pb) != CACHE_TAG || avio_rb32(pb) != CACHE_VERSION)
+        return AVERROR_INVALIDDATA;
+
+    if (!match_string(pb, s->url) || !match_string(pb, s->iformat->name) ||
+        avio_rb64(pb) != c->file_size || avio_rb32(pb) != c->crc)
+        return 0;
+
+    c->has_timings = avio_r8(pb);
+    c->start_time  = avio_rb64(pb);
+    c->duration    = avio_rb64(pb);
+    c->bit_rate    = avio_rb64(pb);
+    c->duration_estimation_method = avio_r8(pb);
+
+    c->nb_streams = avio_rb32(pb);
+    if (c->nb_streams > s->max_streams) {
+        c->nb_streams = 0;
+        return AVERROR_INVALIDDATA;
+    }
+    c->streams = av_calloc(c->nb_streams, sizeof(*c->streams));
+    if (!c->streams) {
+        c->nb_streams = 0;
+        return AVERROR(ENOMEM);
+    }
+
+    for (i = 0; i < c->nb_streams; i++) {
+        IndexCacheStream *cst = &c->streams[i];
+
+        cst->id             = avio_rb32(pb);
+        cst->time_base.num  = avio_rb32(pb);
+        cst->time_base.den  = avio_rb32(pb);
+        cst->start_time     = avio_rb64(pb);
+        cst->duration       = avio_rb64(pb);
+        cst->nb_entries     = avio_rb32(pb);
+        if (cst->nb_entries < 0 ||
+            cst->nb_entries > (size - avio_tell(pb)) / ENTRY_SIZE)
+            return AVERROR_INVALIDDATA;
+
+        cst->entries = av_malloc_array(cst->nb_entries, sizeof(*cst->entries));
+        if (!cst->entries)
+            return AVERROR(ENOMEM);
+
+        for (j = 0; j < cst->nb_entries; j++) {
+            AVIndexEntry *e = &cst->entries[j];
+            unsigned size_flags;
+
+            e->pos          = avio_rb64(pb);
+            e->timestamp    = avio_rb64(pb);
+            size_flags      = avio_rb32(pb);
+            e->size         = size_flags >> 2;
+            e->flags        = size_flags & 3;
+            e->min_distance = avio_rb32(pb);
+
+            /* keep the invariants of ff_add_index_entry() */
+            if (e->timestamp == AV_NOPTS_VALUE ||
+                (j && e->timestamp <= e[-1].timestamp) ||
+                e->pos < 0 || e->pos >= c->file_size ||
+                e->size > c->file_size - e->pos)
+                return AVERROR_INVALIDDATA;
+        }
+    }
+
+    if (pb->eof_reached || pb->error)
+        return AVERROR_INVALIDDATA;
+
+    return 1;
+}
+
+static int stream_matches(const IndexCache *c, const AVStream *st)
+{
+    const IndexCacheStream *cst;
+
+    if (st->index >= c->nb_streams)
+        return 0;
+    cst = &c->streams[st->index];
+    return cst->id == st->id && !av_cmp_q(cst->time_base, st->time_base);
+}
+
+static int restore_index(IndexCache *c, AVStream *st)
+{
+    IndexCacheStream *cst;
+    AVIndexEntry *entries;
+
+    if (!stream_matches(c, st))
+        return 0;
+    cst = &c->streams[st->index];
+    if (cst->restored || cst->nb_entries <= st->nb_index_entries)
+        return 0;
+
+    entries = av_fast_realloc(st->index_entries, &st->index_entries_allocated_size,
+                              cst->nb_entries * sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+
+    memcpy(entries, cst->entries, cst->nb_entries * sizeof(*entries));
+    st->index_entries    = entries;
+    st->nb_index_entries = cst->nb_entries;
+    cst->restored        = 1;
+
+    return 1;
+}
+
+void ff_index_cache_load(AVFormatContext *s)
+{
+    AVIOContext *pb = NULL;
+    IndexCache *c;
+    int i, ret, restored = 0;
+
+    if (!s->index_cache || !s->pb || s->iformat->flags & AVFMT_NOFILE ||
+        !(s->pb->seekable & AVIO_SEEKABLE_NORMAL))
+        return;
+
+    c = s->internal->index_cache = av_mallocz(sizeof(*c));
+    if (!c)
+        return;
+
+    if (compute_key(s, c) < 0) {
+        av_log(s, AV_LOG_WARNING, "Cannot identify the input, index cache disabled\n");
+        ff_index_cache_free(s);
+        return;
+    }
+
+    /* a missing file is not an error, it is written when the input is closed */
+    if (ffio_open_whitelist(&pb, s->index_cache, AVIO_FLAG_READ, &s->interrupt_callback,
+                            NULL, s->protocol_whitelist, s->protocol_blacklist) < 0)
+        return;
+
+    ret = read_cache(s, c, pb);
+    avio_closep(&pb);
+    if (ret <= 0) {
+        av_log(s, AV_LOG_VERBOSE, "Index cache '%s' is %s, ignoring it\n",
+               s->index_cache, ret < 0 ? "damaged" : "stale");
+        free_streams(c);
+        return;
+    }
+    c->valid = 1;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        ret = restore_index(c, s->streams[i]);
+        if (ret < 0)
+            return;
+        restored += ret;
+    }
+
+    av_log(s, AV_LOG_VERBOSE, "Restored the index of %d streams from '%s'\n",
+           restored, s->index_cache);
+}
+
+int ff_index_cache_restore_timings(AVFormatContext *s)
+{
+    IndexCache *c = s->internal->index_cache;
+    int i;
+
+    if (!c || !c->valid || !c->has_timings || c->nb_streams != s->nb_streams)
+        return 0;
+
+    for (i = 0; i < s->nb_streams; i++)
+        if (!stream_matches(c, s->streams[i]))
+            return 0;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+
+        /* streams created after read_header() */
+        if (restore_index(c, st) < 0)
+            return 0;
+
+        st->start_time = c->streams[i].start_time;
+        st->duration   = c->streams[i].duration;
+    }
+
+    s->start_time = c->start_time;
+    s->duration   = c->duration;
+    s->bit_rate   = c->bit_rate;
+    s->duration_estimation_method = c->duration_estimation_method;
+
+    return 1;
+}
+
+void ff_index_cache_timings_estimated(AVFormatContext *s)
+{
+    IndexCache *c = s->internal->index_cache;
+
+    if (c)
+        c->estimated = 1;
+}
+
+int ff_index_cache_restored(AVFormatContext *s, AVStream *st)
+{
+    IndexCache *c = s->internal->index_cache;
+
+    return c && c->valid && stream_matches(c, st) && c->streams[st->index].restored;
+}
+
+static int cache_is_current(AVFormatContext *s, IndexCache *c)
+{
+    int i;
+
+    if (!c->valid || c->nb_streams != s->nb_streams ||
+        (c->estimated && !c->has_timings))
+        return 0;
+
+    for (i = 0; i < s->nb_streams; i++)
+        if (s->streams[i]->nb_index_entries > c->streams[i].nb_entries)
+            return 0;
+
+    return 1;
+}
+
+void ff_index_cache_save(AVFormatContext *s)
+{
+    IndexCache *c = s->internal->index_cache;
+    /* keep the timings of the cache if this session did not estimate them */
+    int old_timings;
+    AVIOContext *pb = NULL;
+    char *tmp;
+    int i, j, ret;
+
+    if (!c || !s->iformat || cache_is_current(s, c))
+        return;
+
+    old_timings = !c->estimated && c->valid && c->has_timings &&
+                  c->nb_streams == s->nb_streams;
+
+    tmp = av_asprintf("%s.tmp", s->index_cache);
+    if (!tmp)
+        return;
+
+    ret = ffio_open_whitelist(&pb, tmp, AVIO_FLAG_WRITE, &s->interrupt_callback,
+                              NULL, s->protocol_whitelist, s->protocol_blacklist);
+    if (ret < 0) {
+        av_log(s, AV_LOG_WARNING, "Cannot write index cache '%s'\n", tmp);
+        goto end;
+    }
+
+    avio_wb32(pb, CACHE_TAG);
+    avio_wb32(pb, CACHE_VERSION);
+    write_string(pb, s->url);
+    write_string(pb, s->iformat->name);
+    avio_wb64(pb, c->file_size);
+    avio_wb32(pb, c->crc);
+
+    avio_w8  (pb, c->estimated || old_timings);
+    avio_wb64(pb, old_timings ? c->start_time : s->start_time);
+    avio_wb64(pb, old_timings ? c->duration   : s->duration);
+    avio_wb64(pb, old_timings ? c->bit_rate   : s->bit_rate);
+    avio_w8  (pb, old_timings ? c->duration_estimation_method :
+                                s->duration_estimation_method);
+
+    avio_wb32(pb, s->nb_streams);
+    for (i = 0; i < s->nb_streams; i++) {
+        const AVStream *st = s->streams[i];
+
+        avio_wb32(pb, st->id);
+        avio_wb32(pb, st->time_base.num);
+        avio_wb32(pb, st->time_base.den);
+        avio_wb64(pb, old_timings ? c->streams[i].start_time : st->start_time);
+        avio_wb64(pb, old_timings ? c->streams[i].duration   : st->duration);
+        avio_wb32(pb, st->nb_index_entries);
+        for (j = 0; j < st->nb_index_entries; j++) {
+            const AVIndexEntry *e = &st->index_entries[j];
+
+            avio_wb64(pb, e->pos);
+            avio_wb64(pb, e->timestamp);
+            avio_wb32(pb, e->size << 2 | e->flags);
+            avio_wb32(pb, e->min_distance);
+        }
+    }
+
+    avio_flush(pb);
+    ret = pb->error;
+    avio_closep(&pb);
+    if (ret >= 0)
+        ff_rename(tmp, s->index_cache, s);
+
+end:
+    av_free(tmp);
+}
@@ -0,0 +1,62 @@
+/*
+ * Persistent demuxer index cache
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_INDEXCACHE_H
+#define AVFORMAT_INDEXCACHE_H
+
+#include "avformat.h"
+
+/**
+ * Load the sidecar index cache named by AVFormatContext.index_cache and
+ * restore the index of every stream it matches.
+ *
+ * Must be called after read_header(). The cache is only used if it was
+ * written for the same URL, demuxer, file size and file header; any other
+ * failure leaves the input to be indexed as usual.
+ */
+void ff_index_cache_load(AVFormatContext *s);
+
+/**
+ * Restore the stream and container timings saved in the cache, instead
+ * of estimating them.
+ *
+ * @return 1 if the timings were restored, 0 if they must be estimated
+ */
+int ff_index_cache_restore_timings(AVFormatContext *s);
+
+/**
+ * Mark the current timings of s as estimated, so that they are saved.
+ */
+void ff_index_cache_timings_estimated(AVFormatContext *s);
+
+/**
+ * @return 1 if the index of stream st was restored from the cache
+ */
+int ff_index_cache_restored(AVFormatContext *s, AVStream *st);
+
+/**
+ * Write the current index and timings of s to the cache file, unless
+ * the cache loaded at open time already holds all of them.
+ */
+void ff_index_cache_save(AVFormatContext *s);
+
+void ff_index_cache_free(AVFormatContext *s);
+
+#endif /* AVFORMAT_INDEXCACHE_H */
@@ -142,6 +142,11 @@ struct AVFormatInternal {
      * Prefer the codec framerate for avg_frame_rate computation.
      */
     int prefer_codec_framerate;
+
+    /**
+     * Index cache state, see indexcache.h.
+     */
+    struct IndexCache *index_cache;
 };
 
 struct AVStreamInternal {
@@ -658,6 +663,12 @@ int ff_format_output_open(AVFormatContext *s, const char *url, AVDictionary **op
  */
 void ff_format_io_close(AVFormatContext *s, AVIOContext **pb);
 
+/**
+ * Return 1 if the io_open and io_close callbacks of s are the default ones,
+ * which unlike user-supplied callbacks may be called from any thread.
+ */
+int ff_format_io_is_default(const AVFormatContext *s);
+
 /**
  * Utility function to check if the file uses http or https protocol
  *
@@ -713,6 +724,17 @@ int ff_reshuffle_raw_rgb(AVFormatContext *s, AVPacket **ppkt, AVCodecParameters
  */
 int ff_get_packet_palette(AVFormatContext *s, AVPacket *pkt, int ret, uint32_t *palette);
 
+/**
+ * Like av_get_packet(), but packets at least as large as the I/O buffer are
+ * returned as read-only references to the data if the protocol keeps it in
+ * memory (e.g. the file protocol with the mmap option), instead of being
+ * copied.
+ *
+ * Only for demuxers which call av_packet_make_writable() before modifying
+ * the packet data.
+ */
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size);
+
 /**
  * Finalize buf into extradata and set its size appropriately.
  */
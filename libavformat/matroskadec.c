@@ -51,6 +51,7 @@
 
 #include "avformat.h"
 #include "avio_internal.h"
+#include "indexcache.h"
 #include "internal.h"
 #include "isom.h"
 #include "matroska.h"
@@ -3711,8 +3712,9 @@ static int matroska_read_seek(AVFormatContext *s, int stream_index,
     AVStream *st = s->streams[stream_index];
     int i, index;
 
-    /* Parse the CUES now since we need the index data to seek. */
-    if (matroska->cues_parsing_deferred > 0) {
+    /* Parse the CUES now since we need the index data to seek, unless the
+     * index was restored from the index cache. */
+    if (matroska->cues_parsing_deferred > 0 && !ff_index_cache_restored(s, st)) {
         matroska->cues_parsing_deferred = 0;
         matroska_parse_cues(matroska);
     }
@@ -0,0 +1,128 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+
+#include "libavutil/dict.h"
+#include "libavformat/avformat.h"
+#include "libavformat/url.h"
+
+#define FILE_SIZE (1 << 20)
+
+/* two runs of zeros, so that the packets ending there share the window */
+#define ZERO1 600000
+#define ZERO2 700000
+#define ZERO_SIZE 100
+
+static int is_zero(int pos)
+{
+    return (pos >= ZERO1 && pos < ZERO1 + ZERO_SIZE) ||
+           (pos >= ZERO2 && pos < ZERO2 + ZERO_SIZE);
+}
+
+static uint8_t file_byte(int pos)
+{
+    return is_zero(pos) ? 0 : 1 + pos % 251;
+}
+
+static int write_file(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    int i;
+
+    if (!f)
+        return -1;
+    for (i = 0; i < FILE_SIZE; i++)
+        fputc(file_byte(i), f);
+    return fclose(f);
+}
+
+static void print_packet(const AVBufferRef *buf, int pos)
+{
+    static const uint8_t zero[AV_INPUT_BUFFER_PADDING_SIZE];
+    int i;
+
+    for (i = 0; i < buf->size; i++)
+        if (buf->data[i] != file_byte(pos + i))
+            break;
+    printf("%7d %6d: data %s, padding %s, %s\n", pos, buf->size,
+           i == buf->size ? "ok" : "mismatch",
+           memcmp(buf->data + buf->size, zero, sizeof(zero)) ? "not zeroed" : "zeroed",
+           av_buffer_is_writable(buf) ? "writable" : "read-only");
+}
+
+static int get_packet(URLContext *h, int pos, int size, AVBufferRef **buf)
+{
+    int ret = ffurl_get_buffer_ref(h, pos, size, buf);
+
+    if (ret < 0)
+        printf("%7d %6d: error %d\n", pos, size, ret);
+    else
+        print_packet(*buf, pos);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    URLContext *h = NULL;
+    AVDictionary *opts = NULL;
+    AVBufferRef *buf[5] = { NULL };
+    int pos[5];
+    int i, ret;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <temporary file>\n", argv[0]);
+        return 1;
+    }
+    if (write_file(argv[1]) < 0) {
+        fprintf(stderr, "could not write %s\n", argv[1]);
+        return 1;
+    }
+
+    av_dict_set(&opts, "mmap", "1", 0);
+    ret = ffurl_open_whitelist(&h, argv[1], AVIO_FLAG_READ, NULL, &opts,
+                               NULL, NULL, NULL);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        fprintf(stderr, "could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    /* in the middle of the window, followed by nonzero bytes */
+    ret |= get_packet(h, pos[0] = 100000, 40000, &buf[0]);
+    ret |= get_packet(h, pos[1] = 140000, 65536, &buf[1]);
+    /* followed by zeros */
+    ret |= get_packet(h, pos[2] = 500000, ZERO1 - 500000, &buf[2]);
+    ret |= get_packet(h, pos[3] = ZERO1 + ZERO_SIZE, ZERO2 - ZERO1 - ZERO_SIZE, &buf[3]);
+    /* at the end of the file */
+    ret |= get_packet(h, pos[4] = FILE_SIZE - 50000, 50000, &buf[4]);
+    ffurl_closep(&h);
+
+    if (!ret) {
+        printf("packets followed by zeros share a buffer: %s\n",
+               buf[2]->buffer == buf[3]->buffer ? "yes" : "no");
+        printf("after closing the file:\n");
+        for (i = 0; i < FF_ARRAY_ELEMS(buf); i++)
+            print_packet(buf[i], pos[i]);
+    }
+    for (i = 0; i < FF_ARRAY_ELEMS(buf); i++)
+        av_buffer_unref(&buf[i]);
+    remove(argv[1]);
+
+    return !!ret;
+}
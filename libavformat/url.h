@@ -27,6 +27,7 @@
 #include "avio.h"
 #include "libavformat/version.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -49,6 +50,9 @@ typedef struct URLContext {
     const char *protocol_whitelist;
     const char *protocol_blacklist;
     int min_packet_size;        /**< if non zero, the stream is packetized with this min packet size */
+    int io_buffers;             /**< number of buffers for background read-ahead or write-behind, 0 to disable */
+    struct URLIOThread *io_thread;
+    AVIOInterruptCB io_interrupt_callback; /**< callback of the caller, chained to when io_buffers is set */
 } URLContext;
 
 typedef struct URLProtocol {
@@ -96,6 +100,8 @@ typedef struct URLProtocol {
     int (*url_close_dir)(URLContext *h);
     int (*url_delete)(URLContext *h);
     int (*url_move)(URLContext *h_src, URLContext *h_dst);
+    int (*url_get_buffer_ref)(URLContext *h, int64_t pos, int size,
+                              AVBufferRef **buf);
     const char *default_whitelist;
 } URLProtocol;
 
@@ -257,6 +263,20 @@ int ffurl_get_multi_file_handle(URLContext *h, int **handles, int *numhandles);
  */
 int ffurl_get_short_seek(URLContext *h);
 
+/**
+ * Return a reference to size bytes of the resource starting at pos without
+ * copying them, if the protocol keeps the data in memory.
+ *
+ * The returned buffer is read-only and is followed by at least
+ * AV_INPUT_BUFFER_PADDING_SIZE zeroed bytes. The current read position
+ * of h is not changed.
+ *
+ * @return 0 on success, a negative AVERROR code (AVERROR(ENOSYS) if the
+ * protocol does not support it) on failure
+ */
+int ffurl_get_buffer_ref(URLContext *h, int64_t pos, int size,
+                         AVBufferRef **buf);
+
 /**
  * Signal the URLContext that we are done reading or writing the stream.
  *
@@ -45,6 +45,7 @@
 #include "avformat.h"
 #include "avio_internal.h"
 #include "id3v2.h"
+#include "indexcache.h"
 #include "internal.h"
 #include "metadata.h"
 #if CONFIG_NETWORK
@@ -315,6 +316,25 @@ int av_get_packet(AVIOContext *s, AVPacket *pkt, int size)
     return append_packet_chunked(s, pkt, size);
 }
 
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size)
+{
+    AVBufferRef *buf;
+
+    /* Packets larger than the I/O buffer would not benefit from buffering,
+     * reference them directly if the protocol has the data in memory. */
+    if (size < s->buffer_size)
+        return av_get_packet(s, pkt, size);
+
+    av_init_packet(pkt);
+    pkt->pos = avio_tell(s);
+    if (ffio_read_ref(s, &buf, size) < 0)
+        return av_get_packet(s, pkt, size);
+    pkt->buf  = buf;
+    pkt->data = buf->data;
+    pkt->size = size;
+    return size;
+}
+
 int av_append_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
     if (!pkt->size)
@@ -661,6 +681,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
     s->internal->raw_packet_buffer_remaining_size = RAW_PACKET_BUFFER_SIZE;
 
+    ff_index_cache_load(s);
+
     update_stream_avctx(s);
 
     for (i = 0; i < s->nb_streams; i++)
@@ -2960,9 +2982,11 @@ static void estimate_timings(AVFormatContext *ic, int64_t old_offset)
         file_size = FFMAX(0, file_size);
     }
 
-    if ((!strcmp(ic->iformat->name, "mpeg") ||
-         !strcmp(ic->iformat->name, "mpegts")) &&
-        file_size && (ic->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
+    if (ff_index_cache_restore_timings(ic)) {
+        /* timings estimated when the input was opened before */
+    } else if ((!strcmp(ic->iformat->name, "mpeg") ||
+                !strcmp(ic->iformat->name, "mpegts")) &&
+               file_size && (ic->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
         /* get accurate estimate from the PTSes */
         estimate_timings_from_pts(ic, old_offset);
         ic->duration_estimation_method = AVFMT_DURATION_FROM_PTS;
@@ -2981,6 +3005,7 @@ static void estimate_timings(AVFormatContext *ic, int64_t old_offset)
         ic->duration_estimation_method = AVFMT_DURATION_FROM_BITRATE;
     }
     update_stream_timings(ic);
+    ff_index_cache_timings_estimated(ic);
 
     {
         int i;
@@ -4487,6 +4512,7 @@ void avformat_free_context(AVFormatContext *s)
     av_dict_free(&s->metadata);
     av_dict_free(&s->internal->id3v2_meta);
     av_freep(&s->streams);
+    ff_index_cache_free(s);
     flush_packet_queue(s);
     av_freep(&s->internal);
     av_freep(&s->url);
@@ -4504,6 +4530,8 @@ void avformat_close_input(AVFormatContext **ps)
     s  = *ps;
     pb = s->pb;
 
+    ff_index_cache_save(s);
+
     if ((s->iformat && strcmp(s->iformat->name, "image2") && s->iformat->flags & AVFMT_NOFILE) ||
         (s->flags & AVFMT_FLAG_CUSTOM_IO))
         pb = NULL;
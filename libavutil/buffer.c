@@ -26,16 +26,11 @@
 #include "mem.h"
 #include "thread.h"
 
-AVBufferRef *av_buffer_create(uint8_t *data, int size,
-                              void (*free)(void *opaque, uint8_t *data),
-                              void *opaque, int flags)
+static AVBufferRef *buffer_create(AVBuffer *buf, uint8_t *data, int size,
+                                  void (*free)(void *opaque, uint8_t *data),
+                                  void *opaque, int flags)
 {
     AVBufferRef *ref = NULL;
-    AVBuffer    *buf = NULL;
-
-    buf = av_mallocz(sizeof(*buf));
-    if (!buf)
-        return NULL;
 
     buf->data     = data;
     buf->size     = size;
@@ -48,10 +43,8 @@ AVBufferRef *av_buffer_create(uint8_t *data, int size,
         buf->flags |= BUFFER_FLAG_READONLY;
 
     ref = av_mallocz(sizeof(*ref));
-    if (!ref) {
-        av_freep(&buf);
+    if (!ref)
         return NULL;
-    }
 
     ref->buffer = buf;
     ref->data   = data;
@@ -60,6 +53,23 @@ AVBufferRef *av_buffer_create(uint8_t *data, int size,
     return ref;
 }
 
+AVBufferRef *av_buffer_create(uint8_t *data, int size,
+                              void (*free)(void *opaque, uint8_t *data),
+                              void *opaque, int flags)
+{
+    AVBufferRef *ret;
+    AVBuffer *buf = av_mallocz(sizeof(*buf));
+    if (!buf)
+        return NULL;
+
+    ret = buffer_create(buf, data, size, free, opaque, flags);
+    if (!ret) {
+        av_free(buf);
+        return NULL;
+    }
+    return ret;
+}
+
 void av_buffer_default_free(void *opaque, uint8_t *data)
 {
     av_free(data);
@@ -118,8 +128,12 @@ static void buffer_replace(AVBufferRef **dst, AVBufferRef **src)
         av_freep(dst);
 
     if (atomic_fetch_sub_explicit(&b->refcount, 1, memory_order_acq_rel) == 1) {
+        /* b->free below might already free the structure containing *b,
+         * so we have to read the flag now to avoid use-after-free. */
+        int free_avbuffer = !(b->flags & BUFFER_FLAG_NO_FREE);
         b->free(b->opaque, b->data);
-        av_freep(&b);
+        if (free_avbuffer)
+            av_free(b);
     }
 }
 
@@ -232,6 +246,7 @@ AVBufferPool *av_buffer_pool_init2(int size, void *opaque,
     pool->pool_free = pool_free;
 
     atomic_init(&pool->refcount, 1);
+    atomic_init(&pool->released, 0);
 
     return pool;
 }
@@ -248,6 +263,7 @@ AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
     pool->alloc    = alloc ? alloc : av_buffer_alloc;
 
     atomic_init(&pool->refcount, 1);
+    atomic_init(&pool->released, 0);
 
     return pool;
 }
@@ -258,6 +274,15 @@ AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
  */
 static void buffer_pool_free(AVBufferPool *pool)
 {
+    BufferPoolEntry *released = (BufferPoolEntry *)atomic_load(&pool->released);
+
+    while (released) {
+        BufferPoolEntry *buf = released;
+        released   = buf->next;
+        buf->next  = pool->pool;
+        pool->pool = buf;
+    }
+
     while (pool->pool) {
         BufferPoolEntry *buf = pool->pool;
         pool->pool = buf->next;
@@ -286,6 +311,18 @@ void av_buffer_pool_uninit(AVBufferPool **ppool)
         buffer_pool_free(pool);
 }
 
+static void pool_push_released(AVBufferPool *pool, BufferPoolEntry *buf)
+{
+    intptr_t head = atomic_load_explicit(&pool->released, memory_order_relaxed);
+
+    do {
+        buf->next = (BufferPoolEntry *)head;
+    } while (!atomic_compare_exchange_weak_explicit(&pool->released, &head,
+                                                    (intptr_t)buf,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
 static void pool_release_buffer(void *opaque, uint8_t *data)
 {
     BufferPoolEntry *buf = opaque;
@@ -294,10 +331,7 @@ static void pool_release_buffer(void *opaque, uint8_t *data)
     if(CONFIG_MEMORY_POISONING)
         memset(buf->data, FF_MEMORY_POISON, pool->size);
 
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+    pool_push_released(pool, buf);
 
     if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
         buffer_pool_free(pool);
@@ -338,18 +372,28 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
     BufferPoolEntry *buf;
 
     ff_mutex_lock(&pool->mutex);
+    if (!pool->pool)
+        pool->pool = (BufferPoolEntry *)atomic_exchange_explicit(&pool->released, 0,
+                                                                memory_order_acquire);
     buf = pool->pool;
     if (buf) {
-        ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
-                               buf, 0);
-        if (ret) {
-            pool->pool = buf->next;
-            buf->next = NULL;
+        pool->pool = buf->next;
+        buf->next  = NULL;
+        ff_mutex_unlock(&pool->mutex);
+
+        buf->buffer.flags = BUFFER_FLAG_NO_FREE;
+        ret = buffer_create(&buf->buffer, buf->data, pool->size,
+                            pool_release_buffer, buf, 0);
+        if (!ret) {
+            pool_push_released(pool, buf);
+            return NULL;
         }
     } else {
+        /* Allocators such as the hwcontext ones rely on being serialized
+         * by the pool, so new buffers are still created under the mutex. */
         ret = pool_alloc_buffer(pool);
+        ff_mutex_unlock(&pool->mutex);
     }
-    ff_mutex_unlock(&pool->mutex);
 
     if (ret)
         atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
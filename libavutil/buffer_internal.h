@@ -33,6 +33,11 @@
  * The buffer was av_realloc()ed, so it is reallocatable.
  */
 #define BUFFER_FLAG_REALLOCATABLE (1 << 1)
+/**
+ * The AVBuffer structure is part of a larger structure
+ * and should not be freed.
+ */
+#define BUFFER_FLAG_NO_FREE       (1 << 2)
 
 struct AVBuffer {
     uint8_t *data; /**< data described by this buffer */
@@ -71,12 +76,25 @@ typedef struct BufferPoolEntry {
 
     AVBufferPool *pool;
     struct BufferPoolEntry *next;
+
+    /*
+     * An AVBuffer structure to (re)use as AVBuffer for subsequent uses
+     * of this BufferPoolEntry.
+     */
+    AVBuffer buffer;
 } BufferPoolEntry;
 
 struct AVBufferPool {
     AVMutex mutex;
     BufferPoolEntry *pool;
 
+    /*
+     * Entries returned to the pool are pushed onto this lock-free stack,
+     * so that releasing a buffer never takes the mutex. It is moved to
+     * pool as a whole, under the mutex, once pool runs empty.
+     */
+    atomic_intptr_t released;
+
     /*
      * This is used to track when the pool is to be freed.
      * The pointer to the pool itself held by the caller is considered to
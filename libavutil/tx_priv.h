@@ -42,6 +42,7 @@ typedef AVComplexDouble FFTComplex;
 typedef int32_t FFTSample;
 typedef AVComplexInt32 FFTComplex;
 #else
+typedef void FFTSample;
 typedef void FFTComplex;
 #endif
 
@@ -112,6 +113,10 @@ struct AVTXContext {
     FFTComplex *tmp;    /* Temporary buffer needed for all compound transforms */
     int        *pfatab; /* Input/Output mapping for compound transforms */
     int        *revtab; /* Input mapping for power of two transforms */
+
+    /* Split-radix pass of the power of two transforms, set by the SIMD init
+     * functions and NULL for the C version. z[0...8n-1], wre[0...2n] */
+    void (*fft_pass)(FFTComplex *z, const FFTSample *wre, unsigned int n);
 };
 
 /* Shared functions */
@@ -135,6 +140,11 @@ static inline int split_radix_permutation(int i, int n, int inverse)
         return split_radix_permutation(i, m, inverse)*4 - 1;
 }
 
+/* Reference for the SIMD split-radix passes */
+void ff_tx_fft_pass_float(AVComplexFloat *z, const float *wre, unsigned int n);
+
+void ff_tx_init_float_x86(AVTXContext *s);
+
 /* Templated functions */
 int ff_tx_init_mdct_fft_float(AVTXContext *s, av_tx_fn *tx,
                               enum AVTXType type, int inv, int len,
@@ -359,6 +359,35 @@ static void (* const fft_dispatch[])(FFTComplex*) = {
     fft1024, fft2048, fft4096, fft8192, fft16384, fft32768, fft65536, fft131072
 };
 
+#ifdef TX_FLOAT
+void ff_tx_fft_pass_float(FFTComplex *z, const FFTSample *wre, unsigned int n)
+{
+    pass_big(z, wre, n);
+}
+#endif
+
+/* Same recursion as the fftN functions above, using the SIMD passes */
+static void fft_sr(AVTXContext *s, FFTComplex *z, int mb)
+{
+    if (mb <= 4) {
+        fft_dispatch[mb](z);
+        return;
+    }
+
+    fft_sr(s, z, mb - 1);
+    fft_sr(s, z + (2 << (mb - 2)), mb - 2);
+    fft_sr(s, z + (3 << (mb - 2)), mb - 2);
+    s->fft_pass(z, cos_tabs[mb], 1 << (mb - 3));
+}
+
+static av_always_inline void fft_ptwo(AVTXContext *s, FFTComplex *z, int mb)
+{
+    if (s->fft_pass)
+        fft_sr(s, z, mb);
+    else
+        fft_dispatch[mb](z);
+}
+
 #define DECL_COMP_FFT(N)                                                       \
 static void compound_fft_##N##xM(AVTXContext *s, void *_out,                   \
                                  void *_in, ptrdiff_t stride)                  \
@@ -367,7 +396,7 @@ static void compound_fft_##N##xM(AVTXContext *s, void *_out,                   \
     FFTComplex *in = _in;                                                      \
     FFTComplex *out = _out;                                                    \
     FFTComplex fft##N##in[N];                                                  \
-    void (*fftp)(FFTComplex *z) = fft_dispatch[av_log2(m)];                    \
+    const int mb = av_log2(m);                                                 \
                                                                                \
     for (int i = 0; i < m; i++) {                                              \
         for (int j = 0; j < N; j++)                                            \
@@ -376,7 +405,7 @@ static void compound_fft_##N##xM(AVTXContext *s, void *_out,                   \
     }                                                                          \
                                                                                \
     for (int i = 0; i < N; i++)                                                \
-        fftp(s->tmp + m*i);                                                    \
+        fft_ptwo(s, s->tmp + m*i, mb);                                         \
                                                                                \
     for (int i = 0; i < N*m; i++)                                              \
         out[i] = s->tmp[out_map[i]];                                           \
@@ -394,7 +423,7 @@ static void monolithic_fft(AVTXContext *s, void *_out, void *_in,
     int m = s->m, mb = av_log2(m);
     for (int i = 0; i < m; i++)
         out[s->revtab[i]] = in[i];
-    fft_dispatch[mb](out);
+    fft_ptwo(s, out, mb);
 }
 
 #define DECL_COMP_IMDCT(N)                                                     \
@@ -403,10 +432,9 @@ static void compound_imdct_##N##xM(AVTXContext *s, void *_dst, void *_src,     \
 {                                                                              \
     FFTComplex fft##N##in[N];                                                  \
     FFTComplex *z = _dst, *exp = s->exptab;                                    \
-    const int m = s->m, len8 = N*m >> 1;                                       \
+    const int m = s->m, mb = av_log2(m), len8 = N*m >> 1;                      \
     const int *in_map = s->pfatab, *out_map = in_map + N*m;                    \
     const FFTSample *src = _src, *in1, *in2;                                   \
-    void (*fftp)(FFTComplex *) = fft_dispatch[av_log2(m)];                     \
                                                                                \
     stride /= sizeof(*src); /* To convert it from bytes */                     \
     in1 = src;                                                                 \
@@ -422,7 +450,7 @@ static void compound_imdct_##N##xM(AVTXContext *s, void *_dst, void *_src,     \
     }                                                                          \
                                                                                \
     for (int i = 0; i < N; i++)                                                \
-        fftp(s->tmp + m*i);                                                    \
+        fft_ptwo(s, s->tmp + m*i, mb);                                         \
                                                                                \
     for (int i = 0; i < len8; i++) {                                           \
         const int i0 = len8 + i, i1 = len8 - i - 1;                            \
@@ -445,9 +473,9 @@ static void compound_mdct_##N##xM(AVTXContext *s, void *_dst, void *_src,      \
 {                                                                              \
     FFTSample *src = _src, *dst = _dst;                                        \
     FFTComplex *exp = s->exptab, tmp, fft##N##in[N];                           \
-    const int m = s->m, len4 = N*m, len3 = len4 * 3, len8 = len4 >> 1;         \
+    const int m = s->m, mb = av_log2(m), len4 = N*m, len3 = len4 * 3;          \
+    const int len8 = len4 >> 1;                                                \
     const int *in_map = s->pfatab, *out_map = in_map + N*m;                    \
-    void (*fftp)(FFTComplex *) = fft_dispatch[av_log2(m)];                     \
                                                                                \
     stride /= sizeof(*dst);                                                    \
                                                                                \
@@ -468,7 +496,7 @@ static void compound_mdct_##N##xM(AVTXContext *s, void *_dst, void *_src,      \
     }                                                                          \
                                                                                \
     for (int i = 0; i < N; i++)                                                \
-        fftp(s->tmp + m*i);                                                    \
+        fft_ptwo(s, s->tmp + m*i, mb);                                         \
                                                                                \
     for (int i = 0; i < len8; i++) {                                           \
         const int i0 = len8 + i, i1 = len8 - i - 1;                            \
@@ -493,7 +521,6 @@ static void monolithic_imdct(AVTXContext *s, void *_dst, void *_src,
     FFTComplex *z = _dst, *exp = s->exptab;
     const int m = s->m, len8 = m >> 1;
     const FFTSample *src = _src, *in1, *in2;
-    void (*fftp)(FFTComplex *) = fft_dispatch[av_log2(m)];
 
     stride /= sizeof(*src);
     in1 = src;
@@ -504,7 +531,7 @@ static void monolithic_imdct(AVTXContext *s, void *_dst, void *_src,
         CMUL3(z[s->revtab[i]], tmp, exp[i]);
     }
 
-    fftp(z);
+    fft_ptwo(s, z, av_log2(m));
 
     for (int i = 0; i < len8; i++) {
         const int i0 = len8 + i, i1 = len8 - i - 1;
@@ -522,7 +549,6 @@ static void monolithic_mdct(AVTXContext *s, void *_dst, void *_src,
     FFTSample *src = _src, *dst = _dst;
     FFTComplex *exp = s->exptab, tmp, *z = _dst;
     const int m = s->m, len4 = m, len3 = len4 * 3, len8 = len4 >> 1;
-    void (*fftp)(FFTComplex *) = fft_dispatch[av_log2(m)];
 
     stride /= sizeof(*dst);
 
@@ -539,7 +565,7 @@ static void monolithic_mdct(AVTXContext *s, void *_dst, void *_src,
              exp[i].re, exp[i].im);
     }
 
-    fftp(z);
+    fft_ptwo(s, z, av_log2(m));
 
     for (int i = 0; i < len8; i++) {
         const int i0 = len8 + i, i1 = len8 - i - 1;
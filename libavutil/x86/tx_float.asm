@@ -0,0 +1,100 @@
+;******************************************************************************
+;* x86-optimized split-radix passes for the libavutil/tx float transforms
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_tx_fft_pass_float(FFTComplex *z, const FFTSample *wre, unsigned int n)
+;
+; Same as the pass() function of tx_template.c: combines the half and the two
+; quarter length transforms in z[0...8n-1], with w[k] = wre[k] + i*wre[2n-k].
+; Processes 4 complex values of each quarter per iteration.
+;------------------------------------------------------------------------------
+%macro FFT_PASS 0
+cglobal tx_fft_pass_float, 3, 6, 8, z, wre, n, wim, o1, o3
+    mov          o1d, nd
+    lea         wimq, [wreq + o1q*8 - 12]
+    shl          o1q, 4                     ; 2n complex values
+    lea          o3q, [o1q*3]
+    shr           nd, 1
+.loop:
+    movaps       xm0, [wreq]                ; c0 c1 c2 c3
+    movups       xm1, [wimq]                ; s3 s2 s1 s0
+    shufps       xm1, xm1, q0123
+    unpckhps     xm4, xm0, xm0
+    unpcklps     xm0, xm0
+    vinsertf128   m0, m0, xm4, 1            ; c0 c0 c1 c1 c2 c2 c3 c3
+    unpckhps     xm4, xm1, xm1
+    unpcklps     xm1, xm1
+    vinsertf128   m1, m1, xm4, 1            ; s0 s0 s1 s1 s2 s2 s3 s3
+
+    mova          m2, [zq + o1q*2]
+    mova          m3, [zq + o3q]
+    vpermilps     m4, m2, q2301
+    vpermilps     m5, m3, q2301
+%if cpuflag(fma3)
+    mulps         m4, m1
+    mulps         m5, m1
+    fmsubaddps    m2, m2, m0, m4            ; A = z[o2] * conj(w)
+    fmaddsubps    m3, m3, m0, m5            ; B = z[o3] * w
+%else
+    mulps         m4, m0
+    mulps         m2, m1
+    addsubps      m4, m2
+    vpermilps     m2, m4, q2301             ; A = z[o2] * conj(w)
+    mulps         m3, m0
+    mulps         m5, m1
+    addsubps      m3, m5                    ; B = z[o3] * w
+%endif
+
+    subps         m4, m3, m2                ; B - A
+    addps         m5, m3, m2                ; A + B
+    subps         m2, m3                    ; A - B
+    vpermilps     m4, m4, q2301
+    vpermilps     m2, m2, q2301
+    mova          m6, [zq]
+    mova          m7, [zq + o1q]
+    subps         m3, m6, m5
+    addps         m6, m5
+    addsubps      m5, m7, m4                ; z[o1] + i*(B - A)
+    addsubps      m7, m2                    ; z[o1] - i*(B - A)
+    mova   [zq       ], m6
+    mova   [zq + o1q ], m5
+    mova   [zq + o1q*2], m3
+    mova   [zq + o3q ], m7
+
+    add           zq, mmsize
+    add         wreq, 16
+    sub         wimq, 16
+    dec           nd
+    jg .loop
+    RET
+%endmacro
+
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+FFT_PASS
+%endif
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+FFT_PASS
+%endif
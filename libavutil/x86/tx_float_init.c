@@ -0,0 +1,35 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#define TX_FLOAT
+#include "libavutil/attributes.h"
+#include "libavutil/tx_priv.h"
+#include "libavutil/x86/cpu.h"
+
+void ff_tx_fft_pass_float_avx (FFTComplex *z, const FFTSample *wre, unsigned int n);
+void ff_tx_fft_pass_float_fma3(FFTComplex *z, const FFTSample *wre, unsigned int n);
+
+av_cold void ff_tx_init_float_x86(AVTXContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_AVX_FAST(cpu_flags))
+        s->fft_pass = ff_tx_fft_pass_float_avx;
+    if (EXTERNAL_FMA3_FAST(cpu_flags))
+        s->fft_pass = ff_tx_fft_pass_float_fma3;
+}
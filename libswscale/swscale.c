@@ -234,9 +234,10 @@ static void lumRangeFromJpeg16_c(int16_t *_dst, int width)
     if (DEBUG_SWSCALE_BUFFERS)                  \
         av_log(c, AV_LOG_DEBUG, __VA_ARGS__)
 
-static int swscale(SwsContext *c, const uint8_t *src[],
-                   int srcStride[], int srcSliceY,
-                   int srcSliceH, uint8_t *dst[], int dstStride[])
+static int scale_internal(SwsContext *c, const uint8_t *src[],
+                          int srcStride[], int srcSliceY, int srcSliceH,
+                          uint8_t *dst[], int dstStride[],
+                          int dstSliceY, int dstSliceH)
 {
     /* load a few things into local vars to make the code more readable?
      * and faster */
@@ -262,6 +263,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     const int chrSrcSliceH           = AV_CEIL_RSHIFT(srcSliceH,   c->chrSrcVSubSample);
     int should_dither                = isNBPS(c->srcFormat) ||
                                        is16BPS(c->srcFormat);
+    const int dstSliceEnd            = dstSliceY + dstSliceH;
     int lastDstY;
 
     /* vars which will change and which we need to store back in the context */
@@ -338,7 +340,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = dstSliceY;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -370,7 +372,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstSliceEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -532,6 +534,60 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     return dstY - lastDstY;
 }
 
+static int swscale(SwsContext *c, const uint8_t *src[],
+                   int srcStride[], int srcSliceY,
+                   int srcSliceH, uint8_t *dst[], int dstStride[])
+{
+    return scale_internal(c, src, srcStride, srcSliceY, srcSliceH,
+                          dst, dstStride, 0, c->dstH);
+}
+
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads)
+{
+    SwsContext *parent = priv;
+    SwsContext      *c = parent->slice_ctx[jobnr];
+    /* keep the bands aligned to the chroma subsampling, so that every
+     * chroma line is written by exactly one band; unscaled converters
+     * work on source slices and index their 8x8 dither matrices from the
+     * first line of the slice, so their bands start at a multiple of 8
+     * lines of every plane */
+    const int unscaled = c->swscale != swscale;
+    const int align    = unscaled ? 8 << FFMAX(c->chrSrcVSubSample, c->chrDstVSubSample) :
+                                    1 << c->chrDstVSubSample;
+    const int start    = c->dstH *  jobnr      / nb_jobs & ~(align - 1);
+    const int end      = jobnr + 1 == nb_jobs ? c->dstH :
+                         c->dstH * (jobnr + 1) / nb_jobs & ~(align - 1);
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    int srcStride[4], dstStride[4];
+
+    /* the scalers modify these, so each band works on a copy */
+    memcpy(src,       parent->slice_src,       sizeof(src));
+    memcpy(srcStride, parent->slice_srcStride, sizeof(srcStride));
+    memcpy(dst,       parent->slice_dst,       sizeof(dst));
+    memcpy(dstStride, parent->slice_dstStride, sizeof(dstStride));
+
+    if (unscaled) {
+        /* source and destination have the same height, the band is fed to
+         * the converter as a slice of the source picture */
+        if (start == end)
+            return;
+        src[0] += start * srcStride[0];
+        if (src[1])
+            src[1] += (start >> c->chrSrcVSubSample) * srcStride[1];
+        if (src[2])
+            src[2] += (start >> c->chrSrcVSubSample) * srcStride[2];
+        if (src[3])
+            src[3] += start * srcStride[3];
+        c->swscale(c, src, srcStride, start, end - start, dst, dstStride);
+        return;
+    }
+
+    scale_internal(c, src, srcStride, 0, c->srcH, dst, dstStride,
+                   start, end - start);
+}
+
 av_cold void ff_sws_init_range_convert(SwsContext *c)
 {
     c->lumConvertRange = NULL;
@@ -975,7 +1031,19 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     /* reset slice direction at end of frame */
     if (srcSliceY_internal + srcSliceH == c->srcH)
         c->sliceDir = 0;
-    ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
+
+    if (c->slicethread && srcSliceY_internal == 0 && srcSliceH == c->srcH) {
+        memcpy(c->slice_src,       src2,       sizeof(src2));
+        memcpy(c->slice_srcStride, srcStride2, sizeof(srcStride2));
+        memcpy(c->slice_dst,       dst2,       sizeof(dst2));
+        memcpy(c->slice_dstStride, dstStride2, sizeof(dstStride2));
+        avpriv_slicethread_execute(c->slicethread, c->nb_slice_ctx, 0);
+        /* as after a whole picture scaled on this thread, which the gamma
+         * cascade relies on */
+        c->dstY = c->dstH;
+        ret = c->dstH;
+    } else
+        ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
 
     if (c->dstXYZ && !(c->srcXYZ && c->srcW==c->dstW && c->srcH==c->dstH)) {
         int dstY = c->dstY ? c->dstY : srcSliceY + srcSliceH;
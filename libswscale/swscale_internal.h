@@ -31,6 +31,7 @@
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/ppc/util_altivec.h"
 
 #define STR(s) AV_TOSTRING(s) // AV_STRINGIFY is too long
@@ -321,6 +322,18 @@ typedef struct SwsContext {
     uint8_t *cascaded1_tmp[4];
     int cascaded_mainindex;
 
+    /* The slice_* fields allow splitting the output picture into horizontal
+     * bands which are scaled concurrently, each one by its own child context.
+     */
+    int nb_threads;               ///< Number of threads requested by the user, 0 for automatic.
+    AVSliceThread *slicethread;
+    struct SwsContext **slice_ctx;
+    int nb_slice_ctx;
+    const uint8_t *slice_src[4];  ///< Source planes of the frame being scaled by the slice threads.
+    int slice_srcStride[4];
+    uint8_t *slice_dst[4];        ///< Destination planes of the frame being scaled by the slice threads.
+    int slice_dstStride[4];
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -852,12 +865,25 @@ void ff_get_unscaled_swscale_ppc(SwsContext *c);
 void ff_get_unscaled_swscale_arm(SwsContext *c);
 void ff_get_unscaled_swscale_aarch64(SwsContext *c);
 
+/**
+ * Return 1 if the unscaled converter set in c gives the same output whether
+ * the picture is converted at once or in bands, 0 otherwise.
+ */
+int ff_sws_unscaled_slice_invariant(const SwsContext *c);
+
 /**
  * Return function pointer to fastest main scaler path function depending
  * on architecture and available optimizations.
  */
 SwsFunc ff_getSwsFunc(SwsContext *c);
 
+/**
+ * Slice thread worker, scales one horizontal band of the destination
+ * picture with the child context slice_ctx[jobnr].
+ */
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads);
+
 void ff_sws_init_input_funcs(SwsContext *c);
 void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2planar1_fn *yuv2plane1,
@@ -1891,6 +1891,14 @@ static int planarCopyWrapper(SwsContext *c, const uint8_t *src[],
 }
 
 
+int ff_sws_unscaled_slice_invariant(const SwsContext *c)
+{
+    /* these treat the first and last lines of every slice differently from
+     * the ones in between (C rows around the MMX loop, chroma edge
+     * interpolation) */
+    return c->swscale != bgr24ToYv12Wrapper && c->swscale != yvu9ToYv12Wrapper;
+}
+
 #define IS_DIFFERENT_ENDIANESS(src_fmt, dst_fmt, pix_fmt)          \
     ((src_fmt == pix_fmt ## BE && dst_fmt == pix_fmt ## LE) ||     \
      (src_fmt == pix_fmt ## LE && dst_fmt == pix_fmt ## BE))
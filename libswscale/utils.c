@@ -856,9 +856,34 @@ static void fill_xyztables(struct SwsContext *c)
     }
 }
 
-int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
-                             int srcRange, const int table[4], int dstRange,
-                             int brightness, int contrast, int saturation)
+/**
+ * Create one step of a cascade of contexts. The steps do the actual work
+ * for c, so they use the same number of threads.
+ */
+static SwsContext *get_cascaded_context(SwsContext *c,
+                                        int srcW, int srcH, enum AVPixelFormat srcFormat,
+                                        int dstW, int dstH, enum AVPixelFormat dstFormat,
+                                        int flags, SwsFilter *srcFilter,
+                                        SwsFilter *dstFilter)
+{
+    SwsContext *cc = sws_alloc_set_opts(srcW, srcH, srcFormat,
+                                        dstW, dstH, dstFormat,
+                                        flags, c->param);
+    if (!cc)
+        return NULL;
+
+    cc->nb_threads = c->nb_threads;
+    if (sws_init_context(cc, srcFilter, dstFilter) < 0) {
+        sws_freeContext(cc);
+        return NULL;
+    }
+
+    return cc;
+}
+
+static int set_colorspace_details(struct SwsContext *c, const int inv_table[4],
+                                  int srcRange, const int table[4], int dstRange,
+                                  int brightness, int contrast, int saturation)
 {
     const AVPixFmtDescriptor *desc_dst;
     const AVPixFmtDescriptor *desc_src;
@@ -955,6 +980,7 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
                 return -1;
 
             c->cascaded_context[0]->alphablend = c->alphablend;
+            c->cascaded_context[0]->nb_threads = c->nb_threads;
             ret = sws_init_context(c->cascaded_context[0], NULL , NULL);
             if (ret < 0)
                 return ret;
@@ -963,9 +989,9 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
                                      srcRange, table, dstRange,
                                      brightness, contrast, saturation);
 
-            c->cascaded_context[1] = sws_getContext(tmp_width, tmp_height, tmp_format,
-                                                    dstW, dstH, c->dstFormat,
-                                                    c->flags, NULL, NULL, c->param);
+            c->cascaded_context[1] = get_cascaded_context(c, tmp_width, tmp_height, tmp_format,
+                                                             dstW, dstH, c->dstFormat,
+                                                             c->flags, NULL, NULL);
             if (!c->cascaded_context[1])
                 return -1;
             sws_setColorspaceDetails(c->cascaded_context[1], inv_table,
@@ -991,6 +1017,31 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     return 0;
 }
 
+int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
+                             int srcRange, const int table[4], int dstRange,
+                             int brightness, int contrast, int saturation)
+{
+    int i, ret;
+
+    ret = set_colorspace_details(c, inv_table, srcRange, table, dstRange,
+                                 brightness, contrast, saturation);
+
+    /* Once c converts through a cascade, its slice contexts are unused.
+     * Otherwise they take the same path as c and only update their tables. */
+    if (c->cascaded_context[0])
+        return ret;
+
+    for (i = 0; i < c->nb_slice_ctx; i++) {
+        int err = set_colorspace_details(c->slice_ctx[i], inv_table,
+                                         srcRange, table, dstRange,
+                                         brightness, contrast, saturation);
+        if (err < 0 && ret >= 0)
+            ret = err;
+    }
+
+    return ret;
+}
+
 int sws_getColorspaceDetails(struct SwsContext *c, int **inv_table,
                              int *srcRange, int **table, int *dstRange,
                              int *brightness, int *contrast, int *saturation)
@@ -1163,6 +1214,56 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
     }
 }
 
+static av_cold int context_init_threaded(SwsContext *c,
+                                         SwsFilter *srcFilter,
+                                         SwsFilter *dstFilter)
+{
+    int i, ret;
+
+    /* these need state carried from one line to the next, a pass over the
+     * whole picture, or, for Bayer demosaicing, the lines around each
+     * slice, so they cannot be split into bands; the alpha blend-away
+     * converter does not support slices and a few others convert the edges
+     * of each slice differently */
+    if (c->nb_threads == 1 || usePal(c->srcFormat) || isBayer(c->srcFormat) ||
+        c->dither == SWS_DITHER_ED || c->dstXYZ ||
+        c->swscale == ff_sws_alphablendaway || !ff_sws_unscaled_slice_invariant(c))
+        return 0;
+
+    ret = avpriv_slicethread_create(&c->slicethread, c, ff_sws_slice_worker,
+                                    NULL, c->nb_threads);
+    if (ret == AVERROR(ENOSYS) || ret == 1) {
+        avpriv_slicethread_free(&c->slicethread);
+        c->nb_threads = 1;
+        return 0;
+    } else if (ret < 0)
+        return ret;
+
+    c->nb_threads = ret;
+
+    c->slice_ctx = av_mallocz_array(c->nb_threads, sizeof(*c->slice_ctx));
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < c->nb_threads; i++) {
+        c->slice_ctx[i] = sws_alloc_context();
+        if (!c->slice_ctx[i])
+            return AVERROR(ENOMEM);
+        c->nb_slice_ctx++;
+
+        ret = av_opt_copy(c->slice_ctx[i], c);
+        if (ret < 0)
+            return ret;
+        c->slice_ctx[i]->nb_threads = 1;
+
+        ret = sws_init_context(c->slice_ctx[i], srcFilter, dstFilter);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -1476,13 +1577,15 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
         if (ret < 0)
             return ret;
 
-        c->cascaded_context[0] = sws_getContext(srcW, srcH, srcFormat,
-                                                srcW, srcH, tmpFmt,
-                                                flags, NULL, NULL, c->param);
+        c->cascaded_context[0] = get_cascaded_context(c, srcW, srcH, srcFormat,
+                                                         srcW, srcH, tmpFmt,
+                                                         flags, NULL, NULL);
         if (!c->cascaded_context[0]) {
             return -1;
         }
 
+        /* the gamma conversion of this step works in place on the source
+         * lines, which overlap between bands, so it runs on one thread */
         c->cascaded_context[1] = sws_getContext(srcW, srcH, tmpFmt,
                                                 dstW, dstH, tmpFmt,
                                                 flags, srcFilter, dstFilter, c->param);
@@ -1514,9 +1617,9 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
             if (ret < 0)
                 return ret;
 
-            c->cascaded_context[2] = sws_getContext(dstW, dstH, tmpFmt,
-                                                dstW, dstH, dstFormat,
-                                                flags, NULL, NULL, c->param);
+            c->cascaded_context[2] = get_cascaded_context(c, dstW, dstH, tmpFmt,
+                                                         dstW, dstH, dstFormat,
+                                                         flags, NULL, NULL);
             if (!c->cascaded_context[2])
                 return -1;
         }
@@ -1533,15 +1636,15 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
             if (ret < 0)
                 return ret;
 
-            c->cascaded_context[0] = sws_getContext(srcW, srcH, srcFormat,
-                                                    srcW, srcH, tmpFormat,
-                                                    flags, srcFilter, NULL, c->param);
+            c->cascaded_context[0] = get_cascaded_context(c, srcW, srcH, srcFormat,
+                                                             srcW, srcH, tmpFormat,
+                                                             flags, srcFilter, NULL);
             if (!c->cascaded_context[0])
                 return -1;
 
-            c->cascaded_context[1] = sws_getContext(srcW, srcH, tmpFormat,
-                                                    dstW, dstH, dstFormat,
-                                                    flags, NULL, dstFilter, c->param);
+            c->cascaded_context[1] = get_cascaded_context(c, srcW, srcH, tmpFormat,
+                                                             dstW, dstH, dstFormat,
+                                                             flags, NULL, dstFilter);
             if (!c->cascaded_context[1])
                 return -1;
             return 0;
@@ -1582,6 +1685,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
             if (!c->cascaded_context[0])
                 return -1;
             c->cascaded_context[0]->alphablend = c->alphablend;
+            c->cascaded_context[0]->nb_threads = c->nb_threads;
             ret = sws_init_context(c->cascaded_context[0], NULL , NULL);
             if (ret < 0)
                 return ret;
@@ -1594,6 +1698,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
 
             c->cascaded_context[1]->srcRange = c->srcRange;
             c->cascaded_context[1]->dstRange = c->dstRange;
+            c->cascaded_context[1]->nb_threads = c->nb_threads;
             ret = sws_init_context(c->cascaded_context[1], srcFilter , dstFilter);
             if (ret < 0)
                 return ret;
@@ -1812,7 +1917,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
             av_log(c, AV_LOG_INFO,
                     "using alpha blendaway %s -> %s special converter\n",
                     av_get_pix_fmt_name(srcFormat), av_get_pix_fmt_name(dstFormat));
-        return 0;
+        return context_init_threaded(c, srcFilter, dstFilter);
     }
 
     /* unscaled special cases */
@@ -1826,12 +1931,16 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                 av_log(c, AV_LOG_INFO,
                        "using unscaled %s -> %s special converter\n",
                        av_get_pix_fmt_name(srcFormat), av_get_pix_fmt_name(dstFormat));
-            return 0;
+            return context_init_threaded(c, srcFilter, dstFilter);
         }
     }
 
     c->swscale = ff_getSwsFunc(c);
-    return ff_init_filters(c);
+    ret = ff_init_filters(c);
+    if (ret < 0)
+        return ret;
+
+    return context_init_threaded(c, srcFilter, dstFilter);
 fail: // FIXME replace things by appropriate error codes
     if (ret == RETCODE_USE_CASCADE)  {
         int tmpW = sqrt(srcW * (int64_t)dstW);
@@ -1849,15 +1958,15 @@ fail: // FIXME replace things by appropriate error codes
         if (ret < 0)
             return ret;
 
-        c->cascaded_context[0] = sws_getContext(srcW, srcH, srcFormat,
-                                                tmpW, tmpH, tmpFormat,
-                                                flags, srcFilter, NULL, c->param);
+        c->cascaded_context[0] = get_cascaded_context(c, srcW, srcH, srcFormat,
+                                                         tmpW, tmpH, tmpFormat,
+                                                         flags, srcFilter, NULL);
         if (!c->cascaded_context[0])
             return -1;
 
-        c->cascaded_context[1] = sws_getContext(tmpW, tmpH, tmpFormat,
-                                                dstW, dstH, dstFormat,
-                                                flags, NULL, dstFilter, c->param);
+        c->cascaded_context[1] = get_cascaded_context(c, tmpW, tmpH, tmpFormat,
+                                                         dstW, dstH, dstFormat,
+                                                         flags, NULL, dstFilter);
         if (!c->cascaded_context[1])
             return -1;
         return 0;
@@ -2316,6 +2425,11 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    avpriv_slicethread_free(&c->slicethread);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
 
@@ -36,6 +36,7 @@ pw_16:         times 8 dw 16
 pw_32:         times 8 dw 32
 pw_512:        times 8 dw 512
 pw_1024:       times 8 dw 1024
+nv12_interleave: db 0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15
 
 SECTION .text
 
@@ -423,3 +424,195 @@ yuv2plane1_fn  9, 5, 3
 yuv2plane1_fn 10, 5, 3
 yuv2plane1_fn 16, 5, 3
 %endif
+
+;-----------------------------------------------------------------------------
+; vertical line scaling with exact 32-bit sums
+;
+; void yuv2planeX_<output_size>_<opt>(const int16_t *filter, int filterSize,
+;                                     const int16_t **src, uint8_t *dst, int w,
+;                                     const int32_t *init)
+; and
+; void yuv2nv12cX_<output_size>_<opt>(const int16_t *filter, int filterSize,
+;                                     const int16_t **src0, const int16_t **src1,
+;                                     uint8_t *dst, int w, const int32_t *init)
+;
+; Unlike above, $filterSize can be any number, and each pixel is computed as in
+; C. $w is a multiple of mmsize/2. $init holds 16 dwords with the starting sums
+; of pixels 0-3 of each 128-bit lane, then 16 for pixels 4-7, carrying the
+; dither or the rounding; yuv2nv12cX reads another 32 for src1. yuv2nv12cX
+; interleaves the output of src0 and src1.
+;-----------------------------------------------------------------------------
+
+; %1, %2: sums of pixels 0-3 and 4-7 of each lane, %3: source lines,
+; %4, %5: starting sums
+%macro VFILTER 5
+    mova           m%1, m%4
+    mova           m%2, m%5
+    xor             jd, jd
+    test        pairsd, pairsd
+    jz %%odd
+%%pair:
+    mov            p0q, [%3+jq*8]
+    mov            p1q, [%3+jq*8+8]
+    movu            m4, [p0q+posq*2]
+    movu            m5, [p1q+posq*2]
+    vpbroadcastd    m6, [filterq+jq*2]
+    punpckhwd       m7, m4, m5
+    punpcklwd       m4, m5
+    pmaddwd         m4, m6
+    pmaddwd         m7, m6
+    paddd          m%1, m4
+    paddd          m%2, m7
+    add             jd, 2
+    cmp             jd, pairsd
+    jl %%pair
+%%odd:
+    cmp             jd, fltsized
+    je %%done
+    ; pair the last line with itself and its coefficient with 0
+    mov            p0q, [%3+jq*8]
+    movzx          p1d, word [filterq+jq*2]
+    movu            m4, [p0q+posq*2]
+    movd           xm6, p1d
+    vpbroadcastd    m6, xm6
+    punpckhwd       m7, m4, m4
+    punpcklwd       m4, m4
+    pmaddwd         m4, m6
+    pmaddwd         m7, m6
+    paddd          m%1, m4
+    paddd          m%2, m7
+%%done:
+%endmacro
+
+; name, output bits, left shift
+%macro yuv2planeX_exact_fn 3
+cglobal yuv2planeX_%1, 6, 11, 13, filter, fltsize, src, dst, w, init, pos, j, p0, p1, pairs
+    movu            m8, [initq]
+    movu            m9, [initq+64]
+%if %2 > 8
+    mov            p0d, (1 << %2) - 1
+    movd          xm12, p0d
+    vpbroadcastw   m12, xm12
+%endif
+    mov         pairsd, fltsized
+    and         pairsd, ~1
+    xor           posd, posd
+.loop:
+    VFILTER          0, 1, srcq, 8, 9
+%if %2 == 8
+    psrad           m0, 19
+    psrad           m1, 19
+    packssdw        m0, m1
+%if mmsize == 64
+    vextracti64x4  ym1, m0, 1
+    packuswb       ym0, ym1
+    vpermq         ym0, ym0, q3120
+    movu  [dstq+posq], ym0
+%else
+    vextracti128   xm1, m0, 1
+    packuswb       xm0, xm1
+    movu  [dstq+posq], xm0
+%endif
+%else ; %2 > 8
+    psrad           m0, 27 - %2
+    psrad           m1, 27 - %2
+    packusdw        m0, m1
+    pminuw          m0, m12
+%if %3
+    psllw           m0, %3
+%endif
+    movu [dstq+posq*2], m0
+%endif
+    add           posd, mmsize/2
+    cmp           posd, wd
+    jl .loop
+    RET
+%endmacro
+
+; name, output bits
+%macro yuv2nv12cX_exact_fn 2
+cglobal yuv2nv12cX_%1, 7, 12, 13, filter, fltsize, src0, src1, dst, w, init, pos, j, p0, p1, pairs
+    movu            m8, [initq]
+    movu            m9, [initq+64]
+    movu           m10, [initq+128]
+    movu           m11, [initq+192]
+%if %2 == 8
+    vbroadcasti128 m12, [nv12_interleave]
+%else
+    mov            p0d, (1 << %2) - 1
+    movd          xm12, p0d
+    vpbroadcastw   m12, xm12
+%endif
+    mov         pairsd, fltsized
+    and         pairsd, ~1
+    xor           posd, posd
+.loop:
+    VFILTER          0, 1, src0q, 8, 9
+    VFILTER          2, 3, src1q, 10, 11
+%if %2 == 8
+    psrad           m0, 19
+    psrad           m1, 19
+    psrad           m2, 19
+    psrad           m3, 19
+    packssdw        m0, m1
+    packssdw        m2, m3
+    packuswb        m0, m2
+    pshufb          m0, m12
+    movu [dstq+posq*2], m0
+%else ; %2 > 8
+    psrad           m0, 27 - %2
+    psrad           m1, 27 - %2
+    psrad           m2, 27 - %2
+    psrad           m3, 27 - %2
+    packusdw        m0, m1
+    packusdw        m2, m3
+    pminuw          m0, m12
+    pminuw          m2, m12
+    psllw           m0, 16 - %2
+    psllw           m2, 16 - %2
+    punpcklwd       m1, m0, m2
+    punpckhwd       m0, m2
+    ; put the pixels 0-3 and 4-7 of each lane next to each other
+%if mmsize == 64
+    vshufi32x4      m2, m1, m0, q1010
+    vshufi32x4      m3, m1, m0, q3232
+    vshufi32x4      m2, m2, m2, q3120
+    vshufi32x4      m3, m3, m3, q3120
+%else
+    vperm2i128      m2, m1, m0, 0x20
+    vperm2i128      m3, m1, m0, 0x31
+%endif
+    movu [dstq+posq*4], m2
+    movu [dstq+posq*4+mmsize], m3
+%endif
+    add           posd, mmsize/2
+    cmp           posd, wd
+    jl .loop
+    RET
+%endmacro
+
+%if ARCH_X86_64
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2planeX_exact_fn    8,  8, 0
+yuv2planeX_exact_fn    9,  9, 0
+yuv2planeX_exact_fn   10, 10, 0
+yuv2planeX_exact_fn   12, 12, 0
+yuv2planeX_exact_fn   14, 14, 0
+yuv2planeX_exact_fn p010, 10, 6
+yuv2nv12cX_exact_fn nv12,  8
+yuv2nv12cX_exact_fn p010, 10
+%endif
+
+%if HAVE_AVX512_EXTERNAL
+INIT_ZMM avx512
+yuv2planeX_exact_fn    8,  8, 0
+yuv2planeX_exact_fn    9,  9, 0
+yuv2planeX_exact_fn   10, 10, 0
+yuv2planeX_exact_fn   12, 12, 0
+yuv2planeX_exact_fn   14, 14, 0
+yuv2planeX_exact_fn p010, 10, 6
+yuv2nv12cX_exact_fn nv12,  8
+yuv2nv12cX_exact_fn p010, 10
+%endif
+%endif ; ARCH_X86_64
@@ -381,6 +381,198 @@ INPUT_FUNCS(sse2);
 INPUT_FUNCS(ssse3);
 INPUT_FUNCS(avx);
 
+#if ARCH_X86_64
+#define VSCALEX_EXACT_FUNC(size, opt) \
+void ff_yuv2planeX_ ## size ## _ ## opt(const int16_t *filter, int filterSize, \
+                                        const int16_t **src, uint8_t *dest, int w, \
+                                        const int32_t *init)
+#define VSCALEX_NV12_EXACT_FUNC(size, opt) \
+void ff_yuv2nv12cX_ ## size ## _ ## opt(const int16_t *filter, int filterSize, \
+                                        const int16_t **src0, const int16_t **src1, \
+                                        uint8_t *dest, int w, const int32_t *init)
+#define VSCALEX_EXACT_FUNCS(opt) \
+    VSCALEX_EXACT_FUNC(8,    opt); \
+    VSCALEX_EXACT_FUNC(9,    opt); \
+    VSCALEX_EXACT_FUNC(10,   opt); \
+    VSCALEX_EXACT_FUNC(12,   opt); \
+    VSCALEX_EXACT_FUNC(14,   opt); \
+    VSCALEX_EXACT_FUNC(p010, opt); \
+    VSCALEX_NV12_EXACT_FUNC(nv12, opt); \
+    VSCALEX_NV12_EXACT_FUNC(p010, opt)
+
+VSCALEX_EXACT_FUNCS(avx2);
+VSCALEX_EXACT_FUNCS(avx512);
+
+/* The exact vertical scalers accumulate in 32 bits like the C code, so they
+ * match it bit for bit. The assembly handles blocks of 16 (AVX2) or 32
+ * (AVX-512) pixels, the remaining ones are done here. The starting sums hold
+ * the dither or rounding for the pixels 0-3 of each 128-bit lane, then for
+ * the pixels 4-7. */
+static void vscale_init_dither(int32_t *init, const uint8_t *dither, int offset)
+{
+    int k;
+
+    for (k = 0; k < 16; k++) {
+        init[k]      = dither[(k % 4     + offset) & 7] << 12;
+        init[k + 16] = dither[(k % 4 + 4 + offset) & 7] << 12;
+    }
+}
+
+static av_always_inline void
+yuv2planeX_8_exact(const int16_t *filter, int filterSize,
+                   const int16_t **src, uint8_t *dest, int dstW,
+                   const uint8_t *dither, int offset, int block,
+                   void (*vscale)(const int16_t *filter, int filterSize,
+                                  const int16_t **src, uint8_t *dest, int w,
+                                  const int32_t *init))
+{
+    DECLARE_ALIGNED(64, int32_t, init)[32];
+    int i = dstW & ~(block - 1), k;
+
+    if (i) {
+        vscale_init_dither(init, dither, offset);
+        vscale(filter, filterSize, src, dest, i, init);
+    }
+    for (; i < dstW; i++) {
+        int val = dither[(i + offset) & 7] << 12;
+        for (k = 0; k < filterSize; k++)
+            val += src[k][i] * filter[k];
+        dest[i] = av_clip_uint8(val >> 19);
+    }
+}
+
+static av_always_inline void
+yuv2planeX_16_exact(const int16_t *filter, int filterSize,
+                    const int16_t **src, uint8_t *dest8, int dstW,
+                    int output_bits, int shl, int block,
+                    void (*vscale)(const int16_t *filter, int filterSize,
+                                   const int16_t **src, uint8_t *dest, int w,
+                                   const int32_t *init))
+{
+    DECLARE_ALIGNED(64, int32_t, init)[32];
+    uint16_t *dest  = (uint16_t *)dest8;
+    const int shift = 11 + 16 - output_bits;
+    int i = dstW & ~(block - 1), k;
+
+    if (i) {
+        for (k = 0; k < 32; k++)
+            init[k] = 1 << (shift - 1);
+        vscale(filter, filterSize, src, dest8, i, init);
+    }
+    for (; i < dstW; i++) {
+        int val = 1 << (shift - 1);
+        for (k = 0; k < filterSize; k++)
+            val += src[k][i] * filter[k];
+        AV_WN16(&dest[i], av_clip_uintp2(val >> shift, output_bits) << shl);
+    }
+}
+
+static av_always_inline void
+yuv2nv12cX_exact(SwsContext *c, const int16_t *chrFilter, int chrFilterSize,
+                 const int16_t **chrUSrc, const int16_t **chrVSrc,
+                 uint8_t *dest, int chrDstW, int block,
+                 void (*vscale)(const int16_t *filter, int filterSize,
+                                const int16_t **src0, const int16_t **src1,
+                                uint8_t *dest, int w, const int32_t *init))
+{
+    DECLARE_ALIGNED(64, int32_t, init)[64];
+    const uint8_t *chrDither = c->chrDither8;
+    /* The plane written first into each pair of bytes, and its dither. */
+    int swap = c->dstFormat != AV_PIX_FMT_NV12 && c->dstFormat != AV_PIX_FMT_NV24;
+    const int16_t **first  = swap ? chrVSrc : chrUSrc;
+    const int16_t **second = swap ? chrUSrc : chrVSrc;
+    int i = chrDstW & ~(block - 1), k;
+
+    if (i) {
+        vscale_init_dither(init,      chrDither, swap ? 3 : 0);
+        vscale_init_dither(init + 32, chrDither, swap ? 0 : 3);
+        vscale(chrFilter, chrFilterSize, first, second, dest, i, init);
+    }
+    for (; i < chrDstW; i++) {
+        int a = chrDither[(i + (swap ? 3 : 0)) & 7] << 12;
+        int b = chrDither[(i + (swap ? 0 : 3)) & 7] << 12;
+        for (k = 0; k < chrFilterSize; k++) {
+            a += first[k][i]  * chrFilter[k];
+            b += second[k][i] * chrFilter[k];
+        }
+        dest[2 * i]     = av_clip_uint8(a >> 19);
+        dest[2 * i + 1] = av_clip_uint8(b >> 19);
+    }
+}
+
+static av_always_inline void
+yuv2p010cX_exact(const int16_t *chrFilter, int chrFilterSize,
+                 const int16_t **chrUSrc, const int16_t **chrVSrc,
+                 uint8_t *dest8, int chrDstW, int block,
+                 void (*vscale)(const int16_t *filter, int filterSize,
+                                const int16_t **src0, const int16_t **src1,
+                                uint8_t *dest, int w, const int32_t *init))
+{
+    DECLARE_ALIGNED(64, int32_t, init)[64];
+    uint16_t *dest = (uint16_t *)dest8;
+    int i = chrDstW & ~(block - 1), k;
+
+    if (i) {
+        for (k = 0; k < 64; k++)
+            init[k] = 1 << 16;
+        vscale(chrFilter, chrFilterSize, chrUSrc, chrVSrc, dest8, i, init);
+    }
+    for (; i < chrDstW; i++) {
+        int u = 1 << 16;
+        int v = 1 << 16;
+        for (k = 0; k < chrFilterSize; k++) {
+            u += chrUSrc[k][i] * chrFilter[k];
+            v += chrVSrc[k][i] * chrFilter[k];
+        }
+        AV_WL16(&dest[2 * i],     av_clip_uintp2(u >> 17, 10) << 6);
+        AV_WL16(&dest[2 * i + 1], av_clip_uintp2(v >> 17, 10) << 6);
+    }
+}
+
+#define VSCALEX_EXACT_WRAPPER(size, bits, shl, opt, block) \
+static void yuv2planeX_ ## size ## _exact_ ## opt(const int16_t *filter, int filterSize, \
+                                                  const int16_t **src, uint8_t *dest, \
+                                                  int dstW, const uint8_t *dither, \
+                                                  int offset) \
+{ \
+    yuv2planeX_16_exact(filter, filterSize, src, dest, dstW, bits, shl, block, \
+                        ff_yuv2planeX_ ## size ## _ ## opt); \
+}
+
+#define VSCALEX_EXACT_WRAPPERS(opt, block) \
+static void yuv2planeX_8_exact_ ## opt(const int16_t *filter, int filterSize, \
+                                       const int16_t **src, uint8_t *dest, \
+                                       int dstW, const uint8_t *dither, int offset) \
+{ \
+    yuv2planeX_8_exact(filter, filterSize, src, dest, dstW, dither, offset, \
+                       block, ff_yuv2planeX_8_ ## opt); \
+} \
+VSCALEX_EXACT_WRAPPER(9,     9, 0, opt, block) \
+VSCALEX_EXACT_WRAPPER(10,   10, 0, opt, block) \
+VSCALEX_EXACT_WRAPPER(12,   12, 0, opt, block) \
+VSCALEX_EXACT_WRAPPER(14,   14, 0, opt, block) \
+VSCALEX_EXACT_WRAPPER(p010, 10, 6, opt, block) \
+static void yuv2nv12cX_exact_ ## opt(SwsContext *c, const int16_t *chrFilter, \
+                                     int chrFilterSize, const int16_t **chrUSrc, \
+                                     const int16_t **chrVSrc, uint8_t *dest, \
+                                     int chrDstW) \
+{ \
+    yuv2nv12cX_exact(c, chrFilter, chrFilterSize, chrUSrc, chrVSrc, dest, \
+                     chrDstW, block, ff_yuv2nv12cX_nv12_ ## opt); \
+} \
+static void yuv2p010cX_exact_ ## opt(SwsContext *c, const int16_t *chrFilter, \
+                                     int chrFilterSize, const int16_t **chrUSrc, \
+                                     const int16_t **chrVSrc, uint8_t *dest, \
+                                     int chrDstW) \
+{ \
+    yuv2p010cX_exact(chrFilter, chrFilterSize, chrUSrc, chrVSrc, dest, \
+                     chrDstW, block, ff_yuv2nv12cX_p010_ ## opt); \
+}
+
+VSCALEX_EXACT_WRAPPERS(avx2,   16)
+VSCALEX_EXACT_WRAPPERS(avx512, 32)
+#endif /* ARCH_X86_64 */
+
 av_cold void ff_sws_init_swscale_x86(SwsContext *c)
 {
     int cpu_flags = av_get_cpu_flags();
@@ -441,6 +633,27 @@ switch(c->dstBpc){ \
     case 8:                                      vscalefn = ff_yuv2plane1_8_  ## opt1;  break; \
     default: av_assert0(c->dstBpc>8); \
     }
+#define ASSIGN_VSCALE_EXACT_FUNCS(opt) do { \
+    switch (c->dstBpc) { \
+    case 8:  if (!c->use_mmx_vfilter) c->yuv2planeX = yuv2planeX_8_exact_ ## opt; break; \
+    case 9:  if (!isBE(c->dstFormat)) c->yuv2planeX = yuv2planeX_9_exact_ ## opt; break; \
+    case 10: if (c->dstFormat == AV_PIX_FMT_P010LE) \
+                 c->yuv2planeX = yuv2planeX_p010_exact_ ## opt; \
+             else if (!isBE(c->dstFormat)) \
+                 c->yuv2planeX = yuv2planeX_10_exact_ ## opt; \
+             break; \
+    case 12: if (!isBE(c->dstFormat)) c->yuv2planeX = yuv2planeX_12_exact_ ## opt; break; \
+    case 14: if (!isBE(c->dstFormat)) c->yuv2planeX = yuv2planeX_14_exact_ ## opt; break; \
+    } \
+    switch (c->dstFormat) { \
+    case AV_PIX_FMT_NV12: \
+    case AV_PIX_FMT_NV21: \
+    case AV_PIX_FMT_NV24: \
+    case AV_PIX_FMT_NV42:   c->yuv2nv12cX = yuv2nv12cX_exact_ ## opt; break; \
+    case AV_PIX_FMT_P010LE: c->yuv2nv12cX = yuv2p010cX_exact_ ## opt; break; \
+    default: break; \
+    } \
+} while (0)
 #define case_rgb(x, X, opt) \
         case AV_PIX_FMT_ ## X: \
             c->lumToYV12 = ff_ ## x ## ToY_ ## opt; \
@@ -581,4 +794,11 @@ switch(c->dstBpc){ \
             break;
         }
     }
+
+#if ARCH_X86_64
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        ASSIGN_VSCALE_EXACT_FUNCS(avx2);
+    if (EXTERNAL_AVX512(cpu_flags))
+        ASSIGN_VSCALE_EXACT_FUNCS(avx512);
+#endif
 }
@@ -76,6 +76,36 @@ static void test_fcmul_add(const float *src0, const float *src1, const float *sr
     bench_new(odst, src1, src2, LEN);
 }
 
+#define IR_LEN 64
+
+static void test_fir_direct(const float *src, const float *ir)
+{
+    LOCAL_ALIGNED_32(float, cdst, [LEN]);
+    LOCAL_ALIGNED_32(float, odst, [LEN]);
+
+    declare_func(void, float *dst, const float *src, const float *ir,
+                 ptrdiff_t ir_len, ptrdiff_t len);
+
+    for (int ir_len = 16; ir_len <= IR_LEN; ir_len += 16) {
+        /* src needs not be aligned */
+        call_ref(cdst, src + 1, ir, ir_len, LEN - 1);
+        call_new(odst, src + 1, ir, ir_len, LEN - 1);
+        for (int i = 0; i < LEN - 1; i++) {
+            double t = 1.0;
+
+            for (int j = 0; j < ir_len; j++)
+                t += fabs(src[1 + i + j] * ir[j]);
+            if (!float_near_abs_eps(cdst[i], odst[i], t * ir_len * FLT_EPSILON)) {
+                fprintf(stderr, "%d/%d: %- .12f - %- .12f = % .12g\n",
+                        ir_len, i, cdst[i], odst[i], cdst[i] - odst[i]);
+                fail();
+                return;
+            }
+        }
+    }
+    bench_new(odst, src + 1, ir, IR_LEN, LEN - 1);
+}
+
 void checkasm_check_afir(void)
 {
     LOCAL_ALIGNED_32(float, src0, [LEN*2+8]);
@@ -92,4 +122,8 @@ void checkasm_check_afir(void)
     if (check_func(fir.fcmul_add, "fcmul_add"))
         test_fcmul_add(src0, src1, src2);
     report("fcmul_add");
+
+    if (check_func(fir.fir_direct, "fir_direct"))
+        test_fir_direct(src0, src1);
+    report("fir_direct");
 }
@@ -0,0 +1,83 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+
+#include "libavutil/mem.h"
+
+#define TX_FLOAT
+#include "libavutil/tx_priv.h"
+
+#include "checkasm.h"
+
+#define MAX_BITS 12
+#define MAX_LEN  (1 << MAX_BITS)
+
+static void check_fft_pass(void)
+{
+    LOCAL_ALIGNED_32(AVComplexFloat, src,  [MAX_LEN]);
+    LOCAL_ALIGNED_32(AVComplexFloat, dst0, [MAX_LEN]);
+    LOCAL_ALIGNED_32(AVComplexFloat, dst1, [MAX_LEN]);
+    LOCAL_ALIGNED_32(float, tab, [MAX_LEN / 2]);
+    const float scale = 1.0f;
+
+    declare_func(void, AVComplexFloat *z, const float *wre, unsigned int n);
+
+    for (int bits = 5; bits <= MAX_BITS; bits++) {
+        const int len = 1 << bits;
+        void (*pass)(AVComplexFloat *z, const float *wre, unsigned int n);
+        AVTXContext *s;
+        av_tx_fn tx;
+
+        if (av_tx_init(&s, &tx, AV_TX_FLOAT_FFT, 0, len, &scale, 0) < 0) {
+            fail();
+            return;
+        }
+        pass = s->fft_pass ? s->fft_pass : ff_tx_fft_pass_float;
+        av_tx_uninit(&s);
+
+        /* Same layout as the tx cosine tables */
+        for (int i = 0; i <= len / 4; i++)
+            tab[i] = cos(2 * M_PI * i / len);
+        for (int i = 1; i < len / 4; i++)
+            tab[len / 2 - i] = tab[i];
+
+        if (check_func(pass, "fft_pass_%d", len)) {
+            for (int i = 0; i < len; i++) {
+                src[i].re = (rnd() & 0xFFFFFF) / (float)0x800000 - 1.0f;
+                src[i].im = (rnd() & 0xFFFFFF) / (float)0x800000 - 1.0f;
+            }
+            memcpy(dst0, src, len * sizeof(*src));
+            memcpy(dst1, src, len * sizeof(*src));
+
+            call_ref(dst0, tab, len >> 3);
+            call_new(dst1, tab, len >> 3);
+            if (!float_near_abs_eps_array(&dst0->re, &dst1->re, 1.0e-5f, 2 * len))
+                fail();
+
+            memcpy(dst1, src, len * sizeof(*src));
+            bench_new(dst1, tab, len >> 3);
+        }
+    }
+    report("fft_pass");
+}
+
+void checkasm_check_av_tx(void)
+{
+    check_fft_pass();
+}
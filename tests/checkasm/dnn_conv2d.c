@@ -0,0 +1,76 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/dnn/dnn_backend_native_layer_conv2d.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+/* a 3x3 kernel over 32 input channels, on a full 64 pixels tile */
+#define MAX_FILTER_SIZE (3 * 3 * 32)
+#define MAX_WIDTH       64
+
+#define randomize_float(buf, len)                               \
+    do {                                                        \
+        int i;                                                  \
+        for (i = 0; i < len; i++)                               \
+            buf[i] = (float)rnd() / (UINT_MAX >> 1) - 1.0f;     \
+    } while (0)
+
+static void check_gemm4(const Conv2DDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, col,     [MAX_FILTER_SIZE * MAX_WIDTH]);
+    LOCAL_ALIGNED_32(float, kernel,  [4 * MAX_FILTER_SIZE]);
+    LOCAL_ALIGNED_32(float, acc_ref, [4 * MAX_WIDTH]);
+    LOCAL_ALIGNED_32(float, acc_new, [4 * MAX_WIDTH]);
+    /* { filter_size, w }: 1x1, 3x3 and 5x5 kernels over 1 to 32 channels */
+    static const int sizes[][2] = { { 1, 8 }, { 9, 16 }, { 25, 24 },
+                                    { 3 * 3 * 32, 64 }, { 9, 64 } };
+    int i;
+
+    declare_func(void, float *acc, const float *col, const float *kernel,
+                 int filter_size, int w);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        const int filter_size = sizes[i][0], w = sizes[i][1];
+
+        if (check_func(dsp->gemm4, "gemm4_%dx%d", filter_size, w)) {
+            randomize_float(col, filter_size * w);
+            randomize_float(kernel, 4 * filter_size);
+            randomize_float(acc_ref, 4 * w);
+            memcpy(acc_new, acc_ref, 4 * w * sizeof(*acc_ref));
+            call_ref(acc_ref, col, kernel, filter_size, w);
+            call_new(acc_new, col, kernel, filter_size, w);
+            /* the sums are of up to 288 products, fused or not */
+            if (!float_near_abs_eps_array(acc_ref, acc_new, 1e-4f, 4 * w))
+                fail();
+            bench_new(acc_new, col, kernel, filter_size, w);
+        }
+    }
+}
+
+void checkasm_check_dnn_conv2d(void)
+{
+    Conv2DDSPContext dsp;
+
+    ff_dnn_conv2d_init_dsp(&dsp);
+
+    check_gemm4(&dsp);
+    report("gemm4");
+}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/jpeg2000dwt.h"
+#include "libavutil/internal.h"
+
+#define N FF_DWT_COLS
+
+#define randomize_buffers(buf, bits)                                \
+    do {                                                            \
+        int i;                                                      \
+        for (i = 0; i < N; i++)                                     \
+            buf[i] = (int32_t)rnd() >> (32 - (bits));               \
+    } while (0)
+
+static void check_sd53(void (*func)(int32_t *dst, const int32_t *a, const int32_t *b, int n),
+                       const char *name)
+{
+    LOCAL_ALIGNED_32(int32_t, a,   [N]);
+    LOCAL_ALIGNED_32(int32_t, b,   [N]);
+    LOCAL_ALIGNED_32(int32_t, ref, [N]);
+    LOCAL_ALIGNED_32(int32_t, new, [N]);
+
+    declare_func(void, int32_t *dst, const int32_t *a, const int32_t *b, int n);
+
+    if (check_func(func, "jpeg2000_%s", name)) {
+        for (int n = 1; n <= N; n += 5) {
+            randomize_buffers(a,   28);
+            randomize_buffers(b,   28);
+            randomize_buffers(ref, 28);
+            memcpy(new, ref, N * sizeof(*ref));
+            call_ref(ref, a, b, n);
+            call_new(new, a, b, n);
+            if (memcmp(ref, new, n * sizeof(*ref)))
+                fail();
+        }
+        bench_new(new, a, b, N);
+    }
+}
+
+static void check_sd97_int(void (*func)(int32_t *dst, const int32_t *a, const int32_t *b,
+                                        int n, int coef),
+                           const char *name)
+{
+    static const int coefs[] = { 103949, 3472, 57862, 29066 };
+    LOCAL_ALIGNED_32(int32_t, a,   [N]);
+    LOCAL_ALIGNED_32(int32_t, b,   [N]);
+    LOCAL_ALIGNED_32(int32_t, ref, [N]);
+    LOCAL_ALIGNED_32(int32_t, new, [N]);
+
+    declare_func(void, int32_t *dst, const int32_t *a, const int32_t *b, int n, int coef);
+
+    if (check_func(func, "jpeg2000_%s", name)) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(coefs); i++) {
+            for (int n = N - 3 * i; n <= N; n += 2) {
+                randomize_buffers(a,   22);
+                randomize_buffers(b,   22);
+                randomize_buffers(ref, 24);
+                memcpy(new, ref, N * sizeof(*ref));
+                call_ref(ref, a, b, n, coefs[i]);
+                call_new(new, a, b, n, coefs[i]);
+                if (memcmp(ref, new, n * sizeof(*ref)))
+                    fail();
+            }
+        }
+        bench_new(new, a, b, N, coefs[0]);
+    }
+}
+
+void checkasm_check_jpeg2000dwt(void)
+{
+    int border[2][2] = { { 0, 64 }, { 0, 64 } };
+    DWTContext s53 = { 0 }, s97 = { 0 };
+
+    if (ff_jpeg2000_dwt_init(&s53, border, 2, FF_DWT53) < 0 ||
+        ff_jpeg2000_dwt_init(&s97, border, 2, FF_DWT97_INT) < 0)
+        goto end;
+
+    check_sd53(s53.sd53_hi, "sd53_hi");
+    check_sd53(s53.sd53_lo, "sd53_lo");
+    report("sd53");
+
+    check_sd97_int(s97.sd97_int_sub, "sd97_int_sub");
+    check_sd97_int(s97.sd97_int_add, "sd97_int_add");
+    report("sd97_int");
+
+end:
+    ff_dwt_destroy(&s53);
+    ff_dwt_destroy(&s97);
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+
+#include "libavcodec/lpc.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "checkasm.h"
+
+#define LEN 4609
+#define PAD FFALIGN(MAX_LPC_ORDER + 1, 8)
+
+static void test_compute_autocorr(LPCContext *lpc, double *data, int lag)
+{
+    double ref[MAX_LPC_ORDER + 1], new[MAX_LPC_ORDER + 1];
+
+    declare_func(void, const double *data, int len, int lag, double *autoc);
+
+    if (check_func(lpc->lpc_compute_autocorr, "lpc_compute_autocorr_%d", lag)) {
+        for (int len = LEN - 1; len <= LEN; len++) {
+            /* the samples past len must be zero */
+            for (int i = 0; i < LEN; i++)
+                data[i] = i < len ? (int32_t)rnd() >> 12 : 0;
+
+            call_ref(data, len, lag, ref);
+            call_new(data, len, lag, new);
+            for (int i = 0; i <= lag; i++) {
+                double eps = 1.0;
+
+                for (int j = i; j < len; j++)
+                    eps += fabs(data[j] * data[j - i]);
+                if (fabs(ref[i] - new[i]) > eps * 16 * DBL_EPSILON) {
+                    fprintf(stderr, "%d/%d: %- .12f - %- .12f = % .12g\n",
+                            lag, i, ref[i], new[i], ref[i] - new[i]);
+                    fail();
+                    return;
+                }
+            }
+        }
+        bench_new(data, LEN, lag, new);
+    }
+}
+
+void checkasm_check_lpc(void)
+{
+    static const int lags[] = { 8, 12, 31, 32 };
+    LPCContext lpc;
+    double *buf = av_mallocz((PAD + LEN + 2) * sizeof(*buf));
+    double *data = buf + PAD;
+
+    if (!buf || ff_lpc_init(&lpc, LEN, MAX_LPC_ORDER, FF_LPC_TYPE_LEVINSON) < 0) {
+        av_free(buf);
+        fail();
+        return;
+    }
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(lags); i++)
+        test_compute_autocorr(&lpc, data, lags[i]);
+    report("compute_autocorr");
+
+    ff_lpc_end(&lpc);
+    av_free(buf);
+}
@@ -0,0 +1,71 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixelutils.h"
+
+#define STRIDE 96
+#define HEIGHT 32
+
+#define randomize_buffers(buf, size)               \
+    do {                                           \
+        int j;                                     \
+        for (j = 0; j < size; j++)                 \
+            buf[j] = rnd();                        \
+    } while (0)
+
+static void check_sad(int n, int aligned)
+{
+    LOCAL_ALIGNED_32(uint8_t, src1, [STRIDE * (HEIGHT + 1)]);
+    LOCAL_ALIGNED_32(uint8_t, src2, [STRIDE * (HEIGHT + 1)]);
+    static const char *const align_names[] = { "unaligned", "aligned1", "aligned2" };
+    const int size = 1 << n;
+    av_pixelutils_sad_fn sad;
+
+    declare_func_emms(AV_CPU_FLAG_MMX, int, const uint8_t *src1, ptrdiff_t stride1,
+                                            const uint8_t *src2, ptrdiff_t stride2);
+
+    sad = av_pixelutils_get_sad_fn(n, n, aligned, NULL);
+    if (!sad)
+        return;
+
+    randomize_buffers(src1, STRIDE * (HEIGHT + 1));
+    randomize_buffers(src2, STRIDE * (HEIGHT + 1));
+
+    if (check_func(sad, "sad_%dx%d_%s", size, size, align_names[aligned])) {
+        for (int off = 0; off < 8; off++) {
+            const uint8_t *s1 = src1 + (aligned >= 1 ? 0 : off * 3 + STRIDE);
+            const uint8_t *s2 = src2 + (aligned == 2 ? 0 : off * 5 + 1);
+            int res_ref = call_ref(s1, STRIDE, s2, STRIDE);
+            int res_new = call_new(s1, STRIDE, s2, STRIDE);
+            if (res_ref != res_new)
+                fail();
+        }
+        bench_new(src1, STRIDE, src2 + 1, STRIDE);
+    }
+}
+
+void checkasm_check_pixelutils(void)
+{
+    for (int aligned = 0; aligned < 3; aligned++) {
+        for (int n = 1; n <= 5; n++)
+            check_sad(n, aligned);
+        report("sad_%s", aligned ? aligned == 1 ? "aligned1" : "aligned2" : "unaligned");
+    }
+}
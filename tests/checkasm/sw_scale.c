@@ -0,0 +1,192 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#include "checkasm.h"
+
+#define MAX_WIDTH        1920
+#define MAX_LINES  16
+
+static const int widths[]       = { 8, 16, 31, 64, 100, 1920 };
+static const int filter_sizes[] = { 2, 4, 6, 8, 12, 16 };
+/* Chroma filters are not padded to an even size when a single tap is
+ * enough, and yuv2nv12cX has no one-tap variant. */
+static const int chr_filter_sizes[] = { 1, 2, 3, 4, 5, 6, 8, 12, 16 };
+
+static const uint8_t dither[8] = { 64, 9, 22, 117, 5, 81, 33, 120 };
+
+static SwsContext *init_context(enum AVPixelFormat dst_fmt)
+{
+    SwsContext *c = sws_alloc_context();
+
+    if (!c)
+        return NULL;
+    /* Scale, so that the generic scaler is set up instead of an unscaled
+     * converter. Accurate rounding keeps the generic filter layout for
+     * 8-bit output. */
+    av_opt_set_int(c, "srcw",       MAX_WIDTH / 2, 0);
+    av_opt_set_int(c, "srch",       16, 0);
+    av_opt_set_int(c, "dstw",       MAX_WIDTH, 0);
+    av_opt_set_int(c, "dsth",       32, 0);
+    av_opt_set_int(c, "src_format", AV_PIX_FMT_YUV420P, 0);
+    av_opt_set_int(c, "dst_format", dst_fmt, 0);
+    av_opt_set_int(c, "sws_flags",  SWS_BICUBIC | SWS_ACCURATE_RND, 0);
+    if (sws_init_context(c, NULL, NULL) < 0) {
+        sws_freeContext(c);
+        return NULL;
+    }
+    return c;
+}
+
+static void randomize_lines(int16_t *lines, int nb_lines)
+{
+    int i;
+
+    /* 15-bit intermediates, as produced by the horizontal scalers */
+    for (i = 0; i < nb_lines * MAX_WIDTH; i++)
+        lines[i] = rnd() & 0x7fff;
+}
+
+static void randomize_filter(int16_t *filter, int filter_size)
+{
+    int i;
+
+    for (i = 0; i < filter_size; i++)
+        filter[i] = (rnd() & 0x1fff) - 0x1000;
+}
+
+static void check_yuv2planeX(enum AVPixelFormat dst_fmt)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(dst_fmt);
+    int bytes = desc->comp[0].depth > 8 ? 2 : 1;
+    LOCAL_ALIGNED_32(int16_t, lines, [MAX_LINES * MAX_WIDTH]);
+    LOCAL_ALIGNED_32(int16_t, filter, [MAX_LINES]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_WIDTH * 2]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_WIDTH * 2]);
+    const int16_t *src[MAX_LINES];
+    SwsContext *c;
+    int i, j, offset;
+
+    declare_func(void, const int16_t *filter, int filterSize,
+                 const int16_t **src, uint8_t *dest, int dstW,
+                 const uint8_t *dither, int offset);
+
+    if (!(c = init_context(dst_fmt)))
+        return;
+
+    randomize_lines(lines, MAX_LINES);
+    for (i = 0; i < MAX_LINES; i++)
+        src[i] = lines + i * MAX_WIDTH;
+
+    if (check_func(c->yuv2planeX, "yuv2planeX_%s", desc->name)) {
+        for (i = 0; i < FF_ARRAY_ELEMS(filter_sizes); i++) {
+            for (j = 0; j < FF_ARRAY_ELEMS(widths); j++) {
+                for (offset = 0; offset <= 3; offset += 3) {
+                    randomize_filter(filter, filter_sizes[i]);
+                    memset(dst0, 0, MAX_WIDTH * 2);
+                    memset(dst1, 0, MAX_WIDTH * 2);
+                    call_ref(filter, filter_sizes[i], src, dst0, widths[j], dither, offset);
+                    call_new(filter, filter_sizes[i], src, dst1, widths[j], dither, offset);
+                    if (memcmp(dst0, dst1, widths[j] * bytes))
+                        fail();
+                }
+            }
+        }
+        bench_new(filter, 8, src, dst1, MAX_WIDTH, dither, 0);
+    }
+
+    sws_freeContext(c);
+}
+
+static void check_yuv2nv12cX(enum AVPixelFormat dst_fmt)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(dst_fmt);
+    int bytes = desc->comp[1].depth > 8 ? 4 : 2;
+    LOCAL_ALIGNED_32(int16_t, ulines, [MAX_LINES * MAX_WIDTH]);
+    LOCAL_ALIGNED_32(int16_t, vlines, [MAX_LINES * MAX_WIDTH]);
+    LOCAL_ALIGNED_32(int16_t, filter, [MAX_LINES]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_WIDTH * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_WIDTH * 4]);
+    const int16_t *usrc[MAX_LINES], *vsrc[MAX_LINES];
+    SwsContext *c;
+    int i, j;
+
+    declare_func(void, SwsContext *c, const int16_t *chrFilter, int chrFilterSize,
+                 const int16_t **chrUSrc, const int16_t **chrVSrc,
+                 uint8_t *dest, int chrDstW);
+
+    if (!(c = init_context(dst_fmt)))
+        return;
+
+    /* normally set per frame by swscale() */
+    c->chrDither8 = dither;
+
+    randomize_lines(ulines, MAX_LINES);
+    randomize_lines(vlines, MAX_LINES);
+    for (i = 0; i < MAX_LINES; i++) {
+        usrc[i] = ulines + i * MAX_WIDTH;
+        vsrc[i] = vlines + i * MAX_WIDTH;
+    }
+
+    if (check_func(c->yuv2nv12cX, "yuv2nv12cX_%s", desc->name)) {
+        for (i = 0; i < FF_ARRAY_ELEMS(chr_filter_sizes); i++) {
+            for (j = 0; j < FF_ARRAY_ELEMS(widths); j++) {
+                randomize_filter(filter, chr_filter_sizes[i]);
+                memset(dst0, 0, MAX_WIDTH * 4);
+                memset(dst1, 0, MAX_WIDTH * 4);
+                call_ref(c, filter, chr_filter_sizes[i], usrc, vsrc, dst0, widths[j]);
+                call_new(c, filter, chr_filter_sizes[i], usrc, vsrc, dst1, widths[j]);
+                if (memcmp(dst0, dst1, widths[j] * bytes))
+                    fail();
+            }
+        }
+        bench_new(c, filter, 8, usrc, vsrc, dst1, MAX_WIDTH);
+    }
+
+    sws_freeContext(c);
+}
+
+void checkasm_check_sw_scale(void)
+{
+    static const enum AVPixelFormat planar_fmts[] = {
+        AV_PIX_FMT_YUV420P,     AV_PIX_FMT_YUV420P9LE,  AV_PIX_FMT_YUV420P10LE,
+        AV_PIX_FMT_YUV420P12LE, AV_PIX_FMT_YUV420P14LE, AV_PIX_FMT_P010LE,
+    };
+    static const enum AVPixelFormat semiplanar_fmts[] = {
+        AV_PIX_FMT_NV12, AV_PIX_FMT_NV21, AV_PIX_FMT_P010LE,
+    };
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(planar_fmts); i++)
+        check_yuv2planeX(planar_fmts[i]);
+    report("yuv2planeX");
+
+    for (i = 0; i < FF_ARRAY_ELEMS(semiplanar_fmts); i++)
+        check_yuv2nv12cX(semiplanar_fmts[i]);
+    report("yuv2nv12cX");
+}
@@ -0,0 +1,133 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/nnedi.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define MAX_NEURONS 512
+#define MAX_LEN     288
+#define MAX_WEIGHTS (MAX_NEURONS * 32)
+
+#define randomize_float(buf, len, range)                              \
+    do {                                                              \
+        int i;                                                        \
+        for (i = 0; i < len; i++)                                     \
+            buf[i] = (float)rnd() / (UINT_MAX >> 1) * range - range;  \
+    } while (0)
+
+static void check_dot_prods_float(const NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, data,     [MAX_LEN]);
+    LOCAL_ALIGNED_32(float, weights,  [4 * MAX_LEN]);
+    LOCAL_ALIGNED_32(float, vals_ref, [4]);
+    LOCAL_ALIGNED_32(float, vals_new, [4]);
+    /* prescreener and predictor layer sizes */
+    static const int lens[] = { 32, 48, 64, 96, 128, 192, 288 };
+    int i;
+
+    declare_func(void, const float *data, const float *weights,
+                 float *vals, int n, int len);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {
+        const int len = lens[i];
+
+        if (check_func(dsp->dot_prods_float, "dot_prods_float_%d", len)) {
+            randomize_float(data, len, 1.0f);
+            randomize_float(weights, 4 * len, 1.0f);
+            call_ref(data, weights, vals_ref, 4, len);
+            call_new(data, weights, vals_new, 4, len);
+            if (!float_near_abs_eps_array(vals_ref, vals_new, 1e-4f, 4))
+                fail();
+            bench_new(data, weights, vals_new, 4, len);
+        }
+    }
+}
+
+static void check_dot_prods_int16(const NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(int16_t, data,     [MAX_LEN]);
+    LOCAL_ALIGNED_32(int16_t, weights,  [MAX_WEIGHTS]);
+    LOCAL_ALIGNED_32(int32_t, vals_ref, [MAX_NEURONS]);
+    LOCAL_ALIGNED_32(int32_t, vals_new, [MAX_NEURONS]);
+    /* { neurons, length }: prescreeners, then predictors */
+    static const int sizes[][2] = { { 4, 48 }, { 4, 64 }, { 32, 288 },
+                                    { 64, 128 }, { 512, 32 } };
+    int i, j;
+
+    declare_func(void, const int16_t *data, const int16_t *weights,
+                 int32_t *vals, int n, int len);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        const int n = sizes[i][0], len = sizes[i][1];
+
+        if (check_func(dsp->dot_prods_int16, "dot_prods_int16_%dx%d", n, len)) {
+            /* 8-bit pixels and weights small enough for the 32-bit sums
+             * not to overflow: 255 * 2^14 * 288 < 2^31 */
+            for (j = 0; j < len; j++)
+                data[j] = rnd() & 0xff;
+            for (j = 0; j < n * len; j++)
+                weights[j] = (int)(rnd() & 0x7fff) - 0x4000;
+            call_ref(data, weights, vals_ref, n, len);
+            call_new(data, weights, vals_new, n, len);
+            if (memcmp(vals_ref, vals_new, n * sizeof(*vals_ref)))
+                fail();
+            bench_new(data, weights, vals_new, n, len);
+        }
+    }
+}
+
+static void check_exp(const NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, src,     [MAX_NEURONS / 2]);
+    LOCAL_ALIGNED_32(float, dst_ref, [MAX_NEURONS / 2]);
+    LOCAL_ALIGNED_32(float, dst_new, [MAX_NEURONS / 2]);
+    const int n = MAX_NEURONS / 2;
+
+    declare_func(void, float *s, int n);
+
+    if (check_func(dsp->exp, "exp")) {
+        /* also covers the clipping to [-80, 80] */
+        randomize_float(src, n, 90.0f);
+        memcpy(dst_ref, src, n * sizeof(*src));
+        memcpy(dst_new, src, n * sizeof(*src));
+        call_ref(dst_ref, n);
+        call_new(dst_new, n);
+        if (!float_near_ulp_array(dst_ref, dst_new, 4, n))
+            fail();
+        bench_new(dst_new, n);
+    }
+}
+
+void checkasm_check_vf_nnedi(void)
+{
+    NNEDIDSPContext dsp;
+
+    ff_nnedi_init(&dsp);
+
+    check_dot_prods_float(&dsp);
+    report("dot_prods_float");
+
+    check_dot_prods_int16(&dsp);
+    report("dot_prods_int16");
+
+    check_exp(&dsp);
+    report("exp");
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/paletteuse.h"
+#include "libavutil/mem.h"
+
+#define NB_ENTRIES 256
+
+static void check_color_dist(void)
+{
+    LOCAL_ALIGNED_32(int16_t, pal,      [NB_ENTRIES * 4]);
+    LOCAL_ALIGNED_32(int32_t, dist_ref, [NB_ENTRIES]);
+    LOCAL_ALIGNED_32(int32_t, dist_new, [NB_ENTRIES]);
+    int16_t target[4];
+    PaletteUseDSPContext dsp;
+    int i;
+
+    declare_func(void, int32_t *dist, const int16_t *pal,
+                 const int16_t *target, int n);
+
+    ff_paletteuse_init(&dsp);
+
+    for (i = 0; i < NB_ENTRIES; i++) {
+        /* some entries use the out of range value of the ignored colors */
+        const int skip = !(rnd() & 31);
+        pal[4*i + 0] = skip ? 1023 : rnd() & 0xff;
+        pal[4*i + 1] = skip ? 1023 : rnd() & 0xff;
+        pal[4*i + 2] = skip ? 1023 : rnd() & 0xff;
+        pal[4*i + 3] = 0;
+    }
+    target[0] = rnd() & 0xff;
+    target[1] = rnd() & 0xff;
+    target[2] = rnd() & 0xff;
+    target[3] = 0;
+
+    if (check_func(dsp.color_dist, "color_dist")) {
+        memset(dist_ref, 0, NB_ENTRIES * sizeof(*dist_ref));
+        memset(dist_new, 0, NB_ENTRIES * sizeof(*dist_new));
+        call_ref(dist_ref, pal, target, NB_ENTRIES);
+        call_new(dist_new, pal, target, NB_ENTRIES);
+        if (memcmp(dist_ref, dist_new, NB_ENTRIES * sizeof(*dist_ref)))
+            fail();
+        bench_new(dist_new, pal, target, NB_ENTRIES);
+    }
+}
+
+void checkasm_check_vf_paletteuse(void)
+{
+    check_color_dist();
+    report("color_dist");
+}
@@ -0,0 +1,69 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/psnr.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 1931
+
+#define randomize_buffers(buf, size, mask)         \
+    do {                                           \
+        int j;                                     \
+        for (j = 0; j < size; j++)                 \
+            buf[j] = rnd() & mask;                 \
+    } while (0)
+
+static void check_sse_line(int bpp)
+{
+    LOCAL_ALIGNED_32(uint16_t, buf, [WIDTH]);
+    LOCAL_ALIGNED_32(uint16_t, ref, [WIDTH]);
+    const int bytes = bpp > 8 ? 2 : 1;
+    PSNRDSPContext dsp;
+
+    declare_func(uint64_t, const uint8_t *buf, const uint8_t *ref, int w);
+
+    ff_psnr_init(&dsp, bpp);
+
+    if (bytes == 1) {
+        randomize_buffers(((uint8_t *)buf), WIDTH, 0xFF);
+        randomize_buffers(((uint8_t *)ref), WIDTH, 0xFF);
+    } else {
+        randomize_buffers(buf, WIDTH, (1 << bpp) - 1);
+        randomize_buffers(ref, WIDTH, (1 << bpp) - 1);
+    }
+
+    if (check_func(dsp.sse_line, "sse_line_%dbit", bytes * 8)) {
+        for (int w = 1; w <= WIDTH; w += 113) {
+            uint64_t res_ref = call_ref((const uint8_t *)buf, (const uint8_t *)ref, w);
+            uint64_t res_new = call_new((const uint8_t *)buf, (const uint8_t *)ref, w);
+            if (res_ref != res_new)
+                fail();
+        }
+        bench_new((const uint8_t *)buf, (const uint8_t *)ref, WIDTH);
+    }
+}
+
+void checkasm_check_vf_psnr(void)
+{
+    check_sse_line(8);
+    report("sse_line_8bit");
+
+    check_sse_line(12);
+    report("sse_line_16bit");
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/ssim.h"
+#include "libavutil/mem.h"
+
+/* number of 4x4 blocks in a line, the sum arrays have room for 3 more */
+#define BLOCKS 67
+#define STRIDE ((BLOCKS + 1) * 4)
+
+/* a reference line close to the main one, so that the scores are not all 0 */
+static void randomize_lines(uint16_t *buf, uint16_t *ref, int bpp)
+{
+    const int mask = (1 << bpp) - 1;
+
+    for (int i = 0; i < 8 * STRIDE; i++) {
+        buf[i] = rnd() & mask;
+        ref[i] = rnd() & 3 ? FFMIN(buf[i] + (rnd() & 7), mask) : rnd() & mask;
+    }
+}
+
+static void to_bytes(uint8_t *dst, const uint16_t *src, int bpp)
+{
+    if (bpp > 8)
+        memcpy(dst, src, 8 * STRIDE * 2);
+    else
+        for (int i = 0; i < 8 * STRIDE; i++)
+            dst[i] = src[i];
+}
+
+static void block_sums(int (*sums)[4], const uint16_t *buf, const uint16_t *ref)
+{
+    for (int z = 0; z < BLOCKS + 3; z++) {
+        int s1 = 0, s2 = 0, ss = 0, s12 = 0;
+
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                int a = buf[(z % BLOCKS) * 4 + x + y * STRIDE];
+                int b = ref[(z % BLOCKS) * 4 + x + y * STRIDE];
+
+                s1  += a;
+                s2  += b;
+                ss  += a * a + b * b;
+                s12 += a * b;
+            }
+        }
+        sums[z][0] = s1;
+        sums[z][1] = s2;
+        sums[z][2] = ss;
+        sums[z][3] = s12;
+    }
+}
+
+static void check_ssim_4x4_line(int bpp)
+{
+    LOCAL_ALIGNED_32(uint16_t, buf16, [8 * STRIDE]);
+    LOCAL_ALIGNED_32(uint16_t, ref16, [8 * STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, buf, [8 * STRIDE * 2]);
+    LOCAL_ALIGNED_32(uint8_t, ref, [8 * STRIDE * 2]);
+    LOCAL_ALIGNED_16(int, sums_ref, [(BLOCKS + 3) * 4]);
+    LOCAL_ALIGNED_16(int, sums_new, [(BLOCKS + 3) * 4]);
+    const ptrdiff_t stride = STRIDE * (bpp > 8 ? 2 : 1);
+    SSIMDSPContext dsp;
+
+    declare_func(void, const uint8_t *buf, ptrdiff_t buf_stride,
+                 const uint8_t *ref, ptrdiff_t ref_stride,
+                 int (*sums)[4], int w);
+
+    ff_ssim_init(&dsp, bpp);
+
+    randomize_lines(buf16, ref16, bpp);
+    to_bytes(buf, buf16, bpp);
+    to_bytes(ref, ref16, bpp);
+
+    if (check_func(dsp.ssim_4x4_line, "ssim_4x4_line_%dbit", bpp)) {
+        for (int w = 1; w <= BLOCKS; w += 11) {
+            memset(sums_ref, 0, sizeof(int) * (BLOCKS + 3) * 4);
+            memset(sums_new, 0, sizeof(int) * (BLOCKS + 3) * 4);
+            call_ref(buf, stride, ref, stride, (int (*)[4])sums_ref, w);
+            call_new(buf, stride, ref, stride, (int (*)[4])sums_new, w);
+            if (memcmp(sums_ref, sums_new, sizeof(int) * w * 4))
+                fail();
+        }
+        bench_new(buf, stride, ref, stride, (int (*)[4])sums_new, BLOCKS);
+    }
+}
+
+static void check_ssim_end_line(int bpp)
+{
+    LOCAL_ALIGNED_32(uint16_t, buf, [8 * STRIDE]);
+    LOCAL_ALIGNED_32(uint16_t, ref, [8 * STRIDE]);
+    LOCAL_ALIGNED_16(int, sum0, [(BLOCKS + 3) * 4]);
+    LOCAL_ALIGNED_16(int, sum1, [(BLOCKS + 3) * 4]);
+    const int max = (1 << bpp) - 1;
+    const int c1 = (int)(.01*.01*max*max*64 + .5);
+    const int c2 = (int)(.03*.03*max*max*64*63 + .5);
+    SSIMDSPContext dsp;
+
+    ff_ssim_init(&dsp, bpp);
+
+    randomize_lines(buf, ref, bpp);
+    block_sums((int (*)[4])sum0, buf, ref);
+    block_sums((int (*)[4])sum1, buf + 4 * STRIDE, ref + 4 * STRIDE);
+
+    if (bpp == 8) {
+        declare_func(double, const int (*sum0)[4], const int (*sum1)[4], int w);
+
+        if (check_func(dsp.ssim_end_line, "ssim_end_line_8bit")) {
+            for (int w = 1; w < BLOCKS; w++) {
+                double res_ref = call_ref((const int (*)[4])sum0, (const int (*)[4])sum1, w);
+                double res_new = call_new((const int (*)[4])sum0, (const int (*)[4])sum1, w);
+                if (!double_near_abs_eps(res_ref, res_new, 1e-9))
+                    fail();
+            }
+            bench_new((const int (*)[4])sum0, (const int (*)[4])sum1, BLOCKS - 1);
+        }
+    } else {
+        declare_func(double, const int (*sum0)[4], const int (*sum1)[4], int w,
+                     int c1, int c2);
+
+        if (check_func(dsp.ssim_end_line_12bit, "ssim_end_line_%dbit", bpp)) {
+            for (int w = 1; w < BLOCKS; w++) {
+                double res_ref = call_ref((const int (*)[4])sum0, (const int (*)[4])sum1, w, c1, c2);
+                double res_new = call_new((const int (*)[4])sum0, (const int (*)[4])sum1, w, c1, c2);
+                if (!double_near_abs_eps(res_ref, res_new, 1e-9))
+                    fail();
+            }
+            bench_new((const int (*)[4])sum0, (const int (*)[4])sum1, BLOCKS - 1, c1, c2);
+        }
+    }
+}
+
+void checkasm_check_vf_ssim(void)
+{
+    check_ssim_4x4_line(8);
+    report("ssim_4x4_line_8bit");
+
+    check_ssim_4x4_line(10);
+    check_ssim_4x4_line(12);
+    report("ssim_4x4_line_12bit");
+
+    check_ssim_end_line(8);
+    report("ssim_end_line_8bit");
+
+    check_ssim_end_line(10);
+    check_ssim_end_line(12);
+    report("ssim_end_line_12bit");
+}
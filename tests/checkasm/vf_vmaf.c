@@ -0,0 +1,144 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/vmaf.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define WIDTH      1928
+#define MAX_RADIUS 8
+#define STRIDE     (WIDTH + 2 * MAX_RADIUS)
+
+/* samples as converted by the filter: luma minus 128 */
+#define randomize_pixels(buf, len)                              \
+    do {                                                        \
+        int i;                                                  \
+        for (i = 0; i < len; i++)                               \
+            buf[i] = (float)(rnd() & 0xFF) - 128.0f;            \
+    } while (0)
+
+#define randomize_float(buf, len)                               \
+    do {                                                        \
+        int i;                                                  \
+        for (i = 0; i < len; i++)                               \
+            buf[i] = (float)rnd() / UINT_MAX;                   \
+    } while (0)
+
+static void check_vif_vfilter(const VMAFDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, a,       [WIDTH]);
+    LOCAL_ALIGNED_32(float, b,       [WIDTH]);
+    LOCAL_ALIGNED_32(float, dst_ref, [5 * STRIDE]);
+    LOCAL_ALIGNED_32(float, dst_new, [5 * STRIDE]);
+    float c;
+
+    declare_func(void, float *dst, ptrdiff_t stride, const float *a,
+                 const float *b, const float *c, int w);
+
+    if (check_func(dsp->vif_vfilter, "vif_vfilter")) {
+        randomize_pixels(a, WIDTH);
+        randomize_pixels(b, WIDTH);
+        randomize_float(dst_ref, 5 * STRIDE);
+        memcpy(dst_new, dst_ref, 5 * STRIDE * sizeof(*dst_ref));
+        randomize_float((&c), 1);
+        /* the filter writes at an offset of the radius into each row */
+        for (int w = 8; w <= WIDTH; w += 8 * 29) {
+            call_ref(dst_ref + 3, STRIDE, a, b, &c, w);
+            call_new(dst_new + 3, STRIDE, a, b, &c, w);
+        }
+        if (!float_near_abs_eps_array(dst_ref, dst_new, 1e-2f, 5 * STRIDE))
+            fail();
+        bench_new(dst_new + 3, STRIDE, a, b, &c, WIDTH);
+    }
+}
+
+static void check_vif_hfilter(const VMAFDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, src,     [STRIDE]);
+    LOCAL_ALIGNED_32(float, filter,  [2 * MAX_RADIUS + 1]);
+    LOCAL_ALIGNED_32(float, dst_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(float, dst_new, [WIDTH]);
+
+    declare_func(void, float *dst, const float *src, const float *filter,
+                 int len, int w);
+
+    for (int r = 2; r <= MAX_RADIUS; r *= 2) {
+        const int len = 2 * r + 1;
+
+        if (check_func(dsp->vif_hfilter, "vif_hfilter_%d", len)) {
+            randomize_pixels(src, STRIDE);
+            randomize_float(filter, len);
+            for (int w = 8; w <= WIDTH; w += 8 * 29) {
+                memset(dst_ref, 0, WIDTH * sizeof(*dst_ref));
+                memset(dst_new, 0, WIDTH * sizeof(*dst_new));
+                call_ref(dst_ref, src, filter, len, w);
+                call_new(dst_new, src, filter, len, w);
+                if (!float_near_abs_eps_array(dst_ref, dst_new, 1e-3f, WIDTH))
+                    fail();
+            }
+            bench_new(dst_new, src, filter, len, WIDTH);
+        }
+    }
+}
+
+static void check_adm_dwt_v(const VMAFDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, src,    [4 * WIDTH]);
+    LOCAL_ALIGNED_32(float, lo_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(float, lo_new, [WIDTH]);
+    LOCAL_ALIGNED_32(float, hi_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(float, hi_new, [WIDTH]);
+    const float *l[4] = { src, src + WIDTH, src + 2 * WIDTH, src + 3 * WIDTH };
+
+    declare_func(void, float *lo, float *hi, const float *l0, const float *l1,
+                 const float *l2, const float *l3, int w);
+
+    if (check_func(dsp->adm_dwt_v, "adm_dwt_v")) {
+        randomize_pixels(src, 4 * WIDTH);
+        for (int w = 8; w <= WIDTH; w += 8 * 29) {
+            memset(lo_ref, 0, WIDTH * sizeof(*lo_ref));
+            memset(lo_new, 0, WIDTH * sizeof(*lo_new));
+            memset(hi_ref, 0, WIDTH * sizeof(*hi_ref));
+            memset(hi_new, 0, WIDTH * sizeof(*hi_new));
+            call_ref(lo_ref, hi_ref, l[0], l[1], l[2], l[3], w);
+            call_new(lo_new, hi_new, l[0], l[1], l[2], l[3], w);
+            if (!float_near_abs_eps_array(lo_ref, lo_new, 1e-3f, WIDTH) ||
+                !float_near_abs_eps_array(hi_ref, hi_new, 1e-3f, WIDTH))
+                fail();
+        }
+        bench_new(lo_new, hi_new, l[0], l[1], l[2], l[3], WIDTH);
+    }
+}
+
+void checkasm_check_vf_vmaf(void)
+{
+    VMAFDSPContext dsp;
+
+    ff_vmaf_init_dsp(&dsp);
+
+    check_vif_vfilter(&dsp);
+    report("vif_vfilter");
+
+    check_vif_hfilter(&dsp);
+    report("vif_hfilter");
+
+    check_adm_dwt_v(&dsp);
+    report("adm_dwt_v");
+}
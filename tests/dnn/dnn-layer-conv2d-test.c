@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include "libavutil/lfg.h"
 #include "libavfilter/dnn/dnn_backend_native_layer_conv2d.h"
 
 #define EPSON 0.00001
@@ -105,6 +106,7 @@ static int test_with_same_dilate(void)
     params.kernel_size = 3;
     params.output_num = 2;
     params.padding_method = SAME;
+    ff_dnn_conv2d_init_dsp(&params.dsp);
 
     operands[0].data = input;
     operands[0].dims[0] = 1;
@@ -114,7 +116,7 @@ static int test_with_same_dilate(void)
     operands[1].data = NULL;
 
     input_indexes[0] = 0;
-    dnn_execute_layer_conv2d(operands, input_indexes, 1, &params);
+    dnn_execute_layer_conv2d(operands, input_indexes, 1, &params, NULL);
 
     output = operands[1].data;
     for (int i = 0; i < sizeof(expected_output) / sizeof(float); i++) {
@@ -205,6 +207,7 @@ static int test_with_valid(void)
     params.kernel_size = 3;
     params.output_num = 2;
     params.padding_method = VALID;
+    ff_dnn_conv2d_init_dsp(&params.dsp);
 
     operands[0].data = input;
     operands[0].dims[0] = 1;
@@ -214,7 +217,7 @@ static int test_with_valid(void)
     operands[1].data = NULL;
 
     input_indexes[0] = 0;
-    dnn_execute_layer_conv2d(operands, input_indexes, 1, &params);
+    dnn_execute_layer_conv2d(operands, input_indexes, 1, &params, NULL);
 
     output = operands[1].data;
     for (int i = 0; i < sizeof(expected_output) / sizeof(float); i++) {
@@ -229,12 +232,123 @@ static int test_with_valid(void)
     return 0;
 }
 
+static float reference_pel(const float *input, const ConvolutionalParams *params,
+                           int height, int width, int y, int x, int n_filter)
+{
+    int radius = params->kernel_size >> 1;
+    float sum = params->has_bias ? params->biases[n_filter] : 0.f;
+
+    for (int ky = 0; ky < params->kernel_size; ++ky) {
+        for (int kx = 0; kx < params->kernel_size; ++kx) {
+            for (int ch = 0; ch < params->input_num; ++ch) {
+                int y_pos = y + (ky - radius) * params->dilation;
+                int x_pos = x + (kx - radius) * params->dilation;
+                float pel;
+                if (params->padding_method == SAME_CLAMP_TO_EDGE) {
+                    y_pos = FFMIN(FFMAX(y_pos, 0), height - 1);
+                    x_pos = FFMIN(FFMAX(x_pos, 0), width - 1);
+                } else if (x_pos < 0 || x_pos >= width || y_pos < 0 || y_pos >= height) {
+                    continue;
+                }
+                pel = input[(y_pos * width + x_pos) * params->input_num + ch];
+                sum += pel * params->kernel[((n_filter * params->kernel_size + ky) * params->kernel_size + kx) *
+                                            params->input_num + ch];
+            }
+        }
+    }
+    return FFMAX(sum, 0.f);
+}
+
+/* compare against a direct convolution on an input wider than one GEMM tile,
+ * with the rows split into nb_jobs jobs */
+static int test_with_reference(DNNConvPaddingParam padding, int dilation, int nb_jobs)
+{
+    NativeContext ctx = { .nb_threads = nb_jobs };
+    const int height = 9, width = 150, input_num = 4, output_num = 7, kernel_size = 3;
+    ConvolutionalParams params;
+    DnnOperand operands[2] = { { { 0 } } };
+    int32_t input_indexes[1] = { 0 };
+    float *input  = av_malloc_array(height * width * input_num, sizeof(float));
+    float *kernel = av_malloc_array(output_num * kernel_size * kernel_size * input_num, sizeof(float));
+    float *bias   = av_malloc_array(output_num, sizeof(float));
+    float *output;
+    int pad_size, ret = 0;
+    AVLFG lfg;
+
+    if (!input || !kernel || !bias) {
+        ret = 1;
+        goto end;
+    }
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+    for (int i = 0; i < height * width * input_num; i++)
+        input[i] = av_lfg_get(&lfg) / (float)UINT_MAX;
+    for (int i = 0; i < output_num * kernel_size * kernel_size * input_num; i++)
+        kernel[i] = av_lfg_get(&lfg) / (float)UINT_MAX - 0.5f;
+    for (int i = 0; i < output_num; i++)
+        bias[i] = av_lfg_get(&lfg) / (float)UINT_MAX - 0.5f;
+
+    params.activation = RELU;
+    params.has_bias = 1;
+    params.biases = bias;
+    params.dilation = dilation;
+    params.input_num = input_num;
+    params.kernel = kernel;
+    params.kernel_size = kernel_size;
+    params.output_num = output_num;
+    params.padding_method = padding;
+    ff_dnn_conv2d_init_dsp(&params.dsp);
+
+    operands[0].data = input;
+    operands[0].dims[0] = 1;
+    operands[0].dims[1] = height;
+    operands[0].dims[2] = width;
+    operands[0].dims[3] = input_num;
+    operands[1].data = NULL;
+
+    if (dnn_execute_layer_conv2d(operands, input_indexes, 1, &params, &ctx)) {
+        ret = 1;
+        goto end;
+    }
+
+    output = operands[1].data;
+    pad_size = padding == VALID ? (kernel_size - 1) / 2 * dilation : 0;
+    for (int y = pad_size; y < height - pad_size; y++) {
+        for (int x = pad_size; x < width - pad_size; x++) {
+            for (int n = 0; n < output_num; n++) {
+                float expected = reference_pel(input, &params, height, width, y, x, n);
+                if (fabs(*output - expected) > EPSON) {
+                    printf("at (%d, %d, %d), output: %f, expected_output: %f\n", x, y, n, *output, expected);
+                    ret = 1;
+                    goto end;
+                }
+                output++;
+            }
+        }
+    }
+
+end:
+    av_freep(&operands[1].data);
+    av_freep(&input);
+    av_freep(&kernel);
+    av_freep(&bias);
+    return ret;
+}
+
 int main(int argc, char **argv)
 {
     if (test_with_valid())
         return 1;
     if (test_with_same_dilate())
         return 1;
+    if (test_with_reference(VALID, 1, 1))
+        return 1;
+    if (test_with_reference(SAME, 2, 1))
+        return 1;
+    if (test_with_reference(SAME_CLAMP_TO_EDGE, 1, 1))
+        return 1;
+    if (test_with_reference(SAME, 1, 4))
+        return 1;
 
     return 0;
 }
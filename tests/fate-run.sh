@@ -168,6 +168,66 @@ fmtstdout(){
     ffmpeg -bitexact "$@" -f $fmt -
 }
 
+# encode with one and with several threads and check that the outputs match
+enc_threads_cmp(){
+    encfile1="${outdir}/${test}.1.framecrc"
+    encfile4="${outdir}/${test}.4.framecrc"
+    cleanfiles="$encfile1 $encfile4"
+    ffmpeg "$@" -threads 1 -bitexact -f framecrc -y $(target_path $encfile1) || return
+    ffmpeg "$@" -threads 4 -bitexact -f framecrc -y $(target_path $encfile4) || return
+    diff $encfile1 $encfile4
+}
+
+filter_threads_cmp(){
+    outfile1="${outdir}/${test}.1.framecrc"
+    outfile4="${outdir}/${test}.4.framecrc"
+    cleanfiles="$outfile1 $outfile4"
+    ffmpeg -filter_threads 1 "$@" -bitexact -f framecrc -y $(target_path $outfile1) || return
+    ffmpeg -filter_threads 4 "$@" -bitexact -f framecrc -y $(target_path $outfile4) || return
+    diff $outfile1 $outfile4
+}
+
+index_cache_rb32(){
+    od -An -tu1 -j$2 -N4 "$1" | awk '{ print $1 * 16777216 + $2 * 65536 + $3 * 256 + $4 }'
+}
+
+index_cache_probe(){
+    run ffprobe${PROGSUF}${EXECSUF} -v verbose -index_cache "$cache" \
+        -show_entries format=duration:stream=duration -of compact "$src" 2>"$log" || return
+    grep -o "Restored the index of [0-9]* streams\|is damaged\|is stale" "$log"
+}
+
+index_cache(){
+    src=$1
+    damage=$2
+    cache="${outdir}/${test}.cache"
+    log="${outdir}/${test}.log"
+    cleanfiles="$cleanfiles $cache $log"
+    rm -f "$cache"
+    # read the whole input once to build the index and write the cache
+    ffmpeg -index_cache "$cache" -i "$src" -f null - 2>/dev/null || return
+    # offset of the first index entry of the first stream, following the
+    # layout documented in libavformat/indexcache.c
+    url_len=$(index_cache_rb32 "$cache" 8)
+    name_len=$(index_cache_rb32 "$cache" $((12 + url_len)))
+    # tag, version, url, demuxer name, file size, CRC, timings, nb_streams
+    header=$((4 + 4 + 4 + url_len + 4 + name_len + 8 + 4 + 1 + 3 * 8 + 1 + 4))
+    # id, time base, start time, duration, nb_entries of the first stream
+    entry=$((header + 4 + 2 * 4 + 2 * 8 + 4))
+    case "$damage" in
+    pos) printf '\177\377\377\377\377\377\377\377' |
+         dd of="$cache" bs=1 seek=$entry conv=notrunc 2>/dev/null ;;
+    ts)  printf '\000\000\000\000\000\000\000\000' |
+         dd of="$cache" bs=1 seek=$((entry + 32)) conv=notrunc 2>/dev/null ;;
+    esac
+    # a damaged cache is ignored; the probe only writes back the timings, so
+    # the index is rebuilt by a session reading all packets before the
+    # second probe restores it
+    index_cache_probe || return
+    ffmpeg -index_cache "$cache" -i "$src" -f null - 2>/dev/null || return
+    index_cache_probe
+}
+
 enc_dec_pcm(){
     out_fmt=$1
     dec_fmt=$2
@@ -158,6 +158,11 @@ fate-aac-aref-encode: CMP_TARGET = 596
 fate-aac-aref-encode: SIZE_TOLERANCE = 2464
 fate-aac-aref-encode: FUZZ = 89
 
+FATE_AAC_ENCODE_THREADS += fate-aac-6ch-encode-threads
+fate-aac-6ch-encode-threads: tests/data/asynth-44100-6.wav
+fate-aac-6ch-encode-threads: CMD = enc_threads_cmp -i $(TARGET_PATH)/tests/data/asynth-44100-6.wav -c:a aac -aac_coder twoloop -b:a 192k
+fate-aac-6ch-encode-threads: CMP = null
+
 FATE_AAC_ENCODE += fate-aac-ln-encode
 fate-aac-ln-encode: CMD = enc_dec_pcm adts wav s16le $(TARGET_SAMPLES)/audio-reference/luckynight_2ch_44kHz_s16.wav -c:a aac -aac_is 0 -aac_pns 0 -aac_ms 0 -aac_tns 0 -b:a 512k
 fate-aac-ln-encode: CMP = stddev
@@ -254,10 +259,13 @@ $(FATE_AAC_ALL): CMP  = oneoff
 $(FATE_AAC_ALL): FUZZ = 2
 
 FATE_AAC_ENCODE-$(call ENCMUX, AAC, ADTS) += $(FATE_AAC_ENCODE)
+FATE_AAC_ENCODE_THREADS-$(call ALLYES, WAV_DEMUXER PCM_S16LE_DECODER ARESAMPLE_FILTER \
+                                       AAC_ENCODER FRAMECRC_MUXER) += $(FATE_AAC_ENCODE_THREADS)
 
 FATE_AAC_BSF-$(call ALLYES, AAC_DEMUXER AAC_ADTSTOASC_BSF MATROSKA_MUXER) += fate-aac-autobsf-adtstoasc
 
 FATE_SAMPLES_FFMPEG += $(FATE_AAC_ALL) $(FATE_AAC_ENCODE-yes) $(FATE_AAC_BSF-yes)
+FATE_FFMPEG += $(FATE_AAC_ENCODE_THREADS-yes)
 
-fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes)
+fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes) $(FATE_AAC_ENCODE_THREADS-yes)
 fate-aac-latm: $(FATE_AAC_LATM-yes)
@@ -1,11 +1,14 @@
 define DEF_FFT
 FATE_DCT-$(CONFIG_DCT)   += fate-dct1d-$(1) fate-idct1d-$(1)
 FATE_FFT-$(CONFIG_FFT)   += fate-fft-$(1)   fate-ifft-$(1)
+FATE_FFT-$(CONFIG_FFT)   += fate-fft-tx-$(1) fate-ifft-tx-$(1)
 FATE_MDCT-$(CONFIG_MDCT) += fate-mdct-$(1)  fate-imdct-$(1)
 FATE_RDFT-$(CONFIG_RDFT) += fate-rdft-$(1)  fate-irdft-$(1)
 
 fate-fft-$(N):    ARGS = -n$(1)
 fate-ifft-$(N):   ARGS = -n$(1) -i
+fate-fft-tx-$(N):  ARGS = -n$(1) -t
+fate-ifft-tx-$(N): ARGS = -n$(1) -t -i
 fate-mdct-$(N):   ARGS = -n$(1) -m
 fate-imdct-$(N):  ARGS = -n$(1) -m -i
 fate-rdft-$(N):   ARGS = -n$(1) -r
@@ -805,6 +805,34 @@ fate-filter-refcmp-ssim-rgb: CMD = refcmp_metadata ssim rgb24 0.015
 FATE_FILTER_SAMPLES-$(call ALLYES, $(REFCMP_DEPS) SSIM_FILTER) += fate-filter-refcmp-ssim-yuv
 fate-filter-refcmp-ssim-yuv: CMD = refcmp_metadata ssim yuv422p 0.015
 
+# The vmaf references come from this filter with the small model in
+# tests/vmaf-model.json, not from libvmaf and its vmaf_v0.6.1 model. They
+# hold the features and the score of the C and x86 code to a relative
+# difference of 0.1%, and are not a conformance test against libvmaf.
+FATE_FILTER-$(call ALLYES, $(REFCMP_DEPS) VMAF_FILTER) += fate-filter-refcmp-vmaf-yuv
+fate-filter-refcmp-vmaf-yuv: CMD = refcmp_metadata vmaf=model_path=$(SRC_PATH)/tests/vmaf-model.json yuv420p 0.001
+
+FATE_FILTER-$(call ALLYES, $(REFCMP_DEPS) VMAF_FILTER) += fate-filter-refcmp-vmaf-yuv10
+fate-filter-refcmp-vmaf-yuv10: CMD = refcmp_metadata vmaf=model_path=$(SRC_PATH)/tests/vmaf-model.json yuv420p10 0.001
+
+FATE_FILTER_SCALE_THREADS = fate-filter-scale-threads fate-filter-scale-threads-unscaled \
+                            fate-filter-scale-threads-cascade fate-filter-scale-threads-alpha
+FATE_FILTER-$(call ALLYES, LAVFI_INDEV TESTSRC2_FILTER FORMAT_FILTER SCALE_FILTER) += $(FATE_FILTER_SCALE_THREADS)
+fate-filter-scale-threads: CMD = filter_threads_cmp -f lavfi -i testsrc2=s=352x288:d=0.2 -vf scale=640:360:flags=bicubic,format=yuv420p
+fate-filter-scale-threads-unscaled: CMD = filter_threads_cmp -f lavfi -i testsrc2=s=352x200:d=0.2 -vf format=yuv420p16,scale=360:200,format=yuv420p16,scale,format=yuv420p,scale,format=rgb24
+fate-filter-scale-threads-cascade: CMD = filter_threads_cmp -f lavfi -i testsrc2=s=1920x1080:d=0.2 -vf format=yuv420p,scale=16:8:flags=lanczos
+fate-filter-scale-threads-alpha: CMD = filter_threads_cmp -f lavfi -i testsrc2=s=352x288:d=0.2 -vf format=yuva420p,scale=500:300,format=yuva444p
+$(FATE_FILTER_SCALE_THREADS): CMP = null
+
+FATE_FILTER_ZSCALE_THREADS = fate-filter-zscale-threads fate-filter-zscale-threads-dither fate-filter-zscale-threads-alpha fate-filter-zscale-threads-colorspace fate-filter-zscale-threads-seams
+FATE_FILTER-$(call ALLYES, LAVFI_INDEV TESTSRC2_FILTER FORMAT_FILTER ZSCALE_FILTER) += $(FATE_FILTER_ZSCALE_THREADS)
+fate-filter-zscale-threads: CMD = filter_threads_cmp -f lavfi -i testsrc2=s=352x288:d=0.2 -vf zscale=w=720:h=405:f=spline36,format=yuv444p10
+fate-filter-zscale-threads-dither: CMD = filter_threads_cmp -f lavfi -i testsrc2=s=352x288:d=0.2 -vf format=yuv420p10,zscale=w=640:h=360:d=error_diffusion,format=yuv420p
+fate-filter-zscale-threads-alpha: CMD = filter_threads_cmp -f lavfi -i testsrc2=s=352x288:d=0.2 -vf format=yuva420p,zscale=w=500:h=363:f=bicubic,format=yuva420p
+fate-filter-zscale-threads-colorspace: CMD = filter_threads_cmp -f lavfi -i testsrc2=s=352x288:d=0.2 -vf format=yuv444p,zscale=m=bt709:min=bt470bg:r=full:rin=limited,format=yuv444p
+fate-filter-zscale-threads-seams: CMD = filter_threads_cmp -f lavfi -i testsrc2=s=352x288:d=0.2 -vf format=yuv420p,zscale=w=200:h=75:f=lanczos,format=yuv420p
+$(FATE_FILTER_ZSCALE_THREADS): CMP = null
+
 FATE_SAMPLES_FFPROBE += $(FATE_METADATA_FILTER-yes)
 FATE_SAMPLES_FFMPEG += $(FATE_FILTER_SAMPLES-yes)
 FATE_FFMPEG += $(FATE_FILTER-yes)
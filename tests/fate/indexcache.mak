@@ -0,0 +1,20 @@
+tests/data/index_cache.mp2: TAG = GEN
+tests/data/index_cache.mp2: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i "aevalsrc=sin(2*PI*440*t):d=10" -codec:a mp2fixed -bitexact \
+        -y $(TARGET_PATH)/tests/data/index_cache.mp2 2>/dev/null
+
+FATE_INDEX_CACHE += fate-index-cache
+fate-index-cache: CMD = index_cache $(TARGET_PATH)/tests/data/index_cache.mp2
+
+FATE_INDEX_CACHE += fate-index-cache-damaged-pos
+fate-index-cache-damaged-pos: CMD = index_cache $(TARGET_PATH)/tests/data/index_cache.mp2 pos
+
+FATE_INDEX_CACHE += fate-index-cache-damaged-ts
+fate-index-cache-damaged-ts: CMD = index_cache $(TARGET_PATH)/tests/data/index_cache.mp2 ts
+
+$(FATE_INDEX_CACHE): ffprobe$(PROGSSUF)$(EXESUF) tests/data/index_cache.mp2
+
+FATE_FFMPEG-$(call ALLYES, FILE_PROTOCOL LAVFI_INDEV AEVALSRC_FILTER MP2FIXED_ENCODER \
+                           MP2_MUXER MP3_DEMUXER MP2_DECODER NULL_MUXER PCM_S16LE_ENCODER) += $(FATE_INDEX_CACHE)
+fate-index-caches: $(FATE_INDEX_CACHE)
@@ -2,6 +2,10 @@
 #fate-async: libavformat/tests/async$(EXESUF)
 #fate-async: CMD = run libavformat/tests/async
 
+FATE_LIBAVFORMAT-$(HAVE_MMAP) += fate-file-mmap
+fate-file-mmap: libavformat/tests/file$(EXESUF)
+fate-file-mmap: CMD = run libavformat/tests/file$(EXESUF) $(TARGET_PATH)/tests/data/fate/file-mmap.bin
+
 FATE_LIBAVFORMAT-$(CONFIG_NETWORK) += fate-noproxy
 fate-noproxy: libavformat/tests/noproxy$(EXESUF)
 fate-noproxy: CMD = run libavformat/tests/noproxy$(EXESUF)